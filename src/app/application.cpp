@@ -48,6 +48,7 @@
 #include <QDir>
 #include <QLibraryInfo>
 #include <QProcess>
+#include <QTimer>
 
 #ifndef DISABLE_GUI
 #include <QMessageBox>
@@ -62,7 +63,9 @@
 #endif
 
 #include "base/bittorrent/infohash.h"
+#include "base/bittorrent/segmentconcurrency.h"
 #include "base/bittorrent/session.h"
+#include "base/bittorrent/speedhistory.h"
 #include "base/bittorrent/torrenthandle.h"
 #include "base/exceptions.h"
 #include "base/iconprovider.h"
@@ -78,6 +81,7 @@
 #include "base/scanfoldersmodel.h"
 #include "base/search/searchpluginmanager.h"
 #include "base/settingsstorage.h"
+#include "base/torrentstatuscounters.h"
 #include "base/utils/fs.h"
 #include "base/utils/misc.h"
 #include "base/utils/string.h"
@@ -590,6 +594,8 @@ int Application::exec(const QStringList &params)
     Net::ProxyConfigurationManager::initInstance();
     Net::DownloadManager::initInstance();
     IconProvider::initInstance();
+    TorrentStatusCounters::initInstance();
+    BitTorrent::SegmentConcurrencyController::initInstance();
 
     try {
         BitTorrent::Session::initInstance(m_commandLineArgs);
@@ -600,6 +606,7 @@ int Application::exec(const QStringList &params)
 
         connect(BitTorrent::Session::instance(), &BitTorrent::Session::onMainAfter,
             this, &Application::onMainCheckAfter);
+        BitTorrent::SpeedHistory::initInstance();
         Net::GeoIPManager::initInstance();
         ScanFoldersModel::initInstance();
 
@@ -804,7 +811,10 @@ void Application::cleanup()
     delete RSS::Session::instance();
 
     ScanFoldersModel::freeInstance();
+    BitTorrent::SpeedHistory::freeInstance();
     BitTorrent::Session::freeInstance();
+    TorrentStatusCounters::freeInstance();
+    BitTorrent::SegmentConcurrencyController::freeInstance();
     Net::GeoIPManager::freeInstance();
     Net::DownloadManager::freeInstance();
     Net::ProxyConfigurationManager::freeInstance();
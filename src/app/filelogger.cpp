@@ -28,34 +28,74 @@
 
 #include "filelogger.h"
 
-#include <chrono>
+#include <functional>
+#include <utility>
 
 #include <QDateTime>
 #include <QDir>
-#include <QTextStream>
-#include <QVector>
+#include <QThread>
 
 #include "base/global.h"
-#include "base/logger.h"
 #include "base/utils/fs.h"
 
 namespace
 {
-    const std::chrono::seconds FLUSH_INTERVAL {2};
+    // messages arriving faster than the writer thread writes them are dropped beyond this
+    const int MAX_PENDING_MESSAGES = 10000;
+
+    class WriterThread final : public QThread
+    {
+    public:
+        explicit WriterThread(std::function<void ()> function)
+            : m_function(std::move(function))
+        {
+        }
+
+    private:
+        void run() override
+        {
+            m_function();
+        }
+
+        const std::function<void ()> m_function;
+    };
+
+    const char *typePrefix(const Log::MsgType type)
+    {
+        switch (type)
+        {
+        case Log::INFO:
+            return "(I) ";
+        case Log::WARNING:
+            return "(W) ";
+        case Log::CRITICAL:
+            return "(C) ";
+        default:
+            return "(N) ";
+        }
+    }
+
+    void appendLine(QByteArray &buffer, const Log::MsgType type, const qint64 timestamp, const QString &message)
+    {
+        buffer += typePrefix(type);
+        buffer += QDateTime::fromMSecsSinceEpoch(timestamp).toString(Qt::ISODate).toLatin1();
+        buffer += " - ";
+        buffer += message.toUtf8();
+        buffer += '\n';
+    }
 }
 
 FileLogger::FileLogger(const QString &path, const bool backup, const int maxSize, const bool deleteOld, const int age, const FileLogAgeType ageType)
-    : m_backup(backup)
+    : m_writerThread(new WriterThread([this]() { writeLogMessages(); }))
+    , m_backup(backup)
     , m_maxSize(maxSize)
 {
-    m_flusher.setInterval(FLUSH_INTERVAL);
-    m_flusher.setSingleShot(true);
-    connect(&m_flusher, &QTimer::timeout, this, &FileLogger::flushLog);
-
     changePath(path);
     if (deleteOld)
         this->deleteOld(age, ageType);
 
+    m_writerThread->start(QThread::LowPriority);
+
     const Logger *const logger = Logger::instance();
     for (const Log::Msg &msg : asConst(logger->getMessages()))
         addLogMessage(msg);
@@ -65,7 +105,17 @@ FileLogger::FileLogger(const QString &path, const bool backup, const int maxSize
 
 FileLogger::~FileLogger()
 {
-    closeLogFile();
+    // write out the messages still queued in the logger
+    Logger::instance()->processPendingMessages();
+
+    {
+        const QMutexLocker locker(&m_mutex);
+        m_isStopping = true;
+        m_wakeUp.wakeOne();
+    }
+
+    m_writerThread->wait();
+    delete m_writerThread;
 }
 
 void FileLogger::changePath(const QString &newPath)
@@ -74,13 +124,12 @@ void FileLogger::changePath(const QString &newPath)
     dir.mkpath(newPath);
     const QString tmpPath = dir.absoluteFilePath("qbittorrent.log");
 
+    const QMutexLocker locker(&m_mutex);
     if (tmpPath != m_path)
     {
         m_path = tmpPath;
-
-        closeLogFile();
-        m_logFile.setFileName(m_path);
-        openLogFile();
+        m_isPathChanged = true;
+        m_wakeUp.wakeOne();
     }
 }
 
@@ -113,64 +162,109 @@ void FileLogger::deleteOld(const int age, const FileLogAgeType ageType)
 
 void FileLogger::setBackup(const bool value)
 {
+    const QMutexLocker locker(&m_mutex);
     m_backup = value;
 }
 
 void FileLogger::setMaxSize(const int value)
 {
+    const QMutexLocker locker(&m_mutex);
     m_maxSize = value;
 }
 
 void FileLogger::addLogMessage(const Log::Msg &msg)
+{
+    const QMutexLocker locker(&m_mutex);
+    if (m_pendingMessages.size() >= MAX_PENDING_MESSAGES)
+    {
+        ++m_droppedCount;
+        return;
+    }
+
+    m_pendingMessages.append(msg);
+    if (m_pendingMessages.size() == 1)
+        m_wakeUp.wakeOne();
+}
+
+void FileLogger::writeLogMessages()
+{
+    QVector<Log::Msg> messages;
+
+    QMutexLocker locker(&m_mutex);
+    while (true)
+    {
+        while (!m_isStopping && !m_isPathChanged && m_pendingMessages.isEmpty())
+            m_wakeUp.wait(&m_mutex);
+
+        if (m_isPathChanged)
+        {
+            m_isPathChanged = false;
+            const QString path = m_path;
+            locker.unlock();
+
+            closeLogFile();
+            m_logFile.setFileName(path);
+            openLogFile();
+
+            locker.relock();
+            continue;
+        }
+
+        if (m_pendingMessages.isEmpty() && (m_droppedCount == 0))
+            break; // stopping
+
+        // the emptied vector is handed back, so its storage is reused by the next batch
+        messages.swap(m_pendingMessages);
+        const int droppedCount = std::exchange(m_droppedCount, 0);
+        const bool backup = m_backup;
+        const qint64 maxSize = m_maxSize;
+        locker.unlock();
+
+        writeBatch(messages, droppedCount, backup, maxSize);
+        messages.clear();
+
+        locker.relock();
+    }
+
+    locker.unlock();
+    closeLogFile();
+}
+
+void FileLogger::writeBatch(const QVector<Log::Msg> &messages, const int droppedCount, const bool backup, const qint64 maxSize)
 {
     if (!m_logFile.isOpen()) return;
 
-    QTextStream stream(&m_logFile);
-    stream.setCodec("UTF-8");
+    QByteArray buffer;
+    buffer.reserve(messages.size() * 128);
+
+    for (const Log::Msg &msg : messages)
+        appendLine(buffer, msg.type, msg.timestamp, msg.message);
 
-    switch (msg.type)
+    if (droppedCount > 0)
     {
-    case Log::INFO:
-        stream << "(I) ";
-        break;
-    case Log::WARNING:
-        stream << "(W) ";
-        break;
-    case Log::CRITICAL:
-        stream << "(C) ";
-        break;
-    default:
-        stream << "(N) ";
+        appendLine(buffer, Log::WARNING, QDateTime::currentMSecsSinceEpoch()
+            , tr("%1 log messages weren't written to the file because they were added faster than they could be written").arg(droppedCount));
     }
 
-    stream << QDateTime::fromMSecsSinceEpoch(msg.timestamp).toString(Qt::ISODate) << " - " << msg.message << '\n';
+    m_logFile.write(buffer);
+    m_logFile.flush();
 
-    if (m_backup && (m_logFile.size() >= m_maxSize))
+    if (backup && (m_logFile.size() >= maxSize))
     {
+        const QString path = m_logFile.fileName();
         closeLogFile();
         int counter = 0;
-        QString backupLogFilename = m_path + ".bak";
+        QString backupLogFilename = path + ".bak";
 
         while (QFile::exists(backupLogFilename))
         {
             ++counter;
-            backupLogFilename = m_path + ".bak" + QString::number(counter);
+            backupLogFilename = path + ".bak" + QString::number(counter);
         }
 
-        QFile::rename(m_path, backupLogFilename);
+        QFile::rename(path, backupLogFilename);
         openLogFile();
     }
-    else
-    {
-        if (!m_flusher.isActive())
-            m_flusher.start();
-    }
-}
-
-void FileLogger::flushLog()
-{
-    if (m_logFile.isOpen())
-        m_logFile.flush();
 }
 
 void FileLogger::openLogFile()
@@ -185,6 +279,5 @@ void FileLogger::openLogFile()
 
 void FileLogger::closeLogFile()
 {
-    m_flusher.stop();
     m_logFile.close();
 }
@@ -29,14 +29,17 @@
 #pragma once
 
 #include <QFile>
+#include <QMutex>
 #include <QObject>
-#include <QTimer>
+#include <QVector>
+#include <QWaitCondition>
 
-namespace Log
-{
-    struct Msg;
-}
+class QThread;
+
+#include "base/logger.h"
 
+// Messages are formatted and written by a dedicated thread in batches,
+// so neither the logger nor the file rotation blocks the main thread.
 class FileLogger : public QObject
 {
     Q_OBJECT
@@ -60,15 +63,27 @@ public:
 
 private slots:
     void addLogMessage(const Log::Msg &msg);
-    void flushLog();
 
 private:
+    // These are executed in the writer thread
+    void writeLogMessages();
+    void writeBatch(const QVector<Log::Msg> &messages, int droppedCount, bool backup, qint64 maxSize);
     void openLogFile();
     void closeLogFile();
 
+    QThread *m_writerThread = nullptr;
+
+    // Guarded by m_mutex
+    QMutex m_mutex;
+    QWaitCondition m_wakeUp;
     QString m_path;
+    bool m_isPathChanged = false;
     bool m_backup;
     int m_maxSize;
+    QVector<Log::Msg> m_pendingMessages;
+    int m_droppedCount = 0;
+    bool m_isStopping = false;
+
+    // Used by the writer thread only
     QFile m_logFile;
-    QTimer m_flusher;
 };
@@ -18,9 +18,12 @@ HEADERS += \
     $$PWD/bittorrent/peeraddress.h \
     $$PWD/bittorrent/peerinfo.h \
     $$PWD/bittorrent/portforwarderimpl.h \
+    $$PWD/bittorrent/resumedatajournal.h \
     $$PWD/bittorrent/resumedatasavingmanager.h \
+    $$PWD/bittorrent/segmentconcurrency.h \
     $$PWD/bittorrent/session.h \
     $$PWD/bittorrent/sessionstatus.h \
+    $$PWD/bittorrent/speedhistory.h \
     $$PWD/bittorrent/speedmonitor.h \
     $$PWD/bittorrent/statistics.h \
     $$PWD/bittorrent/torrentcontentlayout.h \
@@ -30,6 +33,7 @@ HEADERS += \
     $$PWD/bittorrent/torrentinfo.h \
     $$PWD/bittorrent/tracker.h \
     $$PWD/bittorrent/trackerentry.h \
+    $$PWD/boundedqueue.h \
     $$PWD/exceptions.h \
     $$PWD/filesystemwatcher.h \
     $$PWD/global.h \
@@ -39,7 +43,9 @@ HEADERS += \
     $$PWD/http/requestparser.h \
     $$PWD/http/responsebuilder.h \
     $$PWD/http/responsegenerator.h \
+    $$PWD/http/responsewriter.h \
     $$PWD/http/server.h \
+    $$PWD/http/serverworker.h \
     $$PWD/http/types.h \
     $$PWD/iconprovider.h \
     $$PWD/indexrange.h \
@@ -49,6 +55,7 @@ HEADERS += \
     $$PWD/net/downloadmanager.h \
     $$PWD/net/geoipdatabase.h \
     $$PWD/net/geoipmanager.h \
+    $$PWD/net/httpcache.h \
     $$PWD/net/portforwarder.h \
     $$PWD/net/proxyconfigurationmanager.h \
     $$PWD/net/reverseresolution.h \
@@ -59,10 +66,12 @@ HEADERS += \
     $$PWD/rss/rss_article.h \
     $$PWD/rss/rss_autodownloader.h \
     $$PWD/rss/rss_autodownloadrule.h \
+    $$PWD/rss/rss_autodownloadrulematcher.h \
     $$PWD/rss/rss_feed.h \
     $$PWD/rss/rss_folder.h \
     $$PWD/rss/rss_item.h \
     $$PWD/rss/rss_parser.h \
+    $$PWD/rss/rss_refreshscheduler.h \
     $$PWD/rss/rss_session.h \
     $$PWD/scanfoldersmodel.h \
     $$PWD/search/searchdownloadhandler.h \
@@ -72,6 +81,7 @@ HEADERS += \
     $$PWD/settingvalue.h \
     $$PWD/torrentfileguard.h \
     $$PWD/torrentfilter.h \
+    $$PWD/torrentstatuscounters.h \
     $$PWD/tristatebool.h \
     $$PWD/types.h \
     $$PWD/unicodestrings.h \
@@ -101,8 +111,11 @@ SOURCES += \
     $$PWD/bittorrent/peeraddress.cpp \
     $$PWD/bittorrent/peerinfo.cpp \
     $$PWD/bittorrent/portforwarderimpl.cpp \
+    $$PWD/bittorrent/resumedatajournal.cpp \
     $$PWD/bittorrent/resumedatasavingmanager.cpp \
+    $$PWD/bittorrent/segmentconcurrency.cpp \
     $$PWD/bittorrent/session.cpp \
+    $$PWD/bittorrent/speedhistory.cpp \
     $$PWD/bittorrent/speedmonitor.cpp \
     $$PWD/bittorrent/statistics.cpp \
     $$PWD/bittorrent/torrentcreatorthread.cpp \
@@ -118,7 +131,9 @@ SOURCES += \
     $$PWD/http/requestparser.cpp \
     $$PWD/http/responsebuilder.cpp \
     $$PWD/http/responsegenerator.cpp \
+    $$PWD/http/responsewriter.cpp \
     $$PWD/http/server.cpp \
+    $$PWD/http/serverworker.cpp \
     $$PWD/iconprovider.cpp \
     $$PWD/logger.cpp \
     $$PWD/net/dnsupdater.cpp \
@@ -126,6 +141,7 @@ SOURCES += \
     $$PWD/net/downloadmanager.cpp \
     $$PWD/net/geoipdatabase.cpp \
     $$PWD/net/geoipmanager.cpp \
+    $$PWD/net/httpcache.cpp \
     $$PWD/net/portforwarder.cpp \
     $$PWD/net/proxyconfigurationmanager.cpp \
     $$PWD/net/reverseresolution.cpp \
@@ -136,10 +152,12 @@ SOURCES += \
     $$PWD/rss/rss_article.cpp \
     $$PWD/rss/rss_autodownloader.cpp \
     $$PWD/rss/rss_autodownloadrule.cpp \
+    $$PWD/rss/rss_autodownloadrulematcher.cpp \
     $$PWD/rss/rss_feed.cpp \
     $$PWD/rss/rss_folder.cpp \
     $$PWD/rss/rss_item.cpp \
     $$PWD/rss/rss_parser.cpp \
+    $$PWD/rss/rss_refreshscheduler.cpp \
     $$PWD/rss/rss_session.cpp \
     $$PWD/scanfoldersmodel.cpp \
     $$PWD/search/searchdownloadhandler.cpp \
@@ -148,6 +166,7 @@ SOURCES += \
     $$PWD/settingsstorage.cpp \
     $$PWD/torrentfileguard.cpp \
     $$PWD/torrentfilter.cpp \
+    $$PWD/torrentstatuscounters.cpp \
     $$PWD/tristatebool.cpp \
     $$PWD/utils/bytearray.cpp \
     $$PWD/utils/foreignapps.cpp \
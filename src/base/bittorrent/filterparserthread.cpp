@@ -28,14 +28,27 @@
 
 #include "filterparserthread.h"
 
+#include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include <libtorrent/error_code.hpp>
 
+#include <QCryptographicHash>
 #include <QDataStream>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
 
 #include "base/logger.h"
+#include "base/profile.h"
 
 namespace
 {
@@ -104,487 +117,646 @@ namespace
         return !ec;
     }
 
-    const int BUFFER_SIZE = 2 * 1024 * 1024; // 2 MiB
     const int MAX_LOGGED_ERRORS = 5;
-}
+    // Smaller text files are parsed by a single thread
+    const int MIN_PART_SIZE = 1024 * 1024; // 1 MiB
 
-FilterParserThread::FilterParserThread(QObject *parent)
-    : QThread(parent)
-    , m_abort(false)
-{
-}
+    const QString CACHE_FILE_NAME = QStringLiteral("ipfilter.cache");
+    const char CACHE_MAGIC[8] = {'I', 'P', 'F', 'I', 'L', 'T', 'E', 'R'};
+    const quint32 CACHE_VERSION = 1;
 
-FilterParserThread::~FilterParserThread()
-{
-    m_abort = true;
-    wait();
-}
+    enum class FilterFormat : quint32
+    {
+        DAT = 1,
+        P2P = 2,
+        P2B = 3
+    };
 
-// Parser for eMule ip filter in DAT format
-int FilterParserThread::parseDATFilterFile()
-{
-    int ruleCount = 0;
-    QFile file(m_filePath);
-    if (!file.exists()) return ruleCount;
+    struct IPv4Range
+    {
+        quint32 first;
+        quint32 last;
+    };
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    struct IPv6Range
     {
-        LogMsg(tr("I/O Error: Could not open IP filter file in read mode."), Log::CRITICAL);
-        return ruleCount;
-    }
+        lt::address_v6::bytes_type first;
+        lt::address_v6::bytes_type last;
+    };
+
+    // The cache file starts with the header, followed by the IPv4 ranges and the IPv6 ones.
+    // The ranges are sorted and don't overlap. Integers are in host byte order.
+    struct CacheHeader
+    {
+        char magic[8];
+        quint32 version;
+        quint32 format;
+        qint64 sourceSize;
+        qint64 sourceModified;  // msecs since epoch
+        char sourceHash[20];    // SHA-1 of the filter file
+        qint32 ruleCount;
+        qint32 errorCount;
+        quint32 v4RangeCount;
+        quint32 v6RangeCount;
+        quint32 reserved;
+    };
+
+    static_assert(sizeof(IPv4Range) == 8, "IPv4Range is stored in the cache file as is");
+    static_assert(sizeof(IPv6Range) == 32, "IPv6Range is stored in the cache file as is");
+    static_assert(sizeof(CacheHeader) == 72, "CacheHeader is stored in the cache file as is");
 
-    std::vector<char> buffer(BUFFER_SIZE, 0); // seems a bit faster than QVector
-    qint64 bytesRead = 0;
-    int offset = 0;
-    int start = 0;
-    int endOfLine = -1;
-    int nbLine = 0;
-    int parseErrorCount = 0;
-    const auto addLog = [&parseErrorCount](const QString &msg)
-    {
-        if (parseErrorCount <= MAX_LOGGED_ERRORS)
-            LogMsg(msg, Log::CRITICAL);
+    enum class LineResult
+    {
+        Range,
+        Ignored,
+        Malformed,
+        MalformedStart,
+        MalformedEnd,
+        MixedFamilies
+    };
+
+    struct ParsedRanges
+    {
+        std::vector<IPv4Range> v4Ranges;
+        std::vector<IPv6Range> v6Ranges;
+        int ruleCount = 0;
+        int lineCount = 0;
+        int errorCount = 0;
+        // line numbers (in the parsed part) of the first errors
+        std::vector<std::pair<int, LineResult>> errors;
+        bool isComplete = true;
     };
 
-    while (true)
+    class WorkerThread final : public QThread
     {
-        bytesRead = file.read(buffer.data() + offset, BUFFER_SIZE - offset - 1);
-        if (bytesRead < 0)
-            break;
-        const int dataSize = bytesRead + offset;
-        if ((bytesRead == 0) && (dataSize == 0))
-            break;
+    public:
+        explicit WorkerThread(std::function<void ()> function)
+            : m_function(std::move(function))
+        {
+        }
+
+    private:
+        void run() override
+        {
+            m_function();
+        }
+
+        const std::function<void ()> m_function;
+    };
 
-        for (start = 0; start < dataSize; ++start)
+    int findAndNullDelimiter(char *const data, const char delimiter, const int start, const int end, const bool reverse = false)
+    {
+        if (!reverse)
         {
-            endOfLine = -1;
-            // The file might have ended without the last line having a newline
-            if (!((bytesRead == 0) && (dataSize > 0)))
+            for (int i = start; i <= end; ++i)
             {
-                for (int i = start; i < dataSize; ++i)
+                if (data[i] == delimiter)
                 {
-                    if (buffer[i] == '\n')
-                    {
-                        endOfLine = i;
-                        // We need to NULL the newline in case the line has only an IP range.
-                        // In that case the parser won't work for the end IP, because it ends
-                        // with the newline and not with a number.
-                        buffer[i] = '\0';
-                        break;
-                    }
+                    data[i] = '\0';
+                    return i;
                 }
             }
-            else
+        }
+        else
+        {
+            for (int i = end; i >= start; --i)
             {
-                endOfLine = dataSize;
-                buffer[dataSize] = '\0';
+                if (data[i] == delimiter)
+                {
+                    data[i] = '\0';
+                    return i;
+                }
             }
+        }
+
+        return -1;
+    }
 
-            if (endOfLine == -1)
+    int trim(char *const data, const int start, const int end)
+    {
+        if (start >= end) return start;
+        int newStart = start;
+
+        for (int i = start; i <= end; ++i)
+        {
+            if (isspace(data[i]) != 0)
             {
-                // read the next chunk from file
-                // but first move(copy) the leftover data to the front of the buffer
-                offset = dataSize - start;
-                memmove(buffer.data(), buffer.data() + start, offset);
+                data[i] = '\0';
+            }
+            else
+            {
+                newStart = i;
                 break;
             }
+        }
 
-            ++nbLine;
-
-            if ((buffer[start] == '#')
-                || ((buffer[start] == '/') && ((start + 1 < dataSize) && (buffer[start + 1] == '/'))))
-                {
-                start = endOfLine;
-                continue;
-            }
+        for (int i = end; i >= start; --i)
+        {
+            if (isspace(data[i]) != 0)
+                data[i] = '\0';
+            else
+                break;
+        }
 
-            // Each line should follow this format:
-            // 001.009.096.105 - 001.009.096.105 , 000 , Some organization
-            // The 3rd entry is access level and if above 127 the IP range isn't blocked.
-            const int firstComma = findAndNullDelimiter(buffer.data(), ',', start, endOfLine);
-            if (firstComma != -1)
-                findAndNullDelimiter(buffer.data(), ',', firstComma + 1, endOfLine);
+        return newStart;
+    }
 
-            // Check if there is an access value (apparently not mandatory)
-            if (firstComma != -1)
-            {
-                // There is possibly one
-                const long int nbAccess = strtol(buffer.data() + firstComma + 1, nullptr, 10);
-                // Ignoring this rule because access value is too high
-                if (nbAccess > 127L)
-                {
-                    start = endOfLine;
-                    continue;
-                }
-            }
+    // Line of eMule ip filter in DAT format
+    LineResult parseDATLine(char *const data, const int start, const int endOfLine, lt::address &startAddr, lt::address &endAddr)
+    {
+        // Each line should follow this format:
+        // 001.009.096.105 - 001.009.096.105 , 000 , Some organization
+        // The 3rd entry is access level and if above 127 the IP range isn't blocked.
+        const int firstComma = findAndNullDelimiter(data, ',', start, endOfLine);
+        if (firstComma != -1)
+            findAndNullDelimiter(data, ',', firstComma + 1, endOfLine);
+
+        // Check if there is an access value (apparently not mandatory)
+        if (firstComma != -1)
+        {
+            // There is possibly one
+            const long int nbAccess = strtol(data + firstComma + 1, nullptr, 10);
+            // Ignoring this rule because access value is too high
+            if (nbAccess > 127L)
+                return LineResult::Ignored;
+        }
 
-            // IP Range should be split by a dash
-            const int endOfIPRange = ((firstComma == -1) ? (endOfLine - 1) : (firstComma - 1));
-            const int delimIP = findAndNullDelimiter(buffer.data(), '-', start, endOfIPRange);
-            if (delimIP == -1)
-            {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+        // IP Range should be split by a dash
+        const int endOfIPRange = ((firstComma == -1) ? (endOfLine - 1) : (firstComma - 1));
+        const int delimIP = findAndNullDelimiter(data, '-', start, endOfIPRange);
+        if (delimIP == -1)
+            return LineResult::Malformed;
 
-            lt::address startAddr;
-            int newStart = trim(buffer.data(), start, delimIP - 1);
-            if (!parseIPAddress(buffer.data() + newStart, startAddr))
-            {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. Start IP of the range is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+        if (!parseIPAddress(data + trim(data, start, delimIP - 1), startAddr))
+            return LineResult::MalformedStart;
+        if (!parseIPAddress(data + trim(data, delimIP + 1, endOfIPRange), endAddr))
+            return LineResult::MalformedEnd;
 
-            lt::address endAddr;
-            newStart = trim(buffer.data(), delimIP + 1, endOfIPRange);
-            if (!parseIPAddress(buffer.data() + newStart, endAddr))
-            {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. End IP of the range is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+        return LineResult::Range;
+    }
 
-            if ((startAddr.is_v4() != endAddr.is_v4())
-                || (startAddr.is_v6() != endAddr.is_v6()))
-                {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. One IP is IPv4 and the other is IPv6!").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+    // Line of PeerGuardian ip filter in p2p format
+    LineResult parseP2PLine(char *const data, const int start, const int endOfLine, lt::address &startAddr, lt::address &endAddr)
+    {
+        // Each line should follow this format:
+        // Some organization:1.0.0.0-1.255.255.255
+        // The "Some organization" part might contain a ':' char itself so we find the last occurrence
+        const int partsDelimiter = findAndNullDelimiter(data, ':', start, endOfLine, true);
+        if (partsDelimiter == -1)
+            return LineResult::Malformed;
+
+        // IP Range should be split by a dash
+        const int delimIP = findAndNullDelimiter(data, '-', partsDelimiter + 1, endOfLine);
+        if (delimIP == -1)
+            return LineResult::Malformed;
+
+        if (!parseIPAddress(data + trim(data, partsDelimiter + 1, delimIP - 1), startAddr))
+            return LineResult::MalformedStart;
+        if (!parseIPAddress(data + trim(data, delimIP + 1, endOfLine), endAddr))
+            return LineResult::MalformedEnd;
+
+        return LineResult::Range;
+    }
 
-            start = endOfLine;
+    LineResult addRange(const lt::address &startAddr, const lt::address &endAddr, ParsedRanges &ranges)
+    {
+        if ((startAddr.is_v4() != endAddr.is_v4())
+            || (startAddr.is_v6() != endAddr.is_v6()))
+            return LineResult::MixedFamilies;
 
-            // Now Add to the filter
-            try
-            {
-                m_filter.add_rule(startAddr, endAddr, lt::ip_filter::blocked);
-                ++ruleCount;
-            }
-            catch (const std::exception &e)
-            {
-                ++parseErrorCount;
-                addLog(tr("IP filter exception thrown for line %1. Exception is: %2")
-                       .arg(nbLine).arg(QString::fromLocal8Bit(e.what())));
-            }
+        if (startAddr.is_v4())
+        {
+            const IPv4Range range {qFromBigEndian<quint32>(startAddr.to_v4().to_bytes().data())
+                , qFromBigEndian<quint32>(endAddr.to_v4().to_bytes().data())};
+            if (range.first > range.last)
+                return LineResult::Malformed;
+            ranges.v4Ranges.push_back(range);
+        }
+        else
+        {
+            const IPv6Range range {startAddr.to_v6().to_bytes(), endAddr.to_v6().to_bytes()};
+            if (range.first > range.last)
+                return LineResult::Malformed;
+            ranges.v6Ranges.push_back(range);
         }
 
-        if (start >= dataSize)
-            offset = 0;
+        ++ranges.ruleCount;
+        return LineResult::Range;
     }
 
-    if (parseErrorCount > MAX_LOGGED_ERRORS)
-        LogMsg(tr("%1 extra IP filter parsing errors occurred.", "513 extra IP filter parsing errors occurred.")
-               .arg(parseErrorCount - MAX_LOGGED_ERRORS), Log::CRITICAL);
-    return ruleCount;
-}
+    template <typename Range>
+    void sortRanges(std::vector<Range> &ranges)
+    {
+        std::sort(ranges.begin(), ranges.end(), [](const Range &left, const Range &right)
+        {
+            return (left.first < right.first);
+        });
+    }
 
-// Parser for PeerGuardian ip filter in p2p format
-int FilterParserThread::parseP2PFilterFile()
-{
-    int ruleCount = 0;
-    QFile file(m_filePath);
-    if (!file.exists()) return ruleCount;
+    template <typename Range>
+    void appendSortedRanges(std::vector<Range> &ranges, const std::vector<Range> &sortedRanges)
+    {
+        const auto middle = static_cast<typename std::vector<Range>::difference_type>(ranges.size());
+        ranges.insert(ranges.end(), sortedRanges.cbegin(), sortedRanges.cend());
+        std::inplace_merge(ranges.begin(), (ranges.begin() + middle), ranges.end(), [](const Range &left, const Range &right)
+        {
+            return (left.first < right.first);
+        });
+    }
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    bool isContinuedBy(const IPv4Range &range, const IPv4Range &next)
     {
-        LogMsg(tr("I/O Error: Could not open IP filter file in read mode."), Log::CRITICAL);
-        return ruleCount;
+        return (next.first <= (static_cast<quint64>(range.last) + 1));
     }
 
-    std::vector<char> buffer(BUFFER_SIZE, 0); // seems a bit faster than QVector
-    qint64 bytesRead = 0;
-    int offset = 0;
-    int start = 0;
-    int endOfLine = -1;
-    int nbLine = 0;
-    int parseErrorCount = 0;
-    const auto addLog = [&parseErrorCount](const QString &msg)
-    {
-        if (parseErrorCount <= MAX_LOGGED_ERRORS)
-            LogMsg(msg, Log::CRITICAL);
-    };
+    bool isContinuedBy(const IPv6Range &range, const IPv6Range &next)
+    {
+        return (next.first <= range.last);
+    }
 
-    while (true)
+    // Joins the overlapping and the adjacent ranges of the sorted list,
+    // all of them are blocked so the filter stays the same
+    template <typename Range>
+    void coalesceRanges(std::vector<Range> &ranges)
     {
-        bytesRead = file.read(buffer.data() + offset, BUFFER_SIZE - offset - 1);
-        if (bytesRead < 0)
-            break;
-        const int dataSize = bytesRead + offset;
-        if ((bytesRead == 0) && (dataSize == 0))
-            break;
+        if (ranges.empty()) return;
 
-        for (start = 0; start < dataSize; ++start)
+        auto merged = ranges.begin();
+        for (auto iter = std::next(ranges.begin()); iter != ranges.end(); ++iter)
         {
-            endOfLine = -1;
-            // The file might have ended without the last line having a newline
-            if (!((bytesRead == 0) && (dataSize > 0)))
+            if (isContinuedBy(*merged, *iter))
             {
-                for (int i = start; i < dataSize; ++i)
-                {
-                    if (buffer[i] == '\n')
-                    {
-                        endOfLine = i;
-                        // We need to NULL the newline in case the line has only an IP range.
-                        // In that case the parser won't work for the end IP, because it ends
-                        // with the newline and not with a number.
-                        buffer[i] = '\0';
-                        break;
-                    }
-                }
+                if (merged->last < iter->last)
+                    merged->last = iter->last;
             }
             else
             {
-                endOfLine = dataSize;
-                buffer[dataSize] = '\0';
+                *(++merged) = *iter;
             }
+        }
 
-            if (endOfLine == -1)
-            {
-                // read the next chunk from file
-                // but first move(copy) the leftover data to the front of the buffer
-                offset = dataSize - start;
-                memmove(buffer.data(), buffer.data() + start, offset);
-                break;
-            }
-
-            ++nbLine;
-
-            if ((buffer[start] == '#')
-                || ((buffer[start] == '/') && ((start + 1 < dataSize) && (buffer[start + 1] == '/'))))
-                {
-                start = endOfLine;
-                continue;
-            }
+        ranges.erase(std::next(merged), ranges.end());
+    }
 
-            // Each line should follow this format:
-            // Some organization:1.0.0.0-1.255.255.255
-            // The "Some organization" part might contain a ':' char itself so we find the last occurrence
-            const int partsDelimiter = findAndNullDelimiter(buffer.data(), ':', start, endOfLine, true);
-            if (partsDelimiter == -1)
-            {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+    // Parses the lines between `begin` and `end`, the end of the last line must be
+    // either a newline or the end of the data
+    ParsedRanges parseTextPart(char *const data, const int begin, const int end, const FilterFormat format, const bool &abort)
+    {
+        ParsedRanges result;
 
-            // IP Range should be split by a dash
-            const int delimIP = findAndNullDelimiter(buffer.data(), '-', partsDelimiter + 1, endOfLine);
-            if (delimIP == -1)
+        for (int start = begin; start < end; ++start)
+        {
+            const auto *newline = static_cast<const char *>(memchr((data + start), '\n', (end - start)));
+            const int endOfLine = (newline ? static_cast<int>(newline - data) : end);
+            // We need to NULL the newline in case the line has only an IP range.
+            // In that case the parser won't work for the end IP, because it ends
+            // with the newline and not with a number.
+            if (newline)
+                data[endOfLine] = '\0';
+
+            ++result.lineCount;
+
+            if ((data[start] == '#')
+                || ((data[start] == '/') && (data[start + 1] == '/')))
             {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed.").arg(nbLine));
                 start = endOfLine;
                 continue;
             }
 
             lt::address startAddr;
-            int newStart = trim(buffer.data(), partsDelimiter + 1, delimIP - 1);
-            if (!parseIPAddress(buffer.data() + newStart, startAddr))
-            {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. Start IP of the range is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
-
             lt::address endAddr;
-            newStart = trim(buffer.data(), delimIP + 1, endOfLine);
-            if (!parseIPAddress(buffer.data() + newStart, endAddr))
-            {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. End IP of the range is malformed.").arg(nbLine));
-                start = endOfLine;
-                continue;
-            }
+            LineResult lineResult = ((format == FilterFormat::DAT)
+                ? parseDATLine(data, start, endOfLine, startAddr, endAddr)
+                : parseP2PLine(data, start, endOfLine, startAddr, endAddr));
+            if (lineResult == LineResult::Range)
+                lineResult = addRange(startAddr, endAddr, result);
 
-            if ((startAddr.is_v4() != endAddr.is_v4())
-                || (startAddr.is_v6() != endAddr.is_v6()))
-                {
-                ++parseErrorCount;
-                addLog(tr("IP filter line %1 is malformed. One IP is IPv4 and the other is IPv6!").arg(nbLine));
-                start = endOfLine;
-                continue;
+            if ((lineResult != LineResult::Range) && (lineResult != LineResult::Ignored))
+            {
+                ++result.errorCount;
+                if (static_cast<int>(result.errors.size()) < MAX_LOGGED_ERRORS)
+                    result.errors.emplace_back(result.lineCount, lineResult);
             }
 
             start = endOfLine;
 
-            try
-            {
-                m_filter.add_rule(startAddr, endAddr, lt::ip_filter::blocked);
-                ++ruleCount;
-            }
-            catch (const std::exception &e)
+            if (((result.lineCount % 4096) == 0) && abort)
             {
-                ++parseErrorCount;
-                addLog(tr("IP filter exception thrown for line %1. Exception is: %2")
-                       .arg(nbLine).arg(QString::fromLocal8Bit(e.what())));
+                result.isComplete = false;
+                break;
             }
         }
 
-        if (start >= dataSize)
-            offset = 0;
+        sortRanges(result.v4Ranges);
+        sortRanges(result.v6Ranges);
+        return result;
     }
 
-    if (parseErrorCount > MAX_LOGGED_ERRORS)
-        LogMsg(tr("%1 extra IP filter parsing errors occurred.", "513 extra IP filter parsing errors occurred.")
-               .arg(parseErrorCount - MAX_LOGGED_ERRORS), Log::CRITICAL);
-    return ruleCount;
-}
-
-int FilterParserThread::getlineInStream(QDataStream &stream, std::string &name, const char delim)
-{
-    char c;
-    int totalRead = 0;
-    int read;
-    do
-    {
-        read = stream.readRawData(&c, 1);
-        totalRead += read;
-        if (read > 0)
+    QString lineErrorMessage(const LineResult error, const int lineNumber)
+    {
+        switch (error)
         {
-            if (c != delim)
-            {
-                name += c;
-            }
-            else
-            {
-                // Delim found
-                return totalRead;
-            }
+        case LineResult::MalformedStart:
+            return FilterParserThread::tr("IP filter line %1 is malformed. Start IP of the range is malformed.").arg(lineNumber);
+        case LineResult::MalformedEnd:
+            return FilterParserThread::tr("IP filter line %1 is malformed. End IP of the range is malformed.").arg(lineNumber);
+        case LineResult::MixedFamilies:
+            return FilterParserThread::tr("IP filter line %1 is malformed. One IP is IPv4 and the other is IPv6!").arg(lineNumber);
+        default:
+            return FilterParserThread::tr("IP filter line %1 is malformed.").arg(lineNumber);
         }
     }
-    while (read > 0);
 
-    return totalRead;
-}
-
-// Parser for PeerGuardian ip filter in p2p format
-int FilterParserThread::parseP2BFilterFile()
-{
-    int ruleCount = 0;
-    QFile file(m_filePath);
-    if (!file.exists()) return ruleCount;
-
-    if (!file.open(QIODevice::ReadOnly))
+    // Text filter file is split on the line boundaries into parts that are parsed
+    // in parallel, their sorted ranges are merged afterwards.
+    ParsedRanges parseTextFilter(QByteArray &content, const FilterFormat format, const bool &abort)
     {
-        LogMsg(tr("I/O Error: Could not open IP filter file in read mode."), Log::CRITICAL);
-        return ruleCount;
-    }
+        const int size = content.size();
+        char *const data = content.data();
 
-    QDataStream stream(&file);
-    // Read header
-    char buf[7];
-    unsigned char version;
-    if (!stream.readRawData(buf, sizeof(buf))
-        || memcmp(buf, "\xFF\xFF\xFF\xFFP2B", 7)
-        || !stream.readRawData(reinterpret_cast<char*>(&version), sizeof(version)))
+        const int partCount = std::max(1, std::min((size / MIN_PART_SIZE), QThread::idealThreadCount()));
+        std::vector<int> bounds {0};
+        for (int i = 1; i < partCount; ++i)
         {
-        LogMsg(tr("Parsing Error: The filter file is not a valid PeerGuardian P2B file."), Log::CRITICAL);
-        return ruleCount;
-    }
+            const int pos = std::max(bounds.back(), static_cast<int>((static_cast<qint64>(size) * i) / partCount));
+            const auto *newline = static_cast<const char *>(memchr((data + pos), '\n', (size - pos)));
+            bounds.push_back(newline ? static_cast<int>(newline - data + 1) : size);
+        }
+        bounds.push_back(size);
 
-    if ((version == 1) || (version == 2))
-    {
-        qDebug ("p2b version 1 or 2");
-        unsigned int start, end;
+        std::vector<ParsedRanges> parts(partCount);
+        std::vector<std::unique_ptr<WorkerThread>> workers;
+        for (int i = 1; i < partCount; ++i)
+        {
+            workers.emplace_back(new WorkerThread([&parts, &bounds, &abort, data, format, i]()
+            {
+                parts[i] = parseTextPart(data, bounds[i], bounds[i + 1], format, abort);
+            }));
+            workers.back()->start();
+        }
+        parts[0] = parseTextPart(data, bounds[0], bounds[1], format, abort);
+        for (const std::unique_ptr<WorkerThread> &worker : workers)
+            worker->wait();
 
-        std::string name;
-        while (getlineInStream(stream, name, '\0') && !m_abort)
+        ParsedRanges result;
+        int loggedErrorCount = 0;
+        for (const ParsedRanges &part : parts)
         {
-            if (!stream.readRawData(reinterpret_cast<char*>(&start), sizeof(start))
-                || !stream.readRawData(reinterpret_cast<char*>(&end), sizeof(end)))
-                {
-                LogMsg(tr("Parsing Error: The filter file is not a valid PeerGuardian P2B file."), Log::CRITICAL);
-                return ruleCount;
+            for (const std::pair<int, LineResult> &error : part.errors)
+            {
+                if (loggedErrorCount == MAX_LOGGED_ERRORS)
+                    break;
+
+                LogMsg(lineErrorMessage(error.second, (result.lineCount + error.first)), Log::CRITICAL);
+                ++loggedErrorCount;
             }
 
-            // Network byte order to Host byte order
-            // asio address_v4 constructor expects it
-            // that way
-            const lt::address_v4 first(ntohl(start));
-            const lt::address_v4 last(ntohl(end));
-            // Apply to bittorrent session
-            try
+            appendSortedRanges(result.v4Ranges, part.v4Ranges);
+            appendSortedRanges(result.v6Ranges, part.v6Ranges);
+            result.ruleCount += part.ruleCount;
+            result.lineCount += part.lineCount;
+            result.errorCount += part.errorCount;
+            result.isComplete = (result.isComplete && part.isComplete);
+        }
+
+        if (result.errorCount > MAX_LOGGED_ERRORS)
+            LogMsg(FilterParserThread::tr("%1 extra IP filter parsing errors occurred.", "513 extra IP filter parsing errors occurred.")
+                   .arg(result.errorCount - MAX_LOGGED_ERRORS), Log::CRITICAL);
+        return result;
+    }
+
+    int getlineInStream(QDataStream &stream, std::string &name, const char delim)
+    {
+        char c;
+        int totalRead = 0;
+        int read;
+        do
+        {
+            read = stream.readRawData(&c, 1);
+            totalRead += read;
+            if (read > 0)
             {
-                m_filter.add_rule(first, last, lt::ip_filter::blocked);
-                ++ruleCount;
+                if (c != delim)
+                {
+                    name += c;
+                }
+                else
+                {
+                    // Delim found
+                    return totalRead;
+                }
             }
-            catch (const std::exception &) {}
         }
+        while (read > 0);
+
+        return totalRead;
     }
-    else if (version == 3)
+
+    void addP2BRange(const unsigned int start, const unsigned int end, ParsedRanges &ranges)
     {
-        qDebug ("p2b version 3");
-        unsigned int namecount;
-        if (!stream.readRawData(reinterpret_cast<char*>(&namecount), sizeof(namecount)))
+        // Network byte order to Host byte order
+        const lt::address_v4 first(ntohl(start));
+        const lt::address_v4 last(ntohl(end));
+        addRange(first, last, ranges);
+    }
+
+    // Parser for PeerGuardian ip filter in p2b format
+    ParsedRanges parseP2BFilter(const QByteArray &content, const bool &abort)
+    {
+        ParsedRanges result;
+        const auto logError = [&result]()
+        {
+            LogMsg(FilterParserThread::tr("Parsing Error: The filter file is not a valid PeerGuardian P2B file."), Log::CRITICAL);
+            result.isComplete = false;
+        };
+
+        QDataStream stream(content);
+        // Read header
+        char buf[7];
+        unsigned char version;
+        if (!stream.readRawData(buf, sizeof(buf))
+            || memcmp(buf, "\xFF\xFF\xFF\xFFP2B", 7)
+            || !stream.readRawData(reinterpret_cast<char*>(&version), sizeof(version)))
         {
-            LogMsg(tr("Parsing Error: The filter file is not a valid PeerGuardian P2B file."), Log::CRITICAL);
-            return ruleCount;
+            logError();
+            return result;
         }
 
-        namecount = ntohl(namecount);
-        // Reading names although, we don't really care about them
-        for (unsigned int i = 0; i < namecount; ++i)
+        if ((version == 1) || (version == 2))
         {
+            qDebug ("p2b version 1 or 2");
+            unsigned int start, end;
+
             std::string name;
-            if (!getlineInStream(stream, name, '\0'))
+            while (getlineInStream(stream, name, '\0'))
             {
-                LogMsg(tr("Parsing Error: The filter file is not a valid PeerGuardian P2B file."), Log::CRITICAL);
-                return ruleCount;
-            }
+                if (!stream.readRawData(reinterpret_cast<char*>(&start), sizeof(start))
+                    || !stream.readRawData(reinterpret_cast<char*>(&end), sizeof(end)))
+                {
+                    logError();
+                    return result;
+                }
 
-            if (m_abort) return ruleCount;
-        }
+                name.clear();
+                addP2BRange(start, end, result);
 
-        // Reading the ranges
-        unsigned int rangecount;
-        if (!stream.readRawData(reinterpret_cast<char*>(&rangecount), sizeof(rangecount)))
-        {
-            LogMsg(tr("Parsing Error: The filter file is not a valid PeerGuardian P2B file."), Log::CRITICAL);
-            return ruleCount;
+                if (abort)
+                {
+                    result.isComplete = false;
+                    return result;
+                }
+            }
         }
-
-        rangecount = ntohl(rangecount);
-        unsigned int name, start, end;
-        for (unsigned int i = 0; i < rangecount; ++i)
+        else if (version == 3)
         {
-            if (!stream.readRawData(reinterpret_cast<char*>(&name), sizeof(name))
-                || !stream.readRawData(reinterpret_cast<char*>(&start), sizeof(start))
-                || !stream.readRawData(reinterpret_cast<char*>(&end), sizeof(end)))
+            qDebug ("p2b version 3");
+            unsigned int namecount;
+            if (!stream.readRawData(reinterpret_cast<char*>(&namecount), sizeof(namecount)))
+            {
+                logError();
+                return result;
+            }
+
+            namecount = ntohl(namecount);
+            // Reading names although, we don't really care about them
+            for (unsigned int i = 0; i < namecount; ++i)
+            {
+                std::string name;
+                if (!getlineInStream(stream, name, '\0'))
+                {
+                    logError();
+                    return result;
+                }
+
+                if (abort)
                 {
-                LogMsg(tr("Parsing Error: The filter file is not a valid PeerGuardian P2B file."), Log::CRITICAL);
-                return ruleCount;
+                    result.isComplete = false;
+                    return result;
+                }
             }
 
-            // Network byte order to Host byte order
-            // asio address_v4 constructor expects it
-            // that way
-            const lt::address_v4 first(ntohl(start));
-            const lt::address_v4 last(ntohl(end));
-            // Apply to bittorrent session
-            try
+            // Reading the ranges
+            unsigned int rangecount;
+            if (!stream.readRawData(reinterpret_cast<char*>(&rangecount), sizeof(rangecount)))
             {
-                m_filter.add_rule(first, last, lt::ip_filter::blocked);
-                ++ruleCount;
+                logError();
+                return result;
             }
-            catch (const std::exception &) {}
 
-            if (m_abort) return ruleCount;
+            rangecount = ntohl(rangecount);
+            unsigned int name, start, end;
+            for (unsigned int i = 0; i < rangecount; ++i)
+            {
+                if (!stream.readRawData(reinterpret_cast<char*>(&name), sizeof(name))
+                    || !stream.readRawData(reinterpret_cast<char*>(&start), sizeof(start))
+                    || !stream.readRawData(reinterpret_cast<char*>(&end), sizeof(end)))
+                {
+                    logError();
+                    return result;
+                }
+
+                addP2BRange(start, end, result);
+
+                if (abort)
+                {
+                    result.isComplete = false;
+                    return result;
+                }
+            }
         }
+        else
+        {
+            logError();
+        }
+
+        sortRanges(result.v4Ranges);
+        return result;
     }
-    else
+
+    void applyRanges(lt::ip_filter &filter, const IPv4Range *v4Ranges, const quint32 v4RangeCount
+                     , const IPv6Range *v6Ranges, const quint32 v6RangeCount, const bool &abort)
+    {
+        for (quint32 i = 0; (i < v4RangeCount) && !abort; ++i)
+            filter.add_rule(lt::address_v4 {v4Ranges[i].first}, lt::address_v4 {v4Ranges[i].last}, lt::ip_filter::blocked);
+        for (quint32 i = 0; (i < v6RangeCount) && !abort; ++i)
+            filter.add_rule(lt::address_v6 {v6Ranges[i].first}, lt::address_v6 {v6Ranges[i].last}, lt::ip_filter::blocked);
+    }
+
+    QByteArray fileHash(QFile &file)
     {
-        LogMsg(tr("Parsing Error: The filter file is not a valid PeerGuardian P2B file."), Log::CRITICAL);
+        QCryptographicHash hash {QCryptographicHash::Sha1};
+        if (!file.seek(0) || !hash.addData(&file))
+            return {};
+        return hash.result();
     }
 
-    return ruleCount;
+    // Applies the ranges of the cache if it was made from the same filter file.
+    // Returns the rule count or -1 if the cache can't be used.
+    int loadCache(const CacheHeader &key, QFile &filterFile, lt::ip_filter &filter, const bool &abort)
+    {
+        QFile cacheFile {specialFolderLocation(SpecialFolder::Cache) + CACHE_FILE_NAME};
+        if (!cacheFile.open(QIODevice::ReadOnly) || (cacheFile.size() < static_cast<qint64>(sizeof(CacheHeader))))
+            return -1;
+
+        const uchar *data = cacheFile.map(0, cacheFile.size());
+        if (!data)
+            return -1;
+
+        CacheHeader header;
+        memcpy(&header, data, sizeof(header));
+        if ((memcmp(header.magic, key.magic, sizeof(header.magic)) != 0)
+            || (header.version != key.version) || (header.format != key.format)
+            || (header.sourceSize != key.sourceSize) || (header.sourceModified != key.sourceModified))
+            return -1;
+
+        const qint64 v4Size = static_cast<qint64>(header.v4RangeCount) * sizeof(IPv4Range);
+        const qint64 v6Size = static_cast<qint64>(header.v6RangeCount) * sizeof(IPv6Range);
+        if ((cacheFile.size() != static_cast<qint64>(sizeof(CacheHeader) + v4Size + v6Size)) || (header.ruleCount < 0))
+            return -1;
+
+        // The file may be replaced by another one having the same size within the timestamp resolution
+        const QByteArray sourceHash = fileHash(filterFile);
+        if ((sourceHash.size() != static_cast<int>(sizeof(header.sourceHash)))
+            || (memcmp(header.sourceHash, sourceHash.constData(), sizeof(header.sourceHash)) != 0))
+            return -1;
+
+        applyRanges(filter, reinterpret_cast<const IPv4Range *>(data + sizeof(CacheHeader)), header.v4RangeCount
+            , reinterpret_cast<const IPv6Range *>(data + sizeof(CacheHeader) + v4Size), header.v6RangeCount, abort);
+
+        if (header.errorCount > 0)
+            LogMsg(FilterParserThread::tr("%1 IP filter parsing errors occurred.", "513 IP filter parsing errors occurred.")
+                   .arg(header.errorCount), Log::CRITICAL);
+        return header.ruleCount;
+    }
+
+    void saveCache(const CacheHeader &header, const ParsedRanges &ranges)
+    {
+        const QString path = specialFolderLocation(SpecialFolder::Cache) + CACHE_FILE_NAME;
+        QSaveFile file {path};
+        if (!file.open(QIODevice::WriteOnly)
+            || (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header)))
+            || (file.write(reinterpret_cast<const char *>(ranges.v4Ranges.data()), (ranges.v4Ranges.size() * sizeof(IPv4Range)))
+                != static_cast<qint64>(ranges.v4Ranges.size() * sizeof(IPv4Range)))
+            || (file.write(reinterpret_cast<const char *>(ranges.v6Ranges.data()), (ranges.v6Ranges.size() * sizeof(IPv6Range)))
+                != static_cast<qint64>(ranges.v6Ranges.size() * sizeof(IPv6Range)))
+            || !file.commit())
+        {
+            LogMsg(FilterParserThread::tr("Couldn't save IP filter cache to \"%1\". Error: %2")
+                   .arg(path, file.errorString()), Log::WARNING);
+        }
+    }
+}
+
+FilterParserThread::FilterParserThread(QObject *parent)
+    : QThread(parent)
+    , m_abort(false)
+{
+}
+
+FilterParserThread::~FilterParserThread()
+{
+    m_abort = true;
+    wait();
 }
 
 // Process ip filter file
@@ -616,22 +788,7 @@ lt::ip_filter FilterParserThread::IPfilter()
 void FilterParserThread::run()
 {
     qDebug("Processing filter file");
-    int ruleCount = 0;
-    if (m_filePath.endsWith(".p2p", Qt::CaseInsensitive))
-    {
-        // PeerGuardian p2p file
-        ruleCount = parseP2PFilterFile();
-    }
-    else if (m_filePath.endsWith(".p2b", Qt::CaseInsensitive))
-    {
-        // PeerGuardian p2b file
-        ruleCount = parseP2BFilterFile();
-    }
-    else if (m_filePath.endsWith(".dat", Qt::CaseInsensitive))
-    {
-        // eMule DAT format
-        ruleCount = parseDATFilterFile();
-    }
+    const int ruleCount = loadFilterFile();
 
     if (m_abort) return;
 
@@ -647,59 +804,72 @@ void FilterParserThread::run()
     qDebug("IP Filter thread: finished parsing, filter applied");
 }
 
-int FilterParserThread::findAndNullDelimiter(char *const data, const char delimiter, const int start, const int end, const bool reverse)
+int FilterParserThread::loadFilterFile()
 {
-    if (!reverse)
-    {
-        for (int i = start; i <= end; ++i)
-        {
-            if (data[i] == delimiter)
-            {
-                data[i] = '\0';
-                return i;
-            }
-        }
-    }
+    FilterFormat format;
+    if (m_filePath.endsWith(".p2p", Qt::CaseInsensitive))
+        format = FilterFormat::P2P;
+    else if (m_filePath.endsWith(".p2b", Qt::CaseInsensitive))
+        format = FilterFormat::P2B;
+    else if (m_filePath.endsWith(".dat", Qt::CaseInsensitive))
+        format = FilterFormat::DAT;
     else
+        return 0;
+
+    QFile file(m_filePath);
+    if (!file.exists()) return 0;
+
+    if (!file.open(QIODevice::ReadOnly))
     {
-        for (int i = end; i >= start; --i)
-        {
-            if (data[i] == delimiter)
-            {
-                data[i] = '\0';
-                return i;
-            }
-        }
+        LogMsg(tr("I/O Error: Could not open IP filter file in read mode."), Log::CRITICAL);
+        return 0;
     }
 
-    return -1;
-}
+    CacheHeader header {};
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.format = static_cast<quint32>(format);
+    header.sourceSize = file.size();
+    header.sourceModified = QFileInfo(file).lastModified().toMSecsSinceEpoch();
 
-int FilterParserThread::trim(char *const data, const int start, const int end)
-{
-    if (start >= end) return start;
-    int newStart = start;
+    const int cachedRuleCount = loadCache(header, file, m_filter, m_abort);
+    if (cachedRuleCount >= 0)
+    {
+        qDebug("IP filter is loaded from the cache");
+        return cachedRuleCount;
+    }
 
-    for (int i = start; i <= end; ++i)
+    if (!file.seek(0))
     {
-        if (isspace(data[i]) != 0)
-        {
-            data[i] = '\0';
-        }
-        else
-        {
-            newStart = i;
-            break;
-        }
+        LogMsg(tr("I/O Error: Could not open IP filter file in read mode."), Log::CRITICAL);
+        return 0;
     }
 
-    for (int i = end; i >= start; --i)
+    QByteArray content = file.readAll();
+    file.close();
+    // The file may change while being read, don't cache it then
+    const bool isFullyRead = (content.size() == header.sourceSize);
+    const QByteArray sourceHash = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+    memcpy(header.sourceHash, sourceHash.constData(), sizeof(header.sourceHash));
+
+    ParsedRanges ranges = ((format == FilterFormat::P2B)
+        ? parseP2BFilter(content, m_abort)
+        : parseTextFilter(content, format, m_abort));
+    content.clear();
+
+    coalesceRanges(ranges.v4Ranges);
+    coalesceRanges(ranges.v6Ranges);
+    applyRanges(m_filter, ranges.v4Ranges.data(), static_cast<quint32>(ranges.v4Ranges.size())
+        , ranges.v6Ranges.data(), static_cast<quint32>(ranges.v6Ranges.size()), m_abort);
+
+    if (ranges.isComplete && isFullyRead && !m_abort)
     {
-        if (isspace(data[i]) != 0)
-            data[i] = '\0';
-        else
-            break;
+        header.ruleCount = ranges.ruleCount;
+        header.errorCount = ranges.errorCount;
+        header.v4RangeCount = static_cast<quint32>(ranges.v4Ranges.size());
+        header.v6RangeCount = static_cast<quint32>(ranges.v6Ranges.size());
+        saveCache(header, ranges);
     }
 
-    return newStart;
+    return ranges.ruleCount;
 }
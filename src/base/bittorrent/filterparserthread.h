@@ -32,8 +32,9 @@
 
 #include <QThread>
 
-class QDataStream;
-
+// Parses the IP filter file in a thread. The ranges of the text filter files are
+// parsed by several threads at once and the merged result is kept in a binary
+// cache file, so the same filter file is loaded without parsing the next time.
 class FilterParserThread final : public QThread
 {
     Q_OBJECT
@@ -52,12 +53,7 @@ protected:
     void run() override;
 
 private:
-    int findAndNullDelimiter(char *const data, char delimiter, int start, int end, bool reverse = false);
-    int trim(char *const data, int start, int end);
-    int parseDATFilterFile();
-    int parseP2PFilterFile();
-    int getlineInStream(QDataStream &stream, std::string &name, char delim);
-    int parseP2BFilterFile();
+    int loadFilterFile();
 
     bool m_abort;
     QString m_filePath;
@@ -29,6 +29,7 @@
 #include "peerinfo.h"
 
 #include <QBitArray>
+#include <QStringList>
 
 #include "base/bittorrent/torrenthandle.h"
 #include "base/net/geoipmanager.h"
@@ -37,11 +38,39 @@
 
 using namespace BitTorrent;
 
+namespace
+{
+    struct FlagInfo
+    {
+        PeerInfo::PeerFlag flag;
+        char symbol;
+        const char *description;
+    };
+
+    const FlagInfo FLAG_INFOS[] =
+    {
+        {PeerInfo::InterestedRemoteChoked, 'd', QT_TRANSLATE_NOOP("PeerInfo", "Interested(local) and Choked(peer)")},
+        {PeerInfo::InterestedRemoteUnchoked, 'D', QT_TRANSLATE_NOOP("PeerInfo", "interested(local) and unchoked(peer)")},
+        {PeerInfo::RemoteInterestedChoked, 'u', QT_TRANSLATE_NOOP("PeerInfo", "interested(peer) and choked(local)")},
+        {PeerInfo::RemoteInterestedUnchoked, 'U', QT_TRANSLATE_NOOP("PeerInfo", "interested(peer) and unchoked(local)")},
+        {PeerInfo::OptimisticUnchoke, 'O', QT_TRANSLATE_NOOP("PeerInfo", "optimistic unchoke")},
+        {PeerInfo::Snubbed, 'S', QT_TRANSLATE_NOOP("PeerInfo", "peer snubbed")},
+        {PeerInfo::Incoming, 'I', QT_TRANSLATE_NOOP("PeerInfo", "incoming connection")},
+        {PeerInfo::NotInterestedRemoteUnchoked, 'K', QT_TRANSLATE_NOOP("PeerInfo", "not interested(local) and unchoked(peer)")},
+        {PeerInfo::RemoteNotInterestedUnchoked, '?', QT_TRANSLATE_NOOP("PeerInfo", "not interested(peer) and unchoked(local)")},
+        {PeerInfo::FromPeX, 'X', QT_TRANSLATE_NOOP("PeerInfo", "peer from PEX")},
+        {PeerInfo::FromDHT, 'H', QT_TRANSLATE_NOOP("PeerInfo", "peer from DHT")},
+        {PeerInfo::RC4Encrypted, 'E', QT_TRANSLATE_NOOP("PeerInfo", "encrypted traffic")},
+        {PeerInfo::PlaintextEncrypted, 'e', QT_TRANSLATE_NOOP("PeerInfo", "encrypted handshake")},
+        {PeerInfo::UTPSocket, 'P', nullptr}, // described by C_UTP
+        {PeerInfo::FromLSD, 'L', QT_TRANSLATE_NOOP("PeerInfo", "peer from LSD")}
+    };
+}
+
 PeerInfo::PeerInfo(const TorrentHandle *torrent, const lt::peer_info &nativeInfo)
     : m_nativeInfo(nativeInfo)
 {
     calcRelevance(torrent);
-    determineFlags();
 }
 
 bool PeerInfo::fromDHT() const
@@ -255,135 +284,110 @@ qreal PeerInfo::relevance() const
     return m_relevance;
 }
 
-void PeerInfo::determineFlags()
+PeerInfo::PeerFlags PeerInfo::peerFlags() const
 {
+    PeerFlags flags;
+
     if (isInteresting())
     {
         // d = Your client wants to download, but peer doesn't want to send (interested and choked)
-        if (isRemoteChocked())
-        {
-            m_flags += "d ";
-            m_flagsDescription += ("d = "
-                + tr("Interested(local) and Choked(peer)") + '\n');
-        }
-        else
-        {
-            // D = Currently downloading (interested and not choked)
-            m_flags += "D ";
-            m_flagsDescription += ("D = "
-                + tr("interested(local) and unchoked(peer)") + '\n');
-        }
+        // D = Currently downloading (interested and not choked)
+        flags |= (isRemoteChocked() ? InterestedRemoteChoked : InterestedRemoteUnchoked);
     }
 
     if (isRemoteInterested())
     {
         // u = Peer wants your client to upload, but your client doesn't want to (interested and choked)
-        if (isChocked())
-        {
-            m_flags += "u ";
-            m_flagsDescription += ("u = "
-                + tr("interested(peer) and choked(local)") + '\n');
-        }
-        else
-        {
-            // U = Currently uploading (interested and not choked)
-            m_flags += "U ";
-            m_flagsDescription += ("U = "
-                + tr("interested(peer) and unchoked(local)") + '\n');
-        }
+        // U = Currently uploading (interested and not choked)
+        flags |= (isChocked() ? RemoteInterestedChoked : RemoteInterestedUnchoked);
     }
 
     // O = Optimistic unchoke
     if (optimisticUnchoke())
-    {
-        m_flags += "O ";
-        m_flagsDescription += ("O = " + tr("optimistic unchoke") + '\n');
-    }
+        flags |= OptimisticUnchoke;
 
     // S = Peer is snubbed
     if (isSnubbed())
-    {
-        m_flags += "S ";
-        m_flagsDescription += ("S = " + tr("peer snubbed") + '\n');
-    }
+        flags |= Snubbed;
 
     // I = Peer is an incoming connection
     if (!isLocalConnection())
-    {
-        m_flags += "I ";
-        m_flagsDescription += ("I = " + tr("incoming connection") + '\n');
-    }
+        flags |= Incoming;
 
     // K = Peer is unchoking your client, but your client is not interested
     if (!isRemoteChocked() && !isInteresting())
-    {
-        m_flags += "K ";
-        m_flagsDescription += ("K = "
-            + tr("not interested(local) and unchoked(peer)") + '\n');
-    }
+        flags |= NotInterestedRemoteUnchoked;
 
     // ? = Your client unchoked the peer but the peer is not interested
     if (!isChocked() && !isRemoteInterested())
-    {
-        m_flags += "? ";
-        m_flagsDescription += ("? = "
-            + tr("not interested(peer) and unchoked(local)") + '\n');
-    }
+        flags |= RemoteNotInterestedUnchoked;
 
     // X = Peer was included in peerlists obtained through Peer Exchange (PEX)
     if (fromPeX())
-    {
-        m_flags += "X ";
-        m_flagsDescription += ("X = " + tr("peer from PEX") + '\n');
-    }
+        flags |= FromPeX;
 
     // H = Peer was obtained through DHT
     if (fromDHT())
-    {
-        m_flags += "H ";
-        m_flagsDescription += ("H = " + tr("peer from DHT") + '\n');
-    }
+        flags |= FromDHT;
 
     // E = Peer is using Protocol Encryption (all traffic)
     if (isRC4Encrypted())
-    {
-        m_flags += "E ";
-        m_flagsDescription += ("E = " + tr("encrypted traffic")  + '\n');
-    }
+        flags |= RC4Encrypted;
 
     // e = Peer is using Protocol Encryption (handshake)
     if (isPlaintextEncrypted())
-    {
-        m_flags += "e ";
-        m_flagsDescription += ("e = " + tr("encrypted handshake") + '\n');
-    }
+        flags |= PlaintextEncrypted;
 
     // P = Peer is using uTorrent uTP
     if (useUTPSocket())
-    {
-        m_flags += "P ";
-        m_flagsDescription += ("P = " + QString::fromUtf8(C_UTP) + '\n');
-    }
+        flags |= UTPSocket;
 
     // L = Peer is local
     if (fromLSD())
-    {
-        m_flags += "L ";
-        m_flagsDescription += ("L = " + tr("peer from LSD") + '\n');
-    }
+        flags |= FromLSD;
 
-    m_flags = m_flags.trimmed();
-    m_flagsDescription = m_flagsDescription.trimmed();
+    return flags;
 }
 
 QString PeerInfo::flags() const
 {
-    return m_flags;
+    return flagsString(peerFlags());
 }
 
 QString PeerInfo::flagsDescription() const
 {
-    return m_flagsDescription;
+    return flagsDescription(peerFlags());
+}
+
+QString PeerInfo::flagsString(const PeerFlags flags)
+{
+    QString result;
+    for (const FlagInfo &info : FLAG_INFOS)
+    {
+        if (!flags.testFlag(info.flag))
+            continue;
+
+        if (!result.isEmpty())
+            result += QLatin1Char(' ');
+        result += QLatin1Char(info.symbol);
+    }
+    return result;
+}
+
+QString PeerInfo::flagsDescription(const PeerFlags flags)
+{
+    QStringList lines;
+    for (const FlagInfo &info : FLAG_INFOS)
+    {
+        if (!flags.testFlag(info.flag))
+            continue;
+
+        const QString description = (info.flag == UTPSocket)
+            ? QString::fromUtf8(C_UTP)
+            : tr(info.description);
+        lines += (QLatin1Char(info.symbol) + QLatin1String(" = ") + description);
+    }
+    return lines.join(QLatin1Char('\n'));
 }
 
 int PeerInfo::downloadingPieceIndex() const
@@ -44,6 +44,26 @@ namespace BitTorrent
         Q_DECLARE_TR_FUNCTIONS(PeerInfo)
 
     public:
+        enum PeerFlag
+        {
+            InterestedRemoteChoked = 0x1,        // d
+            InterestedRemoteUnchoked = 0x2,      // D
+            RemoteInterestedChoked = 0x4,        // u
+            RemoteInterestedUnchoked = 0x8,      // U
+            OptimisticUnchoke = 0x10,            // O
+            Snubbed = 0x20,                      // S
+            Incoming = 0x40,                     // I
+            NotInterestedRemoteUnchoked = 0x80,  // K
+            RemoteNotInterestedUnchoked = 0x100, // ?
+            FromPeX = 0x200,                     // X
+            FromDHT = 0x400,                     // H
+            RC4Encrypted = 0x800,                // E
+            PlaintextEncrypted = 0x1000,         // e
+            UTPSocket = 0x2000,                  // P
+            FromLSD = 0x4000                     // L
+        };
+        Q_DECLARE_FLAGS(PeerFlags, PeerFlag)
+
         PeerInfo() = default;
         PeerInfo(const TorrentHandle *torrent, const lt::peer_info &nativeInfo);
 
@@ -86,20 +106,24 @@ namespace BitTorrent
         QBitArray pieces() const;
         QString connectionType() const;
         qreal relevance() const;
+        PeerFlags peerFlags() const;
         QString flags() const;
         QString flagsDescription() const;
         QString country() const;
         int downloadingPieceIndex() const;
 
+        // Flags are stored as a bitmask, these build the text forms only when they are needed
+        static QString flagsString(PeerFlags flags);
+        static QString flagsDescription(PeerFlags flags);
+
     private:
         void calcRelevance(const TorrentHandle *torrent);
-        void determineFlags();
 
         lt::peer_info m_nativeInfo = {};
         qreal m_relevance = 0;
-        QString m_flags;
-        QString m_flagsDescription;
 
         mutable QString m_country;
     };
 }
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(BitTorrent::PeerInfo::PeerFlags)
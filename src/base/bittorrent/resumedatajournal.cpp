@@ -0,0 +1,349 @@
+#include "resumedatajournal.h"
+
+#include <QtGlobal>
+
+#include <cstring>
+#include <limits>
+
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QtEndian>
+
+namespace
+{
+    const char FILE_MAGIC[] = {'Q', 'B', 'R', 'J'};
+    const quint32 FILE_VERSION = 1;
+    const int FILE_HEADER_SIZE = 8;
+
+    // type (1), checksum of key and data (2), key length (2), data length (4)
+    const int RECORD_HEADER_SIZE = 9;
+
+    const quint8 RECORD_PUT = 1;
+    const quint8 RECORD_REMOVE = 2;
+
+    // don't bother compacting small journals
+    const qint64 MIN_COMPACTION_SIZE = 4 * 1024 * 1024;
+    const int COMPACTION_BUFFER_SIZE = 1024 * 1024;
+
+    QByteArray fileHeader()
+    {
+        QByteArray header(FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.resize(FILE_HEADER_SIZE);
+        qToBigEndian<quint32>(FILE_VERSION, header.data() + sizeof(FILE_MAGIC));
+        return header;
+    }
+
+    qint64 recordSize(const int keySize, const int dataSize)
+    {
+        return (RECORD_HEADER_SIZE + keySize + dataSize);
+    }
+
+    // Appends encoded record to `buffer`, returns the position of the data in it
+    int encodeRecord(QByteArray &buffer, const quint8 type, const QByteArray &key, const char *data, const int dataSize)
+    {
+        Q_ASSERT(key.size() <= std::numeric_limits<quint16>::max());
+
+        const int start = buffer.size();
+        buffer.resize(start + RECORD_HEADER_SIZE);
+        buffer.append(key);
+        buffer.append(data, dataSize);
+
+        char *header = buffer.data() + start;
+        const char *payload = header + RECORD_HEADER_SIZE;
+        header[0] = static_cast<char>(type);
+        qToBigEndian<quint16>(qChecksum(payload, static_cast<uint>(key.size() + dataSize)), header + 1);
+        qToBigEndian<quint16>(static_cast<quint16>(key.size()), header + 3);
+        qToBigEndian<quint32>(static_cast<quint32>(dataSize), header + 5);
+
+        return (start + RECORD_HEADER_SIZE + key.size());
+    }
+
+    bool syncFile(QFile &file)
+    {
+#ifdef Q_OS_WIN
+        return ::FlushFileBuffers(reinterpret_cast<HANDLE>(::_get_osfhandle(file.handle())));
+#else
+        return (::fsync(file.handle()) == 0);
+#endif
+    }
+}
+
+ResumeDataJournal::ResumeDataJournal(const QString &filePath)
+    : m_file {filePath}
+{
+}
+
+ResumeDataJournal::~ResumeDataJournal()
+{
+    if (isOpen())
+        commit();
+}
+
+bool ResumeDataJournal::open(QHash<QString, QByteArray> *records)
+{
+    if (!m_file.open(QIODevice::ReadWrite))
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize == 0)
+    {
+        const QByteArray header = fileHeader();
+        if ((m_file.write(header) != header.size()) || !m_file.flush())
+        {
+            m_errorString = m_file.errorString();
+            m_file.close();
+            return false;
+        }
+
+        m_fileSize = m_liveSize = header.size();
+        return true;
+    }
+
+    QByteArray buffer;
+    const uchar *mapped = m_file.map(0, fileSize);
+    const uchar *content = mapped;
+    if (!content)
+    {
+        buffer = m_file.readAll();
+        content = reinterpret_cast<const uchar *>(buffer.constData());
+    }
+
+    if ((fileSize < FILE_HEADER_SIZE) || (memcmp(content, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+        || (qFromBigEndian<quint32>(content + sizeof(FILE_MAGIC)) != FILE_VERSION))
+    {
+        m_errorString = QCoreApplication::translate("ResumeDataJournal", "Unsupported journal format");
+        m_file.close();
+        return false;
+    }
+
+    qint64 pos = FILE_HEADER_SIZE;
+    m_liveSize = FILE_HEADER_SIZE;
+    while ((pos + RECORD_HEADER_SIZE) <= fileSize)
+    {
+        const uchar *header = content + pos;
+        const quint8 type = header[0];
+        const quint16 checksum = qFromBigEndian<quint16>(header + 1);
+        const quint16 keySize = qFromBigEndian<quint16>(header + 3);
+        const quint32 dataSize = qFromBigEndian<quint32>(header + 5);
+
+        const qint64 end = pos + recordSize(keySize, dataSize);
+        if (end > fileSize)
+            break;
+
+        const char *payload = reinterpret_cast<const char *>(header + RECORD_HEADER_SIZE);
+        if (qChecksum(payload, (keySize + dataSize)) != checksum)
+            break;
+
+        const QString key = QString::fromUtf8(payload, keySize);
+        const auto oldRecordIter = m_index.constFind(key);
+        if (oldRecordIter != m_index.cend())
+            m_liveSize -= recordSize(keySize, oldRecordIter->size);
+
+        if (type == RECORD_PUT)
+        {
+            m_index[key] = {(pos + RECORD_HEADER_SIZE + keySize), static_cast<int>(dataSize)};
+            m_liveSize += recordSize(keySize, dataSize);
+            if (records)
+                records->insert(key, QByteArray {(payload + keySize), static_cast<int>(dataSize)});
+        }
+        else if (type == RECORD_REMOVE)
+        {
+            m_index.remove(key);
+            if (records)
+                records->remove(key);
+        }
+        else
+        {
+            break;
+        }
+
+        pos = end;
+    }
+
+    if (mapped)
+        m_file.unmap(const_cast<uchar *>(mapped));
+    buffer.clear();
+
+    // drop the tail of an interrupted commit
+    if ((pos < fileSize) && !m_file.resize(pos))
+    {
+        m_errorString = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_fileSize = pos;
+    m_file.seek(m_fileSize);
+    return true;
+}
+
+bool ResumeDataJournal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString ResumeDataJournal::errorString() const
+{
+    return m_errorString;
+}
+
+bool ResumeDataJournal::contains(const QString &key) const
+{
+    return m_index.contains(key);
+}
+
+void ResumeDataJournal::put(const QString &key, const QByteArray &data)
+{
+    append(RECORD_PUT, key, data);
+}
+
+void ResumeDataJournal::remove(const QString &key)
+{
+    if (m_index.contains(key))
+        append(RECORD_REMOVE, key, {});
+}
+
+void ResumeDataJournal::append(const quint8 type, const QString &key, const QByteArray &data)
+{
+    const QByteArray keyData = key.toUtf8();
+    const int dataPos = encodeRecord(m_pending, type, keyData, data.constData(), data.size());
+
+    const auto oldRecordIter = m_index.constFind(key);
+    if (oldRecordIter != m_index.cend())
+        m_liveSize -= recordSize(keyData.size(), oldRecordIter->size);
+
+    if (type == RECORD_PUT)
+    {
+        // the record will be written right after the already committed ones
+        m_index[key] = {(m_fileSize + dataPos), data.size()};
+        m_liveSize += recordSize(keyData.size(), data.size());
+    }
+    else
+    {
+        m_index.remove(key);
+    }
+}
+
+bool ResumeDataJournal::hasPendingChanges() const
+{
+    return !m_pending.isEmpty();
+}
+
+bool ResumeDataJournal::commit()
+{
+    if (m_pending.isEmpty())
+        return true;
+
+    if ((m_file.write(m_pending) != m_pending.size()) || !m_file.flush() || !syncFile(m_file))
+    {
+        m_errorString = m_file.errorString();
+        // Discard the partially written batch. It is kept pending, so
+        // the offsets in the index stay valid for the next attempt.
+        m_file.resize(m_fileSize);
+        m_file.seek(m_fileSize);
+        return false;
+    }
+
+    m_fileSize += m_pending.size();
+    m_pending.clear();
+    return true;
+}
+
+bool ResumeDataJournal::needsCompaction() const
+{
+    return ((m_fileSize >= MIN_COMPACTION_SIZE) && (m_fileSize > (2 * m_liveSize)));
+}
+
+bool ResumeDataJournal::compact()
+{
+    if (!commit())
+        return false;
+
+    QSaveFile newFile {m_file.fileName()};
+    if (!newFile.open(QIODevice::WriteOnly))
+    {
+        m_errorString = newFile.errorString();
+        return false;
+    }
+
+    const uchar *content = m_file.map(0, m_fileSize);
+    const auto readData = [this, content](const Location &location) -> QByteArray
+    {
+        if (content)
+            return QByteArray::fromRawData(reinterpret_cast<const char *>(content + location.offset), location.size);
+
+        m_file.seek(location.offset);
+        return m_file.read(location.size);
+    };
+
+    QHash<QString, Location> newIndex;
+    newIndex.reserve(m_index.size());
+
+    QByteArray buffer = fileHeader();
+    qint64 newFileSize = 0;
+    bool ok = true;
+    for (auto it = m_index.cbegin(); ok && (it != m_index.cend()); ++it)
+    {
+        const QByteArray data = readData(it.value());
+        ok = (data.size() == it->size);
+        if (!ok)
+            break;
+
+        const int dataPos = encodeRecord(buffer, RECORD_PUT, it.key().toUtf8(), data.constData(), data.size());
+        newIndex.insert(it.key(), {(newFileSize + dataPos), data.size()});
+
+        if (buffer.size() >= COMPACTION_BUFFER_SIZE)
+        {
+            ok = (newFile.write(buffer) == buffer.size());
+            newFileSize += buffer.size();
+            buffer.clear();
+        }
+    }
+
+    if (ok)
+    {
+        ok = (newFile.write(buffer) == buffer.size());
+        newFileSize += buffer.size();
+    }
+
+    if (content)
+        m_file.unmap(const_cast<uchar *>(content));
+
+    if (!ok)
+    {
+        m_errorString = (m_file.error() != QFileDevice::NoError) ? m_file.errorString() : newFile.errorString();
+        newFile.cancelWriting();
+        m_file.seek(m_fileSize);
+        return false;
+    }
+
+    // the journal must be closed before it can be replaced on Windows
+    m_file.close();
+    const bool committed = newFile.commit();
+    if (!committed)
+        m_errorString = newFile.errorString();
+
+    if (!m_file.open(QIODevice::ReadWrite))
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    if (committed)
+    {
+        m_index = newIndex;
+        m_fileSize = m_liveSize = newFileSize;
+    }
+    m_file.seek(m_fileSize);
+    return committed;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+// Append-only store of resume data records keyed by file name.
+// Every change is appended to a single segment file, so saving many records
+// costs one write and one sync (see commit()). Records that were replaced or
+// removed are dropped by compact(), which rewrites the live records only.
+class ResumeDataJournal
+{
+    Q_DISABLE_COPY(ResumeDataJournal)
+
+public:
+    explicit ResumeDataJournal(const QString &filePath);
+    ~ResumeDataJournal();
+
+    // Reads the whole journal sequentially. If `records` isn't null it receives
+    // the current data of every key. A torn record at the end (e.g. after a crash
+    // in the middle of a commit) is discarded.
+    bool open(QHash<QString, QByteArray> *records = nullptr);
+    bool isOpen() const;
+    QString errorString() const;
+
+    bool contains(const QString &key) const;
+    void put(const QString &key, const QByteArray &data);
+    void remove(const QString &key);
+
+    bool hasPendingChanges() const;
+    // Writes the pending records and syncs the file once for all of them
+    bool commit();
+
+    bool needsCompaction() const;
+    bool compact();
+
+private:
+    struct Location
+    {
+        qint64 offset = 0;  // of the record data
+        int size = 0;
+    };
+
+    void append(quint8 type, const QString &key, const QByteArray &data);
+
+    QFile m_file;
+    QString m_errorString;
+    QHash<QString, Location> m_index;
+    QByteArray m_pending;
+    qint64 m_fileSize = 0;
+    qint64 m_liveSize = 0;
+};
@@ -28,23 +28,78 @@
 
 #include "resumedatasavingmanager.h"
 
+#include <iterator>
+
 #include <libtorrent/bencode.hpp>
 #include <libtorrent/entry.hpp>
 
 #include <QByteArray>
+#include <QFile>
 #include <QSaveFile>
+#include <QTimer>
 
+#include "base/global.h"
 #include "base/logger.h"
 #include "base/utils/fs.h"
 #include "base/utils/io.h"
+#include "resumedatajournal.h"
+
+namespace
+{
+    const QString JOURNAL_FILE_NAME = QStringLiteral("resume.journal");
+    const QString RESUME_FILE_FILTER = QStringLiteral("*.fastresume");
+
+    // save requests arriving within this interval share a single sync
+    const int COMMIT_DELAY = 200;
+}
 
-ResumeDataSavingManager::ResumeDataSavingManager(const QString &resumeFolderPath)
+ResumeDataSavingManager::ResumeDataSavingManager(const QString &resumeFolderPath, const bool useJournal)
     : m_resumeDataDir(resumeFolderPath)
 {
+    if (useJournal)
+        m_journal = std::make_unique<ResumeDataJournal>(m_resumeDataDir.absoluteFilePath(JOURNAL_FILE_NAME));
+}
+
+ResumeDataSavingManager::~ResumeDataSavingManager()
+{
+    flush();
+}
+
+bool ResumeDataSavingManager::isJournalEnabled() const
+{
+    return static_cast<bool>(m_journal);
+}
+
+QHash<QString, QByteArray> ResumeDataSavingManager::load()
+{
+    QHash<QString, QByteArray> records;
+    if (m_journal && openJournal(&records))
+    {
+        importResumeFiles(records);
+        return records;
+    }
+
+    const QStringList filenames = m_resumeDataDir.entryList({RESUME_FILE_FILTER}, QDir::Files, QDir::Unsorted);
+    records.reserve(filenames.size());
+    for (const QString &filename : filenames)
+    {
+        QFile file {m_resumeDataDir.absoluteFilePath(filename)};
+        if (file.open(QIODevice::ReadOnly))
+            records.insert(filename, file.readAll());
+    }
+
+    return records;
 }
 
-void ResumeDataSavingManager::save(const QString &filename, const QByteArray &data) const
+void ResumeDataSavingManager::save(const QString &filename, const QByteArray &data)
 {
+    if (m_journal && openJournal())
+    {
+        m_journal->put(filename, data);
+        scheduleCommit();
+        return;
+    }
+
     const QString filepath = m_resumeDataDir.absoluteFilePath(filename);
 
     QSaveFile file {filepath};
@@ -55,8 +110,17 @@ void ResumeDataSavingManager::save(const QString &filename, const QByteArray &da
     }
 }
 
-void ResumeDataSavingManager::save(const QString &filename, const std::shared_ptr<lt::entry> &data) const
+void ResumeDataSavingManager::save(const QString &filename, const std::shared_ptr<lt::entry> &data)
 {
+    if (m_journal && openJournal())
+    {
+        QByteArray buffer;
+        lt::bencode(std::back_inserter(buffer), *data);
+        m_journal->put(filename, buffer);
+        scheduleCommit();
+        return;
+    }
+
     const QString filepath = m_resumeDataDir.absoluteFilePath(filename);
 
     QSaveFile file {filepath};
@@ -75,9 +139,96 @@ void ResumeDataSavingManager::save(const QString &filename, const std::shared_pt
     }
 }
 
-void ResumeDataSavingManager::remove(const QString &filename) const
+void ResumeDataSavingManager::remove(const QString &filename)
 {
+    if (m_journal && openJournal())
+    {
+        m_journal->remove(filename);
+        scheduleCommit();
+        return;
+    }
+
     const QString filepath = m_resumeDataDir.absoluteFilePath(filename);
 
     Utils::Fs::forceRemove(filepath);
 }
+
+void ResumeDataSavingManager::flush()
+{
+    m_isCommitScheduled = false;
+    if (!m_journal || !m_journal->isOpen())
+        return;
+
+    if (!m_journal->commit())
+    {
+        LogMsg(tr("Couldn't save resume data journal '%1'. Error: %2")
+            .arg(m_resumeDataDir.absoluteFilePath(JOURNAL_FILE_NAME), m_journal->errorString()), Log::CRITICAL);
+        return;
+    }
+
+    if (m_journal->needsCompaction() && !m_journal->compact())
+    {
+        LogMsg(tr("Couldn't compact resume data journal '%1'. Error: %2")
+            .arg(m_resumeDataDir.absoluteFilePath(JOURNAL_FILE_NAME), m_journal->errorString()), Log::WARNING);
+    }
+}
+
+bool ResumeDataSavingManager::openJournal(QHash<QString, QByteArray> *records)
+{
+    if (m_journal->isOpen())
+        return true;
+
+    if (m_journal->open(records))
+        return true;
+
+    // fall back to separate files
+    LogMsg(tr("Couldn't open resume data journal '%1'. Error: %2")
+        .arg(m_resumeDataDir.absoluteFilePath(JOURNAL_FILE_NAME), m_journal->errorString()), Log::CRITICAL);
+    m_journal.reset();
+    return false;
+}
+
+void ResumeDataSavingManager::scheduleCommit()
+{
+    if (m_isCommitScheduled)
+        return;
+
+    m_isCommitScheduled = true;
+    QTimer::singleShot(COMMIT_DELAY, this, &ResumeDataSavingManager::flush);
+}
+
+void ResumeDataSavingManager::importResumeFiles(QHash<QString, QByteArray> &records)
+{
+    const QStringList filenames = m_resumeDataDir.entryList({RESUME_FILE_FILTER}, QDir::Files, QDir::Unsorted);
+    if (filenames.isEmpty())
+        return;
+
+    QStringList importedFiles;
+    importedFiles.reserve(filenames.size());
+    for (const QString &filename : filenames)
+    {
+        // the journal has newer data if it contains the same key
+        if (!m_journal->contains(filename))
+        {
+            QFile file {m_resumeDataDir.absoluteFilePath(filename)};
+            if (!file.open(QIODevice::ReadOnly))
+                continue;
+
+            const QByteArray data = file.readAll();
+            m_journal->put(filename, data);
+            records.insert(filename, data);
+        }
+
+        importedFiles << filename;
+    }
+
+    if (!m_journal->commit())
+    {
+        LogMsg(tr("Couldn't save resume data journal '%1'. Error: %2")
+            .arg(m_resumeDataDir.absoluteFilePath(JOURNAL_FILE_NAME), m_journal->errorString()), Log::CRITICAL);
+        return;
+    }
+
+    for (const QString &filename : asConst(importedFiles))
+        Utils::Fs::forceRemove(m_resumeDataDir.absoluteFilePath(filename));
+}
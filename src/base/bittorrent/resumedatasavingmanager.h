@@ -33,23 +33,41 @@
 #include <libtorrent/fwd.hpp>
 
 #include <QDir>
+#include <QHash>
 #include <QObject>
 
 class QByteArray;
+class ResumeDataJournal;
 
+// Saves resume data either into separate files of the resume folder or,
+// if the journal is enabled, into a single append-only journal file.
+// Journal writes are grouped, so a whole save round costs one sync.
 class ResumeDataSavingManager : public QObject
 {
     Q_OBJECT
     Q_DISABLE_COPY(ResumeDataSavingManager)
 
 public:
-    explicit ResumeDataSavingManager(const QString &resumeFolderPath);
+    explicit ResumeDataSavingManager(const QString &resumeFolderPath, bool useJournal = false);
+    ~ResumeDataSavingManager() override;
+
+    bool isJournalEnabled() const;
+    // Reads all saved data keyed by file name. The journal is read sequentially,
+    // resume files left from the per-file mode are moved into it.
+    QHash<QString, QByteArray> load();
 
 public slots:
-    void save(const QString &filename, const QByteArray &data) const;
-    void save(const QString &filename, const std::shared_ptr<lt::entry> &data) const;
-    void remove(const QString &filename) const;
+    void save(const QString &filename, const QByteArray &data);
+    void save(const QString &filename, const std::shared_ptr<lt::entry> &data);
+    void remove(const QString &filename);
+    void flush();
 
 private:
+    bool openJournal(QHash<QString, QByteArray> *records = nullptr);
+    void scheduleCommit();
+    void importResumeFiles(QHash<QString, QByteArray> &records);
+
     const QDir m_resumeDataDir;
+    std::unique_ptr<ResumeDataJournal> m_journal;
+    bool m_isCommitScheduled = false;
 };
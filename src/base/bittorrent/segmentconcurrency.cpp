@@ -0,0 +1,392 @@
+#include "segmentconcurrency.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <QDateTime>
+#include <QVariantHash>
+#include <QVariantList>
+
+#include "base/global.h"
+#include "base/settingsstorage.h"
+
+namespace
+{
+    const QString KEY_HOST_CONCURRENCY = QStringLiteral("BitTorrent/XDown/HostConcurrency");
+
+    // speed samples are averaged over windows of this length
+    const qint64 WINDOW_LENGTH = 10 * 1000;
+    const int MIN_WINDOW_SAMPLES = 3;
+    // the step is kept only if the speed improves at least by 10%
+    const qreal IMPROVEMENT_RATIO = 1.1;
+    const int STALL_WINDOWS = 2;
+    // try one more step after about a minute of settled downloading
+    const int PROBE_WINDOWS = 6;
+    const int MAX_HISTORY_SIZE = 32;
+    const int MAX_STORED_HOSTS = 256;
+
+    qint64 currentTime()
+    {
+        return QDateTime::currentMSecsSinceEpoch();
+    }
+}
+
+using namespace BitTorrent;
+
+// SegmentConcurrencyTuner
+
+SegmentConcurrencyTuner::SegmentConcurrencyTuner(const QString &host, const int fixedConcurrency)
+    : m_host {host}
+{
+    if (fixedConcurrency > 0)
+    {
+        m_isAdaptive = false;
+        setConcurrency(fixedConcurrency, ConcurrencyChange::Fixed, 0);
+        return;
+    }
+
+    const SegmentConcurrencyController *controller = SegmentConcurrencyController::instance();
+    const int remembered = controller ? controller->initialConcurrency(m_host) : 0;
+    if (remembered > 0)
+    {
+        // known host: start with its best value and probe later
+        setConcurrency(remembered, ConcurrencyChange::Initial, 0);
+    }
+    else
+    {
+        // unknown host: start probing right after the first measurement
+        setConcurrency(SegmentConcurrencyController::DEFAULT_CONCURRENCY, ConcurrencyChange::Initial, 0);
+        m_settledWindows = PROBE_WINDOWS - 1;
+    }
+}
+
+int SegmentConcurrencyTuner::concurrency() const
+{
+    return m_concurrency;
+}
+
+int SegmentConcurrencyTuner::targetConcurrency() const
+{
+    return (m_pendingChange.concurrency > 0) ? m_pendingChange.concurrency : m_concurrency;
+}
+
+bool SegmentConcurrencyTuner::isAdaptive() const
+{
+    return m_isAdaptive;
+}
+
+QString SegmentConcurrencyTuner::host() const
+{
+    return m_host;
+}
+
+QVector<ConcurrencyChange> SegmentConcurrencyTuner::history() const
+{
+    return m_history;
+}
+
+bool SegmentConcurrencyTuner::setFixedConcurrency(const int concurrency)
+{
+    if (concurrency > 0)
+    {
+        m_isAdaptive = false;
+        if (concurrency == m_concurrency)
+        {
+            // the value being used is kept, a change requested by the adaptation is dropped
+            m_pendingChange = {};
+            m_pendingStep = 0;
+            return false;
+        }
+
+        return requestConcurrency(concurrency, ConcurrencyChange::Fixed, 0);
+    }
+
+    m_isAdaptive = true;
+    m_baselineSpeed = 0;
+    m_settledWindows = 0;
+    restart();
+    if (m_concurrency <= 0)
+        setConcurrency(SegmentConcurrencyController::DEFAULT_CONCURRENCY, ConcurrencyChange::Initial, 0);
+    return false;
+}
+
+bool SegmentConcurrencyTuner::addSpeedSample(const qlonglong speed)
+{
+    // the speed measured while a change is pending belongs to neither value
+    if (!m_isAdaptive || (m_pendingChange.concurrency > 0))
+        return false;
+
+    const qint64 now = currentTime();
+    if (m_windowStart == 0)
+        m_windowStart = now;
+
+    m_windowSum += std::max<qlonglong>(speed, 0);
+    ++m_windowSamples;
+
+    if (((now - m_windowStart) < WINDOW_LENGTH) || (m_windowSamples < MIN_WINDOW_SAMPLES))
+        return false;
+
+    const qlonglong averageSpeed = m_windowSum / m_windowSamples;
+    m_windowStart = now;
+    m_windowSum = 0;
+    m_windowSamples = 0;
+
+    return evaluate(averageSpeed);
+}
+
+bool SegmentConcurrencyTuner::handleError()
+{
+    if (!m_isAdaptive)
+        return false;
+
+    m_baselineSpeed = 0;
+    m_settledWindows = 0;
+    restart();
+
+    const int concurrency = std::max(SegmentConcurrencyController::MIN_CONCURRENCY, m_concurrency / 2);
+    if (concurrency == m_concurrency)
+    {
+        // nothing to reduce, the host fails with the value being used
+        if (SegmentConcurrencyController *controller = SegmentConcurrencyController::instance())
+            controller->reportError(m_host, m_concurrency);
+        return false;
+    }
+
+    // the host learns about the error once the reduced value is used
+    return requestConcurrency(concurrency, ConcurrencyChange::Error, 0);
+}
+
+bool SegmentConcurrencyTuner::applyConcurrency(const int concurrency)
+{
+    if ((m_pendingChange.concurrency <= 0) || (concurrency != m_pendingChange.concurrency))
+        return false;
+
+    const ConcurrencyChange change = std::exchange(m_pendingChange, {});
+    const int step = std::exchange(m_pendingStep, 0);
+
+    if (change.reason == ConcurrencyChange::Error)
+    {
+        if (SegmentConcurrencyController *controller = SegmentConcurrencyController::instance())
+            controller->reportError(m_host, concurrency);
+    }
+
+    setConcurrency(concurrency, change.reason, change.speed);
+    // the next window measures the new value
+    restart();
+    m_lastStep = step;
+    return true;
+}
+
+void SegmentConcurrencyTuner::restart()
+{
+    // the speed measured before the pause says nothing about the current step
+    m_lastStep = 0;
+    m_stalledWindows = 0;
+    m_windowStart = 0;
+    m_windowSum = 0;
+    m_windowSamples = 0;
+}
+
+bool SegmentConcurrencyTuner::evaluate(const qlonglong averageSpeed)
+{
+    SegmentConcurrencyController *controller = SegmentConcurrencyController::instance();
+    const int maxConcurrency = SegmentConcurrencyController::MAX_CONCURRENCY;
+
+    if (averageSpeed <= 0)
+    {
+        if (++m_stalledWindows < STALL_WINDOWS)
+            return false;
+
+        m_stalledWindows = 0;
+        m_lastStep = 0;
+        m_baselineSpeed = 0;
+        m_settledWindows = 0;
+
+        const int concurrency = std::max(SegmentConcurrencyController::MIN_CONCURRENCY, m_concurrency / 2);
+        if (concurrency == m_concurrency)
+            return false;
+
+        return requestConcurrency(concurrency, ConcurrencyChange::Stall, 0);
+    }
+
+    m_stalledWindows = 0;
+
+    if (m_lastStep > 0)
+    {
+        if (averageSpeed > (m_baselineSpeed * IMPROVEMENT_RATIO))
+        {
+            // the step paid off, keep growing
+            if (controller)
+                controller->reportSpeed(m_host, m_concurrency, averageSpeed);
+            m_baselineSpeed = averageSpeed;
+
+            if (m_concurrency < maxConcurrency)
+            {
+                const int step = std::min(std::max(1, m_concurrency / 2), maxConcurrency - m_concurrency);
+                return requestConcurrency(m_concurrency + step, ConcurrencyChange::Grow, averageSpeed, step);
+            }
+
+            m_lastStep = 0;
+            m_settledWindows = 0;
+            return false;
+        }
+
+        // no improvement, return to the previous value
+        const int concurrency = m_concurrency - m_lastStep;
+        if (controller)
+            controller->reportSpeed(m_host, concurrency, m_baselineSpeed);
+        m_lastStep = 0;
+        m_settledWindows = 0;
+        return requestConcurrency(concurrency, ConcurrencyChange::Revert, averageSpeed);
+    }
+
+    // settled
+    m_baselineSpeed = averageSpeed;
+    if (controller)
+        controller->reportSpeed(m_host, m_concurrency, averageSpeed);
+
+    if ((++m_settledWindows < PROBE_WINDOWS) || (m_concurrency >= maxConcurrency))
+        return false;
+
+    m_settledWindows = 0;
+    const int step = std::min(std::max(1, m_concurrency / 2), maxConcurrency - m_concurrency);
+    return requestConcurrency(m_concurrency + step, ConcurrencyChange::Probe, averageSpeed, step);
+}
+
+bool SegmentConcurrencyTuner::requestConcurrency(const int concurrency, const ConcurrencyChange::Reason reason
+    , const qlonglong speed, const int step)
+{
+    if (concurrency == targetConcurrency())
+        return false;
+
+    if (concurrency == m_concurrency)
+    {
+        // back to the value being used, nothing has to be applied
+        m_pendingChange = {};
+        m_pendingStep = 0;
+        return false;
+    }
+
+    m_pendingChange = {currentTime(), concurrency, speed, reason};
+    m_pendingStep = step;
+    return true;
+}
+
+void SegmentConcurrencyTuner::setConcurrency(const int concurrency, const ConcurrencyChange::Reason reason, const qlonglong speed)
+{
+    m_concurrency = concurrency;
+
+    if (m_history.size() >= MAX_HISTORY_SIZE)
+        m_history.removeFirst();
+    m_history.append({currentTime(), concurrency, speed, reason});
+}
+
+// SegmentConcurrencyController
+
+SegmentConcurrencyController *SegmentConcurrencyController::m_instance = nullptr;
+
+SegmentConcurrencyController::SegmentConcurrencyController()
+{
+    load();
+}
+
+SegmentConcurrencyController::~SegmentConcurrencyController()
+{
+    store();
+}
+
+void SegmentConcurrencyController::initInstance()
+{
+    if (!m_instance)
+        m_instance = new SegmentConcurrencyController;
+}
+
+void SegmentConcurrencyController::freeInstance()
+{
+    delete m_instance;
+    m_instance = nullptr;
+}
+
+SegmentConcurrencyController *SegmentConcurrencyController::instance()
+{
+    return m_instance;
+}
+
+int SegmentConcurrencyController::initialConcurrency(const QString &host) const
+{
+    return m_hosts.value(host).concurrency;
+}
+
+void SegmentConcurrencyController::reportSpeed(const QString &host, const int concurrency, const qlonglong speed)
+{
+    if (host.isEmpty())
+        return;
+
+    HostRecord &record = m_hosts[host];
+    // a fresh measurement of the remembered value replaces the old one
+    if ((record.concurrency == concurrency) || (speed >= record.speed))
+        record = {concurrency, speed, currentTime()};
+}
+
+void SegmentConcurrencyController::reportError(const QString &host, const int concurrency)
+{
+    if (host.isEmpty())
+        return;
+
+    HostRecord &record = m_hosts[host];
+    record.concurrency = (record.concurrency > 0) ? std::min(record.concurrency, concurrency) : concurrency;
+    record.speed = 0;
+    record.timestamp = currentTime();
+}
+
+QHash<QString, SegmentConcurrencyController::HostRecord> SegmentConcurrencyController::hosts() const
+{
+    return m_hosts;
+}
+
+void SegmentConcurrencyController::requestConcurrencyChange(TorrentHandle *task, const int concurrency)
+{
+    emit concurrencyChangeRequested(task, concurrency);
+}
+
+void SegmentConcurrencyController::load()
+{
+    const QVariantHash hosts = SettingsStorage::instance()->loadValue(KEY_HOST_CONCURRENCY).toHash();
+    for (auto it = hosts.cbegin(); it != hosts.cend(); ++it)
+    {
+        const QVariantList values = it.value().toList();
+        if (values.size() != 3)
+            continue;
+
+        const int concurrency = values[0].toInt();
+        if ((concurrency < MIN_CONCURRENCY) || (concurrency > MAX_CONCURRENCY))
+            continue;
+
+        m_hosts.insert(it.key(), {concurrency, values[1].toLongLong(), values[2].toLongLong()});
+    }
+}
+
+void SegmentConcurrencyController::store() const
+{
+    QVector<QString> hosts = m_hosts.keys().toVector();
+    if (hosts.size() > MAX_STORED_HOSTS)
+    {
+        // keep the most recently used hosts
+        std::nth_element(hosts.begin(), (hosts.begin() + MAX_STORED_HOSTS), hosts.end()
+            , [this](const QString &left, const QString &right)
+        {
+            return (m_hosts[left].timestamp > m_hosts[right].timestamp);
+        });
+        hosts.resize(MAX_STORED_HOSTS);
+    }
+
+    QVariantHash data;
+    for (const QString &host : asConst(hosts))
+    {
+        const HostRecord &record = m_hosts[host];
+        if (record.concurrency > 0)
+            data.insert(host, QVariantList {record.concurrency, record.speed, record.timestamp});
+    }
+
+    SettingsStorage::instance()->storeValue(KEY_HOST_CONCURRENCY, data);
+}
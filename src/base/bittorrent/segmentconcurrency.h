@@ -0,0 +1,138 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+
+    struct ConcurrencyChange
+    {
+        enum Reason
+        {
+            Initial,
+            Grow,       // throughput improved with the previous step
+            Revert,     // last step didn't improve throughput
+            Probe,      // periodic attempt to use more connections
+            Error,      // download error reported
+            Stall,      // no throughput while downloading
+            Fixed       // set explicitly
+        };
+
+        qint64 timestamp = 0;   // msecs since epoch
+        int concurrency = 0;
+        qlonglong speed = 0;    // average speed that led to the change, B/s
+        Reason reason = Initial;
+    };
+
+    // Chooses the number of segments (connections) of a single HTTP task.
+    // Average throughput is measured for every value: while it improves the
+    // count grows, when it doesn't the previous value is restored. Errors and
+    // stalls halve the count. The best values are remembered per host by
+    // SegmentConcurrencyController and used as the starting point of new tasks.
+    // A new value is only requested, the tuner waits until the download reports
+    // it as applied before it measures, steps or remembers anything else.
+    class SegmentConcurrencyTuner
+    {
+    public:
+        SegmentConcurrencyTuner() = default;
+        SegmentConcurrencyTuner(const QString &host, int fixedConcurrency);
+
+        // the value the download uses
+        int concurrency() const;
+        // the value the download should use, it differs while a change is pending
+        int targetConcurrency() const;
+        bool isAdaptive() const;
+        QString host() const;
+        // applied changes only
+        QVector<ConcurrencyChange> history() const;
+
+        // non-positive value enables adaptive mode again,
+        // returns true if a change was requested
+        bool setFixedConcurrency(int concurrency);
+
+        // Each of these returns true if a change was requested
+        bool addSpeedSample(qlonglong speed);
+        bool handleError();
+
+        // The download uses the requested value now,
+        // returns false if it isn't the pending one
+        bool applyConcurrency(int concurrency);
+
+        // starts a new measurement, e.g. after the task was paused
+        void restart();
+
+    private:
+        bool evaluate(qlonglong averageSpeed);
+        bool requestConcurrency(int concurrency, ConcurrencyChange::Reason reason, qlonglong speed, int step = 0);
+        void setConcurrency(int concurrency, ConcurrencyChange::Reason reason, qlonglong speed);
+
+        QString m_host;
+        bool m_isAdaptive = true;
+        int m_concurrency = 0;
+        int m_lastStep = 0;             // last change made to probe for better throughput
+        qlonglong m_baselineSpeed = 0;  // average speed with the value before the last step
+        int m_stalledWindows = 0;
+        int m_settledWindows = 0;
+
+        qint64 m_windowStart = 0;
+        qlonglong m_windowSum = 0;
+        int m_windowSamples = 0;
+
+        QVector<ConcurrencyChange> m_history;
+
+        // requested change that isn't applied yet, no pending change if the concurrency isn't positive
+        ConcurrencyChange m_pendingChange;
+        int m_pendingStep = 0;
+    };
+
+    // Remembers the best segment count per host across tasks and sessions
+    class SegmentConcurrencyController final : public QObject
+    {
+        Q_OBJECT
+        Q_DISABLE_COPY(SegmentConcurrencyController)
+
+    public:
+        struct HostRecord
+        {
+            int concurrency = 0;
+            qlonglong speed = 0;
+            qint64 timestamp = 0;
+        };
+
+        static const int MIN_CONCURRENCY = 1;
+        static const int MAX_CONCURRENCY = 32;
+        static const int DEFAULT_CONCURRENCY = 4;
+
+        static void initInstance();
+        static void freeInstance();
+        static SegmentConcurrencyController *instance();
+
+        int initialConcurrency(const QString &host) const;
+        void reportSpeed(const QString &host, int concurrency, qlonglong speed);
+        void reportError(const QString &host, int concurrency);
+        QHash<QString, HostRecord> hosts() const;
+
+        void requestConcurrencyChange(TorrentHandle *task, int concurrency);
+
+    signals:
+        // The new value must be applied to the running download, then reported back
+        // with XDownHandleImpl::handleDownConcurrentApplied(). The tuner of the task
+        // holds its current value until that.
+        void concurrencyChangeRequested(BitTorrent::TorrentHandle *task, int concurrency);
+
+    private:
+        SegmentConcurrencyController();
+        ~SegmentConcurrencyController() override;
+
+        void load();
+        void store() const;
+
+        static SegmentConcurrencyController *m_instance;
+
+        QHash<QString, HostRecord> m_hosts;
+    };
+}
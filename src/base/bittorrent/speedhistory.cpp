@@ -0,0 +1,494 @@
+#include "speedhistory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <QDateTime>
+#include <QPair>
+#include <QUrl>
+
+#include "base/global.h"
+#include "base/logger.h"
+#include "base/profile.h"
+#include "session.h"
+#include "torrenthandle.h"
+
+namespace
+{
+    const QString FILE_NAME = QStringLiteral("speedhistory.dat");
+    const char MAGIC[8] = {'X', 'D', 'S', 'P', 'H', 'I', 'S', 'T'};
+    // must be changed together with the layout of the file
+    const quint32 VERSION = 1;
+
+    const int SAMPLE_INTERVAL = 1000;
+
+    struct LevelSpec
+    {
+        qint64 interval;    // secs, multiple of the interval of the previous level
+        int capacity;
+    };
+
+    // 10 minutes, 2 hours, 1 day and 10 days
+    const LevelSpec LEVELS[] = {{1, 600}, {10, 720}, {120, 720}, {1200, 720}};
+    const int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+    // download and upload
+    const int COLUMN_COUNT = 2;
+
+    const int MAX_SERIES = 256;
+    const int KEY_SIZE = 256;
+    // a late sample fills that many missing seconds with its value instead of zero
+    const qint64 MAX_HELD_GAP = 5;
+
+    struct FileHeader
+    {
+        char magic[8];
+        quint32 version;
+        quint32 seriesCount;
+    };
+
+    int levelOffset(const int level)
+    {
+        int offset = 0;
+        for (int i = 0; i < level; ++i)
+            offset += LEVELS[i].capacity;
+        return offset;
+    }
+
+    qint64 seriesDataSize()
+    {
+        return (static_cast<qint64>(levelOffset(LEVEL_COUNT)) * COLUMN_COUNT * sizeof(qint32));
+    }
+
+    QString indexKey(const BitTorrent::SpeedHistory::SeriesType type, const QString &key)
+    {
+        return (QString::number(static_cast<int>(type)) + QLatin1Char(':') + key);
+    }
+
+    qint64 currentTime()
+    {
+        return (QDateTime::currentMSecsSinceEpoch() / 1000);
+    }
+
+    struct LevelState
+    {
+        qint64 lastTick;        // of the newest point
+        qint64 bucketTick;      // of the point being averaged from the finer level, 0 if none
+        qint64 base[COLUMN_COUNT];  // values of the oldest point
+        qint64 last[COLUMN_COUNT];  // values of the newest point
+        qint64 accumulator[COLUMN_COUNT];
+        qint32 head;
+        qint32 count;
+    };
+
+    struct SeriesHeader
+    {
+        char key[KEY_SIZE];     // UTF-8, zero padded
+        qint32 type;            // 0 if the series is free
+        qint32 reserved;
+        qint64 lastActive;      // secs since epoch of the last non-zero sample
+        LevelState levels[LEVEL_COUNT];
+    };
+
+    // The file consists of the FileHeader, then all the SeriesHeaders, then the columns
+    // of all the series. Columns of the same series and level follow each other.
+    static_assert(((sizeof(FileHeader) % 8) == 0), "series headers must be aligned");
+
+    qint64 headersSize()
+    {
+        return (sizeof(FileHeader) + (MAX_SERIES * sizeof(SeriesHeader)));
+    }
+
+    qint64 storageSize()
+    {
+        return (headersSize() + (MAX_SERIES * seriesDataSize()));
+    }
+
+    SeriesHeader *seriesHeader(uchar *data, const int index)
+    {
+        return reinterpret_cast<SeriesHeader *>(data + sizeof(FileHeader) + (index * sizeof(SeriesHeader)));
+    }
+
+    qint32 *column(uchar *data, const int index, const int level, const int columnIndex)
+    {
+        const qint64 offset = headersSize() + (index * seriesDataSize())
+            + ((static_cast<qint64>(levelOffset(level)) * COLUMN_COUNT) + (columnIndex * LEVELS[level].capacity)) * sizeof(qint32);
+        return reinterpret_cast<qint32 *>(data + offset);
+    }
+}
+
+using namespace BitTorrent;
+
+SpeedHistory *SpeedHistory::m_instance = nullptr;
+
+void SpeedHistory::initInstance()
+{
+    if (!m_instance)
+        m_instance = new SpeedHistory;
+}
+
+void SpeedHistory::freeInstance()
+{
+    delete m_instance;
+    m_instance = nullptr;
+}
+
+SpeedHistory *SpeedHistory::instance()
+{
+    return m_instance;
+}
+
+SpeedHistory::SpeedHistory()
+{
+    openStorage();
+
+    connect(&m_timer, &QTimer::timeout, this, &SpeedHistory::sample);
+    m_timer.start(SAMPLE_INTERVAL);
+}
+
+SpeedHistory::~SpeedHistory()
+{
+    if (m_file.isOpen())
+    {
+        m_file.unmap(m_data);
+        m_file.close();
+    }
+}
+
+SpeedHistory::Series SpeedHistory::series(const SeriesType type, const QString &key, const qint64 period) const
+{
+    const auto iter = m_index.constFind(indexKey(type, key));
+    if (iter == m_index.cend())
+        return {};
+
+    int level = 0;
+    while (((level + 1) < LEVEL_COUNT) && ((LEVELS[level].interval * LEVELS[level].capacity) < period))
+        ++level;
+
+    const LevelState &state = seriesHeader(m_data, *iter)->levels[level];
+    const qint64 interval = LEVELS[level].interval;
+    const int capacity = LEVELS[level].capacity;
+
+    Series result;
+    result.interval = interval;
+    if (state.count == 0)
+        return result;
+
+    const qint32 *downloadColumn = column(m_data, *iter, level, 0);
+    const qint32 *uploadColumn = column(m_data, *iter, level, 1);
+    const qint64 firstTick = state.lastTick - state.count + 1;
+    const qint64 fromTime = currentTime() - period;
+
+    result.points.reserve(static_cast<int>(std::min<qint64>(state.count, ((period / interval) + 1))));
+
+    qint64 download = state.base[0];
+    qint64 upload = state.base[1];
+    for (int i = 0; i < state.count; ++i)
+    {
+        if (i > 0)
+        {
+            const int slot = (state.head + i) % capacity;
+            download += downloadColumn[slot];
+            upload += uploadColumn[slot];
+        }
+
+        const qint64 time = (firstTick + i) * interval;
+        if (time >= fromTime)
+            result.points.append({time, download, upload});
+    }
+
+    return result;
+}
+
+QStringList SpeedHistory::keys(const SeriesType type) const
+{
+    const QString prefix = indexKey(type, {});
+
+    QStringList result;
+    for (auto iter = m_index.cbegin(); iter != m_index.cend(); ++iter)
+    {
+        if (iter.key().startsWith(prefix))
+            result.append(iter.key().mid(prefix.size()));
+    }
+
+    return result;
+}
+
+void SpeedHistory::openStorage()
+{
+    const qint64 size = storageSize();
+    bool isValid = false;
+
+    m_file.setFileName(specialFolderLocation(SpecialFolder::Data) + FILE_NAME);
+    if (m_file.open(QIODevice::ReadWrite))
+    {
+        isValid = (m_file.size() == size);
+        if (!isValid)
+        {
+            m_file.resize(0);
+            m_file.resize(size);
+        }
+
+        m_data = m_file.map(0, size);
+        if (!m_data)
+            m_file.close();
+    }
+
+    if (!m_data)
+    {
+        LogMsg(tr("Couldn't open the speed history file \"%1\". The speed history won't be kept across restarts.")
+            .arg(m_file.fileName()), Log::WARNING);
+
+        m_fallbackData.fill('\0', size);
+        m_data = reinterpret_cast<uchar *>(m_fallbackData.data());
+        isValid = false;
+    }
+
+    if (isValid)
+    {
+        const auto *header = reinterpret_cast<const FileHeader *>(m_data);
+        isValid = ((std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0)
+            && (header->version == VERSION) && (header->seriesCount == MAX_SERIES));
+    }
+
+    if (!isValid)
+        resetStorage();
+
+    loadIndex();
+}
+
+void SpeedHistory::resetStorage()
+{
+    // the column data is only read within the counts, so it is left as it is
+    std::memset(m_data, 0, headersSize());
+
+    auto *header = reinterpret_cast<FileHeader *>(m_data);
+    std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->version = VERSION;
+    header->seriesCount = MAX_SERIES;
+}
+
+void SpeedHistory::loadIndex()
+{
+    m_index.clear();
+    m_freeSeries.clear();
+
+    for (int index = (MAX_SERIES - 1); index >= 0; --index)
+    {
+        SeriesHeader *header = seriesHeader(m_data, index);
+
+        bool isValid = (((header->type == static_cast<int>(SeriesType::Task)) || (header->type == static_cast<int>(SeriesType::Host)))
+            && (header->key[KEY_SIZE - 1] == '\0'));
+        for (int level = 0; isValid && (level < LEVEL_COUNT); ++level)
+        {
+            const LevelState &state = header->levels[level];
+            isValid = ((state.head >= 0) && (state.head < LEVELS[level].capacity)
+                && (state.count >= 0) && (state.count <= LEVELS[level].capacity));
+        }
+
+        if (!isValid)
+        {
+            std::memset(header, 0, sizeof(SeriesHeader));
+            m_freeSeries.append(index);
+            continue;
+        }
+
+        m_index.insert(indexKey(static_cast<SeriesType>(header->type), QString::fromUtf8(header->key)), index);
+    }
+}
+
+void SpeedHistory::sample()
+{
+    const qint64 now = currentTime();
+    if (now == m_lastSampleTime)
+        return;
+    m_lastSampleTime = now;
+
+    QHash<QString, QPair<qint64, qint64>> hostSpeeds;
+    const auto sampleTask = [this, now, &hostSpeeds](const TorrentHandle *torrent)
+    {
+        const qint64 values[COLUMN_COUNT] = {torrent->downloadPayloadRate(), torrent->uploadPayloadRate()};
+        addSample(SeriesType::Task, torrent->hash(), now, values);
+
+        if (torrent->getHandleType() != TaskHandleType::XDown_Handle)
+            return;
+
+        const QString host = QUrl(torrent->url()).host();
+        if (!host.isEmpty())
+        {
+            QPair<qint64, qint64> &hostSpeed = hostSpeeds[host];
+            hostSpeed.first += values[0];
+            hostSpeed.second += values[1];
+        }
+    };
+
+    const Session *session = Session::instance();
+    for (const TorrentHandle *torrent : asConst(session->torrents()))
+        sampleTask(torrent);
+    for (const TorrentHandle *torrent : asConst(session->xdowns()))
+        sampleTask(torrent);
+
+    for (auto iter = hostSpeeds.cbegin(); iter != hostSpeeds.cend(); ++iter)
+    {
+        const qint64 values[COLUMN_COUNT] = {iter->first, iter->second};
+        addSample(SeriesType::Host, iter.key(), now, values);
+    }
+}
+
+void SpeedHistory::addSample(const SeriesType type, const QString &key, const qint64 now, const qint64 values[])
+{
+    const bool isActive = ((values[0] > 0) || (values[1] > 0));
+
+    int index = m_index.value(indexKey(type, key), -1);
+    if (index < 0)
+    {
+        // don't waste the series on the tasks that haven't transferred anything
+        if (!isActive)
+            return;
+
+        index = allocateSeries(type, key);
+        if (index < 0)
+            return;
+    }
+
+    if (isActive)
+        seriesHeader(m_data, index)->lastActive = now;
+
+    pushPoint(index, 0, (now / LEVELS[0].interval), values, true);
+}
+
+int SpeedHistory::allocateSeries(const SeriesType type, const QString &key)
+{
+    const QByteArray keyData = key.toUtf8();
+    if (keyData.size() >= KEY_SIZE)
+        return -1;
+
+    int index = -1;
+    if (!m_freeSeries.isEmpty())
+    {
+        index = m_freeSeries.takeLast();
+    }
+    else
+    {
+        // replace the least recently active series
+        qint64 oldestActive = std::numeric_limits<qint64>::max();
+        for (int i = 0; i < MAX_SERIES; ++i)
+        {
+            const qint64 lastActive = seriesHeader(m_data, i)->lastActive;
+            if (lastActive < oldestActive)
+            {
+                oldestActive = lastActive;
+                index = i;
+            }
+        }
+
+        const SeriesHeader *header = seriesHeader(m_data, index);
+        m_index.remove(indexKey(static_cast<SeriesType>(header->type), QString::fromUtf8(header->key)));
+    }
+
+    SeriesHeader *header = seriesHeader(m_data, index);
+    std::memset(header, 0, sizeof(SeriesHeader));
+    std::memcpy(header->key, keyData.constData(), keyData.size());
+    header->type = static_cast<int>(type);
+
+    m_index.insert(indexKey(type, key), index);
+    return index;
+}
+
+void SpeedHistory::pushPoint(const int index, const int level, const qint64 tick, const qint64 values[], const bool holdGaps)
+{
+    LevelState &state = seriesHeader(m_data, index)->levels[level];
+
+    if (state.count > 0)
+    {
+        // the clock went back or the point is known already
+        if (tick <= state.lastTick)
+            return;
+
+        const qint64 gap = tick - state.lastTick - 1;
+        if (holdGaps && (gap <= MAX_HELD_GAP))
+        {
+            // the sample is late rather than the transfer was stopped
+            for (qint64 missingTick = (state.lastTick + 1); missingTick < tick; ++missingTick)
+            {
+                appendValue(index, level, values);
+                if ((level + 1) < LEVEL_COUNT)
+                    feedLevel(index, (level + 1), missingTick, values);
+            }
+        }
+        else
+        {
+            const qint64 zeros[COLUMN_COUNT] = {};
+            const qint64 count = std::min<qint64>(gap, LEVELS[level].capacity);
+            for (qint64 i = 0; i < count; ++i)
+                appendValue(index, level, zeros);
+        }
+    }
+
+    appendValue(index, level, values);
+    state.lastTick = tick;
+
+    if ((level + 1) < LEVEL_COUNT)
+        feedLevel(index, (level + 1), tick, values);
+}
+
+void SpeedHistory::feedLevel(const int index, const int level, const qint64 childTick, const qint64 values[])
+{
+    LevelState &state = seriesHeader(m_data, index)->levels[level];
+    const qint64 divider = LEVELS[level].interval / LEVELS[level - 1].interval;
+    const qint64 tick = childTick / divider;
+
+    if (state.bucketTick != tick)
+    {
+        if (state.bucketTick != 0)
+        {
+            // the missing points of the finer level count as zeros
+            qint64 average[COLUMN_COUNT];
+            for (int i = 0; i < COLUMN_COUNT; ++i)
+                average[i] = state.accumulator[i] / divider;
+            pushPoint(index, level, state.bucketTick, average, false);
+        }
+
+        state.bucketTick = tick;
+        std::fill(std::begin(state.accumulator), std::end(state.accumulator), 0);
+    }
+
+    for (int i = 0; i < COLUMN_COUNT; ++i)
+        state.accumulator[i] += values[i];
+}
+
+void SpeedHistory::appendValue(const int index, const int level, const qint64 values[])
+{
+    LevelState &state = seriesHeader(m_data, index)->levels[level];
+    const int capacity = LEVELS[level].capacity;
+
+    if (state.count == capacity)
+    {
+        // drop the oldest point, the delta of the next one turns it into the new base
+        state.head = (state.head + 1) % capacity;
+        --state.count;
+        for (int i = 0; i < COLUMN_COUNT; ++i)
+            state.base[i] += column(m_data, index, level, i)[state.head];
+    }
+
+    const int slot = (state.head + state.count) % capacity;
+    for (int i = 0; i < COLUMN_COUNT; ++i)
+    {
+        qint32 *columnData = column(m_data, index, level, i);
+        if (state.count == 0)
+        {
+            columnData[slot] = 0;
+            state.base[i] = values[i];
+            state.last[i] = values[i];
+        }
+        else
+        {
+            const qint64 delta = qBound<qint64>(std::numeric_limits<qint32>::min(), (values[i] - state.last[i])
+                , std::numeric_limits<qint32>::max());
+            columnData[slot] = static_cast<qint32>(delta);
+            state.last[i] += delta;
+        }
+    }
+
+    ++state.count;
+}
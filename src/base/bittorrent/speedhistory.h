@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+namespace BitTorrent
+{
+    // Keeps the download/upload speed history of the tasks and of the hosts the
+    // HTTP tasks download from. Every series is stored in fixed-size rings of a few
+    // resolutions, each coarser one being the average of the finer one. The rings
+    // keep the differences between neighbouring points in 32-bit columns and live
+    // in a memory-mapped file, so the history survives restarts. The number of series
+    // is limited, the least recently active ones are replaced by the new ones, so the
+    // memory used doesn't depend on the number of tasks.
+    class SpeedHistory final : public QObject
+    {
+        Q_OBJECT
+        Q_DISABLE_COPY(SpeedHistory)
+
+    public:
+        enum class SeriesType
+        {
+            Task = 1,
+            Host = 2
+        };
+
+        struct Point
+        {
+            qint64 time = 0;    // secs since epoch, start of the interval
+            qint64 download = 0;
+            qint64 upload = 0;
+        };
+
+        struct Series
+        {
+            qint64 interval = 0;    // secs between the points
+            QVector<Point> points;  // oldest first
+        };
+
+        static void initInstance();
+        static void freeInstance();
+        static SpeedHistory *instance();
+
+        // Points of the finest resolution that covers the `period` (in secs),
+        // the series is empty if nothing is known about the key
+        Series series(SeriesType type, const QString &key, qint64 period) const;
+        QStringList keys(SeriesType type) const;
+
+    private:
+        SpeedHistory();
+        ~SpeedHistory() override;
+
+        void openStorage();
+        void resetStorage();
+        void loadIndex();
+
+        void sample();
+        void addSample(SeriesType type, const QString &key, qint64 now, const qint64 values[]);
+        int allocateSeries(SeriesType type, const QString &key);
+        void pushPoint(int index, int level, qint64 tick, const qint64 values[], bool holdGaps);
+        void feedLevel(int index, int level, qint64 childTick, const qint64 values[]);
+        void appendValue(int index, int level, const qint64 values[]);
+
+        static SpeedHistory *m_instance;
+
+        QFile m_file;
+        uchar *m_data = nullptr;
+        QByteArray m_fallbackData;  // used if the file can't be mapped
+        QHash<QString, int> m_index;    // type prefixed key -> series
+        QVector<int> m_freeSeries;
+        qint64 m_lastSampleTime = 0;
+        QTimer m_timer;
+    };
+}
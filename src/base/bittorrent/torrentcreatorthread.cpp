@@ -28,17 +28,30 @@
 
 #include "torrentcreatorthread.h"
 
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include <libtorrent/bencode.hpp>
 #include <libtorrent/create_torrent.hpp>
 #include <libtorrent/file_storage.hpp>
+#include <libtorrent/hasher.hpp>
+#include <libtorrent/settings_pack.hpp>
 #include <libtorrent/torrent_info.hpp>
 
+#include <QDateTime>
 #include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
 #include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QVector>
+#include <QWaitCondition>
 
 #include "base/exceptions.h"
 #include "base/global.h"
@@ -49,6 +62,193 @@
 
 namespace
 {
+    const int READER_COUNT = 2;
+    // every reader takes this much of consecutive pieces at once to keep the reads sequential
+    const qint64 READ_CHUNK_SIZE = 64 * 1024 * 1024;
+    // limits the memory used by the pieces waiting to be hashed
+    const qint64 MAX_BUFFERED_SIZE = 256 * 1024 * 1024;
+    const qint64 PROGRESS_INTERVAL = 250;
+
+    class WorkerThread final : public QThread
+    {
+    public:
+        explicit WorkerThread(std::function<void ()> function)
+            : m_function(std::move(function))
+        {
+        }
+
+    private:
+        void run() override
+        {
+            m_function();
+        }
+
+        const std::function<void ()> m_function;
+    };
+
+    struct PieceBuffer
+    {
+        int pieceIndex = 0;
+        int size = 0;
+        std::vector<char> data;
+    };
+
+    // Hands the piece buffers over from the readers to the hashers and back.
+    // The buffers are allocated once, so the memory use is bounded.
+    class PieceQueue
+    {
+        Q_DISABLE_COPY(PieceQueue)
+
+    public:
+        PieceQueue(const int bufferCount, const int bufferSize)
+            : m_buffers(bufferCount)
+        {
+            for (int i = 0; i < bufferCount; ++i)
+            {
+                m_buffers[i].data.resize(bufferSize);
+                m_freeBuffers.append(i);
+            }
+        }
+
+        PieceBuffer &buffer(const int index)
+        {
+            return m_buffers[index];
+        }
+
+        // These return -1 when the work is over
+        int acquireFree()
+        {
+            const QMutexLocker locker(&m_mutex);
+            while (!m_isAborted && m_freeBuffers.isEmpty())
+                m_freeCondition.wait(&m_mutex);
+            return m_isAborted ? -1 : m_freeBuffers.takeLast();
+        }
+
+        int takeFilled()
+        {
+            const QMutexLocker locker(&m_mutex);
+            while (!m_isAborted && !m_isClosed && m_filledBuffers.isEmpty())
+                m_filledCondition.wait(&m_mutex);
+            return (m_isAborted || m_filledBuffers.isEmpty()) ? -1 : m_filledBuffers.dequeue();
+        }
+
+        void pushFilled(const int index)
+        {
+            const QMutexLocker locker(&m_mutex);
+            m_filledBuffers.enqueue(index);
+            m_filledCondition.wakeOne();
+        }
+
+        void release(const int index)
+        {
+            const QMutexLocker locker(&m_mutex);
+            m_freeBuffers.append(index);
+            m_freeCondition.wakeOne();
+        }
+
+        // no more buffers will be filled
+        void close()
+        {
+            const QMutexLocker locker(&m_mutex);
+            m_isClosed = true;
+            m_filledCondition.wakeAll();
+        }
+
+        void abort(const QString &errorString = {})
+        {
+            const QMutexLocker locker(&m_mutex);
+            if (m_errorString.isEmpty())
+                m_errorString = errorString;
+            m_isAborted = true;
+            m_freeCondition.wakeAll();
+            m_filledCondition.wakeAll();
+        }
+
+        QString errorString() const
+        {
+            const QMutexLocker locker(&m_mutex);
+            return m_errorString;
+        }
+
+    private:
+        mutable QMutex m_mutex;
+        QWaitCondition m_freeCondition;
+        QWaitCondition m_filledCondition;
+        std::vector<PieceBuffer> m_buffers;
+        QVector<int> m_freeBuffers;
+        QQueue<int> m_filledBuffers;
+        bool m_isClosed = false;
+        bool m_isAborted = false;
+        QString m_errorString;
+    };
+
+    // Reads the pieces from the files, the files are kept open between the pieces
+    class PieceReader
+    {
+    public:
+        PieceReader(const lt::file_storage &fs, const std::string &basePath)
+            : m_fs(fs)
+            , m_basePath(basePath)
+        {
+        }
+
+        // returns the error message or an empty string
+        QString read(const int pieceIndex, PieceBuffer &buffer)
+        {
+            const lt::piece_index_t piece {pieceIndex};
+            buffer.pieceIndex = pieceIndex;
+            buffer.size = m_fs.piece_size(piece);
+
+            char *data = buffer.data.data();
+            for (const lt::file_slice &slice : m_fs.map_block(piece, 0, buffer.size))
+            {
+                const auto size = static_cast<qint64>(slice.size);
+                if (m_fs.pad_file_at(slice.file_index))
+                {
+                    std::memset(data, 0, size);
+                    data += size;
+                    continue;
+                }
+
+                if (!openFile(slice.file_index))
+                    return m_file.errorString();
+
+                if (!m_file.seek(slice.offset))
+                    return m_file.errorString();
+
+                qint64 remaining = size;
+                while (remaining > 0)
+                {
+                    const qint64 bytesRead = m_file.read(data, remaining);
+                    if (bytesRead <= 0)
+                        return (bytesRead < 0) ? m_file.errorString() : QString::fromLatin1("unexpected end of file");
+
+                    data += bytesRead;
+                    remaining -= bytesRead;
+                }
+            }
+
+            return {};
+        }
+
+    private:
+        bool openFile(const lt::file_index_t fileIndex)
+        {
+            if (m_file.isOpen() && (m_fileIndex == fileIndex))
+                return true;
+
+            m_file.close();
+            m_file.setFileName(QString::fromStdString(m_fs.file_path(fileIndex, m_basePath)));
+            m_fileIndex = fileIndex;
+            return m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+        }
+
+        const lt::file_storage &m_fs;
+        const std::string m_basePath;
+        QFile m_file;
+        lt::file_index_t m_fileIndex {-1};
+    };
+
     // do not include files and folders whose
     // name starts with a .
     bool fileFilter(const std::string &f)
@@ -92,33 +292,135 @@ void TorrentCreatorThread::create(const TorrentCreatorParams &params)
     start();
 }
 
-void TorrentCreatorThread::sendProgressSignal(int currentPieceIdx, int totalPieces)
+void TorrentCreatorThread::sendProgressSignal(const qint64 hashedBytes, const qint64 totalBytes)
 {
-    emit updateProgress(static_cast<int>((currentPieceIdx * 100.) / totalPieces));
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 elapsed = now - m_lastProgressTime;
+    const qint64 speed = (elapsed > 0) ? (((hashedBytes - m_lastProgressBytes) * 1000) / elapsed) : 0;
+    m_lastProgressBytes = hashedBytes;
+    m_lastProgressTime = now;
+
+    emit updateProgress((totalBytes > 0) ? static_cast<int>((hashedBytes * 100.) / totalBytes) : 0);
+    emit updateHashingProgress(hashedBytes, totalBytes, speed);
 }
 
 void TorrentCreatorThread::run()
+{
+    createTorrent(m_params);
+}
+
+void TorrentCreatorThread::hashPieces(lt::create_torrent &newTorrent, const std::string &basePath)
+{
+    const lt::file_storage &fs = newTorrent.files();
+    const int pieceCount = newTorrent.num_pieces();
+    const int pieceLength = newTorrent.piece_length();
+    const qint64 totalSize = fs.total_size();
+
+    const int readerCount = std::min(READER_COUNT, pieceCount);
+    const int maxBufferCount = std::max((readerCount + 1), static_cast<int>(MAX_BUFFERED_SIZE / pieceLength));
+    const int hasherCount = qBound(1, QThread::idealThreadCount(), (maxBufferCount - readerCount));
+    const int bufferCount = std::min(maxBufferCount, (2 * (readerCount + hasherCount)));
+    const int piecesPerChunk = std::max(1, static_cast<int>(READ_CHUNK_SIZE / pieceLength));
+
+    PieceQueue queue {bufferCount, pieceLength};
+    std::vector<lt::sha1_hash> pieceHashes(pieceCount);
+    std::atomic<int> nextChunk {0};
+    std::atomic<int> runningReaders {readerCount};
+    std::atomic<qint64> hashedBytes {0};
+
+    const auto readPieces = [&]()
+    {
+        PieceReader reader {fs, basePath};
+        for (int firstPiece = (nextChunk++ * piecesPerChunk); firstPiece < pieceCount
+             ; firstPiece = (nextChunk++ * piecesPerChunk))
+        {
+            const int lastPiece = std::min((firstPiece + piecesPerChunk), pieceCount);
+            for (int pieceIndex = firstPiece; pieceIndex < lastPiece; ++pieceIndex)
+            {
+                const int index = queue.acquireFree();
+                if (index < 0)
+                    return;
+
+                const QString error = reader.read(pieceIndex, queue.buffer(index));
+                if (!error.isEmpty())
+                {
+                    queue.abort(error);
+                    return;
+                }
+
+                queue.pushFilled(index);
+            }
+        }
+
+        if (--runningReaders == 0)
+            queue.close();
+    };
+
+    const auto hashPieceBuffers = [&]()
+    {
+        for (int index = queue.takeFilled(); index >= 0; index = queue.takeFilled())
+        {
+            const PieceBuffer &buffer = queue.buffer(index);
+            pieceHashes[buffer.pieceIndex] = lt::hasher(buffer.data.data(), buffer.size).final();
+            hashedBytes += buffer.size;
+            queue.release(index);
+        }
+    };
+
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < readerCount; ++i)
+        threads.emplace_back(new WorkerThread(readPieces));
+    for (int i = 0; i < hasherCount; ++i)
+        threads.emplace_back(new WorkerThread(hashPieceBuffers));
+    for (const std::unique_ptr<QThread> &thread : threads)
+        thread->start();
+
+    for (const std::unique_ptr<QThread> &thread : threads)
+    {
+        while (!thread->wait(PROGRESS_INTERVAL))
+        {
+            if (isInterruptionRequested())
+                queue.abort();
+            sendProgressSignal(hashedBytes, totalSize);
+        }
+    }
+
+    const QString error = queue.errorString();
+    if (!error.isEmpty())
+        throw RuntimeError {tr("Couldn't read the content of the torrent. Reason: %1").arg(error)};
+    if (isInterruptionRequested())
+        return;
+
+    for (int i = 0; i < pieceCount; ++i)
+        newTorrent.set_hash(lt::piece_index_t {i}, pieceHashes[i]);
+
+    sendProgressSignal(hashedBytes, totalSize);
+}
+
+void TorrentCreatorThread::createTorrent(const TorrentCreatorParams &params)
 {
     const QString creatorStr("qBittorrent " QBT_VERSION);
 
+    m_lastProgressBytes = 0;
+    m_lastProgressTime = QDateTime::currentMSecsSinceEpoch();
     emit updateProgress(0);
 
     try
     {
-        const QString parentPath = Utils::Fs::branchPath(m_params.inputPath) + '/';
+        const QString parentPath = Utils::Fs::branchPath(params.inputPath) + '/';
 
         // Adding files to the torrent
         lt::file_storage fs;
-        if (QFileInfo(m_params.inputPath).isFile())
+        if (QFileInfo(params.inputPath).isFile())
         {
-            lt::add_files(fs, Utils::Fs::toNativePath(m_params.inputPath).toStdString(), fileFilter);
+            lt::add_files(fs, Utils::Fs::toNativePath(params.inputPath).toStdString(), fileFilter);
         }
         else
         {
             // need to sort the file names by natural sort order
-            QStringList dirs = {m_params.inputPath};
+            QStringList dirs = {params.inputPath};
 
-            QDirIterator dirIter(m_params.inputPath, (QDir::AllDirs | QDir::NoDotAndDotDot), QDirIterator::Subdirectories);
+            QDirIterator dirIter(params.inputPath, (QDir::AllDirs | QDir::NoDotAndDotDot), QDirIterator::Subdirectories);
             while (dirIter.hasNext())
             {
                 dirIter.next();
@@ -154,14 +456,14 @@ void TorrentCreatorThread::run()
         if (isInterruptionRequested()) return;
 
 #if (LIBTORRENT_VERSION_NUM >= 20000)
-        lt::create_torrent newTorrent {fs, m_params.pieceSize, toNativeTorrentFormatFlag(m_params.torrentFormat)};
+        lt::create_torrent newTorrent {fs, params.pieceSize, toNativeTorrentFormatFlag(params.torrentFormat)};
 #else
-        lt::create_torrent newTorrent(fs, m_params.pieceSize, m_params.paddedFileSizeLimit
-            , (m_params.isAlignmentOptimized ? lt::create_torrent::optimize_alignment : lt::create_flags_t {}));
+        lt::create_torrent newTorrent(fs, params.pieceSize, params.paddedFileSizeLimit
+            , (params.isAlignmentOptimized ? lt::create_torrent::optimize_alignment : lt::create_flags_t {}));
 #endif
 
         // Add url seeds
-        for (QString seed : asConst(m_params.urlSeeds))
+        for (QString seed : asConst(params.urlSeeds))
         {
             seed = seed.trimmed();
             if (!seed.isEmpty())
@@ -169,7 +471,7 @@ void TorrentCreatorThread::run()
         }
 
         int tier = 0;
-        for (const QString &tracker : asConst(m_params.trackers))
+        for (const QString &tracker : asConst(params.trackers))
         {
             if (tracker.isEmpty())
                 ++tier;
@@ -180,30 +482,54 @@ void TorrentCreatorThread::run()
         if (isInterruptionRequested()) return;
 
         // calculate the hash for all pieces
-        lt::set_piece_hashes(newTorrent, Utils::Fs::toNativePath(parentPath).toStdString()
-            , [this, &newTorrent](const lt::piece_index_t n)
+        const std::string basePath = Utils::Fs::toNativePath(parentPath).toStdString();
+#if (LIBTORRENT_VERSION_NUM >= 20000)
+        if (params.torrentFormat != TorrentFormat::V1)
         {
-            sendProgressSignal(static_cast<LTUnderlyingType<lt::piece_index_t>>(n), newTorrent.num_pieces());
-        });
+            // v2 piece layers are Merkle trees of the blocks within files, libtorrent
+            // builds them itself, only with the hashing spread across threads
+            lt::settings_pack settings;
+            settings.set_int(lt::settings_pack::hashing_threads, std::max(1, QThread::idealThreadCount()));
+
+            const qint64 totalSize = newTorrent.files().total_size();
+            lt::error_code ec;
+            lt::set_piece_hashes(newTorrent, basePath, settings
+                , [this, &newTorrent, totalSize](const lt::piece_index_t n)
+            {
+                const qint64 hashedBytes = static_cast<qint64>(static_cast<LTUnderlyingType<lt::piece_index_t>>(n) + 1) * newTorrent.piece_length();
+                if ((QDateTime::currentMSecsSinceEpoch() - m_lastProgressTime) >= PROGRESS_INTERVAL)
+                    sendProgressSignal(std::min(hashedBytes, totalSize), totalSize);
+            }, ec);
+            if (ec)
+                throw RuntimeError {QString::fromStdString(ec.message())};
+        }
+        else
+#endif
+        {
+            hashPieces(newTorrent, basePath);
+        }
+
+        if (isInterruptionRequested()) return;
+
         // Set qBittorrent as creator and add user comment to
         // torrent_info structure
         newTorrent.set_creator(creatorStr.toUtf8().constData());
-        newTorrent.set_comment(m_params.comment.toUtf8().constData());
+        newTorrent.set_comment(params.comment.toUtf8().constData());
         // Is private ?
-        newTorrent.set_priv(m_params.isPrivate);
+        newTorrent.set_priv(params.isPrivate);
 
         if (isInterruptionRequested()) return;
 
         lt::entry entry = newTorrent.generate();
 
         // add source field
-        if (!m_params.source.isEmpty())
-            entry["info"]["source"] = m_params.source.toStdString();
+        if (!params.source.isEmpty())
+            entry["info"]["source"] = params.source.toStdString();
 
         if (isInterruptionRequested()) return;
 
         // create the torrent
-        QFile outfile {m_params.savePath};
+        QFile outfile {params.savePath};
         if (!outfile.open(QIODevice::WriteOnly))
         {
             throw RuntimeError
@@ -223,7 +549,7 @@ void TorrentCreatorThread::run()
         outfile.close();
 
         emit updateProgress(100);
-        emit creationSuccess(m_params.savePath, parentPath);
+        emit creationSuccess(params.savePath, parentPath);
     }
     catch (const std::exception &e)
     {
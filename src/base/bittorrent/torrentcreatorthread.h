@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <string>
+
+#include <libtorrent/fwd.hpp>
 #include <libtorrent/version.hpp>
 
 #include <QStringList>
@@ -62,6 +65,7 @@ namespace BitTorrent
         QStringList urlSeeds;
     };
 
+    // Pieces are read by a few reader threads and hashed by a pool of hasher threads.
     class TorrentCreatorThread final : public QThread
     {
         Q_OBJECT
@@ -86,10 +90,17 @@ namespace BitTorrent
         void creationFailure(const QString &msg);
         void creationSuccess(const QString &path, const QString &branchPath);
         void updateProgress(int progress);
+        void updateHashingProgress(qint64 hashedBytes, qint64 totalBytes, qint64 bytesPerSecond);
 
     private:
-        void sendProgressSignal(int currentPieceIdx, int totalPieces);
+        void createTorrent(const TorrentCreatorParams &params);
+        void hashPieces(lt::create_torrent &newTorrent, const std::string &basePath);
+        void sendProgressSignal(qint64 hashedBytes, qint64 totalBytes);
 
         TorrentCreatorParams m_params;
+
+        // used by the thread only
+        qint64 m_lastProgressBytes = 0;
+        qint64 m_lastProgressTime = 0;
     };
 }
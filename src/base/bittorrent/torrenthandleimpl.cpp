@@ -58,6 +58,7 @@
 #include "base/logger.h"
 #include "base/preferences.h"
 #include "base/profile.h"
+#include "base/torrentstatuscounters.h"
 #include "base/utils/fs.h"
 #include "base/utils/string.h"
 #include "common.h"
@@ -125,6 +126,9 @@ TorrentHandleImpl::TorrentHandleImpl(Session *session, lt::session *nativeSessio
     , m_isStopped(params.paused)
     , m_ltAddTorrentParams(params.ltAddTorrentParams)
 {
+    // counted in no status filter until its state is known
+    if (TorrentStatusCounters::instance())
+        TorrentStatusCounters::instance()->addTorrent(m_statusMask);
 
 #ifdef __ENABLE_CATEGORY__
     if (m_useAutoTMM)
@@ -169,7 +173,11 @@ TorrentHandleImpl::TorrentHandleImpl(Session *session, lt::session *nativeSessio
     // == END UPGRADE CODE ==
 }
 
-TorrentHandleImpl::~TorrentHandleImpl() {}
+TorrentHandleImpl::~TorrentHandleImpl()
+{
+    if (TorrentStatusCounters::instance())
+        TorrentStatusCounters::instance()->removeTorrent(m_statusMask);
+}
 
 bool TorrentHandleImpl::isValid() const
 {
@@ -856,6 +864,18 @@ void TorrentHandleImpl::updateState()
         else
             m_state = TorrentState::StalledDownloading;
     }
+
+    updateStatusCounters();
+}
+
+void TorrentHandleImpl::updateStatusCounters()
+{
+    const quint32 mask = TorrentStatusCounters::statusMask(this);
+    if (mask == m_statusMask) return;
+
+    if (TorrentStatusCounters::instance())
+        TorrentStatusCounters::instance()->updateTorrent(m_statusMask, mask);
+    m_statusMask = mask;
 }
 
 bool TorrentHandleImpl::hasMetadata() const
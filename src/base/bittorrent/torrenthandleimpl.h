@@ -288,6 +288,7 @@ namespace BitTorrent
         void updateStatus();
         void updateStatus(const lt::torrent_status &nativeStatus);
         void updateState();
+        void updateStatusCounters();
 
         void handleFastResumeRejectedAlert(const lt::fastresume_rejected_alert *p);
         void handleFileCompletedAlert(const lt::file_completed_alert *p);
@@ -323,6 +324,7 @@ namespace BitTorrent
         lt::torrent_handle m_nativeHandle;
         lt::torrent_status m_nativeStatus;
         TorrentState m_state = TorrentState::Unknown;
+        quint32 m_statusMask = 0;  // status filters the torrent is counted in
         TorrentInfo m_torrentInfo;
         SpeedMonitor m_speedMonitor;
 
@@ -30,10 +30,17 @@
 
 #include "tracker.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include <libtorrent/bencode.hpp>
 #include <libtorrent/entry.hpp>
 
+#include <QDateTime>
 #include <QHostAddress>
+#include <QtEndian>
+#include <QTimer>
+#include <QUdpSocket>
 
 #include "base/exceptions.h"
 #include "base/global.h"
@@ -42,6 +49,7 @@
 #include "base/http/types.h"
 #include "base/logger.h"
 #include "base/preferences.h"
+#include "base/utils/random.h"
 
 namespace
 {
@@ -50,10 +58,18 @@ namespace
     const int MAX_PEERS_PER_TORRENT = 200;
     const int ANNOUNCE_INTERVAL = 1800;  // 30min
 
+    // peers that missed an announce are kept until the next one is due
+    const int PEER_TIMEOUT = 2 * ANNOUNCE_INTERVAL;
+    const int EXPIRY_TICK_INTERVAL = 60;
+    const int PEER_TIMEOUT_TICKS = PEER_TIMEOUT / EXPIRY_TICK_INTERVAL;
+
     // constants
     const int PEER_ID_SIZE = 20;
+    const int IPV4_ENDPOINT_SIZE = 6;
+    const int IPV6_ENDPOINT_SIZE = 18;
 
     const char ANNOUNCE_REQUEST_PATH[] = "/announce";
+    const char SCRAPE_REQUEST_PATH[] = "/scrape";
 
     const char ANNOUNCE_REQUEST_COMPACT[] = "compact";
     const char ANNOUNCE_REQUEST_INFO_HASH[] = "info_hash";
@@ -83,6 +99,40 @@ namespace
     const char ANNOUNCE_RESPONSE_PEERS_PEER_ID[] = "peer id";
     const char ANNOUNCE_RESPONSE_PEERS_PORT[] = "port";
 
+    const char SCRAPE_RESPONSE_FILES[] = "files";
+    const char SCRAPE_RESPONSE_COMPLETE[] = "complete";
+    const char SCRAPE_RESPONSE_DOWNLOADED[] = "downloaded";
+    const char SCRAPE_RESPONSE_INCOMPLETE[] = "incomplete";
+
+    // [BEP-15] UDP Tracker Protocol
+    const quint64 UDP_PROTOCOL_ID = 0x41727101980;
+
+    const quint32 UDP_ACTION_CONNECT = 0;
+    const quint32 UDP_ACTION_ANNOUNCE = 1;
+    const quint32 UDP_ACTION_SCRAPE = 2;
+    const quint32 UDP_ACTION_ERROR = 3;
+
+    // "none" (0) and "started" (2) just register the peer
+    const quint32 UDP_EVENT_COMPLETED = 1;
+    const quint32 UDP_EVENT_STOPPED = 3;
+
+    // connection_id (8), action (4), transaction_id (4)
+    const int UDP_REQUEST_HEADER_SIZE = 16;
+    const int UDP_ANNOUNCE_REQUEST_SIZE = 98;
+    // action (4), transaction_id (4)
+    const int UDP_RESPONSE_HEADER_SIZE = 8;
+    const int UDP_ANNOUNCE_RESPONSE_HEADER_SIZE = 20;
+    const int UDP_SCRAPE_RESPONSE_ENTRY_SIZE = 12;
+    const int UDP_MAX_SCRAPE_TORRENTS = 74;
+
+    // scrape of the maximum number of torrents plus BEP-41 options
+    const int UDP_REQUEST_BUFFER_SIZE = 2048;
+    // announce response with IPv6 endpoints of all the peers of torrent
+    const int UDP_RESPONSE_BUFFER_SIZE = UDP_ANNOUNCE_RESPONSE_HEADER_SIZE + (IPV6_ENDPOINT_SIZE * MAX_PEERS_PER_TORRENT);
+
+    // connection ID is valid during the time slot it was issued in and the next one
+    const qint64 UDP_CONNECTION_ID_TIME_SLOT = 60;
+
     class TrackerError : public RuntimeError
     {
     public:
@@ -120,6 +170,44 @@ namespace
             return {};
         };
     }
+
+    quint64 mix64(quint64 value)
+    {
+        // finalizer of SplitMix64
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+        return (value ^ (value >> 31));
+    }
+
+    qint64 currentTimeSlot()
+    {
+        return (QDateTime::currentMSecsSinceEpoch() / 1000 / UDP_CONNECTION_ID_TIME_SLOT);
+    }
+
+    // Peers are handed out from a random position, so every announce gets a different subset
+    int randomWindowStart(const int peerCount)
+    {
+        return static_cast<int>(Utils::Random::rand(0, (peerCount - 1)));
+    }
+
+    // Copies compact endpoints of `count` peers starting from `start` and wrapping around
+    void copyEndpoints(char *dest, const lt::entry::string_type &endpoints, const int endpointSize, const int start, const int count)
+    {
+        const int peerCount = static_cast<int>(endpoints.size()) / endpointSize;
+        const int headCount = std::min(count, (peerCount - start));
+        std::memcpy(dest, (endpoints.data() + (start * endpointSize)), (headCount * endpointSize));
+        std::memcpy((dest + (headCount * endpointSize)), endpoints.data(), ((count - headCount) * endpointSize));
+    }
+
+    lt::entry::string_type endpointsWindow(const lt::entry::string_type &endpoints, const int endpointSize, const int count)
+    {
+        if (count <= 0)
+            return {};
+
+        lt::entry::string_type window(static_cast<size_t>(count * endpointSize), '\0');
+        copyEndpoints(&window[0], endpoints, endpointSize, randomWindowStart(static_cast<int>(endpoints.size()) / endpointSize), count);
+        return window;
+    }
 }
 
 namespace BitTorrent
@@ -162,31 +250,62 @@ struct Tracker::TrackerAnnounceRequest
 };
 
 // Tracker::TorrentStats
-void Tracker::TorrentStats::setPeer(const Peer &peer)
+bool Tracker::TorrentStats::setPeer(const QByteArray &peerID, const Peer &peer, const qint64 expiryTick)
 {
+    PeerList *peerList = nullptr;
+    if (peer.endpoint.size() == IPV4_ENDPOINT_SIZE)
+        peerList = &peersV4;
+    else if (peer.endpoint.size() == IPV6_ENDPOINT_SIZE)
+        peerList = &peersV6;
+    else
+        return false;
+
     // always replace existing peer
-    if (!removePeer(peer))
+    if (!removePeer(peerID))
     {
         // Too many peers, remove a random one
         if (peers.size() >= MAX_PEERS_PER_TORRENT)
-            removePeer(*peers.begin());
+        {
+            const QByteArray evictedPeerID = peers.cbegin().key();
+            removePeer(evictedPeerID);
+        }
     }
 
     // add peer
     if (peer.isSeeder)
         ++seeders;
-    peers.insert(peer);
+    peers.insert(peerID, {peer, expiryTick, peerList->peerIDs.size()});
+    peerList->peerIDs.append(peerID);
+    peerList->endpoints.append(peer.endpoint);
+    return true;
 }
 
-bool Tracker::TorrentStats::removePeer(const Peer &peer)
+bool Tracker::TorrentStats::removePeer(const QByteArray &peerID)
 {
-    const auto iter = peers.find(peer);
+    const auto iter = peers.find(peerID);
     if (iter == peers.end())
         return false;
 
-    if (iter->isSeeder)
+    const int endpointSize = static_cast<int>(iter->peer.endpoint.size());
+    const int index = iter->index;
+    PeerList &peerList = (endpointSize == IPV6_ENDPOINT_SIZE) ? peersV6 : peersV4;
+
+    if (iter->peer.isSeeder)
         --seeders;
-    peers.remove(*iter);
+    peers.erase(iter);
+
+    // move the last peer of the list in place of the removed one
+    const int lastIndex = peerList.peerIDs.size() - 1;
+    if (index != lastIndex)
+    {
+        const QByteArray movedPeerID = peerList.peerIDs.at(lastIndex);
+        std::memcpy(&peerList.endpoints[index * endpointSize], (peerList.endpoints.data() + (lastIndex * endpointSize)), endpointSize);
+        peerList.peerIDs[index] = movedPeerID;
+        peers[movedPeerID].index = index;
+    }
+
+    peerList.peerIDs.removeLast();
+    peerList.endpoints.resize(lastIndex * endpointSize);
     return true;
 }
 
@@ -194,7 +313,17 @@ bool Tracker::TorrentStats::removePeer(const Peer &peer)
 Tracker::Tracker(QObject *parent)
     : QObject(parent)
     , m_server(new Http::Server(this, this))
+    , m_udpSocket(new QUdpSocket(this))
+    , m_udpSecret((static_cast<quint64>(Utils::Random::rand()) << 32) | Utils::Random::rand())
+    , m_udpRequest(UDP_REQUEST_BUFFER_SIZE, 0)
+    , m_udpResponse(UDP_RESPONSE_BUFFER_SIZE, 0)
+    , m_expiryTimer(new QTimer(this))
+    , m_expiryWheel(PEER_TIMEOUT_TICKS + 1)
 {
+    connect(m_udpSocket, &QUdpSocket::readyRead, this, &Tracker::readUdpDatagrams);
+
+    connect(m_expiryTimer, &QTimer::timeout, this, &Tracker::expirePeers);
+    m_expiryTimer->start(EXPIRY_TICK_INTERVAL * 1000);
 }
 
 bool Tracker::start()
@@ -202,6 +331,8 @@ bool Tracker::start()
     const QHostAddress ip = QHostAddress::Any;
     const int port = Preferences::instance()->getTrackerPort();
 
+    startUdp(ip, port);
+
     if (m_server->isListening())
     {
         if (m_server->serverPort() == port)
@@ -232,6 +363,33 @@ bool Tracker::start()
     return listenSuccess;
 }
 
+bool Tracker::startUdp(const QHostAddress &ip, const int port)
+{
+    if (m_udpSocket->state() == QAbstractSocket::BoundState)
+    {
+        if (m_udpSocket->localPort() == port)
+            return true;
+
+        m_udpSocket->close();
+    }
+
+    const bool bindSuccess = m_udpSocket->bind(ip, port);
+
+    if (bindSuccess)
+    {
+        LogMsg(tr("Embedded Tracker: Now listening for UDP announces on IP: %1, port: %2")
+            .arg(ip.toString(), QString::number(port)), Log::INFO);
+    }
+    else
+    {
+        LogMsg(tr("Embedded Tracker: Unable to bind UDP socket to IP: %1, port: %2. Reason: %3")
+                .arg(ip.toString(), QString::number(port), m_udpSocket->errorString())
+            , Log::WARNING);
+    }
+
+    return bindSuccess;
+}
+
 Http::Response Tracker::processRequest(const Http::Request &request, const Http::Environment &env)
 {
     clear();  // clear response
@@ -249,6 +407,8 @@ Http::Response Tracker::processRequest(const Http::Request &request, const Http:
 
         if (request.path.startsWith(ANNOUNCE_REQUEST_PATH, Qt::CaseInsensitive))
             processAnnounceRequest();
+        else if (request.path.startsWith(SCRAPE_REQUEST_PATH, Qt::CaseInsensitive))
+            processScrapeRequest();
         else
             throw NotFoundHTTPError();
     }
@@ -378,6 +538,42 @@ void Tracker::processAnnounceRequest()
     prepareAnnounceResponse(announceReq);
 }
 
+void Tracker::processScrapeRequest()
+{
+    // [BEP-48] Tracker Protocol Extension: Scrape
+    // Only the last "info_hash" parameter is kept in the request query,
+    // so one torrent is scraped per request (as libtorrent does).
+    // Full scrape isn't supported.
+    const auto infoHashIter = m_request.query.find(ANNOUNCE_REQUEST_INFO_HASH);
+    if (infoHashIter == m_request.query.end())
+        throw TrackerError("Missing \"info_hash\" parameter");
+
+    const InfoHash infoHash(infoHashIter->toHex());
+    if (!infoHash.isValid())
+        throw TrackerError("Invalid \"info_hash\" parameter");
+
+    lt::entry::dictionary_type files;
+    const auto torrentStatsIter = m_torrents.constFind(infoHash);
+    if (torrentStatsIter != m_torrents.cend())
+    {
+        files[infoHashIter->toStdString()] = lt::entry::dictionary_type
+        {
+            {SCRAPE_RESPONSE_COMPLETE, torrentStatsIter->seeders},
+            {SCRAPE_RESPONSE_DOWNLOADED, torrentStatsIter->completed},
+            {SCRAPE_RESPONSE_INCOMPLETE, (torrentStatsIter->peers.size() - torrentStatsIter->seeders)}
+        };
+    }
+
+    const lt::entry::dictionary_type replyDict
+    {
+        {SCRAPE_RESPONSE_FILES, files}
+    };
+
+    QByteArray reply;
+    lt::bencode(std::back_inserter(reply), replyDict);
+    print(reply, Http::CONTENT_TYPE_TXT);
+}
+
 void Tracker::registerPeer(const TrackerAnnounceRequest &announceReq)
 {
     if (!m_torrents.contains(announceReq.infoHash))
@@ -387,7 +583,21 @@ void Tracker::registerPeer(const TrackerAnnounceRequest &announceReq)
             m_torrents.erase(m_torrents.begin());
     }
 
-    m_torrents[announceReq.infoHash].setPeer(announceReq.peer);
+    const QByteArray peerID = announceReq.peer.uniqueID();
+    const qint64 expiryTick = m_currentTick + PEER_TIMEOUT_TICKS;
+
+    TorrentStats &torrentStats = m_torrents[announceReq.infoHash];
+    if (!torrentStats.setPeer(peerID, announceReq.peer, expiryTick))
+    {
+        if (torrentStats.peers.isEmpty())
+            m_torrents.remove(announceReq.infoHash);
+        return;
+    }
+
+    if (announceReq.event == ANNOUNCE_REQUEST_EVENT_COMPLETED)
+        ++torrentStats.completed;
+
+    m_expiryWheel[expiryTick % m_expiryWheel.size()].append({announceReq.infoHash, peerID});
 }
 
 void Tracker::unregisterPeer(const TrackerAnnounceRequest &announceReq)
@@ -396,7 +606,7 @@ void Tracker::unregisterPeer(const TrackerAnnounceRequest &announceReq)
     if (torrentStatsIter == m_torrents.end())
         return;
 
-    torrentStatsIter->removePeer(announceReq.peer);
+    torrentStatsIter->removePeer(announceReq.peer.uniqueID());
 
     if (torrentStatsIter->peers.isEmpty())
         m_torrents.erase(torrentStatsIter);
@@ -404,7 +614,9 @@ void Tracker::unregisterPeer(const TrackerAnnounceRequest &announceReq)
 
 void Tracker::prepareAnnounceResponse(const TrackerAnnounceRequest &announceReq)
 {
-     const TorrentStats &torrentStats = m_torrents[announceReq.infoHash];
+     static const TorrentStats emptyTorrentStats;
+     const auto torrentStatsIter = m_torrents.constFind(announceReq.infoHash);
+     const TorrentStats &torrentStats = (torrentStatsIter != m_torrents.cend()) ? *torrentStatsIter : emptyTorrentStats;
 
      lt::entry::dictionary_type replyDict
      {
@@ -416,44 +628,39 @@ void Tracker::prepareAnnounceResponse(const TrackerAnnounceRequest &announceReq)
          {ANNOUNCE_RESPONSE_EXTERNAL_IP, toBigEndianByteArray(announceReq.socketAddress).toStdString()}
      };
 
+     // IPv4 peers go first, the rest of `numwant` is filled with IPv6 ones
+     int peersV4Count = 0;
+     int peersV6Count = 0;
+     if (announceReq.event != ANNOUNCE_REQUEST_EVENT_STOPPED)
+     {
+         peersV4Count = std::min(announceReq.numwant, torrentStats.peersV4.peerIDs.size());
+         peersV6Count = std::min((announceReq.numwant - peersV4Count), torrentStats.peersV6.peerIDs.size());
+     }
+
      // peer list
      // [BEP-7] IPv6 Tracker Extension (partial support - only the part that concerns BEP-23)
      // [BEP-23] Tracker Returns Compact Peer Lists
      if (announceReq.compact)
      {
-         lt::entry::string_type peers;
-         lt::entry::string_type peers6;
-
-         if (announceReq.event != ANNOUNCE_REQUEST_EVENT_STOPPED)
-         {
-             int counter = 0;
-             for (const Peer &peer : asConst(torrentStats.peers))
-             {
-                 if (counter++ >= announceReq.numwant)
-                     break;
-
-                 if (peer.endpoint.size() == 6)  // IPv4 + port
-                     peers.append(peer.endpoint);
-                 else if (peer.endpoint.size() == 18)  // IPv6 + port
-                     peers6.append(peer.endpoint);
-             }
-         }
-
-         replyDict[ANNOUNCE_RESPONSE_PEERS] = peers;  // required, even it's empty
-         if (!peers6.empty())
-             replyDict[ANNOUNCE_RESPONSE_PEERS6] = peers6;
+         // required, even it's empty
+         replyDict[ANNOUNCE_RESPONSE_PEERS] = endpointsWindow(torrentStats.peersV4.endpoints, IPV4_ENDPOINT_SIZE, peersV4Count);
+         if (peersV6Count > 0)
+             replyDict[ANNOUNCE_RESPONSE_PEERS6] = endpointsWindow(torrentStats.peersV6.endpoints, IPV6_ENDPOINT_SIZE, peersV6Count);
      }
      else
      {
          lt::entry::list_type peerList;
 
-         if (announceReq.event != ANNOUNCE_REQUEST_EVENT_STOPPED)
+         const auto appendPeers = [&announceReq, &torrentStats, &peerList](const PeerList &peers, const int count)
          {
-             int counter = 0;
-             for (const Peer &peer : torrentStats.peers)
+             if (count <= 0)
+                 return;
+
+             const int start = randomWindowStart(peers.peerIDs.size());
+             for (int i = 0; i < count; ++i)
              {
-                 if (counter++ >= announceReq.numwant)
-                     break;
+                 const QByteArray &peerID = peers.peerIDs[(start + i) % peers.peerIDs.size()];
+                 const Peer &peer = torrentStats.peers.constFind(peerID)->peer;
 
                  lt::entry::dictionary_type peerDict =
                  {
@@ -466,7 +673,10 @@ void Tracker::prepareAnnounceResponse(const TrackerAnnounceRequest &announceReq)
 
                  peerList.emplace_back(peerDict);
              }
-         }
+         };
+
+         appendPeers(torrentStats.peersV4, peersV4Count);
+         appendPeers(torrentStats.peersV6, peersV6Count);
 
          replyDict[ANNOUNCE_RESPONSE_PEERS] = peerList;
      }
@@ -476,3 +686,231 @@ void Tracker::prepareAnnounceResponse(const TrackerAnnounceRequest &announceReq)
      lt::bencode(std::back_inserter(reply), replyDict);
      print(reply, Http::CONTENT_TYPE_TXT);
 }
+
+void Tracker::expirePeers()
+{
+    ++m_currentTick;
+
+    ExpiryBucket &bucket = m_expiryWheel[m_currentTick % m_expiryWheel.size()];
+    for (const auto &expiryEntry : asConst(bucket))
+    {
+        const auto torrentStatsIter = m_torrents.find(expiryEntry.first);
+        if (torrentStatsIter == m_torrents.end())
+            continue;
+
+        // the peer that announced again since then has a later expiry tick
+        const auto peerIter = torrentStatsIter->peers.constFind(expiryEntry.second);
+        if ((peerIter == torrentStatsIter->peers.cend()) || (peerIter->expiryTick > m_currentTick))
+            continue;
+
+        torrentStatsIter->removePeer(expiryEntry.second);
+        if (torrentStatsIter->peers.isEmpty())
+            m_torrents.erase(torrentStatsIter);
+    }
+
+    bucket.clear();
+}
+
+void Tracker::readUdpDatagrams()
+{
+    while (m_udpSocket->hasPendingDatagrams())
+    {
+        const qint64 requestSize = m_udpSocket->readDatagram(m_udpRequest.data(), m_udpRequest.size()
+            , &m_udpClientAddress, &m_udpClientPort);
+        if (requestSize < UDP_REQUEST_HEADER_SIZE)
+            continue;
+
+        const int responseSize = processUdpRequest(static_cast<int>(requestSize));
+        if (responseSize > 0)
+            m_udpSocket->writeDatagram(m_udpResponse.constData(), responseSize, m_udpClientAddress, m_udpClientPort);
+    }
+}
+
+int Tracker::processUdpRequest(const int requestSize)
+{
+    const char *request = m_udpRequest.constData();
+    const quint64 connectionId = qFromBigEndian<quint64>(request);
+    const quint32 action = qFromBigEndian<quint32>(request + 8);
+
+    // transaction_id is sent back as is
+    std::memcpy((m_udpResponse.data() + 4), (request + 12), 4);
+
+    if (action == UDP_ACTION_CONNECT)
+        return processUdpConnectRequest();
+
+    const qint64 timeSlot = currentTimeSlot();
+    if ((connectionId != udpConnectionId(timeSlot)) && (connectionId != udpConnectionId(timeSlot - 1)))
+        return prepareUdpErrorResponse("Invalid connection ID");
+
+    switch (action)
+    {
+    case UDP_ACTION_ANNOUNCE:
+        return processUdpAnnounceRequest(requestSize);
+    case UDP_ACTION_SCRAPE:
+        return processUdpScrapeRequest(requestSize);
+    default:
+        return prepareUdpErrorResponse("Invalid action");
+    }
+}
+
+int Tracker::processUdpConnectRequest()
+{
+    // not a BEP-15 request, ignore it
+    if (qFromBigEndian<quint64>(m_udpRequest.constData()) != UDP_PROTOCOL_ID)
+        return 0;
+
+    char *response = m_udpResponse.data();
+    qToBigEndian<quint32>(UDP_ACTION_CONNECT, response);
+    qToBigEndian<quint64>(udpConnectionId(currentTimeSlot()), (response + 8));
+    return 16;
+}
+
+int Tracker::processUdpAnnounceRequest(const int requestSize)
+{
+    if (requestSize < UDP_ANNOUNCE_REQUEST_SIZE)
+        return prepareUdpErrorResponse("Malformed announce request");
+
+    const char *request = m_udpRequest.constData();
+
+    const quint32 event = qFromBigEndian<quint32>(request + 80);
+    if (event > UDP_EVENT_STOPPED)
+        return prepareUdpErrorResponse("Invalid event");
+
+    const quint16 port = qFromBigEndian<quint16>(request + 96);
+    if (port == 0)
+        return prepareUdpErrorResponse("Invalid port");
+
+    TrackerAnnounceRequest announceReq;
+    announceReq.infoHash = lt::sha1_hash(request + 16);
+    announceReq.peer.peerId = QByteArray((request + 36), PEER_ID_SIZE);
+    announceReq.peer.isSeeder = (qFromBigEndian<quint64>(request + 64) == 0);
+    announceReq.peer.port = port;
+
+    const qint32 numWant = qFromBigEndian<qint32>(request + 92);
+    if (numWant >= 0)  // -1 means default
+        announceReq.numwant = numWant;
+
+    // Enforce using IPv4 if address is indeed IPv4 or if it is an IPv4-mapped IPv6 address
+    bool isIPv4 = false;
+    const quint32 socketIPv4 = m_udpClientAddress.toIPv4Address(&isIPv4);
+
+    lt::entry::string_type &endpoint = announceReq.peer.endpoint;
+    if (isIPv4)
+    {
+        // self claimed by peer, 0 means the address of the sender
+        const quint32 claimedIPv4 = qFromBigEndian<quint32>(request + 84);
+        const quint32 ipv4 = (claimedIPv4 != 0) ? claimedIPv4 : socketIPv4;
+
+        endpoint.resize(6);
+        qToBigEndian<quint32>(ipv4, &endpoint[0]);
+        announceReq.peer.address = QHostAddress(ipv4).toString().toStdString();
+    }
+    else
+    {
+        const Q_IPV6ADDR ipv6 = m_udpClientAddress.toIPv6Address();
+
+        endpoint.resize(18);
+        std::memcpy(&endpoint[0], ipv6.c, 16);
+        announceReq.peer.address = m_udpClientAddress.toString().toStdString();
+    }
+    qToBigEndian<quint16>(port, &endpoint[endpoint.size() - 2]);
+
+    if (event == UDP_EVENT_STOPPED)
+    {
+        unregisterPeer(announceReq);
+    }
+    else
+    {
+        if (event == UDP_EVENT_COMPLETED)
+            announceReq.event = QLatin1String(ANNOUNCE_REQUEST_EVENT_COMPLETED);
+        registerPeer(announceReq);
+    }
+
+    char *response = m_udpResponse.data();
+    qToBigEndian<quint32>(UDP_ACTION_ANNOUNCE, response);
+    qToBigEndian<quint32>(ANNOUNCE_INTERVAL, (response + 8));
+
+    // peers of the same address family as the sender only, as the response has no room for others
+    int responseSize = UDP_ANNOUNCE_RESPONSE_HEADER_SIZE;
+    qint64 seeders = 0;
+    qint64 leechers = 0;
+    const auto torrentStatsIter = m_torrents.constFind(announceReq.infoHash);
+    if (torrentStatsIter != m_torrents.cend())
+    {
+        seeders = torrentStatsIter->seeders;
+        leechers = torrentStatsIter->peers.size() - torrentStatsIter->seeders;
+
+        if (event != UDP_EVENT_STOPPED)
+        {
+            const int endpointSize = static_cast<int>(endpoint.size());
+            const PeerList &peers = isIPv4 ? torrentStatsIter->peersV4 : torrentStatsIter->peersV6;
+            const int count = std::min(announceReq.numwant, peers.peerIDs.size());
+            if (count > 0)
+            {
+                copyEndpoints((response + responseSize), peers.endpoints, endpointSize, randomWindowStart(peers.peerIDs.size()), count);
+                responseSize += (count * endpointSize);
+            }
+        }
+    }
+
+    qToBigEndian<quint32>(static_cast<quint32>(leechers), (response + 12));
+    qToBigEndian<quint32>(static_cast<quint32>(seeders), (response + 16));
+    return responseSize;
+}
+
+int Tracker::processUdpScrapeRequest(const int requestSize)
+{
+    const int count = std::min(((requestSize - UDP_REQUEST_HEADER_SIZE) / InfoHash::length()), UDP_MAX_SCRAPE_TORRENTS);
+    if (count <= 0)
+        return prepareUdpErrorResponse("Malformed scrape request");
+
+    const char *request = m_udpRequest.constData();
+    char *response = m_udpResponse.data();
+    qToBigEndian<quint32>(UDP_ACTION_SCRAPE, response);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const char *infoHash = request + UDP_REQUEST_HEADER_SIZE + (i * InfoHash::length());
+        char *entry = response + UDP_RESPONSE_HEADER_SIZE + (i * UDP_SCRAPE_RESPONSE_ENTRY_SIZE);
+
+        qint64 seeders = 0;
+        qint64 completed = 0;
+        qint64 leechers = 0;
+        const auto torrentStatsIter = m_torrents.constFind(lt::sha1_hash(infoHash));
+        if (torrentStatsIter != m_torrents.cend())
+        {
+            seeders = torrentStatsIter->seeders;
+            completed = torrentStatsIter->completed;
+            leechers = torrentStatsIter->peers.size() - torrentStatsIter->seeders;
+        }
+
+        qToBigEndian<quint32>(static_cast<quint32>(seeders), entry);
+        qToBigEndian<quint32>(static_cast<quint32>(completed), (entry + 4));
+        qToBigEndian<quint32>(static_cast<quint32>(leechers), (entry + 8));
+    }
+
+    return (UDP_RESPONSE_HEADER_SIZE + (count * UDP_SCRAPE_RESPONSE_ENTRY_SIZE));
+}
+
+int Tracker::prepareUdpErrorResponse(const char *message)
+{
+    char *response = m_udpResponse.data();
+    qToBigEndian<quint32>(UDP_ACTION_ERROR, response);
+
+    const int messageSize = static_cast<int>(std::strlen(message));
+    std::memcpy((response + UDP_RESPONSE_HEADER_SIZE), message, messageSize);
+    return (UDP_RESPONSE_HEADER_SIZE + messageSize);
+}
+
+quint64 Tracker::udpConnectionId(const qint64 timeSlot) const
+{
+    // Connection IDs aren't stored, they are keyed hashes of the client address and time slot
+    const Q_IPV6ADDR address = m_udpClientAddress.toIPv6Address();
+    quint64 high = 0;
+    quint64 low = 0;
+    std::memcpy(&high, address.c, sizeof(high));
+    std::memcpy(&low, (address.c + sizeof(high)), sizeof(low));
+
+    const quint64 id = mix64(m_udpSecret ^ static_cast<quint64>(timeSlot));
+    return mix64(mix64(id ^ high) ^ low);
+}
@@ -34,14 +34,20 @@
 
 #include <libtorrent/entry.hpp>
 
+#include <QByteArray>
 #include <QHash>
+#include <QHostAddress>
 #include <QObject>
-#include <QSet>
+#include <QPair>
+#include <QVector>
 
 #include "base/bittorrent/infohash.h"
 #include "base/http/irequesthandler.h"
 #include "base/http/responsebuilder.h"
 
+class QTimer;
+class QUdpSocket;
+
 namespace Http
 {
     class Server;
@@ -69,6 +75,7 @@ namespace BitTorrent
     // *Basic* Bittorrent tracker implementation
     // [BEP-3] The BitTorrent Protocol Specification
     // also see: https://wiki.theory.org/index.php/BitTorrentSpecification#Tracker_HTTP.2FHTTPS_Protocol
+    // [BEP-15] UDP Tracker Protocol is served on the same port
     class Tracker final : public QObject, public Http::IRequestHandler, private Http::ResponseBuilder
     {
         Q_OBJECT
@@ -76,15 +83,36 @@ namespace BitTorrent
 
         struct TrackerAnnounceRequest;
 
+        struct PeerEntry
+        {
+            Peer peer;
+            qint64 expiryTick = 0;
+            int index = 0;  // in the peer list of its address family
+        };
+
+        // Compact endpoints of the peers of one address family, stored back to back
+        // so that a response takes a slice of them instead of building the list again
+        struct PeerList
+        {
+            lt::entry::string_type endpoints;
+            QVector<QByteArray> peerIDs;  // in the same order as endpoints
+        };
+
         struct TorrentStats
         {
             qint64 seeders = 0;
-            QSet<Peer> peers;
+            qint64 completed = 0;
+            QHash<QByteArray, PeerEntry> peers;  // by Peer::uniqueID()
+            PeerList peersV4;
+            PeerList peersV6;
 
-            void setPeer(const Peer &peer);
-            bool removePeer(const Peer &peer);
+            bool setPeer(const QByteArray &peerID, const Peer &peer, qint64 expiryTick);
+            bool removePeer(const QByteArray &peerID);
         };
 
+        // peers to expire at the tick of the bucket, ones that announced again since then are skipped
+        using ExpiryBucket = QVector<QPair<InfoHash, QByteArray>>;
+
     public:
         explicit Tracker(QObject *parent = nullptr);
 
@@ -93,15 +121,40 @@ namespace BitTorrent
     private:
         Http::Response processRequest(const Http::Request &request, const Http::Environment &env) override;
         void processAnnounceRequest();
+        void processScrapeRequest();
 
         void registerPeer(const TrackerAnnounceRequest &announceReq);
         void unregisterPeer(const TrackerAnnounceRequest &announceReq);
         void prepareAnnounceResponse(const TrackerAnnounceRequest &announceReq);
+        void expirePeers();
+
+        bool startUdp(const QHostAddress &ip, int port);
+        void readUdpDatagrams();
+        // These write the response to `m_udpResponse` and return its size
+        int processUdpRequest(int requestSize);
+        int processUdpConnectRequest();
+        int processUdpAnnounceRequest(int requestSize);
+        int processUdpScrapeRequest(int requestSize);
+        int prepareUdpErrorResponse(const char *message);
+        quint64 udpConnectionId(qint64 timeSlot) const;
 
         Http::Server *m_server;
         Http::Request m_request;
         Http::Environment m_env;
 
+        QUdpSocket *m_udpSocket;
+        quint64 m_udpSecret;
+        // reused for every datagram
+        QByteArray m_udpRequest;
+        QByteArray m_udpResponse;
+        QHostAddress m_udpClientAddress;
+        quint16 m_udpClientPort = 0;
+
         QHash<InfoHash, TorrentStats> m_torrents;
+
+        // timing wheel of peer expiration
+        QTimer *m_expiryTimer;
+        QVector<ExpiryBucket> m_expiryWheel;
+        qint64 m_currentTick = 0;
     };
 }
@@ -33,6 +33,7 @@
 #include "base/logger.h"
 #include "base/preferences.h"
 #include "base/profile.h"
+#include "base/torrentstatuscounters.h"
 #include "base/tristatebool.h"
 #include "base/utils/fs.h"
 #include "base/utils/string.h"
@@ -352,7 +353,7 @@ XDownHandleImpl::XDownHandleImpl(Session *session, const CreateXDownParams &para
     , m_fileSize(params.fileSize)
     , m_completedSize(params.completedSize)
     , m_fileIndex(params.fileIndex)
-    , m_downConcurrent(params.downConcurrent)
+    , m_concurrencyTuner(QUrl(params.url).host(), params.downConcurrent)
 
     , m_reqHeaderMap(params.reqHeaderMap)
     , m_reqUriOptionMap(params.reqUriOptionMap)
@@ -367,6 +368,10 @@ XDownHandleImpl::XDownHandleImpl(Session *session, const CreateXDownParams &para
     , m_gid(0)
     , m_seedingTimeLimit(0)
 {
+    // counted in no status filter until its state is known
+    if (TorrentStatusCounters::instance())
+        TorrentStatusCounters::instance()->addTorrent(m_statusMask);
+
     if (params.savePath.length() > 0) {
         m_savePath = params.savePath;
     }
@@ -408,9 +413,15 @@ XDownHandleImpl::XDownHandleImpl(Session *session, const CreateXDownParams &para
     //    if (filesCount() == 1)
     //        m_hasRootFolder = false;
     //}
+
+    updateStatusCounters();
 }
 
-XDownHandleImpl::~XDownHandleImpl() {}
+XDownHandleImpl::~XDownHandleImpl()
+{
+    if (TorrentStatusCounters::instance())
+        TorrentStatusCounters::instance()->removeTorrent(m_statusMask);
+}
 
 void XDownHandleImpl::clearPeers()
 {
@@ -502,16 +513,21 @@ qlonglong XDownHandleImpl::totalSize() const
 void XDownHandleImpl::setTotalSize(qlonglong iValue) 
 {
     m_fileSize = iValue;
+    updateStatusCounters();
 }
 
 void XDownHandleImpl::setCompletedSize(qlonglong iValue)
 {
     m_completedSize = iValue;
+    updateStatusCounters();
 }
 
 void XDownHandleImpl::setDownSpeed(long iValue)
 {
     m_downSpeed = iValue;
+
+    if ((m_state == TorrentState::XDown_Downloading) && m_concurrencyTuner.addSpeedSample(iValue))
+        requestConcurrencyChange();
 }
 
 int XDownHandleImpl::getRetryValue()
@@ -910,12 +926,14 @@ void XDownHandleImpl::updateState(aria2::DownloadEvent dEvent, long iValue, cons
         setErrorCode(0);
         setErrorMessage("");
         m_state = TorrentState::XDown_Downloading;
+        m_concurrencyTuner.restart();
         break;
     case aria2::EVENT_ON_DOWNLOAD_PAUSE:
     case aria2::EVENT_ON_DOWNLOAD_STOP:
         setErrorCode(0);
         setErrorMessage("");
         m_state = TorrentState::XDown_Paused;
+        m_concurrencyTuner.restart();
         break;
     case aria2::EVENT_ON_DOWNLOAD_COMPLETE:
         setErrorCode(0);
@@ -928,6 +946,8 @@ void XDownHandleImpl::updateState(aria2::DownloadEvent dEvent, long iValue, cons
             setErrorCode(iValue);
             setErrorMessage(strErrMessage);
             bError = true;
+            if (m_concurrencyTuner.handleError())
+                requestConcurrencyChange();
         }
         break;
     case aria2::EVENT_ON_DOWNLOAD_REMOVE:
@@ -942,12 +962,36 @@ void XDownHandleImpl::updateState(aria2::DownloadEvent dEvent, long iValue, cons
     if (dEvent) {
         m_event = dEvent;
     }
+    updateStatusCounters();
+
     if (!bError) {
         // ûд
         setErrorCode(0);
     }
 }
 
+void XDownHandleImpl::setDownConcurrent(const int iValue)
+{
+    if (m_concurrencyTuner.setFixedConcurrency(iValue))
+        requestConcurrencyChange();
+}
+
+void XDownHandleImpl::requestConcurrencyChange()
+{
+    if (SegmentConcurrencyController::instance())
+        SegmentConcurrencyController::instance()->requestConcurrencyChange(this, m_concurrencyTuner.targetConcurrency());
+}
+
+void XDownHandleImpl::updateStatusCounters()
+{
+    const quint32 mask = TorrentStatusCounters::statusMask(this);
+    if (mask == m_statusMask) return;
+
+    if (TorrentStatusCounters::instance())
+        TorrentStatusCounters::instance()->updateTorrent(m_statusMask, mask);
+    m_statusMask = mask;
+}
+
 aria2::DownloadEvent XDownHandleImpl::getDownloadEvent()
 {
     return m_event;
@@ -16,6 +16,7 @@
 #include <QVector>
 #include <QMap>
 
+#include "segmentconcurrency.h"
 #include "speedmonitor.h"
 #include "infohash.h"
 #include "torrenthandle.h"
@@ -133,7 +134,7 @@ namespace BitTorrent
 
         qlonglong getFileIndex() { return m_fileIndex;  }
 
-        void setState(BitTorrent::TorrentState iVal) {m_state = iVal;}
+        void setState(BitTorrent::TorrentState iVal) {m_state = iVal; updateStatusCounters();}
 
         QString url() const override;
         QString source() const override;
@@ -180,8 +181,16 @@ namespace BitTorrent
         void addRetryValue();
 
         // ز
-        void setDownConcurrent(int iValue) { m_downConcurrent = iValue; }
-        int getDownConcurrent() const { return m_downConcurrent; }
+        // non-positive value lets the concurrency adapt to the measured throughput
+        void setDownConcurrent(int iValue);
+        // the value the running download uses
+        int getDownConcurrent() const { return m_concurrencyTuner.concurrency(); }
+        // the value to (re)start the download with, it differs while a change is pending
+        int getTargetDownConcurrent() const { return m_concurrencyTuner.targetConcurrency(); }
+        // called by the session once the running download uses the requested value
+        void handleDownConcurrentApplied(int iValue) { m_concurrencyTuner.applyConcurrency(iValue); }
+        bool isDownConcurrentAdaptive() const { return m_concurrencyTuner.isAdaptive(); }
+        QVector<ConcurrencyChange> getDownConcurrentHistory() const { return m_concurrencyTuner.history(); }
 
         // uint64_t  m_downIndex = 0 ;
         // 
@@ -388,6 +397,8 @@ public:
         void updateStatus();
         void updateStatus(const lt::torrent_status &nativeStatus);
         void updateState();
+        void updateStatusCounters();
+        void requestConcurrencyChange();
 
         
 
@@ -428,6 +439,7 @@ public:
 
         // ״̬
         TorrentState m_state = TorrentState::XDown_Paused;
+        quint32 m_statusMask = 0;  // status filters the task is counted in
 
         aria2::DownloadEvent m_event = aria2::DownloadEvent::EVENT_ON_DOWNLOAD_NONE;
 
@@ -454,7 +466,7 @@ public:
         QMap<QString, QString> m_UIOptionMap;
         
 
-        int  m_downConcurrent = 16;
+        SegmentConcurrencyTuner m_concurrencyTuner;
 
         uint64_t  m_downIndex = 0 ;
 
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <QtGlobal>
+
+// Lock-free bounded queue for many producers and a single consumer.
+// Every slot carries a sequence number telling whether it is free for the producer
+// that claimed its position or holds a value for the consumer, so producers
+// never wait for each other except to retry a failed position claim.
+// Capacity is rounded up to the power of two.
+template <typename T>
+class BoundedQueue
+{
+    Q_DISABLE_COPY(BoundedQueue)
+
+public:
+    explicit BoundedQueue(const int capacity)
+        : m_capacity {roundUpToPowerOfTwo(capacity)}
+        , m_slots {new Slot[m_capacity]}
+    {
+        for (quint64 i = 0; i < m_capacity; ++i)
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Can be called from any thread. Returns false if the queue is full.
+    bool tryPush(T value)
+    {
+        quint64 pos = m_tail.load(std::memory_order_relaxed);
+        Slot *slot = nullptr;
+        for (;;)
+        {
+            slot = &m_slots[pos & (m_capacity - 1)];
+            const quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+            const qint64 diff = static_cast<qint64>(sequence - pos);
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, (pos + 1), std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->value = std::move(value);
+        slot->sequence.store((pos + 1), std::memory_order_release);
+        return true;
+    }
+
+    // Must be called from the consumer thread only. Returns false if the queue is empty.
+    bool tryPop(T &value)
+    {
+        Slot &slot = m_slots[m_head & (m_capacity - 1)];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        if (static_cast<qint64>(sequence - (m_head + 1)) < 0)
+            return false;
+
+        value = std::move(slot.value);
+        slot.value = T {};
+        slot.sequence.store((m_head + m_capacity), std::memory_order_release);
+        ++m_head;
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<quint64> sequence;
+        T value;
+    };
+
+    static quint64 roundUpToPowerOfTwo(const int value)
+    {
+        quint64 result = 1;
+        while (result < static_cast<quint64>(value))
+            result <<= 1;
+        return result;
+    }
+
+    const quint64 m_capacity;
+    const std::unique_ptr<Slot[]> m_slots;
+    // producers and consumer work on different cache lines
+    alignas(64) std::atomic<quint64> m_tail {0};
+    alignas(64) quint64 m_head = 0;
+};
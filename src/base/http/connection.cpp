@@ -33,20 +33,26 @@
 #include <QTcpSocket>
 
 #include "base/logger.h"
-#include "irequesthandler.h"
 #include "requestparser.h"
 #include "responsegenerator.h"
+#include "responsewriter.h"
+#include "serverworker.h"
 
 using namespace Http;
 
-Connection::Connection(QTcpSocket *socket, IRequestHandler *requestHandler, QObject *parent)
+Connection::Connection(QTcpSocket *socket, ServerWorker *worker, QObject *parent)
     : QObject(parent)
     , m_socket(socket)
-    , m_requestHandler(requestHandler)
+    , m_worker(worker)
+    , m_responseWriter(new ResponseWriter(socket, this))
 {
     m_socket->setParent(this);
     m_idleTimer.start();
     connect(m_socket, &QTcpSocket::readyRead, this, &Connection::read);
+    // long responses keep the connection busy
+    connect(m_socket, &QTcpSocket::bytesWritten, this, [this]() { m_idleTimer.restart(); });
+    // pipelined requests wait until the previous response is written
+    connect(m_responseWriter, &ResponseWriter::finished, this, &Connection::read, Qt::QueuedConnection);
 }
 
 Connection::~Connection()
@@ -57,18 +63,27 @@ Connection::~Connection()
 void Connection::read()
 {
     m_idleTimer.restart();
+
+    // drop the requests that have been processed already,
+    // the unprocessed tail is moved in place without reallocation
+    if (m_readPos >= m_receivedData.size())
+        m_receivedData.clear();
+    else if (m_readPos > 0)
+        m_receivedData.remove(0, m_readPos);
+    m_readPos = 0;
+
     m_receivedData.append(m_socket->readAll());
 
-    while (!m_receivedData.isEmpty())
+    while ((m_readPos < m_receivedData.size()) && !m_isProcessing && !m_responseWriter->isBusy())
     {
-        const RequestParser::ParseResult result = RequestParser::parse(m_receivedData);
+        const RequestParser::ParseResult result = m_requestParser.parse(m_receivedData, m_readPos);
 
         switch (result.status)
         {
         case RequestParser::ParseStatus::Incomplete:
         {
                 const long bufferLimit = RequestParser::MAX_CONTENT_SIZE * 1.1;  // some margin for headers
-                if (m_receivedData.size() > bufferLimit)
+                if ((m_receivedData.size() - m_readPos) > bufferLimit)
                 {
                     Logger::instance()->addMessage(tr("Http request size exceeds limitation, closing socket. Limit: %1, IP: %2")
                         .arg(bufferLimit).arg(m_socket->peerAddress().toString()), Log::WARNING);
@@ -76,6 +91,9 @@ void Connection::read()
                     Response resp(413, "Payload Too Large");
                     resp.headers[HEADER_CONNECTION] = "close";
 
+                    m_receivedData.clear();
+                    m_readPos = 0;
+                    m_requestParser.reset();
                     sendResponse(resp);
                     m_socket->close();
                 }
@@ -90,6 +108,8 @@ void Connection::read()
                 Response resp(400, "Bad Request");
                 resp.headers[HEADER_CONNECTION] = "close";
 
+                m_receivedData.clear();
+                m_readPos = 0;
                 sendResponse(resp);
                 m_socket->close();
             }
@@ -99,15 +119,13 @@ void Connection::read()
         {
                 const Environment env {m_socket->localAddress(), m_socket->localPort(), m_socket->peerAddress(), m_socket->peerPort()};
 
-                Response resp = m_requestHandler->processRequest(result.request, env);
-
-                if (acceptsGzipEncoding(result.request.headers["accept-encoding"]))
-                    resp.headers[HEADER_CONTENT_ENCODING] = "gzip";
+                m_acceptsGzip = acceptsGzipEncoding(result.request.headers["accept-encoding"]);
+                m_acceptsChunked = (result.request.version == QLatin1String("1.1"));
+                m_readPos += result.frameSize;
 
-                resp.headers[HEADER_CONNECTION] = "keep-alive";
-
-                sendResponse(resp);
-                m_receivedData = m_receivedData.mid(result.frameSize);
+                // the response may be delivered later, pipelined requests wait for it
+                m_isProcessing = true;
+                m_worker->processRequest(this, result.request, env);
             }
             break;
 
@@ -118,13 +136,26 @@ void Connection::read()
     }
 }
 
-void Connection::sendResponse(const Response &response) const
+void Connection::handleResponse(Response response)
+{
+    m_isProcessing = false;
+    m_idleTimer.restart();
+
+    response.headers[HEADER_CONNECTION] = "keep-alive";
+    sendResponse(response, m_acceptsGzip, m_acceptsChunked);
+}
+
+void Connection::sendResponse(const Response &response, const bool gzip, const bool chunked) const
 {
-    m_socket->write(toByteArray(response));
+    m_responseWriter->write(response, gzip, chunked);
 }
 
 bool Connection::hasExpired(const qint64 timeout) const
 {
+    // the connection isn't idle while its request is processed or its response is written
+    if (m_isProcessing || m_responseWriter->isBusy())
+        return false;
+
     return m_idleTimer.hasExpired(timeout);
 }
 
@@ -33,11 +33,14 @@
 #include <QElapsedTimer>
 #include <QObject>
 
+#include "requestparser.h"
+
 class QTcpSocket;
 
 namespace Http
 {
-    class IRequestHandler;
+    class ResponseWriter;
+    class ServerWorker;
     struct Response;
 
     class Connection : public QObject
@@ -46,22 +49,31 @@ namespace Http
         Q_DISABLE_COPY(Connection)
 
     public:
-        Connection(QTcpSocket *socket, IRequestHandler *requestHandler, QObject *parent = nullptr);
+        Connection(QTcpSocket *socket, ServerWorker *worker, QObject *parent = nullptr);
         ~Connection();
 
         bool hasExpired(qint64 timeout) const;
         bool isClosed() const;
 
+        // called by the worker when the current request has been processed
+        void handleResponse(Response response);
+
     private slots:
         void read();
 
     private:
         static bool acceptsGzipEncoding(QString codings);
-        void sendResponse(const Response &response) const;
+        void sendResponse(const Response &response, bool gzip = false, bool chunked = false) const;
 
         QTcpSocket *m_socket;
-        IRequestHandler *m_requestHandler;
+        ServerWorker *m_worker;
+        ResponseWriter *m_responseWriter;
+        RequestParser m_requestParser;
         QByteArray m_receivedData;
+        int m_readPos = 0;  // start of the first unprocessed request in m_receivedData
         QElapsedTimer m_idleTimer;
+        bool m_isProcessing = false;  // the current request is being processed in another thread
+        bool m_acceptsGzip = false;
+        bool m_acceptsChunked = false;
     };
 }
@@ -39,5 +39,9 @@ namespace Http
     public:
         virtual ~IRequestHandler() {}
         virtual Response processRequest(const Request &request, const Environment &env) = 0;
+
+        // Requests the handler can process in any thread at the same time as other requests.
+        // The rest are processed one by one in the thread the handler belongs to.
+        virtual bool canProcessConcurrently(const Request &) const { return false; }
     };
 }
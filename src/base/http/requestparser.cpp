@@ -33,7 +33,6 @@
 #include <algorithm>
 
 #include <QDebug>
-#include <QRegularExpression>
 #include <QStringList>
 #include <QUrl>
 #include <QUrlQuery>
@@ -57,6 +56,28 @@ namespace
         return in;
     }
 
+    bool isDigit(const char c)
+    {
+        return ((c >= '0') && (c <= '9'));
+    }
+
+    bool parseHeaderLine(const QByteArray &line, HeaderMap &out)
+    {
+        // [rfc7230] 3.2. Header Fields
+        const int i = line.indexOf(':');
+        if (i <= 0)
+        {
+            qWarning() << Q_FUNC_INFO << "invalid http header:" << line;
+            return false;
+        }
+
+        const QString name = QString::fromLatin1(midView(line, 0, i).trimmed()).toLower();
+        const QString value = QString::fromLatin1(midView(line, (i + 1)).trimmed());
+        out[name] = value;
+
+        return true;
+    }
+
     bool parseHeaderLine(const QString &line, HeaderMap &out)
     {
         // [rfc7230] 3.2. Header Fields
@@ -77,36 +98,53 @@ namespace
 
 RequestParser::RequestParser()
 {
+    reset();
 }
 
-RequestParser::ParseResult RequestParser::parse(const QByteArray &data)
+void RequestParser::reset()
+{
+    m_request = {};
+    m_state = State::Header;
+    m_scannedSize = 0;
+    m_headerLength = 0;
+    m_contentLength = 0;
+}
+
+RequestParser::ParseResult RequestParser::parse(const QByteArray &data, const int offset)
 {
     // Warning! Header names are converted to lowercase
-    return RequestParser().doParse(data);
+    const QByteArray frame = midView(data, offset);
+
+    const ParseResult result = (m_state == State::Header) ? parseHeader(frame) : parseBody(frame);
+    if (result.status != ParseStatus::Incomplete)
+        reset();
+    return result;
 }
 
-RequestParser::ParseResult RequestParser::doParse(const QByteArray &data)
+RequestParser::ParseResult RequestParser::parseHeader(const QByteArray &data)
 {
     // we don't handle malformed requests which use double `LF` as delimiter
-    const int headerEnd = data.indexOf(EOH);
+    // the end of header may be split between the reads, so the last bytes are searched again
+    const int from = qMax(0, (m_scannedSize - EOH.length() + 1));
+    const int headerEnd = data.indexOf(EOH, from);
     if (headerEnd < 0)
     {
         qDebug() << Q_FUNC_INFO << "incomplete request";
+        m_scannedSize = data.size();
         return {ParseStatus::Incomplete, Request(), 0};
     }
 
-    const QString httpHeaders = QString::fromLatin1(data.constData(), headerEnd);
-    if (!parseStartLines(httpHeaders))
+    if (!parseStartLines(midView(data, 0, headerEnd)))
     {
         qWarning() << Q_FUNC_INFO << "header parsing error";
         return {ParseStatus::BadRequest, Request(), 0};
     }
 
-    const int headerLength = headerEnd + EOH.length();
+    m_headerLength = headerEnd + EOH.length();
 
     // handle supported methods
     if ((m_request.method == HEADER_REQUEST_METHOD_GET) || (m_request.method == HEADER_REQUEST_METHOD_HEAD))
-        return {ParseStatus::OK, m_request, headerLength};
+        return {ParseStatus::OK, m_request, m_headerLength};
     if (m_request.method == HEADER_REQUEST_METHOD_POST)
     {
         bool ok = false;
@@ -122,46 +160,53 @@ RequestParser::ParseResult RequestParser::doParse(const QByteArray &data)
             return {ParseStatus::BadRequest, Request(), 0};
         }
 
-        if (contentLength > 0)
-        {
-            const QByteArray httpBodyView = midView(data, headerLength, contentLength);
-            if (httpBodyView.length() < contentLength)
-            {
-                qDebug() << Q_FUNC_INFO << "incomplete request";
-                return {ParseStatus::Incomplete, Request(), 0};
-            }
-
-            if (!parsePostMessage(httpBodyView))
-            {
-                qWarning() << Q_FUNC_INFO << "message body parsing error";
-                return {ParseStatus::BadRequest, Request(), 0};
-            }
-        }
-
-        return {ParseStatus::OK, m_request, (headerLength + contentLength)};
+        m_contentLength = contentLength;
+        m_state = State::Body;
+        return parseBody(data);
     }
 
     qWarning() << Q_FUNC_INFO << "unsupported request method: " << m_request.method;
     return {ParseStatus::BadRequest, Request(), 0};  // TODO: SHOULD respond "501 Not Implemented"
 }
 
-bool RequestParser::parseStartLines(const QString &data)
+RequestParser::ParseResult RequestParser::parseBody(const QByteArray &data)
+{
+    if ((data.size() - m_headerLength) < m_contentLength)
+    {
+        qDebug() << Q_FUNC_INFO << "incomplete request";
+        return {ParseStatus::Incomplete, Request(), 0};
+    }
+
+    if (m_contentLength > 0)
+    {
+        if (!parsePostMessage(midView(data, m_headerLength, m_contentLength)))
+        {
+            qWarning() << Q_FUNC_INFO << "message body parsing error";
+            return {ParseStatus::BadRequest, Request(), 0};
+        }
+    }
+
+    return {ParseStatus::OK, m_request, (m_headerLength + m_contentLength)};
+}
+
+bool RequestParser::parseStartLines(const QByteArray &data)
 {
     // we don't handle malformed request which uses `LF` for newline
-    const QVector<QStringRef> lines = data.splitRef(CRLF, QString::SkipEmptyParts);
+    const QVector<QByteArray> lines = splitToViews(data, CRLF, QString::SkipEmptyParts);
 
     // [rfc7230] 3.2.2. Field Order
-    QStringList requestLines;
-    for (const auto &line : lines)
+    QVector<QByteArray> requestLines;
+    requestLines.reserve(lines.size());
+    for (const QByteArray &line : lines)
     {
-        if (line.at(0).isSpace() && !requestLines.isEmpty())
+        if (((line.at(0) == ' ') || (line.at(0) == '\t')) && !requestLines.isEmpty())
         {
             // continuation of previous line
-            requestLines.last() += line.toString();
+            requestLines.last() = requestLines.last() + line;
         }
         else
         {
-            requestLines += line.toString();
+            requestLines += line;
         }
     }
 
@@ -171,7 +216,7 @@ bool RequestParser::parseStartLines(const QString &data)
     if (!parseRequestLine(requestLines[0]))
         return false;
 
-    for (auto i = ++(requestLines.begin()); i != requestLines.end(); ++i)
+    for (auto i = ++(requestLines.cbegin()); i != requestLines.cend(); ++i)
     {
         if (!parseHeaderLine(*i, m_request.headers))
             return false;
@@ -180,24 +225,27 @@ bool RequestParser::parseStartLines(const QString &data)
     return true;
 }
 
-bool RequestParser::parseRequestLine(const QString &line)
+bool RequestParser::parseRequestLine(const QByteArray &line)
 {
     // [rfc7230] 3.1.1. Request Line
-
-    const QRegularExpression re(QLatin1String("^([A-Z]+)\\s+(\\S+)\\s+HTTP\\/(\\d\\.\\d)$"));
-    const QRegularExpressionMatch match = re.match(line);
-
-    if (!match.hasMatch())
+    // request-line = method SP request-target SP HTTP-version
+
+    const QVector<QByteArray> parts = splitToViews(line, " ", QString::SkipEmptyParts);
+    const bool isValid = (parts.size() == 3)
+        && std::all_of(parts[0].cbegin(), parts[0].cend(), [](const char c) { return ((c >= 'A') && (c <= 'Z')); })
+        && (parts[2].size() == 8) && parts[2].startsWith("HTTP/")
+        && isDigit(parts[2][5]) && (parts[2][6] == '.') && isDigit(parts[2][7]);
+    if (!isValid)
     {
         qWarning() << Q_FUNC_INFO << "invalid http header:" << line;
         return false;
     }
 
     // Request Methods
-    m_request.method = match.captured(1);
+    m_request.method = QString::fromLatin1(parts[0]);
 
     // Request Target
-    const QByteArray url {match.captured(2).toLatin1()};
+    const QByteArray &url = parts[1];
     const int sepPos = url.indexOf('?');
     const QByteArray pathComponent = ((sepPos == -1) ? url : midView(url, 0, sepPos));
 
@@ -226,7 +274,7 @@ bool RequestParser::parseRequestLine(const QString &line)
     }
 
     // HTTP-version
-    m_request.version = match.captured(3);
+    m_request.version = QString::fromLatin1(midView(parts[2], 5));
 
     return true;
 }
@@ -34,6 +34,10 @@
 
 namespace Http
 {
+    // Parses requests out of a connection receive buffer. The parser remembers how far
+    // it got, so when a request arrives in several reads only the new bytes are scanned.
+    // Parsed request refers to the buffer without copying it, it is valid as long as
+    // the parsed part of the buffer isn't modified.
     class RequestParser
     {
     public:
@@ -52,20 +56,35 @@ namespace Http
             long frameSize;  // http request frame size (bytes)
         };
 
-        static ParseResult parse(const QByteArray &data);
+        RequestParser();
+
+        // Parses the request that starts at `offset` in `data`.
+        // Data preceding `offset` may be discarded between the calls
+        // as long as the request is passed at its new offset.
+        ParseResult parse(const QByteArray &data, int offset = 0);
+        void reset();
 
         static const long MAX_CONTENT_SIZE = 64 * 1024 * 1024;  // 64 MB
 
     private:
-        RequestParser();
+        enum class State
+        {
+            Header,
+            Body
+        };
 
-        ParseResult doParse(const QByteArray &data);
-        bool parseStartLines(const QString &data);
-        bool parseRequestLine(const QString &line);
+        ParseResult parseHeader(const QByteArray &data);
+        ParseResult parseBody(const QByteArray &data);
+        bool parseStartLines(const QByteArray &data);
+        bool parseRequestLine(const QByteArray &line);
 
         bool parsePostMessage(const QByteArray &data);
         bool parseFormData(const QByteArray &data);
 
         Request m_request;
+        State m_state;
+        int m_scannedSize;  // header bytes already searched for the end of header
+        int m_headerLength;
+        int m_contentLength;
     };
 }
@@ -50,6 +50,12 @@ void ResponseBuilder::print(const QByteArray &data, const QString &type)
     print_impl(data, type);
 }
 
+void ResponseBuilder::setPrecompressed(const QByteArray &gzipData)
+{
+    m_response.isPrecompressed = true;
+    m_response.gzipContent = gzipData;
+}
+
 void ResponseBuilder::clear()
 {
     m_response = Response();
@@ -39,6 +39,8 @@ namespace Http
         void setHeader(const Header &header);
         void print(const QString &text, const QString &type = CONTENT_TYPE_HTML);
         void print(const QByteArray &data, const QString &type = CONTENT_TYPE_HTML);
+        // `gzipData` is the printed data compressed, empty if it shouldn't be compressed at all
+        void setPrecompressed(const QByteArray &gzipData);
         void clear();
 
         Response response() const;
@@ -38,29 +38,33 @@ QByteArray Http::toByteArray(Response response)
 {
     compressContent(response);
 
-    response.headers[HEADER_CONTENT_LENGTH] = QString::number(response.content.length());
+    // [rfc7230] 3.3.2. 304 response has no body, its content-length would describe the 200 one
+    if (response.status.code != 304)
+        response.headers[HEADER_CONTENT_LENGTH] = QString::number(response.content.length());
     response.headers[HEADER_DATE] = httpDate();
 
+    // message body  // TODO: support HEAD request
+    return headToByteArray(response).append(response.content);
+}
+
+QByteArray Http::headToByteArray(const Response &response)
+{
     QByteArray buf;
-    buf.reserve(10 * 1024);
+    buf.reserve(1024);
 
     // Status Line
-    buf += QString("HTTP/%1 %2 %3")
-        .arg("1.1",  // TODO: depends on request
-            QString::number(response.status.code),
-            response.status.text)
-        .toLatin1()
+    buf.append("HTTP/1.1 ")  // TODO: depends on request
+        .append(QByteArray::number(response.status.code))
+        .append(' ')
+        .append(response.status.text.toLatin1())
         .append(CRLF);
 
     // Header Fields
     for (auto i = response.headers.constBegin(); i != response.headers.constEnd(); ++i)
-        buf += QString::fromLatin1("%1: %2").arg(i.key(), i.value()).toLatin1().append(CRLF);
+        buf.append(i.key().toLatin1()).append(": ").append(i.value().toLatin1()).append(CRLF);
 
     // the first empty line
-    buf += CRLF;
-
-    // message body  // TODO: support HEAD request
-    buf += response.content;
+    buf.append(CRLF);
 
     return buf;
 }
@@ -81,6 +85,17 @@ void Http::compressContent(Response &response)
 
     response.headers.remove(HEADER_CONTENT_ENCODING);
 
+    // the handler has already decided, calling this again gives the same result
+    if (response.isPrecompressed)
+    {
+        if (!response.gzipContent.isEmpty())
+        {
+            response.content = response.gzipContent;
+            response.headers[HEADER_CONTENT_ENCODING] = QLatin1String("gzip");
+        }
+        return;
+    }
+
     // for very small files, compressing them only wastes cpu cycles
     const int contentSize = response.content.size();
     if (contentSize <= 1024)  // 1 kb
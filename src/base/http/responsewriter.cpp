@@ -0,0 +1,143 @@
+#include "responsewriter.h"
+
+#include <QTcpSocket>
+
+#include "base/utils/gzip.h"
+#include "responsegenerator.h"
+#include "types.h"
+
+namespace
+{
+    // bodies up to this size are sent in one piece with content-length
+    const int STREAMING_THRESHOLD = 64 * 1024;
+    // amount of the body consumed at once
+    const int PIECE_SIZE = 32 * 1024;
+    // no more data is produced while the socket has this much pending
+    const qint64 WRITE_BUFFER_LIMIT = 256 * 1024;
+}
+
+using namespace Http;
+
+ResponseWriter::ResponseWriter(QTcpSocket *socket, QObject *parent)
+    : QObject(parent)
+    , m_socket(socket)
+{
+    connect(m_socket, &QTcpSocket::bytesWritten, this, &ResponseWriter::writeMore);
+}
+
+ResponseWriter::~ResponseWriter() = default;
+
+bool ResponseWriter::isBusy() const
+{
+    return m_busy;
+}
+
+void ResponseWriter::write(Response response, const bool gzip, const bool chunked)
+{
+    Q_ASSERT(!m_busy);
+
+    if (gzip)
+        response.headers[HEADER_CONTENT_ENCODING] = QLatin1String("gzip");
+
+    // precompressed content is never compressed on the fly, only the variant to send is chosen
+    if (response.isPrecompressed)
+        compressContent(response);
+
+    if (response.content.size() <= STREAMING_THRESHOLD)
+    {
+        m_socket->write(toByteArray(response));
+        emit finished();
+        return;
+    }
+
+    if (!response.isPrecompressed)
+        response.headers.remove(HEADER_CONTENT_ENCODING);
+    response.headers[HEADER_DATE] = httpDate();
+
+    // incremental compression needs chunked transfer-encoding since the resulting size isn't known in advance
+    const QString contentType = response.headers.value(HEADER_CONTENT_TYPE);
+    if (gzip && chunked && !response.isPrecompressed
+        && (contentType != CONTENT_TYPE_GIF) && (contentType != CONTENT_TYPE_PNG))
+    {
+        m_compressor.reset(new Utils::Gzip::Compressor);
+        if (!m_compressor->isValid())
+            m_compressor.reset();
+    }
+
+    m_chunked = (m_compressor != nullptr);
+    if (m_chunked)
+    {
+        response.headers[HEADER_CONTENT_ENCODING] = QLatin1String("gzip");
+        response.headers[HEADER_TRANSFER_ENCODING] = QLatin1String("chunked");
+    }
+    else
+    {
+        response.headers[HEADER_CONTENT_LENGTH] = QString::number(response.content.size());
+    }
+
+    m_socket->write(headToByteArray(response));
+
+    m_content = response.content;
+    m_offset = 0;
+    m_busy = true;
+    writeMore();
+}
+
+void ResponseWriter::writeMore()
+{
+    if (!m_busy)
+        return;
+
+    while (m_socket->bytesToWrite() < WRITE_BUFFER_LIMIT)
+    {
+        if (m_offset >= m_content.size())
+        {
+            if (m_compressor)
+            {
+                writeChunk(m_compressor->finish());
+                m_compressor.reset();
+            }
+            if (m_chunked)
+                m_socket->write(QByteArray("0").append(CRLF).append(CRLF));
+
+            m_content.clear();
+            m_busy = false;
+            emit finished();
+            return;
+        }
+
+        // refers to m_content without copying, it is kept alive until the piece is written
+        const int size = qMin(PIECE_SIZE, (m_content.size() - m_offset));
+        const QByteArray piece = QByteArray::fromRawData((m_content.constData() + m_offset), size);
+        m_offset += size;
+
+        if (m_compressor)
+        {
+            writeChunk(m_compressor->compress(piece));
+            if (!m_compressor->isValid())
+            {
+                // the body is broken already, the client has to know it
+                m_socket->abort();
+                m_busy = false;
+                return;
+            }
+        }
+        else
+        {
+            m_socket->write(piece);
+        }
+    }
+}
+
+void ResponseWriter::writeChunk(const QByteArray &data)
+{
+    // zero-sized chunk would terminate the body
+    if (data.isEmpty())
+        return;
+
+    QByteArray chunk;
+    chunk.reserve(data.size() + 16);
+    chunk.append(QByteArray::number(data.size(), 16)).append(CRLF)
+        .append(data).append(CRLF);
+    m_socket->write(chunk);
+}
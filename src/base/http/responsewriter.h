@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+
+#include <QByteArray>
+#include <QObject>
+
+class QTcpSocket;
+
+namespace Utils
+{
+    namespace Gzip
+    {
+        class Compressor;
+    }
+}
+
+namespace Http
+{
+    struct Response;
+
+    // Writes a response to the socket piece by piece. Large bodies are sent with
+    // chunked transfer-encoding and compressed on the fly, the next piece is produced
+    // only after the socket has flushed enough of the previous ones.
+    class ResponseWriter : public QObject
+    {
+        Q_OBJECT
+        Q_DISABLE_COPY(ResponseWriter)
+
+    public:
+        explicit ResponseWriter(QTcpSocket *socket, QObject *parent = nullptr);
+        ~ResponseWriter();
+
+        bool isBusy() const;
+
+        // `gzip` and `chunked` tell what the client accepts,
+        // they are used only if it is worth it
+        void write(Response response, bool gzip, bool chunked);
+
+    signals:
+        void finished();
+
+    private slots:
+        void writeMore();
+
+    private:
+        void writeChunk(const QByteArray &data);
+
+        QTcpSocket *m_socket;
+        QByteArray m_content;
+        int m_offset = 0;
+        bool m_chunked = false;
+        bool m_busy = false;
+        std::unique_ptr<Utils::Gzip::Compressor> m_compressor;
+    };
+}
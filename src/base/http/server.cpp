@@ -37,17 +37,16 @@
 #include <QSslConfiguration>
 #include <QSslSocket>
 #include <QStringList>
-#include <QTimer>
+#include <QThread>
 
-#include "base/algorithm.h"
+#include "base/global.h"
 #include "base/utils/net.h"
-#include "connection.h"
+#include "serverworker.h"
 
 namespace
 {
-    const int KEEP_ALIVE_DURATION = 7 * 1000;  // milliseconds
     const int CONNECTIONS_LIMIT = 500;
-    const int CONNECTIONS_SCAN_INTERVAL = 2;  // seconds
+    const int MAX_WORKER_THREADS = 16;
 
     QList<QSslCipher> safeCipherList()
     {
@@ -70,6 +69,8 @@ using namespace Http;
 Server::Server(IRequestHandler *requestHandler, QObject *parent)
     : QTcpServer(parent)
     , m_requestHandler(requestHandler)
+    , m_localWorker(new ServerWorker(requestHandler, this, CONNECTIONS_LIMIT, this))
+    , m_nextWorker(0)
     , m_https(false)
 {
     setProxy(QNetworkProxy::NoProxy);
@@ -77,58 +78,77 @@ Server::Server(IRequestHandler *requestHandler, QObject *parent)
     QSslConfiguration sslConf {QSslConfiguration::defaultConfiguration()};
     sslConf.setCiphers(safeCipherList());
     QSslConfiguration::setDefaultConfiguration(sslConf);
+}
 
-    auto *dropConnectionTimer = new QTimer(this);
-    connect(dropConnectionTimer, &QTimer::timeout, this, &Server::dropTimedOutConnection);
-    dropConnectionTimer->start(CONNECTIONS_SCAN_INTERVAL * 1000);
+Server::~Server()
+{
+    stopWorkerThreads();
 }
 
-void Server::incomingConnection(const qintptr socketDescriptor)
+void Server::setWorkerThreadCount(int count)
 {
-    if (m_connections.size() >= CONNECTIONS_LIMIT) return;
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    count = qBound(0, count, MAX_WORKER_THREADS);
+    if (count == m_workerThreads.size()) return;
 
-    QTcpSocket *serverSocket;
-    if (m_https)
-        serverSocket = new QSslSocket(this);
-    else
-        serverSocket = new QTcpSocket(this);
+    // connections served by the old workers are dropped
+    stopWorkerThreads();
 
-    if (!serverSocket->setSocketDescriptor(socketDescriptor))
+    for (int i = 0; i < count; ++i)
     {
-        delete serverSocket;
-        return;
+        auto *thread = new QThread(this);
+        auto *worker = new ServerWorker(m_requestHandler, this, (CONNECTIONS_LIMIT / count));
+        worker->moveToThread(thread);
+        // the worker, its connections and timer are deleted in their own thread
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start();
+
+        m_workerThreads.append(thread);
+        m_workers.append(worker);
     }
+#else
+    // worker threads need functor based QMetaObject::invokeMethod()
+    Q_UNUSED(count);
+#endif
+}
+
+void Server::stopWorkerThreads()
+{
+    for (ServerWorker *worker : asConst(m_workers))
+        worker->retire();
+    m_workers.clear();
 
-    if (m_https)
+    // the workers are deleted by their threads when these finish
+    for (QThread *thread : asConst(m_workerThreads))
     {
-        static_cast<QSslSocket *>(serverSocket)->setProtocol(QSsl::SecureProtocols);
-        static_cast<QSslSocket *>(serverSocket)->setPrivateKey(m_key);
-        static_cast<QSslSocket *>(serverSocket)->setLocalCertificateChain(m_certificates);
-        static_cast<QSslSocket *>(serverSocket)->setPeerVerifyMode(QSslSocket::VerifyNone);
-        static_cast<QSslSocket *>(serverSocket)->startServerEncryption();
+        thread->quit();
+        thread->wait();
+        delete thread;
     }
-
-    auto *c = new Connection(serverSocket, m_requestHandler, this);
-    m_connections.insert(c);
-    connect(serverSocket, &QAbstractSocket::disconnected, this, [c, this]() { removeConnection(c); });
+    m_workerThreads.clear();
+    m_nextWorker = 0;
 }
 
-void Server::removeConnection(Connection *connection)
+void Server::incomingConnection(const qintptr socketDescriptor)
 {
-    m_connections.remove(connection);
-    connection->deleteLater();
-}
+    const QList<QSslCertificate> certificates = m_https ? m_certificates : QList<QSslCertificate> {};
 
-void Server::dropTimedOutConnection()
-{
-    Algorithm::removeIf(m_connections, [](Connection *connection)
+    if (m_workers.isEmpty())
     {
-        if (!connection->hasExpired(KEEP_ALIVE_DURATION))
-            return false;
+        m_localWorker->addConnection(socketDescriptor, certificates, m_key);
+        return;
+    }
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    ServerWorker *worker = m_workers[m_nextWorker];
+    m_nextWorker = (m_nextWorker + 1) % m_workers.size();
 
-        connection->deleteLater();
-        return true;
-    });
+    const QSslKey key = m_key;
+    QMetaObject::invokeMethod(worker, [worker, socketDescriptor, certificates, key]()
+    {
+        worker->addConnection(socketDescriptor, certificates, key);
+    }, Qt::QueuedConnection);
+#endif
 }
 
 bool Server::setupHttps(const QByteArray &certificates, const QByteArray &privateKey)
@@ -30,15 +30,17 @@
 
 #pragma once
 
-#include <QSet>
 #include <QSslCertificate>
 #include <QSslKey>
 #include <QTcpServer>
+#include <QVector>
+
+class QThread;
 
 namespace Http
 {
     class IRequestHandler;
-    class Connection;
+    class ServerWorker;
 
     class Server final : public QTcpServer
     {
@@ -47,19 +49,24 @@ namespace Http
 
     public:
         explicit Server(IRequestHandler *requestHandler, QObject *parent = nullptr);
+        ~Server() override;
 
         bool setupHttps(const QByteArray &certificates, const QByteArray &privateKey);
         void disableHttps();
 
-    private slots:
-        void dropTimedOutConnection();
+        // Connections are served by the given number of worker threads,
+        // 0 serves them in the thread of the server
+        void setWorkerThreadCount(int count);
 
     private:
         void incomingConnection(qintptr socketDescriptor) override;
-        void removeConnection(Connection *connection);
+        void stopWorkerThreads();
 
         IRequestHandler *m_requestHandler;
-        QSet<Connection *> m_connections;  // for tracking persistent connections
+        ServerWorker *m_localWorker;
+        QVector<QThread *> m_workerThreads;
+        QVector<ServerWorker *> m_workers;
+        int m_nextWorker;
 
         bool m_https;
         QList<QSslCertificate> m_certificates;
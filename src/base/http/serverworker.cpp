@@ -0,0 +1,125 @@
+#include "serverworker.h"
+
+#include <QPointer>
+#include <QSslSocket>
+#include <QThread>
+#include <QTimer>
+
+#include "base/algorithm.h"
+#include "connection.h"
+#include "irequesthandler.h"
+#include "types.h"
+
+namespace
+{
+    const int KEEP_ALIVE_DURATION = 7 * 1000;  // milliseconds
+    const int CONNECTIONS_SCAN_INTERVAL = 2;  // seconds
+
+    // Parsed request refers to the receive buffer of its connection,
+    // it has to own its data before it is passed to another thread
+    Http::Request detached(Http::Request request)
+    {
+        for (Http::UploadedFile &file : request.files)
+            file.data = QByteArray(file.data.constData(), file.data.size());
+        return request;
+    }
+}
+
+using namespace Http;
+
+ServerWorker::ServerWorker(IRequestHandler *requestHandler, QObject *handlerContext, const int connectionsLimit, QObject *parent)
+    : QObject(parent)
+    , m_requestHandler(requestHandler)
+    , m_handlerContext(handlerContext)
+    , m_connectionsLimit(connectionsLimit)
+    , m_isAlive(std::make_shared<bool>(true))
+{
+    auto *dropConnectionTimer = new QTimer(this);
+    connect(dropConnectionTimer, &QTimer::timeout, this, &ServerWorker::dropTimedOutConnection);
+    dropConnectionTimer->start(CONNECTIONS_SCAN_INTERVAL * 1000);
+}
+
+void ServerWorker::addConnection(const qintptr socketDescriptor, const QList<QSslCertificate> &certificates, const QSslKey &key)
+{
+    if (m_connections.size() >= m_connectionsLimit) return;
+
+    const bool https = !certificates.isEmpty();
+
+    QTcpSocket *serverSocket;
+    if (https)
+        serverSocket = new QSslSocket(this);
+    else
+        serverSocket = new QTcpSocket(this);
+
+    if (!serverSocket->setSocketDescriptor(socketDescriptor))
+    {
+        delete serverSocket;
+        return;
+    }
+
+    if (https)
+    {
+        static_cast<QSslSocket *>(serverSocket)->setProtocol(QSsl::SecureProtocols);
+        static_cast<QSslSocket *>(serverSocket)->setPrivateKey(key);
+        static_cast<QSslSocket *>(serverSocket)->setLocalCertificateChain(certificates);
+        static_cast<QSslSocket *>(serverSocket)->setPeerVerifyMode(QSslSocket::VerifyNone);
+        static_cast<QSslSocket *>(serverSocket)->startServerEncryption();
+    }
+
+    auto *c = new Connection(serverSocket, this, this);
+    m_connections.insert(c);
+    connect(serverSocket, &QAbstractSocket::disconnected, this, [c, this]() { removeConnection(c); });
+}
+
+void ServerWorker::processRequest(Connection *connection, const Request &request, const Environment &env)
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    if ((m_handlerContext->thread() != thread()) && !m_requestHandler->canProcessConcurrently(request))
+    {
+        // the connection may be gone when the response is ready, its guard is checked in this thread only.
+        // Workers are retired in the thread of the handler before they are deleted in their own thread,
+        // so the alive flag is checked there.
+        const QPointer<Connection> guard = connection;
+        ServerWorker *worker = this;
+        IRequestHandler *requestHandler = m_requestHandler;
+        QMetaObject::invokeMethod(m_handlerContext, [worker, isAlive = m_isAlive, requestHandler, guard, request = detached(request), env]()
+        {
+            if (!*isAlive)
+                return;
+
+            const Response response = requestHandler->processRequest(request, env);
+            QMetaObject::invokeMethod(worker, [guard, response]()
+            {
+                if (guard)
+                    guard->handleResponse(response);
+            }, Qt::QueuedConnection);
+        }, Qt::QueuedConnection);
+        return;
+    }
+#endif
+
+    connection->handleResponse(m_requestHandler->processRequest(request, env));
+}
+
+void ServerWorker::retire()
+{
+    *m_isAlive = false;
+}
+
+void ServerWorker::removeConnection(Connection *connection)
+{
+    m_connections.remove(connection);
+    connection->deleteLater();
+}
+
+void ServerWorker::dropTimedOutConnection()
+{
+    Algorithm::removeIf(m_connections, [](Connection *connection)
+    {
+        if (!connection->hasExpired(KEEP_ALIVE_DURATION))
+            return false;
+
+        connection->deleteLater();
+        return true;
+    });
+}
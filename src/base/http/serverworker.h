@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QSslCertificate>
+#include <QSslKey>
+
+namespace Http
+{
+    class Connection;
+    class IRequestHandler;
+    struct Environment;
+    struct Request;
+
+    // Serves the connections handed over by the server. A worker can live in a thread
+    // of its own, then parsing, TLS and response encoding of its connections happen there
+    // and only the requests that the handler can't process concurrently are passed
+    // to the thread of `handlerContext`.
+    class ServerWorker final : public QObject
+    {
+        Q_OBJECT
+        Q_DISABLE_COPY(ServerWorker)
+
+    public:
+        ServerWorker(IRequestHandler *requestHandler, QObject *handlerContext, int connectionsLimit, QObject *parent = nullptr);
+
+        // HTTPS is used if the certificates aren't empty
+        void addConnection(qintptr socketDescriptor, const QList<QSslCertificate> &certificates, const QSslKey &key);
+        void processRequest(Connection *connection, const Request &request, const Environment &env);
+        // Called in the thread of `handlerContext` before the thread of the worker is stopped,
+        // the requests still waiting there are dropped
+        void retire();
+
+    private slots:
+        void dropTimedOutConnection();
+
+    private:
+        void removeConnection(Connection *connection);
+
+        IRequestHandler *m_requestHandler;
+        QObject *m_handlerContext;
+        int m_connectionsLimit;
+        QSet<Connection *> m_connections;  // for tracking persistent connections
+        // accessed in the thread of `handlerContext` only, it outlives the worker
+        std::shared_ptr<bool> m_isAlive;
+    };
+}
@@ -46,11 +46,15 @@ namespace Http
     const char HEADER_CONTENT_SECURITY_POLICY[] = "content-security-policy";
     const char HEADER_CONTENT_TYPE[] = "content-type";
     const char HEADER_DATE[] = "date";
+    const char HEADER_ETAG[] = "etag";
     const char HEADER_HOST[] = "host";
+    const char HEADER_IF_NONE_MATCH[] = "if-none-match";
     const char HEADER_ORIGIN[] = "origin";
     const char HEADER_REFERER[] = "referer";
     const char HEADER_REFERRER_POLICY[] = "referrer-policy";
     const char HEADER_SET_COOKIE[] = "set-cookie";
+    const char HEADER_TRANSFER_ENCODING[] = "transfer-encoding";
+    const char HEADER_VARY[] = "vary";
     const char HEADER_X_CONTENT_TYPE_OPTIONS[] = "x-content-type-options";
     const char HEADER_X_FORWARDED_HOST[] = "x-forwarded-host";
     const char HEADER_X_FRAME_OPTIONS[] = "x-frame-options";
@@ -119,6 +123,10 @@ namespace Http
         ResponseStatus status;
         HeaderMap headers;
         QByteArray content;
+        // Set by the handler that compressed the content in advance, `gzipContent` is sent instead
+        // of the content if the client accepts gzip. It is empty if compression isn't worth it.
+        bool isPrecompressed = false;
+        QByteArray gzipContent;
 
         Response(uint code = 200, const QString &text = "OK")
             : status {code, text}
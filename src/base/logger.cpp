@@ -31,10 +31,16 @@
 #include <algorithm>
 
 #include <QDateTime>
+#include <QMetaObject>
 #include <QVector>
 
+#include "global.h"
+
 namespace
 {
+    // messages added faster than the logger thread takes them are dropped beyond this
+    const int MAX_PENDING_MESSAGES = 4096;
+
     template <typename T>
     QVector<T> loadFromBuffer(const boost::circular_buffer_space_optimized<T> &src, const int offset = 0)
     {
@@ -50,6 +56,8 @@ Logger *Logger::m_instance = nullptr;
 Logger::Logger()
     : m_messages(MAX_LOG_MESSAGES)
     , m_peers(MAX_LOG_MESSAGES)
+    , m_pendingMessages(MAX_PENDING_MESSAGES)
+    , m_pendingPeers(MAX_PENDING_MESSAGES)
 {
 }
 
@@ -72,22 +80,74 @@ void Logger::freeInstance()
 
 void Logger::addMessage(const QString &message, const Log::MsgType &type)
 {
-    QWriteLocker locker(&m_lock);
-    const Log::Msg msg = {m_msgCounter++, type, QDateTime::currentMSecsSinceEpoch(), message};
-    m_messages.push_back(msg);
-    locker.unlock();
+    // id is assigned when the message is moved to the history
+    if (!m_pendingMessages.tryPush({-1, type, QDateTime::currentMSecsSinceEpoch(), message}))
+        ++m_droppedCount;
 
-    emit newLogMessage(msg);
+    scheduleProcessing();
 }
 
 void Logger::addPeer(const QString &ip, const bool blocked, const QString &reason)
 {
+    if (!m_pendingPeers.tryPush({-1, blocked, QDateTime::currentMSecsSinceEpoch(), ip, reason}))
+        ++m_droppedCount;
+
+    scheduleProcessing();
+}
+
+void Logger::scheduleProcessing()
+{
+    if (m_isProcessingScheduled.exchange(true))
+        return;
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    QMetaObject::invokeMethod(this, [this]() { processPendingMessages(); }, Qt::QueuedConnection);
+#else
+    QMetaObject::invokeMethod(this, "processPendingMessages", Qt::QueuedConnection);
+#endif
+}
+
+void Logger::processPendingMessages()
+{
+    // messages added from now on need another run
+    m_isProcessingScheduled.store(false);
+
+    QVector<Log::Msg> messages;
+    QVector<Log::Peer> peers;
+
     QWriteLocker locker(&m_lock);
-    const Log::Peer msg = {m_peerCounter++, blocked, QDateTime::currentMSecsSinceEpoch(), ip, reason};
-    m_peers.push_back(msg);
+
+    Log::Msg msg;
+    while (m_pendingMessages.tryPop(msg))
+    {
+        msg.id = m_msgCounter++;
+        m_messages.push_back(msg);
+        messages.append(msg);
+    }
+
+    Log::Peer peer;
+    while (m_pendingPeers.tryPop(peer))
+    {
+        peer.id = m_peerCounter++;
+        m_peers.push_back(peer);
+        peers.append(peer);
+    }
+
+    const int droppedCount = m_droppedCount.exchange(0);
+    if (droppedCount > 0)
+    {
+        msg = {m_msgCounter++, Log::WARNING, QDateTime::currentMSecsSinceEpoch()
+            , tr("%1 log messages were dropped because they were added faster than they could be processed").arg(droppedCount)};
+        m_messages.push_back(msg);
+        messages.append(msg);
+    }
+
     locker.unlock();
 
-    emit newLogPeer(msg);
+    for (const Log::Msg &message : asConst(messages))
+        emit newLogMessage(message);
+    for (const Log::Peer &peerMessage : asConst(peers))
+        emit newLogPeer(peerMessage);
 }
 
 QVector<Log::Msg> Logger::getMessages(const int lastKnownId) const
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <boost/circular_buffer.hpp>
 
 #include <QObject>
@@ -35,6 +37,8 @@
 #include <QString>
 #include <QtContainerFwd>
 
+#include "boundedqueue.h"
+
 const int MAX_LOG_MESSAGES = 20000;
 
 namespace Log
@@ -79,11 +83,17 @@ public:
     static void freeInstance();
     static Logger *instance();
 
+    // These can be called from any thread. The messages are queued without locking
+    // and become available in the thread of the logger on its next event loop iteration.
     void addMessage(const QString &message, const Log::MsgType &type = Log::NORMAL);
     void addPeer(const QString &ip, bool blocked, const QString &reason = {});
     QVector<Log::Msg> getMessages(int lastKnownId = -1) const;
     QVector<Log::Peer> getPeers(int lastKnownId = -1) const;
 
+    // Moves the queued messages to the history and emits them.
+    // Must be called from the thread of the logger.
+    Q_INVOKABLE void processPendingMessages();
+
 signals:
     void newLogMessage(const Log::Msg &message);
     void newLogPeer(const Log::Peer &peer);
@@ -92,12 +102,19 @@ private:
     Logger();
     ~Logger() = default;
 
+    void scheduleProcessing();
+
     static Logger *m_instance;
     boost::circular_buffer_space_optimized<Log::Msg> m_messages;
     boost::circular_buffer_space_optimized<Log::Peer> m_peers;
     mutable QReadWriteLock m_lock;
     int m_msgCounter = 0;
     int m_peerCounter = 0;
+
+    BoundedQueue<Log::Msg> m_pendingMessages;
+    BoundedQueue<Log::Peer> m_pendingPeers;
+    std::atomic<int> m_droppedCount {0};
+    std::atomic<bool> m_isProcessingScheduled {false};
 };
 
 // Helper function
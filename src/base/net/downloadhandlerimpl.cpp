@@ -37,23 +37,8 @@
 #include "base/utils/misc.h"
 
 const int MAX_REDIRECTIONS = 20;  // the common value for web browsers
-
-namespace
-{
-    bool saveToFile(const QByteArray &replyData, QString &filePath)
-    {
-        QTemporaryFile tmpfile {Utils::Fs::tempPath() + "XXXXXX"};
-        tmpfile.setAutoRemove(false);
-
-        if (!tmpfile.open())
-            return false;
-
-        filePath = tmpfile.fileName();
-
-        tmpfile.write(replyData);
-        return true;
-    }
-}
+// the reply data is read and saved to file in pieces of this size
+const qint64 READ_CHUNK_SIZE = 64 * 1024;
 
 DownloadHandlerImpl::DownloadHandlerImpl(Net::DownloadManager *manager, const Net::DownloadRequest &downloadRequest)
     : DownloadHandler {manager}
@@ -64,6 +49,8 @@ DownloadHandlerImpl::DownloadHandlerImpl(Net::DownloadManager *manager, const Ne
     m_result.status = Net::DownloadStatus::Success;
 }
 
+DownloadHandlerImpl::~DownloadHandlerImpl() = default;
+
 void DownloadHandlerImpl::cancel()
 {
     if (m_reply)
@@ -86,6 +73,8 @@ void DownloadHandlerImpl::assignNetworkReply(QNetworkReply *reply)
     m_reply->setParent(this);
     if (m_downloadRequest.limit() > 0)
         connect(m_reply, &QNetworkReply::downloadProgress, this, &DownloadHandlerImpl::checkDownloadSize);
+    if (m_downloadRequest.saveToFile())
+        connect(m_reply, &QNetworkReply::readyRead, this, [this]() { readReplyData(); });
     connect(m_reply, &QNetworkReply::finished, this, &DownloadHandlerImpl::processFinishedDownload);
 }
 
@@ -121,24 +110,52 @@ void DownloadHandlerImpl::processFinishedDownload()
         handleRedirection(redirection.toUrl());
         return;
     }
+
+    // Check if the cached data is still up to date
+    if (m_downloadRequest.useCache()
+        && (m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304))
+    {
+        loadFromCache();
+        finish();
+        return;
+    }
     if (m_reply->error())
     {
         setError(tr("m_reply Error"));
     }
-    else 
-	{
+    else if (m_downloadRequest.saveToFile())
+    {
+        // Success, save the rest of the data
+        if (!readReplyData())
+            return;
+
+        if (m_decompressor && !m_decompressor->isFinished())
+        {
+            setError(tr("Downloaded data is not a valid gzip stream"));
+        }
+        else if (!m_file->flush())
+        {
+            setError(tr("I/O Error"));
+        }
+        else
+        {
+            if (m_downloadRequest.useCache())
+                m_manager->cache()->store(m_reply->request().url().toString(), m_reply, *m_file);
+
+            m_file->setAutoRemove(false);
+            m_result.filePath = m_file->fileName();
+            m_file->close();
+        }
+    }
+    else
+    {
         // Success
         m_result.data = (m_reply->rawHeader("Content-Encoding") == "gzip")
             ? Utils::Gzip::decompress(m_reply->readAll())
             : m_reply->readAll();
 
-        if (m_downloadRequest.saveToFile()) {
-            QString filePath;
-            if (saveToFile(m_result.data, filePath))
-                m_result.filePath = filePath;
-            else
-                setError(tr("I/O Error"));
-        }
+        if (m_downloadRequest.useCache())
+            m_manager->cache()->store(m_reply->request().url().toString(), m_reply, m_result.data);
     }
 
     finish();
@@ -155,14 +172,114 @@ void DownloadHandlerImpl::checkDownloadSize(const qint64 bytesReceived, const qi
 
     if ((bytesTotal > m_downloadRequest.limit()) || (bytesReceived > m_downloadRequest.limit()))
     {
-        m_reply->abort();
-        setError(tr("The file size (%1) exceeds the download limit (%2)")
+        abortDownload(tr("The file size (%1) exceeds the download limit (%2)")
                  .arg(Utils::Misc::friendlyUnit(bytesTotal)
                       , Utils::Misc::friendlyUnit(m_downloadRequest.limit())));
-        finish();
     }
 }
 
+// Saves the data received so far to the temporary file.
+// Returns false if the download was aborted because of an error.
+bool DownloadHandlerImpl::readReplyData()
+{
+    // body of the redirection response isn't needed
+    if (m_reply->attribute(QNetworkRequest::RedirectionTargetAttribute).isValid())
+        return true;
+
+    if (!m_file)
+    {
+        m_file = std::make_unique<QTemporaryFile>(Utils::Fs::tempPath() + "XXXXXX");
+        if (!m_file->open())
+        {
+            abortDownload(tr("I/O Error"));
+            return false;
+        }
+
+        if (m_reply->rawHeader("Content-Encoding") == "gzip")
+            m_decompressor = std::make_unique<Utils::Gzip::Decompressor>();
+    }
+
+    while (m_reply->bytesAvailable() > 0)
+    {
+        if (!writeData(m_reply->read(READ_CHUNK_SIZE)))
+            return false;
+    }
+
+    return true;
+}
+
+bool DownloadHandlerImpl::writeData(const QByteArray &data)
+{
+    bool ok = true;
+    const QByteArray output = m_decompressor ? m_decompressor->decompress(data, &ok) : data;
+    if (!ok)
+    {
+        abortDownload(tr("Downloaded data is not a valid gzip stream"));
+        return false;
+    }
+
+    // the download size is checked again after decompression
+    if ((m_downloadRequest.limit() > 0) && ((m_bytesWritten + output.size()) > m_downloadRequest.limit()))
+    {
+        abortDownload(tr("The file size (%1) exceeds the download limit (%2)")
+                 .arg(Utils::Misc::friendlyUnit(m_bytesWritten + output.size())
+                      , Utils::Misc::friendlyUnit(m_downloadRequest.limit())));
+        return false;
+    }
+
+    if (m_file->write(output) != output.size())
+    {
+        abortDownload(tr("I/O Error"));
+        return false;
+    }
+
+    m_bytesWritten += output.size();
+    return true;
+}
+
+void DownloadHandlerImpl::loadFromCache()
+{
+    // the cache is keyed by the URL the validators were added for
+    const QString cacheKey = m_reply->request().url().toString();
+    Net::HttpCache *cache = m_manager->cache();
+
+    bool loaded = false;
+    if (m_downloadRequest.saveToFile())
+    {
+        if (!m_file)
+            m_file = std::make_unique<QTemporaryFile>(Utils::Fs::tempPath() + "XXXXXX");
+
+        loaded = (m_file->isOpen() || m_file->open())
+            && cache->loadToFile(cacheKey, *m_file) && m_file->flush();
+        if (loaded)
+        {
+            m_file->setAutoRemove(false);
+            m_result.filePath = m_file->fileName();
+            m_file->close();
+        }
+    }
+    else
+    {
+        loaded = cache->load(cacheKey, m_result.data);
+    }
+
+    if (loaded)
+        m_result.isFromCache = true;
+    else
+        setError(tr("The server reported that the data is not modified, but it isn't cached anymore"));
+}
+
+void DownloadHandlerImpl::abortDownload(const QString &error)
+{
+    // the reply must not report its own (cancellation) error
+    disconnect(m_reply, nullptr, this, nullptr);
+    m_reply->abort();
+    m_file.reset();
+
+    setError(error);
+    finish();
+}
+
 void DownloadHandlerImpl::handleRedirection(const QUrl &newUrl)
 {
     if (m_redirectionCount >= MAX_REDIRECTIONS)
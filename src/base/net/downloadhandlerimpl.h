@@ -29,13 +29,24 @@
 
 #pragma once
 
+#include <memory>
+
 #include <QNetworkReply>
 
 #include "base/net/downloadmanager.h"
 
 class QObject;
+class QTemporaryFile;
 class QUrl;
 
+namespace Utils
+{
+    namespace Gzip
+    {
+        class Decompressor;
+    }
+}
+
 class DownloadHandlerImpl final : public Net::DownloadHandler
 {
     Q_OBJECT
@@ -43,6 +54,7 @@ class DownloadHandlerImpl final : public Net::DownloadHandler
 
 public:
     DownloadHandlerImpl(Net::DownloadManager *manager, const Net::DownloadRequest &downloadRequest);
+    ~DownloadHandlerImpl() override;
 
     void cancel() override;
 
@@ -54,6 +66,10 @@ public:
 private:
     void processFinishedDownload();
     void checkDownloadSize(qint64 bytesReceived, qint64 bytesTotal);
+    bool readReplyData();
+    void loadFromCache();
+    bool writeData(const QByteArray &data);
+    void abortDownload(const QString &error);
     void handleRedirection(const QUrl &newUrl);
     void setError(const QString &error);
     void finish();
@@ -65,4 +81,9 @@ private:
     const Net::DownloadRequest m_downloadRequest;
     short m_redirectionCount = 0;
     Net::DownloadResult m_result;
+
+    // used when the data is saved to file
+    std::unique_ptr<QTemporaryFile> m_file;
+    std::unique_ptr<Utils::Gzip::Decompressor> m_decompressor;
+    qint64 m_bytesWritten = 0;
 };
@@ -33,6 +33,7 @@
 
 #include <QDateTime>
 #include <QDebug>
+#include <QDir>
 #include <QNetworkCookie>
 #include <QNetworkCookieJar>
 #include <QNetworkProxy>
@@ -44,6 +45,7 @@
 #include "base/global.h"
 #include "base/logger.h"
 #include "base/preferences.h"
+#include "base/profile.h"
 #include "downloadhandlerimpl.h"
 #include "proxyconfigurationmanager.h"
 
@@ -152,6 +154,7 @@ Net::DownloadManager *Net::DownloadManager::m_instance = nullptr;
 
 Net::DownloadManager::DownloadManager(QObject *parent)
     : QObject(parent)
+    , m_cache {QDir::cleanPath(specialFolderLocation(SpecialFolder::Cache) + "/http")}
 {
     connect(&m_networkManager, &QNetworkAccessManager::sslErrors, this, &Net::DownloadManager::ignoreSslErrors);
     connect(&m_networkManager, &QNetworkAccessManager::finished, this, &DownloadManager::handleReplyFinished);
@@ -181,7 +184,7 @@ Net::DownloadManager *Net::DownloadManager::instance()
 Net::DownloadHandler *Net::DownloadManager::download(const DownloadRequest &downloadRequest)
 {
     // Process download request
-    const QNetworkRequest request = createNetworkRequest(downloadRequest);
+    const QNetworkRequest request = prepareNetworkRequest(downloadRequest);
     const ServiceID id = ServiceID::fromURL(request.url());
     const bool isSequentialService = m_sequentialServices.contains(id);
 
@@ -261,6 +264,24 @@ bool Net::DownloadManager::hasSupportedScheme(const QString &url)
     });
 }
 
+Net::HttpCache *Net::DownloadManager::cache()
+{
+    return &m_cache;
+}
+
+Net::HttpCacheStatistics Net::DownloadManager::cacheStatistics() const
+{
+    return m_cache.statistics();
+}
+
+QNetworkRequest Net::DownloadManager::prepareNetworkRequest(const DownloadRequest &downloadRequest)
+{
+    QNetworkRequest request = createNetworkRequest(downloadRequest);
+    if (downloadRequest.useCache())
+        m_cache.addValidators(request);
+    return request;
+}
+
 void Net::DownloadManager::applyProxySettings()
 {
     const auto *proxyManager = ProxyConfigurationManager::instance();
@@ -319,7 +340,7 @@ void Net::DownloadManager::handleReplyFinished(const QNetworkReply *reply)
         }
         else {
             auto handler = static_cast<DownloadHandlerImpl *>(waitingJobsIter.value().dequeue());
-            handler->assignNetworkReply(m_networkManager.get(createNetworkRequest(handler->downloadRequest())));
+            handler->assignNetworkReply(m_networkManager.get(prepareNetworkRequest(handler->downloadRequest())));
             handler->disconnect(this);
         }
     }
@@ -417,6 +438,17 @@ Net::DownloadRequest &Net::DownloadRequest::saveToFile(const bool value)
     return *this;
 }
 
+bool Net::DownloadRequest::useCache() const
+{
+    return m_useCache;
+}
+
+Net::DownloadRequest &Net::DownloadRequest::useCache(const bool value)
+{
+    m_useCache = value;
+    return *this;
+}
+
 Net::ServiceID Net::ServiceID::fromURL(const QUrl &url)
 {
     return {url.host(), url.port(80)};
@@ -36,6 +36,8 @@
 #include <QSet>
 #include <QMutex>
 
+#include "httpcache.h"
+
 class QNetworkCookie;
 class QNetworkReply;
 class QSslError;
@@ -79,9 +81,16 @@ namespace Net
         qint64 limit() const;
         DownloadRequest &limit(qint64 value);
 
+        // The data is written to a temporary file as it arrives (gzip encoded data
+        // is inflated on the fly), so DownloadResult::data stays empty
         bool saveToFile() const;
         DownloadRequest &saveToFile(bool value);
 
+        // Makes the request conditional if the previous response is cached,
+        // "304 Not Modified" response is answered with the cached data
+        bool useCache() const;
+        DownloadRequest &useCache(bool value);
+
         QString getXSNI() const { return x_sni; };
         void setXSNI(const QString& strVal) { x_sni = strVal; };
 
@@ -105,6 +114,7 @@ namespace Net
         QHash<QString, QString> m_userHeaders;
         qint64 m_limit = 0;
         bool m_saveToFile = false;
+        bool m_useCache = false;
         bool m_useDefaultRef = true;
         bool m_useDefaultGZip = true;
 
@@ -122,6 +132,7 @@ namespace Net
         QByteArray data;
         QString filePath;
         QString magnet;
+        bool isFromCache = false;   // the server reported that the cached data is up to date
     };
 
     class DownloadHandler : public QObject
@@ -163,6 +174,9 @@ namespace Net
 
         static bool hasSupportedScheme(const QString &url);
 
+        HttpCache *cache();
+        HttpCacheStatistics cacheStatistics() const;
+
     private slots:
         void ignoreSslErrors(QNetworkReply *, const QList<QSslError> &);
 
@@ -171,9 +185,11 @@ namespace Net
 
         void applyProxySettings();
         void handleReplyFinished(const QNetworkReply *reply);
+        QNetworkRequest prepareNetworkRequest(const DownloadRequest &downloadRequest);
 
         static DownloadManager *m_instance;
         QNetworkAccessManager m_networkManager;
+        HttpCache m_cache;
 
         QSet<ServiceID> m_sequentialServices;
         QSet<ServiceID> m_busyServices;
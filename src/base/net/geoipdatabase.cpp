@@ -26,9 +26,12 @@
  * exception statement from your version.
  */
 
+#include <algorithm>
+
 #include <QDateTime>
 #include <QDebug>
 #include <QFile>
+#include <QHash>
 #include <QHostAddress>
 #include <QVariant>
 
@@ -72,43 +75,49 @@ struct DataFieldDescriptor
     };
 };
 
-GeoIPDatabase::GeoIPDatabase(const quint32 size)
-    : m_ipVersion(0)
-    , m_recordSize(0)
-    , m_nodeCount(0)
-    , m_nodeSize(0)
-    , m_indexSize(0)
-    , m_recordBytes(0)
-    , m_size(size)
-    , m_data(new uchar[size])
-{
-}
-
 GeoIPDatabase *GeoIPDatabase::load(const QString &filename, QString &error)
 {
-    GeoIPDatabase *db = nullptr;
-    QFile file(filename);
-    if (file.size() > MAX_FILE_SIZE)
+    auto *file = new QFile(filename);
+    if (file->size() > MAX_FILE_SIZE)
     {
         error = tr("Unsupported database file size.");
+        delete file;
         return nullptr;
     }
 
-    if (!file.open(QFile::ReadOnly))
+    if (!file->open(QFile::ReadOnly))
     {
-        error = file.errorString();
+        error = file->errorString();
+        delete file;
         return nullptr;
     }
 
-    db = new GeoIPDatabase(file.size());
+    auto *db = new GeoIPDatabase;
+    db->m_size = file->size();
 
-    if (file.read(reinterpret_cast<char *>(db->m_data), db->m_size) != db->m_size)
+    // The mapping stays valid after the file is closed
+    const uchar *mapped = file->map(0, db->m_size);
+    if (mapped)
     {
-        error = file.errorString();
-        delete db;
-        return nullptr;
+        db->m_file = file;
+        db->m_data = mapped;
+        file->close();
     }
+    else
+    {
+        // fall back to reading the whole file into memory
+        db->m_buffer = file->readAll();
+        if (db->m_buffer.size() != static_cast<int>(db->m_size))
+        {
+            error = file->errorString();
+            delete file;
+            delete db;
+            return nullptr;
+        }
 
+        db->m_data = reinterpret_cast<const uchar *>(db->m_buffer.constData());
+        delete file;
+    }
 
     if (!db->parseMetadata(db->readMetadata(), error) || !db->loadDB(error))
     {
@@ -121,16 +130,17 @@ GeoIPDatabase *GeoIPDatabase::load(const QString &filename, QString &error)
 
 GeoIPDatabase *GeoIPDatabase::load(const QByteArray &data, QString &error)
 {
-    GeoIPDatabase *db = nullptr;
     if (data.size() > MAX_FILE_SIZE)
     {
         error = tr("Unsupported database file size.");
         return nullptr;
     }
 
-    db = new GeoIPDatabase(data.size());
-
-    memcpy(reinterpret_cast<char *>(db->m_data), data.constData(), db->m_size);
+    // QByteArray is implicitly shared so the data isn't copied
+    auto *db = new GeoIPDatabase;
+    db->m_buffer = data;
+    db->m_size = data.size();
+    db->m_data = reinterpret_cast<const uchar *>(db->m_buffer.constData());
 
     if (!db->parseMetadata(db->readMetadata(), error) || !db->loadDB(error))
     {
@@ -143,7 +153,7 @@ GeoIPDatabase *GeoIPDatabase::load(const QByteArray &data, QString &error)
 
 GeoIPDatabase::~GeoIPDatabase()
 {
-    delete [] m_data;
+    delete m_file; // unmaps the file
 }
 
 QString GeoIPDatabase::type() const
@@ -163,50 +173,59 @@ QDateTime GeoIPDatabase::buildEpoch() const
 
 QString GeoIPDatabase::lookup(const QHostAddress &hostAddr) const
 {
-    Q_IPV6ADDR addr = hostAddr.toIPv6Address();
+    const Q_IPV6ADDR addr = hostAddr.toIPv6Address();
 
-    const uchar *ptr = m_data;
+    // IPv4 addresses are converted to IPv4-mapped ones, their common prefix is resolved at load time
+    if (hostAddr.protocol() == QAbstractSocket::IPv4Protocol)
+        return countryByRecord(findRecord(&addr.c[12], 32, m_ipv4Node));
 
-    for (int i = 0; i < 16; ++i)
+    return countryByRecord(findRecord(addr.c, 128, 0));
+}
+
+QVector<QString> GeoIPDatabase::lookup(const QVector<QHostAddress> &hostAddrs) const
+{
+    QVector<QString> countries;
+    countries.reserve(hostAddrs.size());
+    for (const QHostAddress &hostAddr : hostAddrs)
+        countries.append(lookup(hostAddr));
+
+    return countries;
+}
+
+quint32 GeoIPDatabase::readRecord(const quint32 node, const bool right) const
+{
+    // Interpret the left/right record as number
+    const uchar *ptr = m_data + (node * m_nodeSize) + (right ? m_recordBytes : 0);
+    quint32 id = 0;
+    for (int i = 0; i < m_recordBytes; ++i)
+        id = (id << 8) | ptr[i];
+
+    return id;
+}
+
+quint32 GeoIPDatabase::findRecord(const quint8 *addr, const int bitCount, quint32 node) const
+{
+    for (int i = 0; (i < bitCount) && (node < m_nodeCount); ++i)
     {
-        for (int j = 0; j < 8; ++j)
-        {
-            const bool right = static_cast<bool>((addr[i] >> (7 - j)) & 1);
-            // Interpret the left/right record as number
-            if (right)
-                ptr += m_recordBytes;
-
-            quint32 id = 0;
-            auto *idPtr = reinterpret_cast<uchar *>(&id);
-            memcpy(&idPtr[4 - m_recordBytes], ptr, m_recordBytes);
-            fromBigEndian(idPtr, 4);
-
-            if (id == m_nodeCount)
-            {
-                return {};
-            }
-            if (id > m_nodeCount)
-            {
-                QString country = m_countries.value(id);
-                if (country.isEmpty())
-                {
-                    const quint32 offset = id - m_nodeCount - sizeof(DATA_SECTION_SEPARATOR);
-                    quint32 tmp = offset + m_indexSize + sizeof(DATA_SECTION_SEPARATOR);
-                    const QVariant val = readDataField(tmp);
-                    if (val.userType() == QMetaType::QVariantHash)
-                    {
-                        country = val.toHash()["country"].toHash()["iso_code"].toString();
-                        m_countries[id] = country;
-                    }
-                }
-                return country;
-            }
-
-            ptr = m_data + (id * m_nodeSize);
-        }
+        const bool right = static_cast<bool>((addr[i / 8] >> (7 - (i % 8))) & 1);
+        node = readRecord(node, right);
     }
 
-    return {};
+    return node;
+}
+
+QString GeoIPDatabase::countryByRecord(const quint32 id) const
+{
+    // id == m_nodeCount means "no data", id < m_nodeCount can only be
+    // returned if the address is shorter than the tree depth
+    if (id <= m_nodeCount)
+        return {};
+
+    const auto iter = std::lower_bound(m_countryRecords.cbegin(), m_countryRecords.cend(), id);
+    if ((iter == m_countryRecords.cend()) || (iter->id != id))
+        return {};
+
+    return iter->country;
 }
 
 #define CHECK_METADATA_REQ(key, type) \
@@ -282,7 +301,7 @@ bool GeoIPDatabase::parseMetadata(const QVariantHash &metadata, QString &error)
     return true;
 }
 
-bool GeoIPDatabase::loadDB(QString &error) const
+bool GeoIPDatabase::loadDB(QString &error)
 {
     qDebug() << "Parsing IP geolocation database index tree...";
 
@@ -295,9 +314,51 @@ bool GeoIPDatabase::loadDB(QString &error) const
         return false;
     }
 
+    buildCountryIndex();
+
+    const quint8 ipv4MappedPrefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    m_ipv4Node = findRecord(ipv4MappedPrefix, 96, 0);
+
     return true;
 }
 
+void GeoIPDatabase::buildCountryIndex()
+{
+    qDebug() << "Resolving IP geolocation database countries...";
+
+    // Data records are shared by many tree nodes, so each of them is decoded once
+    QHash<quint32, QString> countries;
+    for (quint32 node = 0; node < m_nodeCount; ++node)
+    {
+        for (const bool right : {false, true})
+        {
+            const quint32 id = readRecord(node, right);
+            if ((id <= m_nodeCount) || countries.contains(id))
+                continue;
+
+            QString &country = countries[id];
+            quint32 offset = id - m_nodeCount + m_indexSize;
+            if (offset >= m_size)
+                continue;
+
+            const QVariant val = readDataField(offset);
+            if (val.userType() == QMetaType::QVariantHash)
+                country = val.toHash()["country"].toHash()["iso_code"].toString();
+        }
+    }
+
+    m_countryRecords.clear();
+    m_countryRecords.reserve(countries.size());
+    for (auto i = countries.cbegin(); i != countries.cend(); ++i)
+    {
+        if (!i.value().isEmpty())
+            m_countryRecords.append({i.key(), i.value()});
+    }
+
+    std::sort(m_countryRecords.begin(), m_countryRecords.end()
+        , [](const CountryRecord &left, const CountryRecord &right) { return left.id < right.id; });
+}
+
 QVariantHash GeoIPDatabase::readMetadata() const
 {
     const char *ptr = reinterpret_cast<const char *>(m_data);
@@ -28,16 +28,21 @@
 
 #pragma once
 
+#include <QByteArray>
 #include <QCoreApplication>
+#include <QString>
+#include <QVector>
 #include <QtGlobal>
 
-class QByteArray;
 class QDateTime;
+class QFile;
 class QHostAddress;
-class QString;
 
 struct DataFieldDescriptor;
 
+// The database file is memory mapped (if possible) instead of being copied,
+// and the country codes of all data records are resolved once at load time.
+// Lookups don't modify the database, so they can be done from any thread.
 class GeoIPDatabase
 {
     Q_DECLARE_TR_FUNCTIONS(GeoIPDatabase)
@@ -52,13 +57,30 @@ public:
     quint16 ipVersion() const;
     QDateTime buildEpoch() const;
     QString lookup(const QHostAddress &hostAddr) const;
+    QVector<QString> lookup(const QVector<QHostAddress> &hostAddrs) const;
 
 private:
-    explicit GeoIPDatabase(quint32 size);
+    struct CountryRecord
+    {
+        quint32 id;
+        QString country;
+
+        bool operator<(const quint32 otherId) const
+        {
+            return id < otherId;
+        }
+    };
+
+    GeoIPDatabase() = default;
 
     bool parseMetadata(const QVariantHash &metadata, QString &error);
-    bool loadDB(QString &error) const;
+    bool loadDB(QString &error);
     QVariantHash readMetadata() const;
+    void buildCountryIndex();
+
+    quint32 readRecord(quint32 node, bool right) const;
+    quint32 findRecord(const quint8 *addr, int bitCount, quint32 node) const;
+    QString countryByRecord(quint32 id) const;
 
     QVariant readDataField(quint32 &offset) const;
     bool readDataFieldDescriptor(quint32 &offset, DataFieldDescriptor &out) const;
@@ -86,16 +108,20 @@ private:
     }
 
     // Metadata
-    quint16 m_ipVersion;
-    quint16 m_recordSize;
-    quint32 m_nodeCount;
-    int m_nodeSize;
-    int m_indexSize;
-    int m_recordBytes;
+    quint16 m_ipVersion = 0;
+    quint16 m_recordSize = 0;
+    quint32 m_nodeCount = 0;
+    int m_nodeSize = 0;
+    int m_indexSize = 0;
+    int m_recordBytes = 0;
     QDateTime m_buildEpoch;
     QString m_dbType;
     // Search data
-    mutable QHash<quint32, QString> m_countries;
-    quint32 m_size;
-    uchar *m_data;
+    QVector<CountryRecord> m_countryRecords; // sorted by record id
+    quint32 m_ipv4Node = 0; // record reached by the IPv4-mapped address prefix (::ffff:0:0/96)
+    quint32 m_size = 0;
+    const uchar *m_data = nullptr;
+    // Storage
+    QFile *m_file = nullptr; // is set if database file is memory mapped
+    QByteArray m_buffer;
 };
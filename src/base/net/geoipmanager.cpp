@@ -58,7 +58,11 @@ GeoIPManager::GeoIPManager()
     , m_geoIPDatabase(nullptr)
 {
     configure();
-    connect(Preferences::instance(), &Preferences::changed, this, &GeoIPManager::configure);
+    connect(Preferences::instance(), &Preferences::changed, this, [this](const Preferences::Keys changedKeys)
+    {
+        if (changedKeys.testFlag(Preferences::Key::ResolvePeerCountries))
+            configure();
+    });
 }
 
 GeoIPManager::~GeoIPManager()
@@ -127,7 +131,7 @@ void GeoIPManager::downloadDatabaseFile()
 {
     const QDateTime curDatetime = QDateTime::currentDateTimeUtc();
     const QString curUrl = DATABASE_URL.arg(QLocale::c().toString(curDatetime, "yyyy-MM"));
-    DownloadManager::instance()->download({curUrl}, this, &GeoIPManager::downloadFinished);
+    DownloadManager::instance()->download(DownloadRequest(curUrl).useCache(true), this, &GeoIPManager::downloadFinished);
 }
 
 QString GeoIPManager::lookup(const QHostAddress &hostAddr) const
@@ -138,6 +142,14 @@ QString GeoIPManager::lookup(const QHostAddress &hostAddr) const
     return {};
 }
 
+QVector<QString> GeoIPManager::lookup(const QVector<QHostAddress> &hostAddrs) const
+{
+    if (m_enabled && m_geoIPDatabase)
+        return m_geoIPDatabase->lookup(hostAddrs);
+
+    return QVector<QString>(hostAddrs.size());
+}
+
 QString GeoIPManager::CountryName(const QString &countryISOCode)
 {
     static const QHash<QString, QString> countries =
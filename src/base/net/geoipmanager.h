@@ -30,6 +30,7 @@
 #pragma once
 
 #include <QObject>
+#include <QVector>
 
 class QHostAddress;
 class QString;
@@ -51,6 +52,7 @@ namespace Net
         static GeoIPManager *instance();
 
         QString lookup(const QHostAddress &hostAddr) const;
+        QVector<QString> lookup(const QVector<QHostAddress> &hostAddrs) const;
 
         static QString CountryName(const QString &countryISOCode);
 
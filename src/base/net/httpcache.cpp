@@ -0,0 +1,233 @@
+#include "httpcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+
+
+namespace
+{
+    const quint32 ENTRY_MAGIC = 0x71624843;  // "qbHC"
+    const QDataStream::Version STREAM_VERSION = QDataStream::Qt_5_0;
+    const QString ENTRY_FILE_EXTENSION = QStringLiteral(".entry");
+
+    // bigger responses aren't cached
+    const qint64 MAX_ENTRY_SIZE = 32 * 1024 * 1024;
+    // entries that weren't updated for so long are dropped
+    const int MAX_ENTRY_AGE_DAYS = 90;
+    const qint64 COPY_CHUNK_SIZE = 64 * 1024;
+
+    bool copyData(QIODevice &source, QIODevice &destination)
+    {
+        while (!source.atEnd())
+        {
+            const QByteArray chunk = source.read(COPY_CHUNK_SIZE);
+            if (chunk.isEmpty() || (destination.write(chunk) != chunk.size()))
+                return false;
+        }
+
+        return true;
+    }
+}
+
+using namespace Net;
+
+HttpCache::HttpCache(const QString &cacheDir)
+    : m_cacheDir {cacheDir}
+{
+}
+
+void HttpCache::addValidators(QNetworkRequest &request)
+{
+    loadIndex();
+
+    const auto iter = m_index.constFind(request.url().toString());
+    if (iter == m_index.cend())
+        return;
+
+    if (!iter->eTag.isEmpty())
+        request.setRawHeader("If-None-Match", iter->eTag);
+    if (!iter->lastModified.isEmpty())
+        request.setRawHeader("If-Modified-Since", iter->lastModified);
+}
+
+bool HttpCache::load(const QString &url, QByteArray &data)
+{
+    QFile file;
+    if (!openEntry(url, file))
+        return false;
+
+    data = file.readAll();
+
+    ++m_statistics.hits;
+    m_statistics.savedBytes += data.size();
+    return true;
+}
+
+bool HttpCache::loadToFile(const QString &url, QFile &file)
+{
+    QFile entryFile;
+    if (!openEntry(url, entryFile))
+        return false;
+
+    const qint64 size = entryFile.bytesAvailable();
+    if (!copyData(entryFile, file))
+        return false;
+
+    ++m_statistics.hits;
+    m_statistics.savedBytes += size;
+    return true;
+}
+
+void HttpCache::store(const QString &url, const QNetworkReply *reply, const QByteArray &data)
+{
+    ++m_statistics.misses;
+
+    const Validators validators {reply->rawHeader("ETag"), reply->rawHeader("Last-Modified")};
+    const bool isCacheable = (!validators.eTag.isEmpty() || !validators.lastModified.isEmpty())
+        && !reply->rawHeader("Cache-Control").contains("no-store")
+        && (data.size() <= MAX_ENTRY_SIZE);
+
+    if (!isCacheable || !writeEntry(url, validators, data, nullptr))
+        removeEntry(url);
+}
+
+void HttpCache::store(const QString &url, const QNetworkReply *reply, QFile &dataFile)
+{
+    ++m_statistics.misses;
+
+    const Validators validators {reply->rawHeader("ETag"), reply->rawHeader("Last-Modified")};
+    const bool isCacheable = (!validators.eTag.isEmpty() || !validators.lastModified.isEmpty())
+        && !reply->rawHeader("Cache-Control").contains("no-store")
+        && (dataFile.size() <= MAX_ENTRY_SIZE);
+
+    if (!isCacheable || !writeEntry(url, validators, {}, &dataFile))
+        removeEntry(url);
+}
+
+HttpCacheStatistics HttpCache::statistics() const
+{
+    HttpCacheStatistics statistics = m_statistics;
+    statistics.entries = m_index.size();
+    return statistics;
+}
+
+void HttpCache::loadIndex()
+{
+    if (m_isIndexLoaded)
+        return;
+
+    m_isIndexLoaded = true;
+
+    const QDateTime expirationTime = QDateTime::currentDateTime().addDays(-MAX_ENTRY_AGE_DAYS);
+    const QFileInfoList entries = m_cacheDir.entryInfoList({'*' + ENTRY_FILE_EXTENSION}, QDir::Files);
+    for (const QFileInfo &entryInfo : entries)
+    {
+        QFile file {entryInfo.absoluteFilePath()};
+        if ((entryInfo.lastModified() < expirationTime) || !file.open(QIODevice::ReadOnly))
+        {
+            file.remove();
+            continue;
+        }
+
+        QDataStream stream {&file};
+        stream.setVersion(STREAM_VERSION);
+
+        quint32 magic = 0;
+        QString url;
+        Validators validators;
+        stream >> magic >> url >> validators.eTag >> validators.lastModified;
+        if ((stream.status() != QDataStream::Ok) || (magic != ENTRY_MAGIC) || (entryPath(url) != entryInfo.absoluteFilePath()))
+        {
+            file.remove();
+            continue;
+        }
+
+        m_index.insert(url, validators);
+    }
+}
+
+QString HttpCache::entryPath(const QString &url) const
+{
+    const QByteArray hash = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_cacheDir.absoluteFilePath(QString::fromLatin1(hash) + ENTRY_FILE_EXTENSION);
+}
+
+// Opens the entry file positioned at the beginning of the body
+bool HttpCache::openEntry(const QString &url, QFile &file)
+{
+    loadIndex();
+
+    if (!m_index.contains(url))
+        return false;
+
+    file.setFileName(entryPath(url));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        m_index.remove(url);
+        return false;
+    }
+
+    QDataStream stream {&file};
+    stream.setVersion(STREAM_VERSION);
+
+    quint32 magic = 0;
+    QString entryUrl;
+    Validators validators;
+    stream >> magic >> entryUrl >> validators.eTag >> validators.lastModified;
+    if ((stream.status() != QDataStream::Ok) || (magic != ENTRY_MAGIC) || (entryUrl != url))
+    {
+        file.close();
+        removeEntry(url);
+        return false;
+    }
+
+    return true;
+}
+
+bool HttpCache::writeEntry(const QString &url, const Validators &validators, const QByteArray &data, QFile *dataFile)
+{
+    loadIndex();
+
+    if (!m_cacheDir.exists() && !m_cacheDir.mkpath(QLatin1String(".")))
+        return false;
+
+    QSaveFile file {entryPath(url)};
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream {&file};
+    stream.setVersion(STREAM_VERSION);
+    stream << ENTRY_MAGIC << url << validators.eTag << validators.lastModified;
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    if (dataFile)
+    {
+        if (!dataFile->seek(0) || !copyData(*dataFile, file))
+            return false;
+    }
+    else if (file.write(data) != data.size())
+    {
+        return false;
+    }
+
+    if (!file.commit())
+        return false;
+
+    m_index[url] = validators;
+    return true;
+}
+
+void HttpCache::removeEntry(const QString &url)
+{
+    loadIndex();
+
+    if (m_index.remove(url) > 0)
+        QFile::remove(entryPath(url));
+}
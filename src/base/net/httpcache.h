@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDir>
+#include <QHash>
+#include <QString>
+
+class QFile;
+class QNetworkReply;
+class QNetworkRequest;
+
+namespace Net
+{
+    struct HttpCacheStatistics
+    {
+        qint64 hits = 0;        // "304 Not Modified" responses served from the cache
+        qint64 misses = 0;      // full responses
+        qint64 savedBytes = 0;  // size of the bodies served from the cache
+        int entries = 0;
+    };
+
+    // Keeps the bodies of cacheable responses together with their validators
+    // (ETag, Last-Modified), so repeated requests can be made conditional.
+    // Every entry is stored in its own file named by the hash of the URL.
+    class HttpCache
+    {
+        Q_DISABLE_COPY(HttpCache)
+
+    public:
+        explicit HttpCache(const QString &cacheDir);
+
+        // Adds "If-None-Match"/"If-Modified-Since" headers if the response is cached
+        void addValidators(QNetworkRequest &request);
+
+        // These return the cached body of "304 Not Modified" response
+        bool load(const QString &url, QByteArray &data);
+        bool loadToFile(const QString &url, QFile &file);
+
+        // Caches the body if the response has validators, otherwise removes the old entry
+        void store(const QString &url, const QNetworkReply *reply, const QByteArray &data);
+        void store(const QString &url, const QNetworkReply *reply, QFile &dataFile);
+
+        HttpCacheStatistics statistics() const;
+
+    private:
+        struct Validators
+        {
+            QByteArray eTag;
+            QByteArray lastModified;
+        };
+
+        void loadIndex();
+        QString entryPath(const QString &url) const;
+        bool openEntry(const QString &url, QFile &file);
+        bool writeEntry(const QString &url, const Validators &validators, const QByteArray &data, QFile *dataFile);
+        void removeEntry(const QString &url);
+
+        const QDir m_cacheDir;
+        bool m_isIndexLoaded = false;
+        QHash<QString, Validators> m_index;
+        HttpCacheStatistics m_statistics;
+    };
+}
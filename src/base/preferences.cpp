@@ -30,6 +30,7 @@
 #include "preferences.h"
 
 #include <chrono>
+#include <utility>
 
 #ifdef Q_OS_MACOS
 #include <CoreServices/CoreServices.h>
@@ -58,9 +59,62 @@
 #include "settingsstorage.h"
 #include "utils/fs.h"
 
+namespace
+{
+    struct KeyInfo
+    {
+        Preferences::Key key;
+        const char *name;
+    };
+
+    constexpr KeyInfo KEY_TABLE[] =
+    {
+        {Preferences::Key::Locale, "Preferences/General/Locale"},
+        {Preferences::Key::AlternatingRowColors, "Preferences/General/AlternatingRowColors"},
+        {Preferences::Key::HideZeroValues, "Preferences/General/HideZeroValues"},
+        {Preferences::Key::HideZeroComboValues, "Preferences/General/HideZeroComboValues"},
+        {Preferences::Key::ResolvePeerCountries, "Preferences/Connection/ResolvePeerCountries"},
+        {Preferences::Key::ResolvePeerHostNames, "Preferences/Connection/ResolvePeerHostNames"}
+    };
+
+    constexpr const char *keyName(const Preferences::Key key)
+    {
+        for (const KeyInfo &info : KEY_TABLE)
+        {
+            if (info.key == key)
+                return info.name;
+        }
+        return nullptr;
+    }
+
+    Preferences::Keys diffSnapshots(const Preferences::Snapshot &left, const Preferences::Snapshot &right)
+    {
+        using Key = Preferences::Key;
+
+        Preferences::Keys keys;
+        if (left.locale != right.locale)
+            keys |= Key::Locale;
+        if (left.alternatingRowColors != right.alternatingRowColors)
+            keys |= Key::AlternatingRowColors;
+        if (left.hideZeroValues != right.hideZeroValues)
+            keys |= Key::HideZeroValues;
+        if (left.hideZeroComboValues != right.hideZeroComboValues)
+            keys |= Key::HideZeroComboValues;
+        if (left.resolvePeerCountries != right.resolvePeerCountries)
+            keys |= Key::ResolvePeerCountries;
+        if (left.resolvePeerHostNames != right.resolvePeerHostNames)
+            keys |= Key::ResolvePeerHostNames;
+        return keys;
+    }
+}
+
 Preferences *Preferences::m_instance = nullptr;
 
-Preferences::Preferences() = default;
+Preferences::Preferences()
+{
+    m_snapshots.push_back(std::make_unique<const Snapshot>(loadSnapshot()));
+    m_snapshot.store(m_snapshots.back().get(), std::memory_order_release);
+}
 
 Preferences *Preferences::instance()
 {
@@ -87,18 +141,57 @@ const QVariant Preferences::value(const QString &key, const QVariant &defaultVal
 void Preferences::setValue(const QString &key, const QVariant &value)
 {
     SettingsStorage::instance()->storeValue(key, value);
+    m_changedKeys |= Key::Other;
+}
+
+void Preferences::setValue(const Key key, const QVariant &value)
+{
+    SettingsStorage::instance()->storeValue(QLatin1String(keyName(key)), value);
+    publishSnapshot();
+}
+
+Preferences::Snapshot Preferences::loadSnapshot() const
+{
+    Snapshot snapshot;
+
+    snapshot.locale = value(keyName(Key::Locale)).toString();
+    if (snapshot.locale.isEmpty())
+        snapshot.locale = QLocale::system().name();
+    snapshot.alternatingRowColors = value(keyName(Key::AlternatingRowColors), true).toBool();
+    snapshot.hideZeroValues = value(keyName(Key::HideZeroValues), false).toBool();
+    snapshot.hideZeroComboValues = value(keyName(Key::HideZeroComboValues), 0).toInt();
+    snapshot.resolvePeerCountries = value(keyName(Key::ResolvePeerCountries), true).toBool();
+    snapshot.resolvePeerHostNames = value(keyName(Key::ResolvePeerHostNames), false).toBool();
+
+    return snapshot;
+}
+
+void Preferences::publishSnapshot()
+{
+    auto newSnapshot = std::make_unique<const Snapshot>(loadSnapshot());
+    const Keys changedKeys = diffSnapshots(snapshot(), *newSnapshot);
+    if (!changedKeys)
+        return;
+
+    m_changedKeys |= changedKeys;
+    m_snapshot.store(newSnapshot.get(), std::memory_order_release);
+    m_snapshots.push_back(std::move(newSnapshot));
+}
+
+const Preferences::Snapshot &Preferences::snapshot() const
+{
+    return *m_snapshot.load(std::memory_order_acquire);
 }
 
 // General options
 QString Preferences::getLocale() const
 {
-    const QString localeName = value("Preferences/General/Locale").toString();
-    return (localeName.isEmpty() ? QLocale::system().name() : localeName);
+    return snapshot().locale;
 }
 
 void Preferences::setLocale(const QString &locale)
 {
-    setValue("Preferences/General/Locale", locale);
+    setValue(Key::Locale, locale);
 }
 
 bool Preferences::useCustomUITheme() const
@@ -154,32 +247,32 @@ void Preferences::showSpeedInTitleBar(const bool show)
 
 bool Preferences::useAlternatingRowColors() const
 {
-    return value("Preferences/General/AlternatingRowColors", true).toBool();
+    return snapshot().alternatingRowColors;
 }
 
 void Preferences::setAlternatingRowColors(const bool b)
 {
-    setValue("Preferences/General/AlternatingRowColors", b);
+    setValue(Key::AlternatingRowColors, b);
 }
 
 bool Preferences::getHideZeroValues() const
 {
-    return value("Preferences/General/HideZeroValues", false).toBool();
+    return snapshot().hideZeroValues;
 }
 
 void Preferences::setHideZeroValues(const bool b)
 {
-    setValue("Preferences/General/HideZeroValues", b);
+    setValue(Key::HideZeroValues, b);
 }
 
 int Preferences::getHideZeroComboValues() const
 {
-    return value("Preferences/General/HideZeroComboValues", 0).toInt();
+    return snapshot().hideZeroComboValues;
 }
 
 void Preferences::setHideZeroComboValues(const int n)
 {
-    setValue("Preferences/General/HideZeroComboValues", n);
+    setValue(Key::HideZeroComboValues, n);
 }
 
 // In Mac OS X the dock is sufficient for our needs so we disable the sys tray functionality.
@@ -693,6 +786,16 @@ void Preferences::setWebUIHostHeaderValidationEnabled(const bool enabled)
     setValue("Preferences/WebUI/HostHeaderValidation", enabled);
 }
 
+int Preferences::getWebUiWorkerThreads() const
+{
+    return value("Preferences/WebUI/WorkerThreads", 0).toInt();
+}
+
+void Preferences::setWebUiWorkerThreads(const int count)
+{
+    setValue("Preferences/WebUI/WorkerThreads", count);
+}
+
 bool Preferences::isWebUiHttpsEnabled() const
 {
     return value("Preferences/WebUI/HTTPS/Enabled", false).toBool();
@@ -926,24 +1029,34 @@ void Preferences::recheckTorrentsOnCompletion(const bool recheck)
     setValue("Preferences/Advanced/RecheckOnCompletion", recheck);
 }
 
+bool Preferences::isResumeDataJournalEnabled() const
+{
+    return value("Preferences/Advanced/ResumeDataJournal", false).toBool();
+}
+
+void Preferences::setResumeDataJournalEnabled(const bool enabled)
+{
+    setValue("Preferences/Advanced/ResumeDataJournal", enabled);
+}
+
 bool Preferences::resolvePeerCountries() const
 {
-    return value("Preferences/Connection/ResolvePeerCountries", true).toBool();
+    return snapshot().resolvePeerCountries;
 }
 
 void Preferences::resolvePeerCountries(const bool resolve)
 {
-    setValue("Preferences/Connection/ResolvePeerCountries", resolve);
+    setValue(Key::ResolvePeerCountries, resolve);
 }
 
 bool Preferences::resolvePeerHostNames() const
 {
-    return value("Preferences/Connection/ResolvePeerHostNames", false).toBool();
+    return snapshot().resolvePeerHostNames;
 }
 
 void Preferences::resolvePeerHostNames(const bool resolve)
 {
-    setValue("Preferences/Connection/ResolvePeerHostNames", resolve);
+    setValue(Key::ResolvePeerHostNames, resolve);
 }
 
 #if (defined(Q_OS_UNIX) && !defined(Q_OS_MACOS))
@@ -1566,5 +1679,5 @@ void Preferences::setSpeedWidgetGraphEnable(const int id, const bool enable)
 void Preferences::apply()
 {
     if (SettingsStorage::instance()->save())
-        emit changed();
+        emit changed(std::exchange(m_changedKeys, {}));
 }
@@ -29,7 +29,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include <QtContainerFwd>
+#include <QFlags>
 #include <QVariant>
 
 #include "base/utils/net.h"
@@ -78,21 +83,63 @@ class Preferences : public QObject
     Q_OBJECT
     Q_DISABLE_COPY(Preferences)
 
+public:
+    // Preferences that are read on hot paths (per row, per peer, ...). Their values
+    // are kept in an immutable snapshot that is replaced on every change, so reading
+    // one costs a pointer load and a field access.
+    enum class Key : quint32
+    {
+        Locale = 1 << 0,
+        AlternatingRowColors = 1 << 1,
+        HideZeroValues = 1 << 2,
+        HideZeroComboValues = 1 << 3,
+        ResolvePeerCountries = 1 << 4,
+        ResolvePeerHostNames = 1 << 5,
+
+        // Any preference that isn't kept in the snapshot
+        Other = 1u << 31
+    };
+    Q_DECLARE_FLAGS(Keys, Key)
+
+    struct Snapshot
+    {
+        QString locale;
+        bool alternatingRowColors = true;
+        bool hideZeroValues = false;
+        int hideZeroComboValues = 0;
+        bool resolvePeerCountries = true;
+        bool resolvePeerHostNames = false;
+    };
+
+private:
     Preferences();
 
     const QVariant value(const QString &key, const QVariant &defaultValue = {}) const;
     void setValue(const QString &key, const QVariant &value);
+    void setValue(Key key, const QVariant &value);
+
+    Snapshot loadSnapshot() const;
+    void publishSnapshot();
 
     static Preferences *m_instance;
 
+    std::atomic<const Snapshot *> m_snapshot {nullptr};
+    // Every published snapshot is kept alive since readers don't hold any reference
+    // to it. They are only replaced when the user changes the preferences.
+    std::vector<std::unique_ptr<const Snapshot>> m_snapshots;
+    Keys m_changedKeys;
+
 signals:
-    void changed();
+    // `changedKeys` are the keys changed since the previous signal
+    void changed(Preferences::Keys changedKeys);
 
 public:
     static void initInstance();
     static void freeInstance();
     static Preferences *instance();
 
+    const Snapshot &snapshot() const;
+
     // General options
     QString getLocale() const;
     void setLocale(const QString &locale);
@@ -208,6 +255,8 @@ public:
     void setWebUiSecureCookieEnabled(bool enabled);
     bool isWebUIHostHeaderValidationEnabled() const;
     void setWebUIHostHeaderValidationEnabled(bool enabled);
+    int getWebUiWorkerThreads() const;
+    void setWebUiWorkerThreads(int count);
 
     // HTTPS
     bool isWebUiHttpsEnabled() const;
@@ -264,6 +313,8 @@ public:
     void setDontConfirmAutoExit(bool dontConfirmAutoExit);
     bool recheckTorrentsOnCompletion() const;
     void recheckTorrentsOnCompletion(bool recheck);
+    bool isResumeDataJournalEnabled() const;
+    void setResumeDataJournalEnabled(bool enabled);
     bool resolvePeerCountries() const;
     void resolvePeerCountries(bool resolve);
     bool resolvePeerHostNames() const;
@@ -402,3 +453,5 @@ public slots:
 
     void apply();
 };
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Preferences::Keys)
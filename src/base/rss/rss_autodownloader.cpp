@@ -28,6 +28,8 @@
 
 #include "rss_autodownloader.h"
 
+#include <algorithm>
+
 #include <QDataStream>
 #include <QDebug>
 #include <QJsonDocument>
@@ -51,6 +53,7 @@
 #include "../utils/fs.h"
 #include "rss_article.h"
 #include "rss_autodownloadrule.h"
+#include "rss_autodownloadrulematcher.h"
 #include "rss_feed.h"
 #include "rss_folder.h"
 #include "rss_session.h"
@@ -68,6 +71,9 @@ const QString SettingsKey_ProcessingEnabled(QStringLiteral("RSS/AutoDownloader/E
 const QString SettingsKey_SmartEpisodeFilter(QStringLiteral("RSS/AutoDownloader/SmartEpisodeFilter"));
 const QString SettingsKey_DownloadRepacks(QStringLiteral("RSS/AutoDownloader/DownloadRepacks"));
 
+// keeps the results of the matching coming while lots of articles are processed
+const int MaxMatchingBatchSize = 500;
+
 namespace
 {
     QVector<RSS::AutoDownloadRule> rulesFromJSON(const QByteArray &jsonData)
@@ -125,6 +131,11 @@ AutoDownloader::AutoDownloader()
                .arg(fileName, errorString), Log::CRITICAL);
     });
 
+    m_ruleMatcher = new Private::RuleMatcher;
+    m_ruleMatcher->moveToThread(m_ioThread);
+    connect(m_ioThread, &QThread::finished, m_ruleMatcher, &Private::RuleMatcher::deleteLater);
+    connect(m_ruleMatcher, &Private::RuleMatcher::finished, this, &AutoDownloader::handleMatchingFinished);
+
     m_ioThread->start();
 
     connect(BitTorrent::Session::instance(), &BitTorrent::Session::downloadFromUrlFinished
@@ -182,6 +193,7 @@ void AutoDownloader::insertRule(const AutoDownloadRule &rule)
     {
         // Insert new rule
         setRule_impl(rule);
+        handleRulesChanged();
         m_dirty = true;
         store();
         emit ruleAdded(rule.name());
@@ -191,6 +203,7 @@ void AutoDownloader::insertRule(const AutoDownloadRule &rule)
     {
         // Update existing rule
         setRule_impl(rule);
+        handleRulesChanged();
         m_dirty = true;
         storeDeferred();
         emit ruleChanged(rule.name());
@@ -206,6 +219,7 @@ bool AutoDownloader::renameRule(const QString &ruleName, const QString &newRuleN
     AutoDownloadRule rule = m_rules.take(ruleName);
     rule.setName(newRuleName);
     m_rules.insert(newRuleName, rule);
+    handleRulesChanged();
     m_dirty = true;
     store();
     emit ruleRenamed(newRuleName, ruleName);
@@ -218,6 +232,7 @@ void AutoDownloader::removeRule(const QString &ruleName)
     {
         emit ruleAboutToBeRemoved(ruleName);
         m_rules.remove(ruleName);
+        handleRulesChanged();
         m_dirty = true;
         store();
     }
@@ -334,10 +349,40 @@ void AutoDownloader::setDownloadRepacks(const bool downloadRepacks)
 void AutoDownloader::process()
 {
     if (m_processingQueue.isEmpty()) return; // processing was disabled
+    // The next batch is sent when the matcher is done with the current one
+    if (!m_matchingJobs.isEmpty()) return;
+
+    if (m_isRuleMatcherOutdated)
+    {
+        m_ruleMatcher->setRules(m_rules.values());
+        m_isRuleMatcherOutdated = false;
+    }
+
+    const int batchSize = std::min(m_processingQueue.size(), MaxMatchingBatchSize);
+    m_matchingJobs = m_processingQueue.mid(0, batchSize);
+    m_processingQueue.erase(m_processingQueue.begin(), (m_processingQueue.begin() + batchSize));
+
+    QVector<Private::ArticleToMatch> articles;
+    articles.reserve(batchSize);
+    for (const QSharedPointer<ProcessingJob> &job : asConst(m_matchingJobs))
+        articles.append({job->feedURL, job->articleData.value(Article::KeyTitle).toString()});
+
+    m_ruleMatcher->match(m_matchingRevision, articles);
+}
+
+void AutoDownloader::handleMatchingFinished(const int revision, const QVector<QStringList> &matchedRules)
+{
+    if (revision != m_matchingRevision) return;
+
+    const QList<QSharedPointer<ProcessingJob>> jobs = m_matchingJobs;
+    m_matchingJobs.clear();
+
+    Q_ASSERT(jobs.size() == matchedRules.size());
+    for (int i = 0; i < jobs.size(); ++i)
+        processJob(jobs[i], matchedRules[i]);
 
-    processJob(m_processingQueue.takeFirst());
     if (!m_processingQueue.isEmpty())
-        // Schedule to process the next torrent (if any)
+        // Schedule to process the next batch (if any)
         m_processingTimer->start();
 }
 
@@ -368,6 +413,21 @@ void AutoDownloader::setRule_impl(const AutoDownloadRule &rule)
     m_rules.insert(rule.name(), rule);
 }
 
+void AutoDownloader::handleRulesChanged()
+{
+    // The rules are passed to the matcher along with the next batch
+    m_isRuleMatcherOutdated = true;
+
+    // The jobs being matched have to be matched against the new rules
+    if (!m_matchingJobs.isEmpty())
+    {
+        m_processingQueue = m_matchingJobs + m_processingQueue;
+        m_matchingJobs.clear();
+        ++m_matchingRevision;
+        m_processingTimer->start();
+    }
+}
+
 void AutoDownloader::addJobForArticle(const Article *article)
 {
     const QString torrentURL = article->torrentUrl();
@@ -381,13 +441,16 @@ void AutoDownloader::addJobForArticle(const Article *article)
         m_processingTimer->start();
 }
 
-void AutoDownloader::processJob(const QSharedPointer<ProcessingJob> &job)
+void AutoDownloader::processJob(const QSharedPointer<ProcessingJob> &job, const QStringList &matchedRules)
 {
-    for (AutoDownloadRule &rule : m_rules)
+    // The rules are matched in the order of m_rules, so the first accepting one wins as before
+    for (const QString &ruleName : matchedRules)
     {
-        if (!rule.isEnabled()) continue;
-        if (!rule.feedURLs().contains(job->feedURL)) continue;
-        if (!rule.accepts(job->articleData)) continue;
+        const auto ruleIter = m_rules.find(ruleName);
+        if (ruleIter == m_rules.end()) continue;
+
+        AutoDownloadRule &rule = ruleIter.value();
+        if (!rule.acceptsMatchedArticle(job->articleData)) continue;
 
         m_dirty = true;
         storeDeferred();
@@ -488,6 +551,8 @@ bool AutoDownloader::isProcessingEnabled() const
 void AutoDownloader::resetProcessingQueue()
 {
     m_processingQueue.clear();
+    m_matchingJobs.clear();
+    ++m_matchingRevision;
     if (!m_processingEnabled) return;
 
     for (Article *article : asConst(Session::instance()->rootFolder()->articles()))
@@ -515,7 +580,7 @@ void AutoDownloader::setProcessingEnabled(const bool enabled)
         }
         else
         {
-            m_processingQueue.clear();
+            resetProcessingQueue();
             disconnect(Session::instance()->rootFolder(), &Folder::newArticle, this, &AutoDownloader::handleNewArticle);
         }
 
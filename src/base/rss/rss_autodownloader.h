@@ -37,6 +37,8 @@
 #include <QPointer>
 #include <QRegularExpression>
 #include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
 
 class QThread;
 class QTimer;
@@ -53,6 +55,11 @@ namespace RSS
 
     class AutoDownloadRule;
 
+    namespace Private
+    {
+        class RuleMatcher;
+    }
+
     class ParsingError : public std::runtime_error
     {
     public:
@@ -112,14 +119,16 @@ namespace RSS
         void handleTorrentDownloadFinished(const QString &url);
         void handleTorrentDownloadFailed(const QString &url);
         void handleNewArticle(const Article *article);
+        void handleMatchingFinished(int revision, const QVector<QStringList> &matchedRules);
 
     private:
         void timerEvent(QTimerEvent *event) override;
         void setRule_impl(const AutoDownloadRule &rule);
+        void handleRulesChanged();
         void resetProcessingQueue();
         void startProcessing();
         void addJobForArticle(const Article *article);
-        void processJob(const QSharedPointer<ProcessingJob> &job);
+        void processJob(const QSharedPointer<ProcessingJob> &job, const QStringList &matchedRules);
         void load();
         void loadRules(const QByteArray &data);
         void loadRulesLegacy();
@@ -138,6 +147,11 @@ namespace RSS
         AsyncFileStorage *m_fileStorage;
         QHash<QString, AutoDownloadRule> m_rules;
         QList<QSharedPointer<ProcessingJob>> m_processingQueue;
+        Private::RuleMatcher *m_ruleMatcher;
+        // the jobs sent to the matcher, the results of other revisions are stale
+        QList<QSharedPointer<ProcessingJob>> m_matchingJobs;
+        int m_matchingRevision = 0;
+        bool m_isRuleMatcherOutdated = true;
         QHash<QString, QSharedPointer<ProcessingJob>> m_waitingJobs;
         bool m_dirty = false;
         QBasicTimer m_savingTimer;
@@ -32,11 +32,11 @@
 #include <algorithm>
 
 #include <QDebug>
-#include <QHash>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QRegularExpression>
 #include <QSharedData>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 
@@ -47,6 +47,7 @@
 #include "base/utils/string.h"
 #include "rss_article.h"
 #include "rss_autodownloader.h"
+#include "rss_autodownloadrulematcher.h"
 #include "rss_feed.h"
 
 namespace
@@ -149,7 +150,7 @@ namespace RSS
         QStringList previouslyMatchedEpisodes;
 
         mutable QStringList lastComputedEpisodes;
-        mutable QHash<QString, QRegularExpression> cachedRegexes;
+        mutable QSharedPointer<const Private::RuleExpression> expression;
 
         bool operator==(const AutoDownloadRuleData &other) const
         {
@@ -211,157 +212,14 @@ AutoDownloadRule::AutoDownloadRule(const AutoDownloadRule &other)
 
 AutoDownloadRule::~AutoDownloadRule() {}
 
-QRegularExpression AutoDownloadRule::cachedRegex(const QString &expression, const bool isRegex) const
+bool AutoDownloadRule::matchesExpressions(const QString &articleTitle) const
 {
-    // Use a cache of regexes so we don't have to continually recompile - big performance increase.
-    // The cache is cleared whenever the regex/wildcard, must or must not contain fields or
-    // episode filter are modified.
-    Q_ASSERT(!expression.isEmpty());
+    // The expressions are compiled on first use. They are dropped whenever
+    // the regex/wildcard, must or must not contain fields or episode filter are modified.
+    if (!m_dataPtr->expression)
+        m_dataPtr->expression.reset(new Private::RuleExpression {*this});
 
-    QRegularExpression &regex = m_dataPtr->cachedRegexes[expression];
-    if (regex.pattern().isEmpty())
-    {
-        regex = QRegularExpression
-        {
-                (isRegex ? expression : Utils::String::wildcardToRegex(expression))
-                , QRegularExpression::CaseInsensitiveOption};
-    }
-
-    return regex;
-}
-
-bool AutoDownloadRule::matchesExpression(const QString &articleTitle, const QString &expression) const
-{
-    const QRegularExpression whitespace {"\\s+"};
-
-    if (expression.isEmpty())
-    {
-        // A regex of the form "expr|" will always match, so do the same for wildcards
-        return true;
-    }
-
-    if (m_dataPtr->useRegex)
-    {
-        const QRegularExpression reg(cachedRegex(expression));
-        return reg.match(articleTitle).hasMatch();
-    }
-
-    // Only match if every wildcard token (separated by spaces) is present in the article name.
-    // Order of wildcard tokens is unimportant (if order is important, they should have used *).
-    const QStringList wildcards {expression.split(whitespace, QString::SplitBehavior::SkipEmptyParts)};
-    for (const QString &wildcard : wildcards)
-    {
-        const QRegularExpression reg {cachedRegex(wildcard, false)};
-        if (!reg.match(articleTitle).hasMatch())
-            return false;
-    }
-
-    return true;
-}
-
-bool AutoDownloadRule::matchesMustContainExpression(const QString &articleTitle) const
-{
-    if (m_dataPtr->mustContain.empty())
-        return true;
-
-    // Each expression is either a regex, or a set of wildcards separated by whitespace.
-    // Accept if any complete expression matches.
-    return std::any_of(m_dataPtr->mustContain.cbegin(), m_dataPtr->mustContain.cend(), [this, &articleTitle](const QString &expression)
-    {
-        // A regex of the form "expr|" will always match, so do the same for wildcards
-        return matchesExpression(articleTitle, expression);
-    });
-}
-
-bool AutoDownloadRule::matchesMustNotContainExpression(const QString &articleTitle) const
-{
-    if (m_dataPtr->mustNotContain.empty())
-        return true;
-
-    // Each expression is either a regex, or a set of wildcards separated by whitespace.
-    // Reject if any complete expression matches.
-    return std::none_of(m_dataPtr->mustNotContain.cbegin(), m_dataPtr->mustNotContain.cend(), [this, &articleTitle](const QString &expression)
-    {
-        // A regex of the form "expr|" will always match, so do the same for wildcards
-        return matchesExpression(articleTitle, expression);
-    });
-}
-
-bool AutoDownloadRule::matchesEpisodeFilterExpression(const QString &articleTitle) const
-{
-    // Reset the lastComputedEpisode, we don't want to leak it between matches
-    m_dataPtr->lastComputedEpisodes.clear();
-
-    if (m_dataPtr->episodeFilter.isEmpty())
-        return true;
-
-    const QRegularExpression filterRegex {cachedRegex("(^\\d{1,4})x(.*;$)")};
-    const QRegularExpressionMatch matcher {filterRegex.match(m_dataPtr->episodeFilter)};
-    if (!matcher.hasMatch())
-        return false;
-
-    const QString season {matcher.captured(1)};
-    const QStringList episodes {matcher.captured(2).split(';')};
-    const int seasonOurs {season.toInt()};
-
-    for (QString episode : episodes)
-    {
-        if (episode.isEmpty())
-            continue;
-
-        // We need to trim leading zeroes, but if it's all zeros then we want episode zero.
-        while ((episode.size() > 1) && episode.startsWith('0'))
-            episode = episode.right(episode.size() - 1);
-
-        if (episode.indexOf('-') != -1)
-        { // Range detected
-            const QString partialPattern1 {"\\bs0?(\\d{1,4})[ -_\\.]?e(0?\\d{1,4})(?:\\D|\\b)"};
-            const QString partialPattern2 {"\\b(\\d{1,4})x(0?\\d{1,4})(?:\\D|\\b)"};
-
-            // Extract partial match from article and compare as digits
-            QRegularExpressionMatch matcher = cachedRegex(partialPattern1).match(articleTitle);
-            bool matched = matcher.hasMatch();
-
-            if (!matched)
-            {
-                matcher = cachedRegex(partialPattern2).match(articleTitle);
-                matched = matcher.hasMatch();
-            }
-
-            if (matched)
-            {
-                const int seasonTheirs {matcher.captured(1).toInt()};
-                const int episodeTheirs {matcher.captured(2).toInt()};
-
-                if (episode.endsWith('-'))
-                { // Infinite range
-                    const int episodeOurs {episode.leftRef(episode.size() - 1).toInt()};
-                    if (((seasonTheirs == seasonOurs) && (episodeTheirs >= episodeOurs)) || (seasonTheirs > seasonOurs))
-                        return true;
-                }
-                else
-                { // Normal range
-                    const QStringList range {episode.split('-')};
-                    Q_ASSERT(range.size() == 2);
-                    if (range.first().toInt() > range.last().toInt())
-                        continue; // Ignore this subrule completely
-
-                    const int episodeOursFirst {range.first().toInt()};
-                    const int episodeOursLast {range.last().toInt()};
-                    if ((seasonTheirs == seasonOurs) && ((episodeOursFirst <= episodeTheirs) && (episodeOursLast >= episodeTheirs)))
-                        return true;
-                }
-            }
-        }
-        else
-        { // Single number
-            const QString expStr {QString::fromLatin1("\\b(?:s0?%1[ -_\\.]?e0?%2|%1x0?%2)(?:\\D|\\b)").arg(season, episode)};
-            if (cachedRegex(expStr).match(articleTitle).hasMatch())
-                return true;
-        }
-    }
-
-    return false;
+    return m_dataPtr->expression->matches(articleTitle);
 }
 
 bool AutoDownloadRule::matchesSmartEpisodeFilter(const QString &articleTitle) const
@@ -409,8 +267,11 @@ bool AutoDownloadRule::matchesSmartEpisodeFilter(const QString &articleTitle) co
     return true;
 }
 
-bool AutoDownloadRule::matches(const QVariantHash &articleData) const
+bool AutoDownloadRule::matchesHistory(const QVariantHash &articleData) const
 {
+    // Reset the lastComputedEpisode, we don't want to leak it between matches
+    m_dataPtr->lastComputedEpisodes.clear();
+
     const QDateTime articleDate {articleData[Article::KeyDate].toDateTime()};
     if (ignoreDays() > 0)
     {
@@ -418,17 +279,13 @@ bool AutoDownloadRule::matches(const QVariantHash &articleData) const
             return false;
     }
 
-    const QString articleTitle {articleData[Article::KeyTitle].toString()};
-    if (!matchesMustContainExpression(articleTitle))
-        return false;
-    if (!matchesMustNotContainExpression(articleTitle))
-        return false;
-    if (!matchesEpisodeFilterExpression(articleTitle))
-        return false;
-    if (!matchesSmartEpisodeFilter(articleTitle))
-        return false;
+    return matchesSmartEpisodeFilter(articleData[Article::KeyTitle].toString());
+}
 
-    return true;
+bool AutoDownloadRule::matches(const QVariantHash &articleData) const
+{
+    return matchesExpressions(articleData[Article::KeyTitle].toString())
+            && matchesHistory(articleData);
 }
 
 bool AutoDownloadRule::accepts(const QVariantHash &articleData)
@@ -436,6 +293,21 @@ bool AutoDownloadRule::accepts(const QVariantHash &articleData)
     if (!matches(articleData))
         return false;
 
+    recordMatch(articleData);
+    return true;
+}
+
+bool AutoDownloadRule::acceptsMatchedArticle(const QVariantHash &articleData)
+{
+    if (!matchesHistory(articleData))
+        return false;
+
+    recordMatch(articleData);
+    return true;
+}
+
+void AutoDownloadRule::recordMatch(const QVariantHash &articleData)
+{
     setLastMatch(articleData[Article::KeyDate].toDateTime());
 
     // If there's a matched episode string, add that to the previously matched list
@@ -444,8 +316,6 @@ bool AutoDownloadRule::accepts(const QVariantHash &articleData)
         m_dataPtr->previouslyMatchedEpisodes.append(m_dataPtr->lastComputedEpisodes);
         m_dataPtr->lastComputedEpisodes.clear();
     }
-
-    return true;
 }
 
 AutoDownloadRule &AutoDownloadRule::operator=(const AutoDownloadRule &other)
@@ -583,7 +453,7 @@ AutoDownloadRule AutoDownloadRule::fromLegacyDict(const QVariantHash &dict)
 
 void AutoDownloadRule::setMustContain(const QString &tokens)
 {
-    m_dataPtr->cachedRegexes.clear();
+    m_dataPtr->expression.reset();
 
     if (m_dataPtr->useRegex)
         m_dataPtr->mustContain = QStringList() << tokens;
@@ -597,7 +467,7 @@ void AutoDownloadRule::setMustContain(const QString &tokens)
 
 void AutoDownloadRule::setMustNotContain(const QString &tokens)
 {
-    m_dataPtr->cachedRegexes.clear();
+    m_dataPtr->expression.reset();
 
     if (m_dataPtr->useRegex)
         m_dataPtr->mustNotContain = QStringList() << tokens;
@@ -727,7 +597,7 @@ bool AutoDownloadRule::useRegex() const
 void AutoDownloadRule::setUseRegex(const bool enabled)
 {
     m_dataPtr->useRegex = enabled;
-    m_dataPtr->cachedRegexes.clear();
+    m_dataPtr->expression.reset();
 }
 
 QStringList AutoDownloadRule::previouslyMatchedEpisodes() const
@@ -748,5 +618,5 @@ QString AutoDownloadRule::episodeFilter() const
 void AutoDownloadRule::setEpisodeFilter(const QString &e)
 {
     m_dataPtr->episodeFilter = e;
-    m_dataPtr->cachedRegexes.clear();
+    m_dataPtr->expression.reset();
 }
@@ -38,7 +38,6 @@
 
 class QDateTime;
 class QJsonObject;
-class QRegularExpression;
 
 class TriStateBool;
 
@@ -90,6 +89,9 @@ namespace RSS
 
         bool matches(const QVariantHash &articleData) const;
         bool accepts(const QVariantHash &articleData);
+        // The same as accepts() for the article whose title is already known to match
+        // the expressions of the rule (see Private::RuleMatcher)
+        bool acceptsMatchedArticle(const QVariantHash &articleData);
 
         AutoDownloadRule &operator=(const AutoDownloadRule &other);
         bool operator==(const AutoDownloadRule &other) const;
@@ -102,12 +104,10 @@ namespace RSS
         static AutoDownloadRule fromLegacyDict(const QVariantHash &dict);
 
     private:
-        bool matchesMustContainExpression(const QString &articleTitle) const;
-        bool matchesMustNotContainExpression(const QString &articleTitle) const;
-        bool matchesEpisodeFilterExpression(const QString &articleTitle) const;
+        bool matchesExpressions(const QString &articleTitle) const;
+        bool matchesHistory(const QVariantHash &articleData) const;
         bool matchesSmartEpisodeFilter(const QString &articleTitle) const;
-        bool matchesExpression(const QString &articleTitle, const QString &expression) const;
-        QRegularExpression cachedRegex(const QString &expression, bool isRegex = true) const;
+        void recordMatch(const QVariantHash &articleData);
 
         QSharedDataPointer<AutoDownloadRuleData> m_dataPtr;
     };
@@ -0,0 +1,250 @@
+#include "rss_autodownloadrulematcher.h"
+
+#include <algorithm>
+
+#include <QMetaObject>
+
+#include "../global.h"
+#include "../utils/string.h"
+
+namespace
+{
+    // Turns '|' separated sets of wildcards into a regex that matches if all the wildcards
+    // (separated by spaces, in any order) of at least one set are present in the title.
+    // An empty set always matches, the same as a regex of the form "expr|".
+    QString wildcardSetsToRegex(const QString &expression)
+    {
+        const QRegularExpression whitespace {"\\s+"};
+
+        QStringList alternatives;
+        for (const QString &wildcards : asConst(expression.split('|')))
+        {
+            QString alternative;
+            for (const QString &wildcard : asConst(wildcards.split(whitespace, QString::SplitBehavior::SkipEmptyParts)))
+                alternative += (QLatin1String("(?=[\\s\\S]*?(?:") + Utils::String::wildcardToRegex(wildcard) + QLatin1String("))"));
+            alternatives << alternative;
+        }
+
+        return (QLatin1String("^(?:") + alternatives.join('|') + QLatin1Char(')'));
+    }
+
+    void parseArticleEpisode(const QString &articleTitle, RSS::Private::ArticleEpisode &articleEpisode)
+    {
+        const QRegularExpression partialPattern1 {"\\bs0?(\\d{1,4})[ -_\\.]?e(0?\\d{1,4})(?:\\D|\\b)"
+                    , QRegularExpression::CaseInsensitiveOption};
+        const QRegularExpression partialPattern2 {"\\b(\\d{1,4})x(0?\\d{1,4})(?:\\D|\\b)"
+                    , QRegularExpression::CaseInsensitiveOption};
+
+        articleEpisode.isParsed = true;
+
+        QRegularExpressionMatch match = partialPattern1.match(articleTitle);
+        if (!match.hasMatch())
+            match = partialPattern2.match(articleTitle);
+        if (!match.hasMatch())
+            return;
+
+        articleEpisode.isFound = true;
+        articleEpisode.season = match.captured(1).toInt();
+        articleEpisode.episode = match.captured(2).toInt();
+    }
+}
+
+using namespace RSS;
+using namespace RSS::Private;
+
+const int ArticleListTypeId = qRegisterMetaType<QVector<ArticleToMatch>>();
+const int RuleListTypeId = qRegisterMetaType<QList<AutoDownloadRule>>();
+const int MatchedRulesTypeId = qRegisterMetaType<QVector<QStringList>>();
+
+RuleExpression::RuleExpression(const AutoDownloadRule &rule)
+{
+    const QString mustContain = rule.mustContain();
+    const QString mustNotContain = rule.mustNotContain();
+
+    m_hasMustContain = !mustContain.isEmpty();
+    if (m_hasMustContain)
+    {
+        m_mustContain = QRegularExpression {(rule.useRegex() ? mustContain : wildcardSetsToRegex(mustContain))
+                , QRegularExpression::CaseInsensitiveOption};
+        m_mustContain.optimize();
+    }
+
+    m_hasMustNotContain = !mustNotContain.isEmpty();
+    if (m_hasMustNotContain)
+    {
+        m_mustNotContain = QRegularExpression {(rule.useRegex() ? mustNotContain : wildcardSetsToRegex(mustNotContain))
+                , QRegularExpression::CaseInsensitiveOption};
+        m_mustNotContain.optimize();
+    }
+
+    compileEpisodeFilter(rule.episodeFilter());
+}
+
+void RuleExpression::compileEpisodeFilter(const QString &episodeFilter)
+{
+    m_hasEpisodeFilter = !episodeFilter.isEmpty();
+    if (!m_hasEpisodeFilter)
+        return;
+
+    const QRegularExpression filterRegex {"(^\\d{1,4})x(.*;$)"};
+    const QRegularExpressionMatch filterMatch {filterRegex.match(episodeFilter)};
+    if (!filterMatch.hasMatch())
+        return;
+
+    m_isEpisodeFilterValid = true;
+
+    const QString season {filterMatch.captured(1)};
+    m_season = season.toInt();
+
+    QStringList singleEpisodes;
+    for (QString episode : asConst(filterMatch.captured(2).split(';')))
+    {
+        if (episode.isEmpty())
+            continue;
+
+        // We need to trim leading zeroes, but if it's all zeros then we want episode zero.
+        while ((episode.size() > 1) && episode.startsWith('0'))
+            episode = episode.right(episode.size() - 1);
+
+        if (episode.indexOf('-') == -1)
+        {
+            singleEpisodes << episode;
+        }
+        else if (episode.endsWith('-'))
+        {
+            m_episodeRanges.append({episode.leftRef(episode.size() - 1).toInt(), -1});
+        }
+        else
+        {
+            const QStringList range {episode.split('-')};
+            const int first = range.first().toInt();
+            const int last = range.last().toInt();
+            if (first <= last)
+                m_episodeRanges.append({first, last});
+        }
+    }
+
+    if (!singleEpisodes.isEmpty())
+    {
+        m_episodes = QRegularExpression {
+                QString::fromLatin1("\\b(?:s0?%1[ -_\\.]?e0?(?:%2)|%1x0?(?:%2))(?:\\D|\\b)").arg(season, singleEpisodes.join('|'))
+                , QRegularExpression::CaseInsensitiveOption};
+        m_episodes.optimize();
+    }
+}
+
+bool RuleExpression::matches(const QString &articleTitle) const
+{
+    ArticleEpisode articleEpisode;
+    return matches(articleTitle, articleEpisode);
+}
+
+bool RuleExpression::matches(const QString &articleTitle, ArticleEpisode &articleEpisode) const
+{
+    if (m_hasMustContain && !m_mustContain.match(articleTitle).hasMatch())
+        return false;
+    if (m_hasMustNotContain && m_mustNotContain.match(articleTitle).hasMatch())
+        return false;
+
+    return matchesEpisodeFilter(articleTitle, articleEpisode);
+}
+
+bool RuleExpression::matchesEpisodeFilter(const QString &articleTitle, ArticleEpisode &articleEpisode) const
+{
+    if (!m_hasEpisodeFilter)
+        return true;
+    if (!m_isEpisodeFilterValid)
+        return false;
+
+    if (!m_episodes.pattern().isEmpty() && m_episodes.match(articleTitle).hasMatch())
+        return true;
+
+    if (m_episodeRanges.isEmpty())
+        return false;
+
+    if (!articleEpisode.isParsed)
+        parseArticleEpisode(articleTitle, articleEpisode);
+    if (!articleEpisode.isFound)
+        return false;
+
+    return std::any_of(m_episodeRanges.cbegin(), m_episodeRanges.cend(), [this, &articleEpisode](const EpisodeRange &range)
+    {
+        if (range.last < 0)
+        {
+            return (((articleEpisode.season == m_season) && (articleEpisode.episode >= range.first))
+                    || (articleEpisode.season > m_season));
+        }
+
+        return ((articleEpisode.season == m_season)
+                && (articleEpisode.episode >= range.first) && (articleEpisode.episode <= range.last));
+    });
+}
+
+void RuleMatcher::setRules(const QList<AutoDownloadRule> &rules)
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    QMetaObject::invokeMethod(this, [this, rules]() { setRules_impl(rules); }
+                              , Qt::QueuedConnection);
+#else
+    QMetaObject::invokeMethod(this, "setRules_impl", Qt::QueuedConnection
+                              , Q_ARG(QList<RSS::AutoDownloadRule>, rules));
+#endif
+}
+
+void RuleMatcher::match(const int revision, const QVector<ArticleToMatch> &articles)
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    QMetaObject::invokeMethod(this, [this, revision, articles]() { match_impl(revision, articles); }
+                              , Qt::QueuedConnection);
+#else
+    QMetaObject::invokeMethod(this, "match_impl", Qt::QueuedConnection
+                              , Q_ARG(int, revision), Q_ARG(QVector<RSS::Private::ArticleToMatch>, articles));
+#endif
+}
+
+void RuleMatcher::setRules_impl(const QList<AutoDownloadRule> &rules)
+{
+    m_rules.clear();
+    m_rulesByFeed.clear();
+
+    m_rules.reserve(rules.size());
+    for (const AutoDownloadRule &rule : rules)
+    {
+        if (!rule.isEnabled())
+            continue;
+
+        const int index = static_cast<int>(m_rules.size());
+        m_rules.push_back({rule.name(), RuleExpression {rule}});
+
+        for (const QString &feedURL : asConst(rule.feedURLs()))
+        {
+            QVector<int> &feedRules = m_rulesByFeed[feedURL];
+            if (feedRules.isEmpty() || (feedRules.last() != index))
+                feedRules.append(index);
+        }
+    }
+}
+
+void RuleMatcher::match_impl(const int revision, const QVector<ArticleToMatch> &articles)
+{
+    QVector<QStringList> matchedRules;
+    matchedRules.reserve(articles.size());
+
+    for (const ArticleToMatch &article : articles)
+    {
+        const QVector<int> feedRules = m_rulesByFeed.value(article.feedURL);
+
+        QStringList ruleNames;
+        ArticleEpisode articleEpisode;
+        for (const int index : feedRules)
+        {
+            const CompiledRule &rule = m_rules[index];
+            if (rule.expression.matches(article.title, articleEpisode))
+                ruleNames.append(rule.name);
+        }
+
+        matchedRules.append(ruleNames);
+    }
+
+    emit finished(revision, matchedRules);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "rss_autodownloadrule.h"
+
+namespace RSS
+{
+    namespace Private
+    {
+        // Season and episode numbers found in the article title. They don't depend
+        // on the rule, so they are extracted once for all the rules being matched.
+        struct ArticleEpisode
+        {
+            bool isParsed = false;
+            bool isFound = false;
+            int season = 0;
+            int episode = 0;
+        };
+
+        // "Must contain", "Must not contain" and episode filter of the rule compiled
+        // into a few regular expressions. Every '|' separated set of wildcards is
+        // turned into lookaheads, so each of the fields is matched by one regex.
+        class RuleExpression
+        {
+        public:
+            explicit RuleExpression(const AutoDownloadRule &rule);
+
+            bool matches(const QString &articleTitle) const;
+            bool matches(const QString &articleTitle, ArticleEpisode &articleEpisode) const;
+
+        private:
+            struct EpisodeRange
+            {
+                int first = 0;
+                int last = 0;   // -1 if the range is open
+            };
+
+            void compileEpisodeFilter(const QString &episodeFilter);
+            bool matchesEpisodeFilter(const QString &articleTitle, ArticleEpisode &articleEpisode) const;
+
+            bool m_hasMustContain = false;
+            bool m_hasMustNotContain = false;
+            QRegularExpression m_mustContain;
+            QRegularExpression m_mustNotContain;
+
+            bool m_hasEpisodeFilter = false;
+            bool m_isEpisodeFilterValid = false;
+            int m_season = 0;
+            QRegularExpression m_episodes;
+            QVector<EpisodeRange> m_episodeRanges;
+        };
+
+        struct ArticleToMatch
+        {
+            QString feedURL;
+            QString title;
+        };
+
+        // Matches articles against the expressions of all the enabled rules at once.
+        // It is intended to live in a worker thread, the rule conditions that depend
+        // on the match history (ignore days, smart episode filter) are left to the caller.
+        class RuleMatcher : public QObject
+        {
+            Q_OBJECT
+            Q_DISABLE_COPY(RuleMatcher)
+
+        public:
+            RuleMatcher() = default;
+
+            // These are queued to the thread of the matcher
+            void setRules(const QList<AutoDownloadRule> &rules);
+            void match(int revision, const QVector<RSS::Private::ArticleToMatch> &articles);
+
+        signals:
+            // Names of the matched rules for every article, in the order of rules passed to setRules()
+            void finished(int revision, const QVector<QStringList> &matchedRules);
+
+        private:
+            struct CompiledRule
+            {
+                QString name;
+                RuleExpression expression;
+            };
+
+            Q_INVOKABLE void setRules_impl(const QList<RSS::AutoDownloadRule> &rules);
+            Q_INVOKABLE void match_impl(int revision, const QVector<RSS::Private::ArticleToMatch> &articles);
+
+            std::vector<CompiledRule> m_rules;
+            QHash<QString, QVector<int>> m_rulesByFeed;
+        };
+    }
+}
+
+Q_DECLARE_METATYPE(RSS::AutoDownloadRule)
+Q_DECLARE_METATYPE(RSS::Private::ArticleToMatch)
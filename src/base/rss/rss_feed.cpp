@@ -133,7 +133,7 @@ void Feed::refresh()
 
     // NOTE: Should we allow manually refreshing for disabled session?
 
-    m_downloadHandler = Net::DownloadManager::instance()->download(m_url);
+    m_downloadHandler = Net::DownloadManager::instance()->download(Net::DownloadRequest(m_url).useCache(true));
     connect(m_downloadHandler, &Net::DownloadHandler::finished, this, &Feed::handleDownloadFinished);
 
     m_isLoading = true;
@@ -200,7 +200,15 @@ void Feed::handleDownloadFinished(const Net::DownloadResult &result)
 {
     m_downloadHandler = nullptr; // will be deleted by DownloadManager later
 
-    if (result.status == Net::DownloadStatus::Success)
+    if ((result.status == Net::DownloadStatus::Success) && result.isFromCache && !m_hasError)
+    {
+        // the articles of unchanged feed are already loaded
+        LogMsg(tr("RSS feed at '%1' is not modified.").arg(result.url));
+
+        m_isLoading = false;
+        emit stateChanged(this);
+    }
+    else if (result.status == Net::DownloadStatus::Success)
     {
         LogMsg(tr("RSS feed at '%1' is successfully downloaded. Starting to parse it.")
                 .arg(result.url));
@@ -423,7 +431,7 @@ void Feed::downloadIcon()
     const QUrl url(m_url);
     const auto iconUrl = QString::fromLatin1("%1://%2/favicon.ico").arg(url.scheme(), url.host());
     Net::DownloadManager::instance()->download(
-            Net::DownloadRequest(iconUrl).saveToFile(true)
+            Net::DownloadRequest(iconUrl).saveToFile(true).useCache(true)
                 , this, &Feed::handleIconDownloadFinished);
 }
 
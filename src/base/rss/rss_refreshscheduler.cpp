@@ -0,0 +1,268 @@
+#include "rss_refreshscheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <QDateTime>
+#include <QPair>
+#include <QVector>
+
+#include "../global.h"
+#include "rss_feed.h"
+
+namespace
+{
+    // quiet feeds are refreshed at most this many times less often
+    const int MAX_IDLE_FACTOR = 8;
+    const qreal IDLE_GROWTH = 1.5;
+    // the interval of failing feed doubles on every failure up to this factor
+    const int MAX_BACKOFF_FACTOR = 16;
+    // the slot of the refresh that takes longer is given to the next feed
+    const qint64 REFRESH_TIMEOUT = 5 * 60 * 1000;
+
+    const qint64 NEVER = std::numeric_limits<qint64>::max();
+
+    qint64 currentTime()
+    {
+        return QDateTime::currentMSecsSinceEpoch();
+    }
+}
+
+using namespace RSS;
+using namespace RSS::Private;
+
+RefreshScheduler::RefreshScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &RefreshScheduler::processDueFeeds);
+}
+
+void RefreshScheduler::setRefreshInterval(const qint64 msecs)
+{
+    if (m_refreshInterval == msecs)
+        return;
+
+    m_refreshInterval = msecs;
+    for (FeedState &state : m_feeds)
+    {
+        state.interval = m_refreshInterval;
+        state.failures = 0;
+    }
+
+    if (m_isActive)
+        start();
+}
+
+void RefreshScheduler::setMaxConcurrentRefreshes(const int count)
+{
+    m_maxConcurrentRefreshes = std::max(1, count);
+    processDueFeeds();
+}
+
+void RefreshScheduler::setMaxRefreshesPerHost(const int count)
+{
+    m_maxRefreshesPerHost = std::max(1, count);
+    processDueFeeds();
+}
+
+void RefreshScheduler::start()
+{
+    m_isActive = true;
+
+    const qint64 now = currentTime();
+    const int count = m_feeds.size();
+    int index = 0;
+    for (FeedState &state : m_feeds)
+    {
+        state.nextRefresh = now + ((m_refreshInterval * index) / count);
+        ++index;
+    }
+
+    processDueFeeds();
+}
+
+void RefreshScheduler::stop()
+{
+    m_isActive = false;
+    m_timer.stop();
+
+    for (FeedState &state : m_feeds)
+        state.nextRefresh = NEVER;
+}
+
+void RefreshScheduler::addFeed(Feed *feed, const bool isRefreshed)
+{
+    FeedState &state = m_feeds[feed];
+    state.service = Net::ServiceID::fromURL(feed->url());
+    state.interval = m_refreshInterval;
+    state.nextRefresh = !m_isActive ? NEVER : (isRefreshed ? (currentTime() + state.interval) : currentTime());
+
+    connect(feed, &Feed::stateChanged, this, &RefreshScheduler::handleFeedStateChanged);
+    connect(feed, &Item::newArticle, this, [this, feed]()
+    {
+        const auto iter = m_feeds.find(feed);
+        if (iter != m_feeds.end())
+            ++iter->newArticles;
+    });
+
+    if (m_isActive)
+        processDueFeeds();
+}
+
+void RefreshScheduler::removeFeed(Feed *feed)
+{
+    const auto iter = m_feeds.find(feed);
+    if (iter == m_feeds.end())
+        return;
+
+    disconnect(feed, nullptr, this, nullptr);
+    releaseSlot(*iter);
+    m_feeds.erase(iter);
+
+    processDueFeeds();
+}
+
+void RefreshScheduler::refreshAll()
+{
+    const qint64 now = currentTime();
+    for (FeedState &state : m_feeds)
+    {
+        if (!state.isLoading)
+            state.nextRefresh = now;
+    }
+
+    processDueFeeds();
+}
+
+void RefreshScheduler::processDueFeeds()
+{
+    const qint64 now = currentTime();
+
+    QVector<QPair<qint64, Feed *>> dueFeeds;
+    qint64 nextWakeUp = NEVER;
+    for (auto iter = m_feeds.begin(); iter != m_feeds.end(); ++iter)
+    {
+        FeedState &state = iter.value();
+        if (state.isLoading)
+        {
+            if (state.startTime > 0)
+            {
+                // it will finish on its own, but shouldn't block the others
+                if ((now - state.startTime) >= REFRESH_TIMEOUT)
+                    releaseSlot(state);
+                else
+                    nextWakeUp = std::min(nextWakeUp, (state.startTime + REFRESH_TIMEOUT));
+            }
+        }
+        else if (state.nextRefresh <= now)
+        {
+            dueFeeds.append({state.nextRefresh, iter.key()});
+        }
+        else
+        {
+            nextWakeUp = std::min(nextWakeUp, state.nextRefresh);
+        }
+    }
+
+    std::sort(dueFeeds.begin(), dueFeeds.end());
+
+    // the feeds that don't get a free slot now are started when some refresh finishes
+    for (const auto &dueFeed : asConst(dueFeeds))
+    {
+        if (m_runningCount >= m_maxConcurrentRefreshes)
+            break;
+
+        const auto iter = m_feeds.find(dueFeed.second);
+        if ((iter == m_feeds.end()) || iter->isLoading)
+            continue;
+        if (m_runningPerHost.value(iter->service) >= m_maxRefreshesPerHost)
+            continue;
+
+        startRefresh(dueFeed.second, *iter);
+        nextWakeUp = std::min(nextWakeUp, (now + REFRESH_TIMEOUT));
+    }
+
+    if (nextWakeUp == NEVER)
+        m_timer.stop();
+    else
+        m_timer.start(static_cast<int>(std::min<qint64>((nextWakeUp - now), std::numeric_limits<int>::max())));
+}
+
+void RefreshScheduler::startRefresh(Feed *feed, FeedState &state)
+{
+    state.isLoading = true;
+    state.newArticles = 0;
+    state.startTime = currentTime();
+
+    ++m_runningCount;
+    ++m_runningPerHost[state.service];
+
+    feed->refresh();
+}
+
+void RefreshScheduler::finishRefresh(Feed *feed, FeedState &state)
+{
+    state.isLoading = false;
+    releaseSlot(state);
+
+    if (feed->hasError())
+    {
+        ++state.failures;
+        const int factor = 1 << std::min(state.failures, 4);
+        state.interval = m_refreshInterval * std::min(factor, MAX_BACKOFF_FACTOR);
+    }
+    else
+    {
+        if (state.failures > 0)
+        {
+            state.failures = 0;
+            state.interval = m_refreshInterval;
+        }
+
+        if (state.newArticles > 0)
+            state.interval = std::max(m_refreshInterval, (state.interval / 2));
+        else
+            state.interval = std::min(static_cast<qint64>(state.interval * IDLE_GROWTH), (m_refreshInterval * MAX_IDLE_FACTOR));
+    }
+
+    state.nextRefresh = m_isActive ? (currentTime() + state.interval) : NEVER;
+}
+
+void RefreshScheduler::handleFeedStateChanged(Feed *feed)
+{
+    const auto iter = m_feeds.find(feed);
+    if (iter == m_feeds.end())
+        return;
+
+    FeedState &state = *iter;
+    if (feed->isLoading())
+    {
+        // refresh requested by the user
+        if (!state.isLoading)
+        {
+            state.isLoading = true;
+            state.newArticles = 0;
+        }
+        return;
+    }
+
+    if (!state.isLoading)
+        return;
+
+    finishRefresh(feed, state);
+    processDueFeeds();
+}
+
+void RefreshScheduler::releaseSlot(FeedState &state)
+{
+    if (state.startTime == 0)
+        return;
+
+    state.startTime = 0;
+    --m_runningCount;
+
+    const auto iter = m_runningPerHost.find(state.service);
+    if ((iter != m_runningPerHost.end()) && (--iter.value() <= 0))
+        m_runningPerHost.erase(iter);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+#include "../net/downloadmanager.h"
+
+namespace RSS
+{
+    class Feed;
+
+    namespace Private
+    {
+        // Spreads feed refreshes evenly across the refresh interval and limits the number
+        // of refreshes running at once, both in total and per host. Every feed gets its own
+        // interval: it grows while the feed doesn't publish new articles and returns to the
+        // configured one when it does. Failing feeds are retried with exponential backoff.
+        class RefreshScheduler final : public QObject
+        {
+            Q_OBJECT
+            Q_DISABLE_COPY(RefreshScheduler)
+
+        public:
+            explicit RefreshScheduler(QObject *parent = nullptr);
+
+            void setRefreshInterval(qint64 msecs);
+            void setMaxConcurrentRefreshes(int count);
+            void setMaxRefreshesPerHost(int count);
+
+            // Schedules all the feeds at even offsets within the refresh interval
+            void start();
+            void stop();
+
+            // `isRefreshed` means the feed has just been refreshed by the caller
+            void addFeed(Feed *feed, bool isRefreshed);
+            void removeFeed(Feed *feed);
+            // Makes all the feeds due, they are still refreshed within the limits
+            void refreshAll();
+
+        private:
+            struct FeedState
+            {
+                Net::ServiceID service;
+                qint64 interval = 0;
+                qint64 nextRefresh = 0;
+                qint64 startTime = 0;   // of the running refresh started by the scheduler
+                int failures = 0;
+                int newArticles = 0;
+                bool isLoading = false;
+            };
+
+            void processDueFeeds();
+            void startRefresh(Feed *feed, FeedState &state);
+            void finishRefresh(Feed *feed, FeedState &state);
+            void handleFeedStateChanged(Feed *feed);
+            void releaseSlot(FeedState &state);
+
+            QTimer m_timer;
+            bool m_isActive = false;
+            qint64 m_refreshInterval = 0;
+            int m_maxConcurrentRefreshes = 0;
+            int m_maxRefreshesPerHost = 0;
+            int m_runningCount = 0;
+            QHash<Feed *, FeedState> m_feeds;
+            QHash<Net::ServiceID, int> m_runningPerHost;
+        };
+    }
+}
@@ -48,6 +48,7 @@
 #include "rss_feed.h"
 #include "rss_folder.h"
 #include "rss_item.h"
+#include "rss_refreshscheduler.h"
 
 const int MsecsPerMin = 60000;
 const QString ConfFolderName(QStringLiteral("rss"));
@@ -57,6 +58,8 @@ const QString FeedsFileName(QStringLiteral("feeds.json"));
 const QString SettingsKey_ProcessingEnabled(QStringLiteral("RSS/Session/EnableProcessing"));
 const QString SettingsKey_RefreshInterval(QStringLiteral("RSS/Session/RefreshInterval"));
 const QString SettingsKey_MaxArticlesPerFeed(QStringLiteral("RSS/Session/MaxArticlesPerFeed"));
+const QString SettingsKey_MaxConcurrentRefreshes(QStringLiteral("RSS/Session/MaxConcurrentRefreshes"));
+const QString SettingsKey_MaxRefreshesPerHost(QStringLiteral("RSS/Session/MaxRefreshesPerHost"));
 
 using namespace RSS;
 
@@ -65,7 +68,10 @@ QPointer<Session> Session::m_instance = nullptr;
 Session::Session()
     : m_processingEnabled(SettingsStorage::instance()->loadValue(SettingsKey_ProcessingEnabled, false).toBool())
     , m_workingThread(new QThread(this))
+    , m_refreshScheduler(new Private::RefreshScheduler(this))
     , m_refreshInterval(SettingsStorage::instance()->loadValue(SettingsKey_RefreshInterval, 30).toInt())
+    , m_maxConcurrentRefreshes(SettingsStorage::instance()->loadValue(SettingsKey_MaxConcurrentRefreshes, 6).toInt())
+    , m_maxRefreshesPerHost(SettingsStorage::instance()->loadValue(SettingsKey_MaxRefreshesPerHost, 2).toInt())
     , m_maxArticlesPerFeed(SettingsStorage::instance()->loadValue(SettingsKey_MaxArticlesPerFeed, 50).toInt())
 {
     Q_ASSERT(!m_instance); // only one instance is allowed
@@ -93,15 +99,15 @@ Session::Session()
 
     m_itemsByPath.insert("", new Folder); // root folder
 
+    m_refreshScheduler->setRefreshInterval(m_refreshInterval * MsecsPerMin);
+    m_refreshScheduler->setMaxConcurrentRefreshes(m_maxConcurrentRefreshes);
+    m_refreshScheduler->setMaxRefreshesPerHost(m_maxRefreshesPerHost);
+
     m_workingThread->start();
     load();
 
-    connect(&m_refreshTimer, &QTimer::timeout, this, &Session::refresh);
     if (m_processingEnabled)
-    {
-        m_refreshTimer.start(m_refreshInterval * MsecsPerMin);
-        refresh();
-    }
+        m_refreshScheduler->start();
 
     // Remove legacy/corrupted settings
     // (at least on Windows, QSettings is case-insensitive and it can get
@@ -167,10 +173,9 @@ bool Session::addFeed(const QString &url, const QString &path, QString *error)
     if (!destFolder)
         return false;
 
+    // the scheduler refreshes new feed right away
     addItem(new Feed(generateUID(), url, path, this), destFolder);
     store();
-    if (m_processingEnabled)
-        feedByURL(url)->refresh();
     return true;
 }
 
@@ -447,6 +452,7 @@ void Session::addItem(Item *item, Folder *destFolder)
         connect(feed, &Feed::stateChanged, this, &Session::feedStateChanged);
         m_feedsByUID[feed->uid()] = feed;
         m_feedsByURL[feed->url()] = feed;
+        m_refreshScheduler->addFeed(feed, false);
     }
 
     connect(item, &Item::pathChanged, this, &Session::itemPathChanged);
@@ -468,14 +474,9 @@ void Session::setProcessingEnabled(bool enabled)
         m_processingEnabled = enabled;
         SettingsStorage::instance()->storeValue(SettingsKey_ProcessingEnabled, m_processingEnabled);
         if (m_processingEnabled)
-        {
-            m_refreshTimer.start(m_refreshInterval * MsecsPerMin);
-            refresh();
-        }
+            m_refreshScheduler->start();
         else
-        {
-            m_refreshTimer.stop();
-        }
+            m_refreshScheduler->stop();
 
         emit processingStateChanged(m_processingEnabled);
     }
@@ -517,7 +518,37 @@ void Session::setRefreshInterval(const int refreshInterval)
     {
         SettingsStorage::instance()->storeValue(SettingsKey_RefreshInterval, refreshInterval);
         m_refreshInterval = refreshInterval;
-        m_refreshTimer.start(m_refreshInterval * MsecsPerMin);
+        m_refreshScheduler->setRefreshInterval(m_refreshInterval * MsecsPerMin);
+    }
+}
+
+int Session::maxConcurrentRefreshes() const
+{
+    return m_maxConcurrentRefreshes;
+}
+
+void Session::setMaxConcurrentRefreshes(const int count)
+{
+    if (m_maxConcurrentRefreshes != count)
+    {
+        SettingsStorage::instance()->storeValue(SettingsKey_MaxConcurrentRefreshes, count);
+        m_maxConcurrentRefreshes = count;
+        m_refreshScheduler->setMaxConcurrentRefreshes(count);
+    }
+}
+
+int Session::maxRefreshesPerHost() const
+{
+    return m_maxRefreshesPerHost;
+}
+
+void Session::setMaxRefreshesPerHost(const int count)
+{
+    if (m_maxRefreshesPerHost != count)
+    {
+        SettingsStorage::instance()->storeValue(SettingsKey_MaxRefreshesPerHost, count);
+        m_maxRefreshesPerHost = count;
+        m_refreshScheduler->setMaxRefreshesPerHost(count);
     }
 }
 
@@ -534,6 +565,7 @@ void Session::handleItemAboutToBeDestroyed(Item *item)
     {
         m_feedsByUID.remove(feed->uid());
         m_feedsByURL.remove(feed->url());
+        m_refreshScheduler->removeFeed(feed);
     }
 }
 
@@ -572,5 +604,5 @@ void Session::setMaxArticlesPerFeed(const int n)
 void Session::refresh()
 {
     // NOTE: Should we allow manually refreshing for disabled session?
-    rootFolder()->refresh();
+    m_refreshScheduler->refreshAll();
 }
@@ -71,7 +71,6 @@
 #include <QHash>
 #include <QObject>
 #include <QPointer>
-#include <QTimer>
 
 class QThread;
 
@@ -84,6 +83,11 @@ namespace RSS
     class Folder;
     class Item;
 
+    namespace Private
+    {
+        class RefreshScheduler;
+    }
+
     class Session : public QObject
     {
         Q_OBJECT
@@ -110,6 +114,11 @@ namespace RSS
         int refreshInterval() const;
         void setRefreshInterval(int refreshInterval);
 
+        int maxConcurrentRefreshes() const;
+        void setMaxConcurrentRefreshes(int count);
+        int maxRefreshesPerHost() const;
+        void setMaxRefreshesPerHost(int count);
+
         bool addFolder(const QString &path, QString *error = nullptr);
         bool addFeed(const QString &url, const QString &path, QString *error = nullptr);
         bool moveItem(const QString &itemPath, const QString &destPath
@@ -157,8 +166,10 @@ namespace RSS
         QThread *m_workingThread;
         AsyncFileStorage *m_confFileStorage;
         AsyncFileStorage *m_dataFileStorage;
-        QTimer m_refreshTimer;
+        Private::RefreshScheduler *m_refreshScheduler;
         int m_refreshInterval;
+        int m_maxConcurrentRefreshes;
+        int m_maxRefreshesPerHost;
         int m_maxArticlesPerFeed;
         QHash<QString, Item *> m_itemsByPath;
         QHash<QUuid, Feed *> m_feedsByUID;
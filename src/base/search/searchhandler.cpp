@@ -29,6 +29,8 @@
 
 #include "searchhandler.h"
 
+#include <cstring>
+
 #include <QProcess>
 #include <QTimer>
 #include <QVector>
@@ -51,6 +53,73 @@ namespace
         PL_DESC_LINK,
         NB_PLUGIN_COLUMNS
     };
+
+    // Trimmed part of the output line, it is converted only when needed
+    struct Field
+    {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+
+        QString toString() const
+        {
+            return QString::fromUtf8(begin, static_cast<int>(end - begin));
+        }
+
+        qlonglong toLongLong(bool *ok = nullptr) const
+        {
+            return QByteArray::fromRawData(begin, static_cast<int>(end - begin)).toLongLong(ok);
+        }
+    };
+
+    bool isSpace(const char c)
+    {
+        return ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\v') || (c == '\f') || (c == '\r'));
+    }
+
+    // Splits the line on '|', returns the number of fields found,
+    // only the first NB_PLUGIN_COLUMNS of them are stored
+    int splitFields(const char *line, const int length, Field fields[])
+    {
+        const char *const lineEnd = line + length;
+        int count = 0;
+        for (const char *begin = line; ; )
+        {
+            const auto *separator = static_cast<const char *>(memchr(begin, '|', (lineEnd - begin)));
+            const char *end = (separator ? separator : lineEnd);
+
+            if (count < NB_PLUGIN_COLUMNS)
+            {
+                Field &field = fields[count];
+                field.begin = begin;
+                field.end = end;
+                while ((field.begin < field.end) && isSpace(*field.begin))
+                    ++field.begin;
+                while ((field.end > field.begin) && isSpace(*(field.end - 1)))
+                    --field.end;
+            }
+            ++count;
+
+            if (!separator)
+                return count;
+            begin = separator + 1;
+        }
+    }
+
+    // Results are the same if they refer to the same torrent
+    QString resultKey(const QString &fileUrl)
+    {
+        if (!fileUrl.startsWith(QLatin1String("magnet:"), Qt::CaseInsensitive))
+            return fileUrl;
+
+        const QString hashPrefix = QLatin1String("urn:btih:");
+        const int prefixPos = fileUrl.indexOf(hashPrefix, 0, Qt::CaseInsensitive);
+        if (prefixPos < 0)
+            return fileUrl;
+
+        const int hashPos = prefixPos + hashPrefix.size();
+        const int hashEnd = fileUrl.indexOf(QLatin1Char('&'), hashPos);
+        return fileUrl.mid(hashPos, ((hashEnd < 0) ? -1 : (hashEnd - hashPos))).toLower();
+    }
 }
 
 SearchHandler::SearchHandler(const QString &pattern, const QString &category, const QStringList &usedPlugins, SearchPluginManager *manager)
@@ -125,30 +194,34 @@ void SearchHandler::processFinished(const int exitcode)
 
 // search QProcess return output as soon as it gets new
 // stuff to read. We split it into lines and parse each
-// line to SearchResult calling parseSearchResult().
+// line to SearchResult without converting the whole output.
 void SearchHandler::readSearchOutput()
 {
-    QByteArray output = m_searchProcess->readAllStandardOutput();
-    output.replace('\r', "");
-
-    QList<QByteArray> lines = output.split('\n');
-    if (!m_searchResultLineTruncated.isEmpty())
-        lines.prepend(m_searchResultLineTruncated + lines.takeFirst());
-    m_searchResultLineTruncated = lines.takeLast().trimmed();
+    const QByteArray output = m_searchProcess->readAllStandardOutput();
 
     QVector<SearchResult> searchResultList;
-    searchResultList.reserve(lines.size());
 
-    for (const QByteArray &line : asConst(lines))
+    int lineStart = 0;
+    for (int lineEnd = output.indexOf('\n'); lineEnd >= 0; lineEnd = output.indexOf('\n', lineStart))
     {
-        SearchResult searchResult;
-        if (parseSearchResult(QString::fromUtf8(line), searchResult))
-            searchResultList << searchResult;
+        if (m_searchResultLineTruncated.isEmpty())
+        {
+            processSearchResultLine((output.constData() + lineStart), (lineEnd - lineStart), searchResultList);
+        }
+        else
+        {
+            m_searchResultLineTruncated.append((output.constData() + lineStart), (lineEnd - lineStart));
+            processSearchResultLine(m_searchResultLineTruncated.constData(), m_searchResultLineTruncated.size(), searchResultList);
+            m_searchResultLineTruncated.clear();
+        }
+
+        lineStart = lineEnd + 1;
     }
+    m_searchResultLineTruncated.append((output.constData() + lineStart), (output.size() - lineStart));
 
     if (!searchResultList.isEmpty())
     {
-        for (const SearchResult &result : searchResultList)
+        for (const SearchResult &result : asConst(searchResultList))
             m_results.append(result);
         emit newSearchResults(searchResultList);
     }
@@ -163,33 +236,38 @@ void SearchHandler::processFailed()
 // Parse one line of search results list
 // Line is in the following form:
 // file url | file name | file size | nb seeds | nb leechers | Search engine url
-bool SearchHandler::parseSearchResult(const QString &line, SearchResult &searchResult)
+void SearchHandler::processSearchResultLine(const char *line, const int length, QVector<SearchResult> &searchResults)
 {
-    const QVector<QStringRef> parts = line.splitRef('|');
-    const int nbFields = parts.size();
+    Field parts[NB_PLUGIN_COLUMNS];
+    const int nbFields = splitFields(line, length, parts);
+
+    if (nbFields < (NB_PLUGIN_COLUMNS - 1)) return; // -1 because desc_link is optional
+
+    SearchResult searchResult;
+    searchResult.fileUrl = parts[PL_DL_LINK].toString(); // download URL
 
-    if (nbFields < (NB_PLUGIN_COLUMNS - 1)) return false; // -1 because desc_link is optional
+    const QString key = resultKey(searchResult.fileUrl);
+    if (m_resultKeys.contains(key)) return;
+    m_resultKeys.insert(key);
 
-    searchResult = SearchResult();
-    searchResult.fileUrl = parts.at(PL_DL_LINK).trimmed().toString(); // download URL
-    searchResult.fileName = parts.at(PL_NAME).trimmed().toString(); // Name
-    searchResult.fileSize = parts.at(PL_SIZE).trimmed().toLongLong(); // Size
+    searchResult.fileName = parts[PL_NAME].toString(); // Name
+    searchResult.fileSize = parts[PL_SIZE].toLongLong(); // Size
 
     bool ok = false;
 
-    searchResult.nbSeeders = parts.at(PL_SEEDS).trimmed().toLongLong(&ok); // Seeders
+    searchResult.nbSeeders = parts[PL_SEEDS].toLongLong(&ok); // Seeders
     if (!ok || (searchResult.nbSeeders < 0))
         searchResult.nbSeeders = -1;
 
-    searchResult.nbLeechers = parts.at(PL_LEECHS).trimmed().toLongLong(&ok); // Leechers
+    searchResult.nbLeechers = parts[PL_LEECHS].toLongLong(&ok); // Leechers
     if (!ok || (searchResult.nbLeechers < 0))
         searchResult.nbLeechers = -1;
 
-    searchResult.siteUrl = parts.at(PL_ENGINE_URL).trimmed().toString(); // Search site URL
+    searchResult.siteUrl = parts[PL_ENGINE_URL].toString(); // Search site URL
     if (nbFields == NB_PLUGIN_COLUMNS)
-        searchResult.descrLink = parts.at(PL_DESC_LINK).trimmed().toString(); // Description Link
+        searchResult.descrLink = parts[PL_DESC_LINK].toString(); // Description Link
 
-    return true;
+    searchResults.append(searchResult);
 }
 
 SearchPluginManager *SearchHandler::manager() const
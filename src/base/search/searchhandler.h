@@ -32,6 +32,7 @@
 #include <QByteArray>
 #include <QList>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QtContainerFwd>
 
@@ -78,7 +79,7 @@ private:
     void readSearchOutput();
     void processFailed();
     void processFinished(int exitcode);
-    bool parseSearchResult(const QString &line, SearchResult &searchResult);
+    void processSearchResultLine(const char *line, int length, QVector<SearchResult> &searchResults);
 
     const QString m_pattern;
     const QString m_category;
@@ -89,4 +90,5 @@ private:
     QByteArray m_searchResultLineTruncated;
     bool m_searchCancelled = false;
     QList<SearchResult> m_results;
+    QSet<QString> m_resultKeys; // the same torrent found again is skipped
 };
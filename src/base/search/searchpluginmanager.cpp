@@ -318,7 +318,7 @@ void SearchPluginManager::checkForUpdates()
 {
     // Download version file from update server
     using namespace Net;
-    DownloadManager::instance()->download({m_updateUrl + "versions.txt"}
+    DownloadManager::instance()->download(DownloadRequest(m_updateUrl + "versions.txt").useCache(true)
                                           , this, &SearchPluginManager::versionInfoDownloadFinished);
 }
 
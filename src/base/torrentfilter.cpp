@@ -75,6 +75,11 @@ TorrentFilter::TorrentFilter(const QString &filter, const InfoHashSet &hashSet)
     setTypeByName(filter);
 }
 
+TorrentFilter::Type TorrentFilter::type() const
+{
+    return m_type;
+}
+
 bool TorrentFilter::setType(Type type)
 {
     if (m_type != type)
@@ -96,6 +96,7 @@ public:
 #endif
     );
 
+    Type type() const;
     bool setType(Type type);
     bool setTypeByName(const QString &filter);
     bool setHashSet(const InfoHashSet &hashSet);
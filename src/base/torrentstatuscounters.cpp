@@ -0,0 +1,118 @@
+#include "torrentstatuscounters.h"
+
+#include <QTimer>
+
+#include "base/bittorrent/torrenthandle.h"
+
+namespace
+{
+    const TorrentFilter STATUS_FILTERS[] =
+    {
+        TorrentFilter {TorrentFilter::Downloading},
+#ifdef __ENABLE_ALL_STATUS__
+        TorrentFilter {TorrentFilter::Seeding},
+#endif
+        TorrentFilter {TorrentFilter::Completed},
+#ifdef __ENABLE_ALL_STATUS__
+        TorrentFilter {TorrentFilter::Resumed},
+        TorrentFilter {TorrentFilter::Paused},
+#endif
+        TorrentFilter {TorrentFilter::Active},
+        TorrentFilter {TorrentFilter::Inactive},
+#ifdef __ENABLE_ALL_STATUS__
+        TorrentFilter {TorrentFilter::Stalled},
+        TorrentFilter {TorrentFilter::StalledUploading},
+        TorrentFilter {TorrentFilter::StalledDownloading},
+        TorrentFilter {TorrentFilter::Errored}
+#endif
+    };
+}
+
+TorrentStatusCounters *TorrentStatusCounters::m_instance = nullptr;
+
+void TorrentStatusCounters::initInstance()
+{
+    if (!m_instance)
+        m_instance = new TorrentStatusCounters;
+}
+
+void TorrentStatusCounters::freeInstance()
+{
+    delete m_instance;
+    m_instance = nullptr;
+}
+
+TorrentStatusCounters *TorrentStatusCounters::instance()
+{
+    return m_instance;
+}
+
+int TorrentStatusCounters::Snapshot::count(const TorrentFilter::Type type) const
+{
+    if (type == TorrentFilter::All)
+        return total;
+
+    const int index = static_cast<int>(type);
+    Q_ASSERT(index < MAX_FILTER_TYPES);
+    return counts[index];
+}
+
+quint32 TorrentStatusCounters::statusMask(const BitTorrent::TorrentHandle *torrent)
+{
+    quint32 mask = 0;
+    for (const TorrentFilter &filter : STATUS_FILTERS)
+    {
+        if (filter.match(torrent))
+            mask |= (1u << static_cast<int>(filter.type()));
+    }
+    return mask;
+}
+
+void TorrentStatusCounters::addTorrent(const quint32 mask)
+{
+    ++m_snapshot.total;
+    applyMask(mask, 1);
+    scheduleNotification();
+}
+
+void TorrentStatusCounters::removeTorrent(const quint32 mask)
+{
+    --m_snapshot.total;
+    applyMask(mask, -1);
+    scheduleNotification();
+}
+
+void TorrentStatusCounters::updateTorrent(const quint32 oldMask, const quint32 newMask)
+{
+    if (oldMask == newMask) return;
+
+    applyMask(oldMask, -1);
+    applyMask(newMask, 1);
+    scheduleNotification();
+}
+
+TorrentStatusCounters::Snapshot TorrentStatusCounters::snapshot() const
+{
+    return m_snapshot;
+}
+
+void TorrentStatusCounters::applyMask(quint32 mask, const int delta)
+{
+    for (int index = 0; mask != 0; ++index, mask >>= 1)
+    {
+        if (mask & 1u)
+            m_snapshot.counts[index] += delta;
+    }
+}
+
+void TorrentStatusCounters::scheduleNotification()
+{
+    if (m_isNotificationScheduled) return;
+
+    m_isNotificationScheduled = true;
+    QTimer::singleShot(0, this, [this]()
+    {
+        m_isNotificationScheduled = false;
+        emit changed();
+    });
+}
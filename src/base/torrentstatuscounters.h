@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QObject>
+
+#include "torrentfilter.h"
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+}
+
+// Keeps the number of tasks matching each status filter. Every task reports
+// the set of filters it matches whenever its state may have changed, so the
+// counters stay exact without rescanning the tasks, and readers get them in O(1).
+class TorrentStatusCounters final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TorrentStatusCounters)
+
+public:
+    static const int MAX_FILTER_TYPES = 16;
+
+    struct Snapshot
+    {
+        int total = 0;
+        int counts[MAX_FILTER_TYPES] = {};
+
+        int count(TorrentFilter::Type type) const;
+    };
+
+    static void initInstance();
+    static void freeInstance();
+    static TorrentStatusCounters *instance();
+
+    // bitmask of the status filters that match the task
+    static quint32 statusMask(const BitTorrent::TorrentHandle *torrent);
+
+    void addTorrent(quint32 mask);
+    void removeTorrent(quint32 mask);
+    void updateTorrent(quint32 oldMask, quint32 newMask);
+
+    Snapshot snapshot() const;
+
+signals:
+    // emitted once per event loop iteration no matter how many tasks have changed
+    void changed();
+
+private:
+    TorrentStatusCounters() = default;
+
+    void applyMask(quint32 mask, int delta);
+    void scheduleNotification();
+
+    static TorrentStatusCounters *m_instance;
+
+    Snapshot m_snapshot;
+    bool m_isNotificationScheduled = false;
+};
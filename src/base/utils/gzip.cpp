@@ -155,3 +155,172 @@ QByteArray Utils::Gzip::decompress(const QByteArray &data, bool *ok)
     if (ok) *ok = true;
     return output;
 }
+
+Utils::Gzip::Compressor::Compressor(const int level)
+    : m_stream(new z_stream)
+    , m_valid(false)
+{
+    m_stream->zalloc = Z_NULL;
+    m_stream->zfree = Z_NULL;
+    m_stream->opaque = Z_NULL;
+    m_stream->next_in = Z_NULL;
+    m_stream->avail_in = 0;
+
+    // windowBits = 15 + 16 to enable gzip, see compress()
+    m_valid = (deflateInit2(m_stream, level, Z_DEFLATED, (15 + 16), 9, Z_DEFAULT_STRATEGY) == Z_OK);
+}
+
+Utils::Gzip::Compressor::~Compressor()
+{
+    if (m_valid)
+        deflateEnd(m_stream);
+    delete m_stream;
+}
+
+bool Utils::Gzip::Compressor::isValid() const
+{
+    return m_valid;
+}
+
+QByteArray Utils::Gzip::Compressor::compress(const QByteArray &data)
+{
+    if (data.isEmpty())
+        return {};
+
+    return deflate(data, Z_NO_FLUSH);
+}
+
+QByteArray Utils::Gzip::Compressor::finish()
+{
+    return deflate({}, Z_FINISH);
+}
+
+QByteArray Utils::Gzip::Compressor::deflate(const QByteArray &data, const int flush)
+{
+    if (!m_valid)
+        return {};
+
+    const int BUFSIZE = 64 * 1024;
+    std::vector<char> tmpBuf(BUFSIZE);
+
+    m_stream->next_in = reinterpret_cast<const Bytef *>(data.constData());
+    m_stream->avail_in = uInt(data.size());
+
+    QByteArray output;
+    while (true)
+    {
+        m_stream->next_out = reinterpret_cast<Bytef *>(tmpBuf.data());
+        m_stream->avail_out = BUFSIZE;
+
+        const int result = ::deflate(m_stream, flush);
+        if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR))
+        {
+            deflateEnd(m_stream);
+            m_valid = false;
+            return {};
+        }
+
+        output.append(tmpBuf.data(), (BUFSIZE - m_stream->avail_out));
+
+        if (result == Z_STREAM_END)
+        {
+            deflateEnd(m_stream);
+            m_valid = false;
+            break;
+        }
+
+        // deflate() left some room in the buffer, so it has nothing more to give for now
+        if ((m_stream->avail_out != 0) && (m_stream->avail_in == 0) && (flush != Z_FINISH))
+            break;
+    }
+
+    return output;
+}
+
+Utils::Gzip::Decompressor::Decompressor()
+    : m_stream(new z_stream)
+    , m_valid(false)
+    , m_finished(false)
+{
+    m_stream->zalloc = Z_NULL;
+    m_stream->zfree = Z_NULL;
+    m_stream->opaque = Z_NULL;
+    m_stream->next_in = Z_NULL;
+    m_stream->avail_in = 0;
+
+    // enable zlib and gzip decoding with automatic header detection, see decompress()
+    m_valid = (inflateInit2(m_stream, (15 + 32)) == Z_OK);
+}
+
+Utils::Gzip::Decompressor::~Decompressor()
+{
+    if (m_valid)
+        inflateEnd(m_stream);
+    delete m_stream;
+}
+
+bool Utils::Gzip::Decompressor::isValid() const
+{
+    return m_valid;
+}
+
+bool Utils::Gzip::Decompressor::isFinished() const
+{
+    return m_finished;
+}
+
+QByteArray Utils::Gzip::Decompressor::decompress(const QByteArray &data, bool *ok)
+{
+    if (ok) *ok = false;
+
+    if (!m_valid)
+    {
+        // trailing bytes after the end of the stream are ignored
+        if (ok) *ok = m_finished;
+        return {};
+    }
+
+    if (data.isEmpty())
+    {
+        if (ok) *ok = true;
+        return {};
+    }
+
+    const int BUFSIZE = 64 * 1024;
+    std::vector<char> tmpBuf(BUFSIZE);
+
+    m_stream->next_in = reinterpret_cast<const Bytef *>(data.constData());
+    m_stream->avail_in = uInt(data.size());
+
+    QByteArray output;
+    while (true)
+    {
+        m_stream->next_out = reinterpret_cast<Bytef *>(tmpBuf.data());
+        m_stream->avail_out = BUFSIZE;
+
+        const int result = inflate(m_stream, Z_NO_FLUSH);
+        if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR))
+        {
+            inflateEnd(m_stream);
+            m_valid = false;
+            return {};
+        }
+
+        output.append(tmpBuf.data(), (BUFSIZE - m_stream->avail_out));
+
+        if (result == Z_STREAM_END)
+        {
+            inflateEnd(m_stream);
+            m_valid = false;
+            m_finished = true;
+            break;
+        }
+
+        // all input consumed and nothing more is pending in the output
+        if ((m_stream->avail_in == 0) && (m_stream->avail_out != 0))
+            break;
+    }
+
+    if (ok) *ok = true;
+    return output;
+}
@@ -29,7 +29,10 @@
 
 #pragma once
 
+#include <QtGlobal>
+
 class QByteArray;
+struct z_stream_s;
 
 namespace Utils
 {
@@ -37,5 +40,49 @@ namespace Utils
     {
         QByteArray compress(const QByteArray &data, int level = 6, bool *ok = nullptr);
         QByteArray decompress(const QByteArray &data, bool *ok = nullptr);
+
+        // Compresses data that arrives in pieces, each call returns
+        // the part of the gzip stream that became available so far
+        class Compressor
+        {
+            Q_DISABLE_COPY(Compressor)
+
+        public:
+            explicit Compressor(int level = 6);
+            ~Compressor();
+
+            bool isValid() const;
+
+            QByteArray compress(const QByteArray &data);
+            QByteArray finish();
+
+        private:
+            QByteArray deflate(const QByteArray &data, int flush);
+
+            z_stream_s *m_stream;
+            bool m_valid;
+        };
+
+        // Decompresses gzip (or zlib) stream that arrives in pieces,
+        // each call returns the data inflated from the given piece
+        class Decompressor
+        {
+            Q_DISABLE_COPY(Decompressor)
+
+        public:
+            Decompressor();
+            ~Decompressor();
+
+            bool isValid() const;
+            // true once the end of the compressed stream was reached
+            bool isFinished() const;
+
+            QByteArray decompress(const QByteArray &data, bool *ok = nullptr);
+
+        private:
+            z_stream_s *m_stream;
+            bool m_valid;
+            bool m_finished;
+        };
     }
 }
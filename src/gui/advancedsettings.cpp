@@ -70,6 +70,7 @@ namespace
         NETWORK_IFACE_ADDRESS,
         // behavior
         SAVE_RESUME_DATA_INTERVAL,
+        RESUME_DATA_JOURNAL,
         CONFIRM_RECHECK_TORRENT,
         RECHECK_COMPLETED,
         // UI related
@@ -238,6 +239,8 @@ void AdvancedSettings::saveAdvancedSettings()
 #endif
     // Disallow connection to peers on privileged ports
     session->setBlockPeersOnPrivilegedPorts(m_checkBoxBlockPeersOnPrivilegedPorts.isChecked());
+    // Resume data journal
+    pref->setResumeDataJournalEnabled(m_checkBoxResumeDataJournal.isChecked());
     // Recheck torrents on completion
     pref->recheckTorrentsOnCompletion(m_checkBoxRecheckCompleted.isChecked());
     // Transfer list refresh interval
@@ -523,6 +526,9 @@ void AdvancedSettings::loadAdvancedSettings()
         , this, &AdvancedSettings::updateSaveResumeDataIntervalSuffix);
     updateSaveResumeDataIntervalSuffix(m_spinBoxSaveResumeDataInterval.value());
     addRow(SAVE_RESUME_DATA_INTERVAL, tr("Save resume data interval", "How often the fastresume file is saved."), &m_spinBoxSaveResumeDataInterval);
+    // Resume data journal
+    m_checkBoxResumeDataJournal.setChecked(pref->isResumeDataJournalEnabled());
+    addRow(RESUME_DATA_JOURNAL, tr("Save resume data into a single journal file (requires restart)"), &m_checkBoxResumeDataJournal);
     // Outgoing port Min
     m_spinBoxOutgoingPortsMin.setMinimum(0);
     m_spinBoxOutgoingPortsMin.setMaximum(65535);
@@ -29,6 +29,7 @@ HEADERS += \
     $$PWD/previewselectdialog.h \
     $$PWD/progressbardelegate.h \
     $$PWD/properties/downloadedpiecesbar.h \
+    $$PWD/properties/peerlistmodel.h \
     $$PWD/properties/peerlistsortmodel.h \
     $$PWD/properties/peerlistwidget.h \
     $$PWD/properties/peersadditiondialog.h \
@@ -51,6 +52,7 @@ HEADERS += \
     $$PWD/search/pluginselectdialog.h \
     $$PWD/search/pluginsourcedialog.h \
     $$PWD/search/searchjobwidget.h \
+    $$PWD/search/searchresultmodel.h \
     $$PWD/search/searchsortmodel.h \
     $$PWD/search/searchwidget.h \
     $$PWD/shutdownconfirmdialog.h \
@@ -110,6 +112,7 @@ SOURCES += \
     $$PWD/previewselectdialog.cpp \
     $$PWD/progressbardelegate.cpp \
     $$PWD/properties/downloadedpiecesbar.cpp \
+    $$PWD/properties/peerlistmodel.cpp \
     $$PWD/properties/peerlistsortmodel.cpp \
     $$PWD/properties/peerlistwidget.cpp \
     $$PWD/properties/peersadditiondialog.cpp \
@@ -132,6 +135,7 @@ SOURCES += \
     $$PWD/search/pluginselectdialog.cpp \
     $$PWD/search/pluginsourcedialog.cpp \
     $$PWD/search/searchjobwidget.cpp \
+    $$PWD/search/searchresultmodel.cpp \
     $$PWD/search/searchsortmodel.cpp \
     $$PWD/search/searchwidget.cpp \
     $$PWD/shutdownconfirmdialog.cpp \
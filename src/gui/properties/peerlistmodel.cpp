@@ -0,0 +1,391 @@
+#include "peerlistmodel.h"
+
+#include <QIcon>
+
+#include "base/bittorrent/torrenthandle.h"
+#include "base/bittorrent/torrentinfo.h"
+#include "base/net/geoipmanager.h"
+#include "base/preferences.h"
+#include "base/utils/misc.h"
+#include "base/utils/string.h"
+#include "gui/uithememanager.h"
+#include "peerlistsortmodel.h"
+#include "peerlistwidget.h"
+
+namespace
+{
+    template <typename T>
+    void updateValue(T &value, const T &newValue, const int column, quint32 &changedColumns)
+    {
+        if (value == newValue)
+            return;
+
+        value = newValue;
+        changedColumns |= (1u << column);
+    }
+
+    bool isNumericColumn(const int column)
+    {
+        switch (column)
+        {
+        case PeerListWidget::PORT:
+        case PeerListWidget::PROGRESS:
+        case PeerListWidget::DOWN_SPEED:
+        case PeerListWidget::UP_SPEED:
+        case PeerListWidget::TOT_DOWN:
+        case PeerListWidget::TOT_UP:
+        case PeerListWidget::RELEVANCE:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+bool operator==(const PeerEndpoint &left, const PeerEndpoint &right)
+{
+    return (left.address == right.address) && (left.connectionType == right.connectionType);
+}
+
+uint qHash(const PeerEndpoint &peerEndpoint, const uint seed)
+{
+    return (qHash(peerEndpoint.address, seed) ^ ::qHash(peerEndpoint.connectionType));
+}
+
+PeerListModel::PeerListModel(QObject *parent)
+    : QAbstractTableModel {parent}
+    , m_hideZeroValues {Preferences::instance()->getHideZeroValues()}
+{
+}
+
+int PeerListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_items.size();
+}
+
+int PeerListModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : PeerListWidget::COL_COUNT;
+}
+
+QVariant PeerListModel::headerData(const int section, const Qt::Orientation orientation, const int role) const
+{
+    if (orientation != Qt::Horizontal)
+        return {};
+
+    if (role == Qt::DisplayRole)
+    {
+        switch (section)
+        {
+        case PeerListWidget::COUNTRY:
+            return tr("Country/Region"); // Country flag column
+        case PeerListWidget::IP:
+            return tr("IP");
+        case PeerListWidget::PORT:
+            return tr("Port");
+        case PeerListWidget::FLAGS:
+            return tr("Flags");
+        case PeerListWidget::CONNECTION:
+            return tr("Connection");
+        case PeerListWidget::CLIENT:
+            return tr("Client", "i.e.: Client application");
+        case PeerListWidget::PROGRESS:
+            return tr("Progress", "i.e: % downloaded");
+        case PeerListWidget::DOWN_SPEED:
+            return tr("Down Speed", "i.e: Download speed");
+        case PeerListWidget::UP_SPEED:
+            return tr("Up Speed", "i.e: Upload speed");
+        case PeerListWidget::TOT_DOWN:
+            return tr("Downloaded", "i.e: total data downloaded");
+        case PeerListWidget::TOT_UP:
+            return tr("Uploaded", "i.e: total data uploaded");
+        case PeerListWidget::RELEVANCE:
+            return tr("Relevance", "i.e: How relevant this peer is to us. How many pieces it has that we don't.");
+        case PeerListWidget::DOWNLOADING_PIECE:
+            return tr("Files", "i.e. files that are being downloaded right now");
+        default:
+            return {};
+        }
+    }
+
+    if ((role == Qt::TextAlignmentRole) && isNumericColumn(section))
+        return QVariant {Qt::AlignRight | Qt::AlignVCenter};
+
+    return {};
+}
+
+QVariant PeerListModel::data(const QModelIndex &index, const int role) const
+{
+    if (!index.isValid() || (index.row() >= m_items.size()))
+        return {};
+
+    const PeerItem &item = m_items[index.row()];
+    const int column = index.column();
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return displayValue(item, column);
+    case PeerListSortModel::UnderlyingDataRole:
+        return underlyingValue(item, column);
+    case Qt::ToolTipRole:
+        return toolTipValue(item, column);
+    case Qt::TextAlignmentRole:
+        if (isNumericColumn(column))
+            return QVariant {Qt::AlignRight | Qt::AlignVCenter};
+        break;
+    case Qt::DecorationRole:
+        if (column == PeerListWidget::COUNTRY)
+            return UIThemeManager::instance()->getFlagIcon(item.country);
+        break;
+    }
+
+    return {};
+}
+
+QVariant PeerListModel::displayValue(const PeerItem &item, const int column) const
+{
+    switch (column)
+    {
+    case PeerListWidget::IP:
+        return item.hostName.isEmpty() ? item.ip : item.hostName;
+    case PeerListWidget::IP_HIDDEN:
+        return item.ip;
+    case PeerListWidget::PORT:
+        return QString::number(item.endpoint.address.port);
+    case PeerListWidget::CONNECTION:
+        return item.endpoint.connectionType;
+    case PeerListWidget::FLAGS:
+        return BitTorrent::PeerInfo::flagsString(item.flags);
+    case PeerListWidget::CLIENT:
+        return item.client;
+    case PeerListWidget::PROGRESS:
+        return (Utils::String::fromDouble(item.progress * 100, 1) + '%');
+    case PeerListWidget::DOWN_SPEED:
+        return (m_hideZeroValues && (item.downSpeed <= 0)) ? QString {} : Utils::Misc::friendlyUnit(item.downSpeed, true);
+    case PeerListWidget::UP_SPEED:
+        return (m_hideZeroValues && (item.upSpeed <= 0)) ? QString {} : Utils::Misc::friendlyUnit(item.upSpeed, true);
+    case PeerListWidget::TOT_DOWN:
+        return (m_hideZeroValues && (item.totalDownload <= 0)) ? QString {} : Utils::Misc::friendlyUnit(item.totalDownload);
+    case PeerListWidget::TOT_UP:
+        return (m_hideZeroValues && (item.totalUpload <= 0)) ? QString {} : Utils::Misc::friendlyUnit(item.totalUpload);
+    case PeerListWidget::RELEVANCE:
+        return (Utils::String::fromDouble(item.relevance * 100, 1) + '%');
+    case PeerListWidget::DOWNLOADING_PIECE:
+        return item.downloadingFiles.join(';');
+    default:
+        return {};
+    }
+}
+
+QVariant PeerListModel::underlyingValue(const PeerItem &item, const int column) const
+{
+    switch (column)
+    {
+    case PeerListWidget::IP:
+    case PeerListWidget::IP_HIDDEN:
+        return item.ip;
+    case PeerListWidget::PORT:
+        return item.endpoint.address.port;
+    case PeerListWidget::PROGRESS:
+        return item.progress;
+    case PeerListWidget::DOWN_SPEED:
+        return item.downSpeed;
+    case PeerListWidget::UP_SPEED:
+        return item.upSpeed;
+    case PeerListWidget::TOT_DOWN:
+        return item.totalDownload;
+    case PeerListWidget::TOT_UP:
+        return item.totalUpload;
+    case PeerListWidget::RELEVANCE:
+        return item.relevance;
+    default:
+        return displayValue(item, column);
+    }
+}
+
+QVariant PeerListModel::toolTipValue(const PeerItem &item, const int column) const
+{
+    switch (column)
+    {
+    case PeerListWidget::COUNTRY:
+        // the country column is sorted by this value
+        if (UIThemeManager::instance()->getFlagIcon(item.country).isNull())
+            return {};
+        return Net::GeoIPManager::CountryName(item.country);
+    case PeerListWidget::IP:
+        return item.ip;
+    case PeerListWidget::FLAGS:
+        return BitTorrent::PeerInfo::flagsDescription(item.flags);
+    case PeerListWidget::DOWNLOADING_PIECE:
+        return item.downloadingFiles.join('\n');
+    default:
+        return {};
+    }
+}
+
+BitTorrent::PeerAddress PeerListModel::peerAddress(const int row) const
+{
+    return m_items.value(row).endpoint.address;
+}
+
+void PeerListModel::setPeers(const BitTorrent::TorrentHandle *torrent, const QVector<BitTorrent::PeerInfo> &peers
+    , const QVector<QString> &countries)
+{
+    const bool hideZeroValues = Preferences::instance()->getHideZeroValues();
+    if (hideZeroValues != m_hideZeroValues)
+    {
+        m_hideZeroValues = hideZeroValues;
+        if (!m_items.isEmpty())
+            emit dataChanged(index(0, 0), index((m_items.size() - 1), (PeerListWidget::COL_COUNT - 1)));
+    }
+
+    const int oldRowCount = m_items.size();
+    QVector<bool> keepRows(oldRowCount, false);
+    QVector<PeerItem> newItems;
+
+    for (int i = 0; i < peers.size(); ++i)
+    {
+        const BitTorrent::PeerInfo &peer = peers[i];
+        if (peer.address().ip.isNull()) continue;
+
+        const PeerEndpoint endpoint {peer.address(), peer.connectionType()};
+        const QString country = countries.value(i);
+        const auto rowIter = m_rowByEndpoint.constFind(endpoint);
+        if (rowIter == m_rowByEndpoint.cend())
+        {
+            PeerItem item;
+            item.endpoint = endpoint;
+            item.ip = endpoint.address.ip.toString();
+            updateItem(item, torrent, peer, country);
+
+            // new items are indexed after the existing ones until they are inserted
+            m_rowByEndpoint.insert(endpoint, (oldRowCount + newItems.size()));
+            newItems.append(item);
+        }
+        else if (*rowIter >= oldRowCount)
+        {
+            // the same peer is listed twice
+            updateItem(newItems[*rowIter - oldRowCount], torrent, peer, country);
+        }
+        else
+        {
+            const int row = *rowIter;
+            keepRows[row] = true;
+
+            const quint32 changedColumns = updateItem(m_items[row], torrent, peer, country);
+            if (changedColumns == 0)
+                continue;
+
+            int firstColumn = 0;
+            while (!(changedColumns & (1u << firstColumn)))
+                ++firstColumn;
+            int lastColumn = PeerListWidget::COL_COUNT - 1;
+            while (!(changedColumns & (1u << lastColumn)))
+                --lastColumn;
+            emit dataChanged(index(row, firstColumn), index(row, lastColumn));
+        }
+    }
+
+    const bool rowsRemoved = removeStaleRows(keepRows);
+
+    if (!newItems.isEmpty())
+    {
+        beginInsertRows({}, m_items.size(), (m_items.size() + newItems.size() - 1));
+        m_items += newItems;
+        endInsertRows();
+    }
+
+    // new items already have the right rows unless some rows were removed before them
+    if (rowsRemoved)
+        rebuildIndex();
+}
+
+quint32 PeerListModel::updateItem(PeerItem &item, const BitTorrent::TorrentHandle *torrent
+    , const BitTorrent::PeerInfo &peer, const QString &country)
+{
+    quint32 changedColumns = 0;
+
+    updateValue(item.country, country, PeerListWidget::COUNTRY, changedColumns);
+    updateValue(item.client, peer.client().toHtmlEscaped(), PeerListWidget::CLIENT, changedColumns);
+    updateValue(item.flags, peer.peerFlags(), PeerListWidget::FLAGS, changedColumns);
+    updateValue(item.progress, peer.progress(), PeerListWidget::PROGRESS, changedColumns);
+    updateValue(item.downSpeed, peer.payloadDownSpeed(), PeerListWidget::DOWN_SPEED, changedColumns);
+    updateValue(item.upSpeed, peer.payloadUpSpeed(), PeerListWidget::UP_SPEED, changedColumns);
+    updateValue(item.totalDownload, peer.totalDownload(), PeerListWidget::TOT_DOWN, changedColumns);
+    updateValue(item.totalUpload, peer.totalUpload(), PeerListWidget::TOT_UP, changedColumns);
+    updateValue(item.relevance, peer.relevance(), PeerListWidget::RELEVANCE, changedColumns);
+
+    // file paths are looked up only when the peer switches to another piece
+    const int pieceIndex = peer.downloadingPieceIndex();
+    if (item.downloadingPieceIndex != pieceIndex)
+    {
+        item.downloadingPieceIndex = pieceIndex;
+        const QStringList downloadingFiles = torrent->info().filesForPiece(pieceIndex);
+        updateValue(item.downloadingFiles, downloadingFiles, PeerListWidget::DOWNLOADING_PIECE, changedColumns);
+    }
+
+    return changedColumns;
+}
+
+void PeerListModel::setHostName(const QHostAddress &ip, const QString &hostName)
+{
+    for (int row = 0; row < m_items.size(); ++row)
+    {
+        PeerItem &item = m_items[row];
+        if ((item.endpoint.address.ip != ip) || (item.hostName == hostName))
+            continue;
+
+        item.hostName = hostName;
+        const QModelIndex cell = index(row, PeerListWidget::IP);
+        emit dataChanged(cell, cell, {Qt::DisplayRole});
+    }
+}
+
+void PeerListModel::clear()
+{
+    if (m_items.isEmpty())
+        return;
+
+    beginResetModel();
+    m_items.clear();
+    m_rowByEndpoint.clear();
+    endResetModel();
+}
+
+bool PeerListModel::removeStaleRows(const QVector<bool> &keepRows)
+{
+    bool removed = false;
+
+    // remove contiguous ranges starting from the end so the rows before them keep their positions
+    int row = keepRows.size() - 1;
+    while (row >= 0)
+    {
+        if (keepRows[row])
+        {
+            --row;
+            continue;
+        }
+
+        const int last = row;
+        while ((row > 0) && !keepRows[row - 1])
+            --row;
+
+        beginRemoveRows({}, row, last);
+        m_items.remove(row, (last - row + 1));
+        endRemoveRows();
+        removed = true;
+
+        --row;
+    }
+
+    return removed;
+}
+
+void PeerListModel::rebuildIndex()
+{
+    m_rowByEndpoint.clear();
+    m_rowByEndpoint.reserve(m_items.size());
+    for (int row = 0; row < m_items.size(); ++row)
+        m_rowByEndpoint.insert(m_items[row].endpoint, row);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+#include "base/bittorrent/peeraddress.h"
+#include "base/bittorrent/peerinfo.h"
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+}
+
+struct PeerEndpoint
+{
+    BitTorrent::PeerAddress address;
+    QString connectionType; // matches return type of `PeerInfo::connectionType()`
+};
+
+bool operator==(const PeerEndpoint &left, const PeerEndpoint &right);
+uint qHash(const PeerEndpoint &peerEndpoint, uint seed);
+
+// Keeps the peers of the current torrent as plain values and builds the cell
+// data on request. Refreshing the list notifies the view only about the cells
+// whose values have changed, new and gone peers are inserted/removed in batches.
+class PeerListModel final : public QAbstractTableModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(PeerListModel)
+
+public:
+    explicit PeerListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = {}) const override;
+    int columnCount(const QModelIndex &parent = {}) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    BitTorrent::PeerAddress peerAddress(int row) const;
+
+    // `countries` is either empty or contains a country code for every peer
+    void setPeers(const BitTorrent::TorrentHandle *torrent, const QVector<BitTorrent::PeerInfo> &peers
+        , const QVector<QString> &countries);
+    void setHostName(const QHostAddress &ip, const QString &hostName);
+    void clear();
+
+private:
+    struct PeerItem
+    {
+        PeerEndpoint endpoint;
+        QString ip;
+        QString hostName;
+        QString country;
+        QString client;
+        BitTorrent::PeerInfo::PeerFlags flags;
+        qreal progress = 0;
+        int downSpeed = 0;
+        int upSpeed = 0;
+        qlonglong totalDownload = 0;
+        qlonglong totalUpload = 0;
+        qreal relevance = 0;
+        int downloadingPieceIndex = -1;
+        QStringList downloadingFiles;
+    };
+
+    QVariant displayValue(const PeerItem &item, int column) const;
+    QVariant underlyingValue(const PeerItem &item, int column) const;
+    QVariant toolTipValue(const PeerItem &item, int column) const;
+
+    // returns the bitmask of the columns whose values have changed
+    static quint32 updateItem(PeerItem &item, const BitTorrent::TorrentHandle *torrent
+        , const BitTorrent::PeerInfo &peer, const QString &country);
+    bool removeStaleRows(const QVector<bool> &keepRows);
+    void rebuildIndex();
+
+    QVector<PeerItem> m_items;
+    QHash<PeerEndpoint, int> m_rowByEndpoint;
+    bool m_hideZeroValues = false;
+};
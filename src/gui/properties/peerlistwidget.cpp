@@ -36,10 +36,8 @@
 #include <QHostAddress>
 #include <QMenu>
 #include <QMessageBox>
-#include <QSet>
 #include <QShortcut>
 #include <QSortFilterProxyModel>
-#include <QStandardItemModel>
 #include <QTableView>
 #include <QVector>
 #include <QWheelEvent>
@@ -48,34 +46,16 @@
 #include "base/bittorrent/peerinfo.h"
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
-#include "base/global.h"
 #include "base/logger.h"
 #include "base/net/geoipmanager.h"
 #include "base/net/reverseresolution.h"
 #include "base/preferences.h"
-#include "base/utils/misc.h"
-#include "base/utils/string.h"
 #include "gui/uithememanager.h"
+#include "peerlistmodel.h"
 #include "peerlistsortmodel.h"
 #include "peersadditiondialog.h"
 #include "propertieswidget.h"
 
-struct PeerEndpoint
-{
-    BitTorrent::PeerAddress address;
-    QString connectionType; // matches return type of `PeerInfo::connectionType()`
-};
-
-bool operator==(const PeerEndpoint &left, const PeerEndpoint &right)
-{
-    return (left.address == right.address) && (left.connectionType == right.connectionType);
-}
-
-uint qHash(const PeerEndpoint &peerEndpoint, const uint seed)
-{
-    return (qHash(peerEndpoint.address, seed) ^ ::qHash(peerEndpoint.connectionType));
-}
-
 PeerListWidget::PeerListWidget(PropertiesWidget *parent)
     : QTreeView(parent)
     , m_properties(parent)
@@ -91,32 +71,13 @@ PeerListWidget::PeerListWidget(PropertiesWidget *parent)
     setSelectionMode(QAbstractItemView::ExtendedSelection);
     header()->setStretchLastSection(false);
     // List Model
-    m_listModel = new QStandardItemModel(0, PeerListColumns::COL_COUNT, this);
-    m_listModel->setHeaderData(PeerListColumns::COUNTRY, Qt::Horizontal, tr("Country/Region")); // Country flag column
-    m_listModel->setHeaderData(PeerListColumns::IP, Qt::Horizontal, tr("IP"));
-    m_listModel->setHeaderData(PeerListColumns::PORT, Qt::Horizontal, tr("Port"));
-    m_listModel->setHeaderData(PeerListColumns::FLAGS, Qt::Horizontal, tr("Flags"));
-    m_listModel->setHeaderData(PeerListColumns::CONNECTION, Qt::Horizontal, tr("Connection"));
-    m_listModel->setHeaderData(PeerListColumns::CLIENT, Qt::Horizontal, tr("Client", "i.e.: Client application"));
-    m_listModel->setHeaderData(PeerListColumns::PROGRESS, Qt::Horizontal, tr("Progress", "i.e: % downloaded"));
-    m_listModel->setHeaderData(PeerListColumns::DOWN_SPEED, Qt::Horizontal, tr("Down Speed", "i.e: Download speed"));
-    m_listModel->setHeaderData(PeerListColumns::UP_SPEED, Qt::Horizontal, tr("Up Speed", "i.e: Upload speed"));
-    m_listModel->setHeaderData(PeerListColumns::TOT_DOWN, Qt::Horizontal, tr("Downloaded", "i.e: total data downloaded"));
-    m_listModel->setHeaderData(PeerListColumns::TOT_UP, Qt::Horizontal, tr("Uploaded", "i.e: total data uploaded"));
-    m_listModel->setHeaderData(PeerListColumns::RELEVANCE, Qt::Horizontal, tr("Relevance", "i.e: How relevant this peer is to us. How many pieces it has that we don't."));
-    m_listModel->setHeaderData(PeerListColumns::DOWNLOADING_PIECE, Qt::Horizontal, tr("Files", "i.e. files that are being downloaded right now"));
-    // Set header text alignment
-    m_listModel->setHeaderData(PeerListColumns::PORT, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListColumns::PROGRESS, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListColumns::DOWN_SPEED, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListColumns::UP_SPEED, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListColumns::TOT_DOWN, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListColumns::TOT_UP, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_listModel->setHeaderData(PeerListColumns::RELEVANCE, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
+    m_listModel = new PeerListModel(this);
     // Proxy model to support sorting without actually altering the underlying model
     m_proxyModel = new PeerListSortModel(this);
     m_proxyModel->setDynamicSortFilter(true);
     m_proxyModel->setSourceModel(m_listModel);
+    connect(m_listModel, &QAbstractItemModel::rowsInserted, this
+        , [this](const QModelIndex &, const int first, const int last) { resolveHostNames(first, last); });
     m_proxyModel->setSortCaseSensitivity(Qt::CaseInsensitive);
     setModel(m_proxyModel);
     hideColumn(PeerListColumns::IP_HIDDEN);
@@ -228,6 +189,7 @@ void PeerListWidget::updatePeerHostNameResolutionState()
         {
             m_resolver = new Net::ReverseResolution(this);
             connect(m_resolver, &Net::ReverseResolution::ipResolved, this, &PeerListWidget::handleResolved);
+            resolveHostNames(0, (m_listModel->rowCount() - 1));
             loadPeers(m_properties->getCurrentTorrent());
         }
     }
@@ -313,7 +275,7 @@ void PeerListWidget::banSelectedPeers()
     for (const QModelIndex &index : selectedIndexes)
     {
         const int row = m_proxyModel->mapToSource(index).row();
-        const QString ip = m_listModel->item(row, PeerListColumns::IP_HIDDEN)->text();
+        const QString ip = m_listModel->peerAddress(row).ip.toString();
         selectedIPs += ip;
     }
 
@@ -339,8 +301,9 @@ void PeerListWidget::copySelectedPeers()
     for (const QModelIndex &index : selectedIndexes)
     {
         const int row = m_proxyModel->mapToSource(index).row();
-        const QString ip = m_listModel->item(row, PeerListColumns::IP_HIDDEN)->text();
-        const QString port = m_listModel->item(row, PeerListColumns::PORT)->text();
+        const BitTorrent::PeerAddress address = m_listModel->peerAddress(row);
+        const QString ip = address.ip.toString();
+        const QString port = QString::number(address.port);
 
         if (!ip.contains('.'))  // IPv6
             selectedPeers << ('[' + ip + "]:" + port);
@@ -353,11 +316,7 @@ void PeerListWidget::copySelectedPeers()
 
 void PeerListWidget::clear()
 {
-    m_peerItems.clear();
-    m_itemsByIP.clear();
-    const int nbrows = m_listModel->rowCount();
-    if (nbrows > 0)
-        m_listModel->removeRows(0, nbrows);
+    m_listModel->clear();
 }
 
 void PeerListWidget::loadSettings()
@@ -375,119 +334,35 @@ void PeerListWidget::loadPeers(const BitTorrent::TorrentHandle *torrent)
     if (!torrent) return;
 
     const QVector<BitTorrent::PeerInfo> peers = torrent->peers();
-    QSet<PeerEndpoint> existingPeers;
-    for (auto i = m_peerItems.cbegin(); i != m_peerItems.cend(); ++i)
-        existingPeers << i.key();
 
-    for (const BitTorrent::PeerInfo &peer : peers)
+    // resolve countries of all peers at once
+    QVector<QString> countries;
+    if (m_resolveCountries)
     {
-        if (peer.address().ip.isNull()) continue;
-
-        bool isNewPeer = false;
-        updatePeer(torrent, peer, isNewPeer);
-        if (!isNewPeer)
-        {
-            const PeerEndpoint peerEndpoint {peer.address(), peer.connectionType()};
-            existingPeers.remove(peerEndpoint);
-        }
+        QVector<QHostAddress> addresses;
+        addresses.reserve(peers.size());
+        for (const BitTorrent::PeerInfo &peer : peers)
+            addresses.append(peer.address().ip);
+        countries = Net::GeoIPManager::instance()->lookup(addresses);
     }
 
-    // Remove peers that are gone
-    for (const PeerEndpoint &peerEndpoint : asConst(existingPeers))
-    {
-        QStandardItem *item = m_peerItems.take(peerEndpoint);
-
-        QSet<QStandardItem *> &items = m_itemsByIP[peerEndpoint.address.ip];
-        items.remove(item);
-        if (items.isEmpty())
-            m_itemsByIP.remove(peerEndpoint.address.ip);
-
-        m_listModel->removeRow(item->row());
-    }
+    m_listModel->setPeers(torrent, peers, countries);
 }
 
-void PeerListWidget::updatePeer(const BitTorrent::TorrentHandle *torrent, const BitTorrent::PeerInfo &peer, bool &isNewPeer)
+void PeerListWidget::resolveHostNames(const int first, const int last)
 {
-    const PeerEndpoint peerEndpoint {peer.address(), peer.connectionType()};
-    const QString peerIp = peerEndpoint.address.ip.toString();
-    const Qt::Alignment intDataTextAlignment = Qt::AlignRight | Qt::AlignVCenter;
-
-    const auto setModelData =
-        [this] (const int row, const int column, const QString &displayData
-                , const QVariant &underlyingData, const Qt::Alignment textAlignmentData = {}
-                , const QString &toolTip = {})
-    {
-        const QMap<int, QVariant> data =
-        {
-            {Qt::DisplayRole, displayData},
-            {PeerListSortModel::UnderlyingDataRole, underlyingData},
-            {Qt::TextAlignmentRole, QVariant {textAlignmentData}},
-            {Qt::ToolTipRole, toolTip}
-        };
-        m_listModel->setItemData(m_listModel->index(row, column), data);
-    };
-
-    auto itemIter = m_peerItems.find(peerEndpoint);
-    isNewPeer = (itemIter == m_peerItems.end());
-    if (isNewPeer)
-    {
-        // new item
-        const int row = m_listModel->rowCount();
-        m_listModel->insertRow(row);
-
-        setModelData(row, PeerListColumns::IP, peerIp, peerIp, {}, peerIp);
-        setModelData(row, PeerListColumns::PORT, QString::number(peer.address().port), peer.address().port, intDataTextAlignment);
-        setModelData(row, PeerListColumns::IP_HIDDEN, peerIp, peerIp);
-
-        itemIter = m_peerItems.insert(peerEndpoint, m_listModel->item(row, PeerListColumns::IP));
-        m_itemsByIP[peerEndpoint.address.ip].insert(itemIter.value());
-    }
-
-    const int row = (*itemIter)->row();
-    const bool hideValues = Preferences::instance()->getHideZeroValues();
-
-    setModelData(row, PeerListColumns::CONNECTION, peer.connectionType(), peer.connectionType());
-    setModelData(row, PeerListColumns::FLAGS, peer.flags(), peer.flags(), {}, peer.flagsDescription());
-    const QString client = peer.client().toHtmlEscaped();
-    setModelData(row, PeerListColumns::CLIENT, client, client);
-    setModelData(row, PeerListColumns::PROGRESS, (Utils::String::fromDouble(peer.progress() * 100, 1) + '%'), peer.progress(), intDataTextAlignment);
-    const QString downSpeed = (hideValues && (peer.payloadDownSpeed() <= 0)) ? QString {} : Utils::Misc::friendlyUnit(peer.payloadDownSpeed(), true);
-    setModelData(row, PeerListColumns::DOWN_SPEED, downSpeed, peer.payloadDownSpeed(), intDataTextAlignment);
-    const QString upSpeed = (hideValues && (peer.payloadUpSpeed() <= 0)) ? QString {} : Utils::Misc::friendlyUnit(peer.payloadUpSpeed(), true);
-    setModelData(row, PeerListColumns::UP_SPEED, upSpeed, peer.payloadUpSpeed(), intDataTextAlignment);
-    const QString totalDown = (hideValues && (peer.totalDownload() <= 0)) ? QString {} : Utils::Misc::friendlyUnit(peer.totalDownload());
-    setModelData(row, PeerListColumns::TOT_DOWN, totalDown, peer.totalDownload(), intDataTextAlignment);
-    const QString totalUp = (hideValues && (peer.totalUpload() <= 0)) ? QString {} : Utils::Misc::friendlyUnit(peer.totalUpload());
-    setModelData(row, PeerListColumns::TOT_UP, totalUp, peer.totalUpload(), intDataTextAlignment);
-    setModelData(row, PeerListColumns::RELEVANCE, (Utils::String::fromDouble(peer.relevance() * 100, 1) + '%'), peer.relevance(), intDataTextAlignment);
-
-    const QStringList downloadingFiles {torrent->info().filesForPiece(peer.downloadingPieceIndex())};
-    const QString downloadingFilesDisplayValue = downloadingFiles.join(';');
-    setModelData(row, PeerListColumns::DOWNLOADING_PIECE, downloadingFilesDisplayValue, downloadingFilesDisplayValue, {}, downloadingFiles.join('\n'));
-
-    if (m_resolver)
-        m_resolver->resolve(peerEndpoint.address.ip);
+    if (!m_resolver) return;
 
-    if (m_resolveCountries)
-    {
-        const QIcon icon = UIThemeManager::instance()->getFlagIcon(peer.country());
-        if (!icon.isNull())
-        {
-            m_listModel->setData(m_listModel->index(row, PeerListColumns::COUNTRY), icon, Qt::DecorationRole);
-            const QString countryName = Net::GeoIPManager::CountryName(peer.country());
-            m_listModel->setData(m_listModel->index(row, PeerListColumns::COUNTRY), countryName, Qt::ToolTipRole);
-        }
-    }
+    for (int row = first; row <= last; ++row)
+        m_resolver->resolve(m_listModel->peerAddress(row).ip);
 }
 
-void PeerListWidget::handleResolved(const QHostAddress &ip, const QString &hostname) const
+void PeerListWidget::handleResolved(const QHostAddress &ip, const QString &hostname)
 {
     if (hostname.isEmpty())
         return;
 
-    const QSet<QStandardItem *> items = m_itemsByIP.value(ip);
-    for (QStandardItem *item : items)
-        item->setData(hostname, Qt::DisplayRole);
+    m_listModel->setHostName(ip, hostname);
 }
 
 void PeerListWidget::handleSortColumnChanged(const int col)
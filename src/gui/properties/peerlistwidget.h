@@ -28,23 +28,17 @@
 
 #pragma once
 
-#include <QHash>
-#include <QSet>
 #include <QTreeView>
 
 class QHostAddress;
-class QStandardItem;
-class QStandardItemModel;
 
+class PeerListModel;
 class PeerListSortModel;
 class PropertiesWidget;
 
-struct PeerEndpoint;
-
 namespace BitTorrent
 {
     class TorrentHandle;
-    class PeerInfo;
 }
 
 namespace Net
@@ -93,18 +87,16 @@ private slots:
     void banSelectedPeers();
     void copySelectedPeers();
     void handleSortColumnChanged(int col);
-    void handleResolved(const QHostAddress &ip, const QString &hostname) const;
+    void handleResolved(const QHostAddress &ip, const QString &hostname);
 
 private:
-    void updatePeer(const BitTorrent::TorrentHandle *torrent, const BitTorrent::PeerInfo &peer, bool &isNewPeer);
+    void resolveHostNames(int first, int last);
 
     void wheelEvent(QWheelEvent *event) override;
 
-    QStandardItemModel *m_listModel = nullptr;
+    PeerListModel *m_listModel = nullptr;
     PeerListSortModel *m_proxyModel = nullptr;
     PropertiesWidget *m_properties = nullptr;
     Net::ReverseResolution *m_resolver = nullptr;
-    QHash<PeerEndpoint, QStandardItem *> m_peerItems;
-    QHash<QHostAddress, QSet<QStandardItem *>> m_itemsByIP;  // must be kept in sync with `m_peerItems`
     bool m_resolveCountries;
 };
@@ -28,8 +28,10 @@
 
 #include "speedplotview.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include <QDateTime>
 #include <QLocale>
 #include <QPainter>
 #include <QPen>
@@ -197,6 +199,15 @@ SpeedPlotView::SpeedPlotView(QWidget *parent)
     greenPen.setStyle(Qt::DotLine);
     m_properties[TRACKER_UP] = GraphProperties(tr("Tracker Upload"), bluePen);
     m_properties[TRACKER_DOWN] = GraphProperties(tr("Tracker Download"), greenPen);
+
+    QPen purplePen;
+    purplePen.setWidthF(1.5);
+    purplePen.setColor(QColor(163, 73, 164));
+    QPen orangePen;
+    orangePen.setWidthF(1.5);
+    orangePen.setColor(QColor(255, 140, 0));
+    m_properties[TASK_UP] = GraphProperties(tr("Selected Task Upload"), purplePen);
+    m_properties[TASK_DOWN] = GraphProperties(tr("Selected Task Download"), orangePen);
 }
 
 void SpeedPlotView::setGraphEnable(GraphID id, bool enable)
@@ -214,6 +225,30 @@ void SpeedPlotView::pushPoint(const SpeedPlotView::PointData &point)
     m_averager24Hour.push(point);
 }
 
+void SpeedPlotView::setTaskSpeedHistory(const BitTorrent::SpeedHistory::Series &series)
+{
+    m_taskSpeedHistory = series;
+}
+
+qint64 SpeedPlotView::periodDuration() const
+{
+    switch (m_period)
+    {
+    case SpeedPlotView::MIN1:
+        return MIN1_SEC;
+    case SpeedPlotView::MIN5:
+        return MIN5_SEC;
+    case SpeedPlotView::MIN30:
+        return MIN30_SEC;
+    case SpeedPlotView::HOUR6:
+        return HOUR6_SEC;
+    case SpeedPlotView::HOUR12:
+        return HOUR12_SEC;
+    default:
+        return HOUR24_SEC;
+    }
+}
+
 void SpeedPlotView::setPeriod(const TimePeriod period)
 {
     m_period = period;
@@ -281,6 +316,16 @@ quint64 SpeedPlotView::maxYValue()
                 maxYValue = queue[i].y[id];
     }
 
+    const bool isTaskUpEnabled = m_properties[TASK_UP].enable;
+    const bool isTaskDownEnabled = m_properties[TASK_DOWN].enable;
+    for (const BitTorrent::SpeedHistory::Point &point : asConst(m_taskSpeedHistory.points))
+    {
+        if (isTaskUpEnabled)
+            maxYValue = std::max(maxYValue, static_cast<quint64>(point.upload));
+        if (isTaskDownEnabled)
+            maxYValue = std::max(maxYValue, static_cast<quint64>(point.download));
+    }
+
     return maxYValue;
 }
 
@@ -376,6 +421,29 @@ void SpeedPlotView::paintEvent(QPaintEvent *)
         painter.drawPolyline(points.data(), points.size());
     }
 
+    // the task history has its own resolution, so its points are placed by time
+    const qint64 now = QDateTime::currentMSecsSinceEpoch() / 1000;
+    const double xSecSize = static_cast<double>(rect.width()) / periodDuration();
+    for (const GraphID id : {TASK_UP, TASK_DOWN})
+    {
+        if (!m_properties[id].enable || m_taskSpeedHistory.points.isEmpty())
+            continue;
+
+        QVector<QPoint> points;
+        points.reserve(m_taskSpeedHistory.points.size());
+        for (const BitTorrent::SpeedHistory::Point &point : asConst(m_taskSpeedHistory.points))
+        {
+            const qint64 value = (id == TASK_UP) ? point.upload : point.download;
+            const int newX = rect.right() - (now - point.time) * xSecSize;
+            const int newY = rect.bottom() - value * yMultiplier;
+
+            points.push_back(QPoint(newX, newY));
+        }
+
+        painter.setPen(m_properties[id].pen);
+        painter.drawPolyline(points.data(), points.size());
+    }
+
     // draw legend
     QPoint legendTopLeft(rect.left() + 4, fullRect.top() + 4);
 
@@ -35,6 +35,8 @@
 #include <QGraphicsView>
 #include <QMap>
 
+#include "base/bittorrent/speedhistory.h"
+
 class QPen;
 
 class SpeedPlotView final : public QGraphicsView
@@ -55,7 +57,13 @@ public:
         TRACKER_UP,
         TRACKER_DOWN,
 
-        NB_GRAPHS
+        NB_GRAPHS,
+
+        // speed of the selected task, taken from BitTorrent::SpeedHistory
+        TASK_UP = NB_GRAPHS,
+        TASK_DOWN,
+
+        NB_ALL_GRAPHS
     };
 
     enum TimePeriod
@@ -78,8 +86,10 @@ public:
 
     void setGraphEnable(GraphID id, bool enable);
     void setPeriod(TimePeriod period);
+    qint64 periodDuration() const;
 
     void pushPoint(const PointData &point);
+    void setTaskSpeedHistory(const BitTorrent::SpeedHistory::Series &series);
 
     void replot();
 
@@ -126,6 +136,7 @@ private:
     Averager m_averager24Hour;
 
     QMap<GraphID, GraphProperties> m_properties;
+    BitTorrent::SpeedHistory::Series m_taskSpeedHistory;
 
     TimePeriod m_period;
     int m_viewablePointsCount;
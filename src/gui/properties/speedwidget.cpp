@@ -37,6 +37,8 @@
 
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/sessionstatus.h"
+#include "base/bittorrent/speedhistory.h"
+#include "base/bittorrent/torrenthandle.h"
 #include "base/preferences.h"
 #include "propertieswidget.h"
 #include "speedplotview.h"
@@ -57,6 +59,7 @@ void ComboBoxMenuButton::showPopup()
 
 SpeedWidget::SpeedWidget(PropertiesWidget *parent)
     : QWidget(parent)
+    , m_propertiesWidget(parent)
 {
     m_layout = new QVBoxLayout(this);
     m_layout->setContentsMargins(0, 0, 0, 0);
@@ -89,10 +92,12 @@ SpeedWidget::SpeedWidget(PropertiesWidget *parent)
     m_graphsMenu->addAction(tr("DHT Download"));
     m_graphsMenu->addAction(tr("Tracker Upload"));
     m_graphsMenu->addAction(tr("Tracker Download"));
+    m_graphsMenu->addAction(tr("Selected Task Upload"));
+    m_graphsMenu->addAction(tr("Selected Task Download"));
 
     m_graphsMenuActions = m_graphsMenu->actions();
 
-    for (int id = SpeedPlotView::UP; id < SpeedPlotView::NB_GRAPHS; ++id)
+    for (int id = SpeedPlotView::UP; id < SpeedPlotView::NB_ALL_GRAPHS; ++id)
     {
         QAction *action = m_graphsMenuActions.at(id);
         action->setCheckable(true);
@@ -149,6 +154,14 @@ void SpeedWidget::update()
     point.y[SpeedPlotView::TRACKER_DOWN] = btStatus.trackerDownloadRate;
 
     m_plot->pushPoint(point);
+
+    const BitTorrent::TorrentHandle *torrent = m_propertiesWidget->getCurrentTorrent();
+    const BitTorrent::SpeedHistory *speedHistory = BitTorrent::SpeedHistory::instance();
+    if (torrent && speedHistory)
+        m_plot->setTaskSpeedHistory(speedHistory->series(BitTorrent::SpeedHistory::SeriesType::Task, torrent->hash(), m_plot->periodDuration()));
+    else
+        m_plot->setTaskSpeedHistory({});
+
     m_plot->replot();
 }
 
@@ -171,7 +184,7 @@ void SpeedWidget::loadSettings()
     m_periodCombobox->setCurrentIndex(periodIndex);
     onPeriodChange(static_cast<SpeedPlotView::TimePeriod>(periodIndex));
 
-    for (int id = SpeedPlotView::UP; id < SpeedPlotView::NB_GRAPHS; ++id)
+    for (int id = SpeedPlotView::UP; id < SpeedPlotView::NB_ALL_GRAPHS; ++id)
     {
         QAction *action = m_graphsMenuActions.at(id);
         bool enable = preferences->getSpeedWidgetGraphEnable(id);
@@ -187,7 +200,7 @@ void SpeedWidget::saveSettings() const
 
     preferences->setSpeedWidgetPeriod(m_periodCombobox->currentIndex());
 
-    for (int id = SpeedPlotView::UP; id < SpeedPlotView::NB_GRAPHS; ++id)
+    for (int id = SpeedPlotView::UP; id < SpeedPlotView::NB_ALL_GRAPHS; ++id)
     {
         QAction *action = m_graphsMenuActions.at(id);
         preferences->setSpeedWidgetGraphEnable(id, action->isChecked());
@@ -74,6 +74,7 @@ private:
     QLabel *m_periodLabel;
     QComboBox *m_periodCombobox;
     SpeedPlotView *m_plot;
+    PropertiesWidget *m_propertiesWidget;
 
     ComboBoxMenuButton *m_graphsButton;
     QMenu *m_graphsMenu;
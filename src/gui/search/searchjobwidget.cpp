@@ -35,8 +35,6 @@
 #include <QHeaderView>
 #include <QKeyEvent>
 #include <QMenu>
-#include <QPalette>
-#include <QStandardItemModel>
 #include <QTableView>
 #include <QUrl>
 
@@ -51,6 +49,7 @@
 #include "gui/lineedit.h"
 #include "gui/uithememanager.h"
 #include "gui/utils.h"
+#include "searchresultmodel.h"
 #include "searchsortmodel.h"
 #include "ui_searchjobwidget.h"
 
@@ -73,16 +72,7 @@ SearchJobWidget::SearchJobWidget(SearchHandler *searchHandler, QWidget *parent)
     header()->setStretchLastSection(false);
 
     // Set Search results list model
-    m_searchListModel = new QStandardItemModel(0, SearchSortModel::NB_SEARCH_COLUMNS, this);
-    m_searchListModel->setHeaderData(SearchSortModel::NAME, Qt::Horizontal, tr("Name", "i.e: file name"));
-    m_searchListModel->setHeaderData(SearchSortModel::SIZE, Qt::Horizontal, tr("Size", "i.e: file size"));
-    m_searchListModel->setHeaderData(SearchSortModel::SEEDS, Qt::Horizontal, tr("Seeders", "i.e: Number of full sources"));
-    m_searchListModel->setHeaderData(SearchSortModel::LEECHES, Qt::Horizontal, tr("Leechers", "i.e: Number of partial sources"));
-    m_searchListModel->setHeaderData(SearchSortModel::ENGINE_URL, Qt::Horizontal, tr("Search engine"));
-    // Set columns text alignment
-    m_searchListModel->setHeaderData(SearchSortModel::SIZE, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_searchListModel->setHeaderData(SearchSortModel::SEEDS, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
-    m_searchListModel->setHeaderData(SearchSortModel::LEECHES, Qt::Horizontal, QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
+    m_searchListModel = new SearchResultModel(this);
 
     m_proxyModel = new SearchSortModel(this);
     m_proxyModel->setDynamicSortFilter(true);
@@ -180,16 +170,6 @@ QHeaderView *SearchJobWidget::header() const
     return m_ui->resultsBrowser->header();
 }
 
-// Set the color of a row in data model
-void SearchJobWidget::setRowColor(int row, const QColor &color)
-{
-    m_proxyModel->setDynamicSortFilter(false);
-    for (int i = 0; i < m_proxyModel->columnCount(); ++i)
-        m_proxyModel->setData(m_proxyModel->index(row, i), color, Qt::ForegroundRole);
-
-    m_proxyModel->setDynamicSortFilter(true);
-}
-
 SearchJobWidget::Status SearchJobWidget::status() const
 {
     return m_status;
@@ -287,7 +267,7 @@ void SearchJobWidget::downloadTorrent(const QModelIndex &rowIndex)
         connect(downloadHandler, &SearchDownloadHandler::downloadFinished, this, &SearchJobWidget::addTorrentToSession);
         connect(downloadHandler, &SearchDownloadHandler::downloadFinished, downloadHandler, &SearchDownloadHandler::deleteLater);
     }
-    setRowColor(rowIndex.row(), QApplication::palette().color(QPalette::LinkVisited));
+    m_searchListModel->setVisited(m_proxyModel->mapToSource(m_proxyModel->index(rowIndex.row(), 0)).row());
 }
 
 void SearchJobWidget::addTorrentToSession(const QString &source)
@@ -515,33 +495,7 @@ void SearchJobWidget::searchFailed()
 
 void SearchJobWidget::appendSearchResults(const QVector<SearchResult> &results)
 {
-    for (const SearchResult &result : results)
-    {
-        // Add item to search result list
-        int row = m_searchListModel->rowCount();
-        m_searchListModel->insertRow(row);
-
-        const auto setModelData = [this, row] (const int column, const QString &displayData
-                                               , const QVariant &underlyingData, const Qt::Alignment textAlignmentData = {})
-        {
-            const QMap<int, QVariant> data =
-            {
-                {Qt::DisplayRole, displayData},
-                {SearchSortModel::UnderlyingDataRole, underlyingData},
-                {Qt::TextAlignmentRole, QVariant {textAlignmentData}}
-            };
-            m_searchListModel->setItemData(m_searchListModel->index(row, column), data);
-        };
-
-        setModelData(SearchSortModel::NAME, result.fileName, result.fileName);
-        setModelData(SearchSortModel::DL_LINK, result.fileUrl, result.fileUrl);
-        setModelData(SearchSortModel::ENGINE_URL, result.siteUrl, result.siteUrl);
-        setModelData(SearchSortModel::DESC_LINK, result.descrLink, result.descrLink);
-        setModelData(SearchSortModel::SIZE, Utils::Misc::friendlyUnit(result.fileSize), result.fileSize, (Qt::AlignRight | Qt::AlignVCenter));
-        setModelData(SearchSortModel::SEEDS, QString::number(result.nbSeeders), result.nbSeeders, (Qt::AlignRight | Qt::AlignVCenter));
-        setModelData(SearchSortModel::LEECHES, QString::number(result.nbLeechers), result.nbLeechers, (Qt::AlignRight | Qt::AlignVCenter));
-    }
-
+    m_searchListModel->appendResults(results);
     updateResultsCount();
 }
 
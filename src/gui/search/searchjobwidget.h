@@ -36,10 +36,10 @@
 
 class QHeaderView;
 class QModelIndex;
-class QStandardItemModel;
 
 class LineEdit;
 class SearchHandler;
+class SearchResultModel;
 class SearchSortModel;
 struct SearchResult;
 
@@ -107,7 +107,6 @@ private:
     void fillFilterComboBoxes();
     NameFilteringMode filteringMode() const;
     QHeaderView *header() const;
-    void setRowColor(int row, const QColor &color);
 
     void downloadTorrents();
     void openTorrentPages() const;
@@ -121,7 +120,7 @@ private:
 
     Ui::SearchJobWidget *m_ui;
     SearchHandler *m_searchHandler;
-    QStandardItemModel *m_searchListModel;
+    SearchResultModel *m_searchListModel;
     SearchSortModel *m_proxyModel;
     LineEdit *m_lineEditSearchResultsFilter;
     Status m_status = Status::Ongoing;
@@ -0,0 +1,194 @@
+#include "searchresultmodel.h"
+
+#include <QApplication>
+#include <QPalette>
+
+#include "base/search/searchhandler.h"
+#include "base/utils/misc.h"
+#include "searchsortmodel.h"
+
+SearchResultModel::SearchResultModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int SearchResultModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_fileNames.size();
+}
+
+int SearchResultModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : SearchSortModel::NB_SEARCH_COLUMNS;
+}
+
+QVariant SearchResultModel::data(const QModelIndex &index, const int role) const
+{
+    if (!index.isValid() || (index.row() >= rowCount()))
+        return {};
+
+    const int row = index.row();
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        switch (index.column())
+        {
+        case SearchSortModel::NAME:
+            return m_fileNames[row];
+        case SearchSortModel::SIZE:
+            return Utils::Misc::friendlyUnit(m_fileSizes[row]);
+        case SearchSortModel::SEEDS:
+            return QString::number(m_seeders[row]);
+        case SearchSortModel::LEECHES:
+            return QString::number(m_leechers[row]);
+        case SearchSortModel::ENGINE_URL:
+            return m_siteUrls[row];
+        case SearchSortModel::DL_LINK:
+            return m_fileUrls[row];
+        case SearchSortModel::DESC_LINK:
+            return m_descrLinks[row];
+        default:
+            return {};
+        }
+    case SearchSortModel::UnderlyingDataRole:
+        switch (index.column())
+        {
+        case SearchSortModel::SIZE:
+            return m_fileSizes[row];
+        case SearchSortModel::SEEDS:
+            return m_seeders[row];
+        case SearchSortModel::LEECHES:
+            return m_leechers[row];
+        default:
+            return data(index, Qt::DisplayRole);
+        }
+    case Qt::TextAlignmentRole:
+        switch (index.column())
+        {
+        case SearchSortModel::SIZE:
+        case SearchSortModel::SEEDS:
+        case SearchSortModel::LEECHES:
+            return QVariant {Qt::AlignRight | Qt::AlignVCenter};
+        default:
+            return {};
+        }
+    case Qt::ForegroundRole:
+        if (m_isVisited[row])
+            return QApplication::palette().color(QPalette::LinkVisited);
+        return {};
+    default:
+        return {};
+    }
+}
+
+QVariant SearchResultModel::headerData(const int section, const Qt::Orientation orientation, const int role) const
+{
+    if (orientation != Qt::Horizontal)
+        return {};
+
+    if (role == Qt::DisplayRole)
+    {
+        switch (section)
+        {
+        case SearchSortModel::NAME:
+            return tr("Name", "i.e: file name");
+        case SearchSortModel::SIZE:
+            return tr("Size", "i.e: file size");
+        case SearchSortModel::SEEDS:
+            return tr("Seeders", "i.e: Number of full sources");
+        case SearchSortModel::LEECHES:
+            return tr("Leechers", "i.e: Number of partial sources");
+        case SearchSortModel::ENGINE_URL:
+            return tr("Search engine");
+        default:
+            return {};
+        }
+    }
+
+    if (role == Qt::TextAlignmentRole)
+    {
+        switch (section)
+        {
+        case SearchSortModel::SIZE:
+        case SearchSortModel::SEEDS:
+        case SearchSortModel::LEECHES:
+            return QVariant {Qt::AlignRight | Qt::AlignVCenter};
+        default:
+            return {};
+        }
+    }
+
+    return {};
+}
+
+void SearchResultModel::appendResults(const QVector<SearchResult> &results)
+{
+    if (results.isEmpty())
+        return;
+
+    const int first = rowCount();
+    const int newSize = first + results.size();
+
+    beginInsertRows({}, first, (newSize - 1));
+
+    // the columns aren't reserved for the batch, reserving the exact size
+    // would reallocate them on every batch instead of growing them geometrically
+    for (const SearchResult &result : results)
+    {
+        m_fileNames.append(result.fileName);
+        m_fileUrls.append(result.fileUrl);
+        m_siteUrls.append(result.siteUrl);
+        m_descrLinks.append(result.descrLink);
+        m_fileSizes.append(result.fileSize);
+        m_seeders.append(result.nbSeeders);
+        m_leechers.append(result.nbLeechers);
+    }
+    m_isVisited.resize(newSize);
+
+    endInsertRows();
+}
+
+void SearchResultModel::setVisited(const int row)
+{
+    if ((row < 0) || (row >= rowCount()) || m_isVisited[row])
+        return;
+
+    m_isVisited[row] = true;
+    emit dataChanged(index(row, 0), index(row, (SearchSortModel::NB_SEARCH_COLUMNS - 1)), {Qt::ForegroundRole});
+}
+
+const QString &SearchResultModel::fileName(const int row) const
+{
+    return m_fileNames[row];
+}
+
+const QString &SearchResultModel::fileUrl(const int row) const
+{
+    return m_fileUrls[row];
+}
+
+const QString &SearchResultModel::siteUrl(const int row) const
+{
+    return m_siteUrls[row];
+}
+
+const QString &SearchResultModel::descrLink(const int row) const
+{
+    return m_descrLinks[row];
+}
+
+qlonglong SearchResultModel::fileSize(const int row) const
+{
+    return m_fileSizes[row];
+}
+
+qlonglong SearchResultModel::seeders(const int row) const
+{
+    return m_seeders[row];
+}
+
+qlonglong SearchResultModel::leechers(const int row) const
+{
+    return m_leechers[row];
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <QVector>
+
+struct SearchResult;
+
+// Keeps the search results column by column. The new results are added in one
+// batch, the values shown are produced only for the rows being displayed.
+// Columns and roles are the ones of SearchSortModel.
+class SearchResultModel final : public QAbstractTableModel
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SearchResultModel)
+
+public:
+    explicit SearchResultModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = {}) const override;
+    int columnCount(const QModelIndex &parent = {}) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void appendResults(const QVector<SearchResult> &results);
+    // The download of the result was started
+    void setVisited(int row);
+
+    const QString &fileName(int row) const;
+    const QString &fileUrl(int row) const;
+    const QString &siteUrl(int row) const;
+    const QString &descrLink(int row) const;
+    qlonglong fileSize(int row) const;
+    qlonglong seeders(int row) const;
+    qlonglong leechers(int row) const;
+
+private:
+    QVector<QString> m_fileNames;
+    QVector<QString> m_fileUrls;
+    QVector<QString> m_siteUrls;
+    QVector<QString> m_descrLinks;
+    QVector<qlonglong> m_fileSizes;
+    QVector<qlonglong> m_seeders;
+    QVector<qlonglong> m_leechers;
+    QVector<bool> m_isVisited;
+};
@@ -30,6 +30,7 @@
 
 #include "base/global.h"
 #include "base/utils/string.h"
+#include "searchresultmodel.h"
 
 SearchSortModel::SearchSortModel(QObject *parent)
     : base(parent)
@@ -112,19 +113,33 @@ qint64 SearchSortModel::maxSize() const
     return m_maxSize;
 }
 
+const SearchResultModel *SearchSortModel::resultModel() const
+{
+    return static_cast<const SearchResultModel *>(sourceModel());
+}
+
 bool SearchSortModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
+    const SearchResultModel *model = resultModel();
+    const int leftRow = left.row();
+    const int rightRow = right.row();
+
     switch (sortColumn())
     {
     case NAME:
+        return (Utils::String::naturalCompare(model->fileName(leftRow), model->fileName(rightRow), Qt::CaseInsensitive) < 0);
     case ENGINE_URL:
-    {
-            const QString strL = left.data().toString();
-            const QString strR = right.data().toString();
-            const int result = Utils::String::naturalCompare(strL, strR, Qt::CaseInsensitive);
-            return (result < 0);
-        }
-        break;
+        return (Utils::String::naturalCompare(model->siteUrl(leftRow), model->siteUrl(rightRow), Qt::CaseInsensitive) < 0);
+    case SIZE:
+        return (model->fileSize(leftRow) < model->fileSize(rightRow));
+    case SEEDS:
+        return (model->seeders(leftRow) < model->seeders(rightRow));
+    case LEECHES:
+        return (model->leechers(leftRow) < model->leechers(rightRow));
+    case DL_LINK:
+        return (model->fileUrl(leftRow) < model->fileUrl(rightRow));
+    case DESC_LINK:
+        return (model->descrLink(leftRow) < model->descrLink(rightRow));
     default:
         return base::lessThan(left, right);
     };
@@ -132,11 +147,13 @@ bool SearchSortModel::lessThan(const QModelIndex &left, const QModelIndex &right
 
 bool SearchSortModel::filterAcceptsRow(const int sourceRow, const QModelIndex &sourceParent) const
 {
-    const QAbstractItemModel *const sourceModel = this->sourceModel();
+    Q_UNUSED(sourceParent);
+
+    const SearchResultModel *model = resultModel();
+    const QString &name = model->fileName(sourceRow);
 
     if (m_isNameFilterEnabled && !m_searchTerm.isEmpty())
     {
-        const QString name = sourceModel->data(sourceModel->index(sourceRow, NAME, sourceParent), UnderlyingDataRole).toString();
         for (const QString &word : asConst(m_searchTermWords))
         {
             if (!name.contains(word, Qt::CaseInsensitive))
@@ -146,7 +163,7 @@ bool SearchSortModel::filterAcceptsRow(const int sourceRow, const QModelIndex &s
 
     if ((m_minSize > 0) || (m_maxSize >= 0))
     {
-        const qlonglong size = sourceModel->data(sourceModel->index(sourceRow, SIZE, sourceParent), UnderlyingDataRole).toLongLong();
+        const qlonglong size = model->fileSize(sourceRow);
         if (((m_minSize > 0) && (size < m_minSize))
             || ((m_maxSize > 0) && (size > m_maxSize)))
             return false;
@@ -154,7 +171,7 @@ bool SearchSortModel::filterAcceptsRow(const int sourceRow, const QModelIndex &s
 
     if ((m_minSeeds > 0) || (m_maxSeeds >= 0))
     {
-        const int seeds = sourceModel->data(sourceModel->index(sourceRow, SEEDS, sourceParent), UnderlyingDataRole).toInt();
+        const qlonglong seeds = model->seeders(sourceRow);
         if (((m_minSeeds > 0) && (seeds < m_minSeeds))
             || ((m_maxSeeds > 0) && (seeds > m_maxSeeds)))
             return false;
@@ -162,11 +179,13 @@ bool SearchSortModel::filterAcceptsRow(const int sourceRow, const QModelIndex &s
 
     if ((m_minLeeches > 0) || (m_maxLeeches >= 0))
     {
-        const int leeches = sourceModel->data(sourceModel->index(sourceRow, LEECHES, sourceParent), UnderlyingDataRole).toInt();
+        const qlonglong leeches = model->leechers(sourceRow);
         if (((m_minLeeches > 0) && (leeches < m_minLeeches))
             || ((m_maxLeeches > 0) && (leeches > m_maxLeeches)))
             return false;
     }
 
-    return base::filterAcceptsRow(sourceRow, sourceParent);
+    // the filter text is matched against the name only
+    const QRegExp regExp = filterRegExp();
+    return (regExp.isEmpty() || name.contains(regExp));
 }
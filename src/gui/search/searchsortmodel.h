@@ -31,6 +31,9 @@
 #include <QSortFilterProxyModel>
 #include <QStringList>
 
+class SearchResultModel;
+
+// Sorts and filters the rows of SearchResultModel, reading its typed columns directly
 class SearchSortModel final : public QSortFilterProxyModel
 {
     using base = QSortFilterProxyModel;
@@ -88,6 +91,8 @@ protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
 
 private:
+    const SearchResultModel *resultModel() const;
+
     bool m_isNameFilterEnabled;
     QString m_searchTerm;
     QStringList m_searchTermWords;
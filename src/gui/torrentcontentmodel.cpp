@@ -48,6 +48,8 @@
 #include <QPixmapCache>
 #endif
 
+#include <libtorrent/torrent_info.hpp>
+
 #include "base/bittorrent/downloadpriority.h"
 #include "base/bittorrent/torrentinfo.h"
 #include "base/global.h"
@@ -212,8 +214,7 @@ void TorrentContentModel::updateFilesProgress(const QVector<qreal> &fp)
     for (int i = 0; i < fp.size(); ++i)
         m_filesIndex[i]->setProgress(fp[i]);
     // Update folders progress in the tree
-    m_rootItem->recalculateProgress();
-    m_rootItem->recalculateAvailability();
+    updateFoldersProgress();
     emit dataChanged(index(0, 0), index((rowCount() - 1), (columnCount() - 1)));
 }
 
@@ -226,7 +227,9 @@ void TorrentContentModel::updateFilesPriorities(const QVector<BitTorrent::Downlo
 
     emit layoutAboutToBeChanged();
     for (int i = 0; i < fprio.size(); ++i)
-        m_filesIndex[i]->setPriority(static_cast<BitTorrent::DownloadPriority>(fprio[i]));
+        m_filesIndex[i]->setPriority(static_cast<BitTorrent::DownloadPriority>(fprio[i]), false);
+    // Update folders priority in the tree
+    updateFoldersPriority();
     emit dataChanged(index(0, 0), index((rowCount() - 1), (columnCount() - 1)));
 }
 
@@ -240,7 +243,7 @@ void TorrentContentModel::updateFilesAvailability(const QVector<qreal> &fa)
     for (int i = 0; i < m_filesIndex.size(); ++i)
         m_filesIndex[i]->setAvailability(fa[i]);
     // Update folders progress in the tree
-    m_rootItem->recalculateProgress();
+    updateFoldersProgress();
     emit dataChanged(index(0, 0), index((rowCount() - 1), (columnCount() - 1)));
 }
 
@@ -288,8 +291,7 @@ bool TorrentContentModel::setData(const QModelIndex &index, const QVariant &valu
 
             item->setPriority(prio);
             // Update folders progress in the tree
-            m_rootItem->recalculateProgress();
-            m_rootItem->recalculateAvailability();
+            updateFoldersProgress();
             emit dataChanged(this->index(0, 0), this->index((rowCount() - 1), (columnCount() - 1)));
             emit filteredFilesChanged();
         }
@@ -470,6 +472,7 @@ void TorrentContentModel::clear()
     qDebug("clear called");
     beginResetModel();
     m_filesIndex.clear();
+    m_foldersIndex.clear();
     m_rootItem->deleteAllChildren();
     endResetModel();
 }
@@ -486,36 +489,63 @@ void TorrentContentModel::setupModelData(const BitTorrent::TorrentInfo &info)
     qDebug("Torrent contains %d files", filesCount);
     m_filesIndex.reserve(filesCount);
 
-    TorrentContentModelFolder *currentParent;
+    const lt::file_storage &fileStorage = info.nativeInfo()->files();
+    // Files of the same folder usually go one after another,
+    // so the folder of the previous file is reused if it matches
+    QString currentFolderPath;
+    TorrentContentModelFolder *currentParent = m_rootItem;
     // Iterate over files
     for (int i = 0; i < filesCount; ++i)
     {
-        currentParent = m_rootItem;
-        const QString path = Utils::Fs::toUniformPath(info.filePath(i));
-
-        // Iterate of parts of the path to create necessary folders
-        QVector<QStringRef> pathFolders = path.splitRef('/', QString::SkipEmptyParts);
-        pathFolders.removeLast();
+        const lt::file_index_t fileIndex {i};
+        const QString path = Utils::Fs::toUniformPath(QString::fromStdString(fileStorage.file_path(fileIndex)));
+        const int fileNamePos = path.lastIndexOf('/') + 1;
+        const QStringRef folderPath = path.leftRef(fileNamePos);
 
-        for (const QStringRef &pathPartRef : asConst(pathFolders))
+        if (folderPath != currentFolderPath)
         {
-            const QString pathPart = pathPartRef.toString();
-            TorrentContentModelFolder *newParent = currentParent->childFolderWithName(pathPart);
-            if (!newParent)
+            currentParent = m_rootItem;
+            // Iterate of parts of the path to create necessary folders
+            for (const QStringRef &pathPartRef : folderPath.split('/', QString::SkipEmptyParts))
             {
-                newParent = new TorrentContentModelFolder(pathPart, currentParent);
-                currentParent->appendChild(newParent);
+                const QString pathPart = pathPartRef.toString();
+                TorrentContentModelFolder *newParent = currentParent->childFolderWithName(pathPart);
+                if (!newParent)
+                {
+                    newParent = new TorrentContentModelFolder(pathPart, currentParent);
+                    currentParent->appendChild(newParent);
+                    m_foldersIndex.push_back(newParent);
+                }
+                currentParent = newParent;
             }
-            currentParent = newParent;
+            currentFolderPath = folderPath.toString();
         }
+
         // Actually create the file
-        TorrentContentModelFile *fileItem = new TorrentContentModelFile(info.fileName(i), info.fileSize(i), currentParent, i);
+        TorrentContentModelFile *fileItem = new TorrentContentModelFile(path.mid(fileNamePos)
+            , fileStorage.file_size(fileIndex), currentParent, i);
         currentParent->appendChild(fileItem);
         m_filesIndex.push_back(fileItem);
     }
     emit layoutChanged();
 }
 
+void TorrentContentModel::updateFoldersProgress()
+{
+    // Single bottom-up pass, every folder is recalculated after all of its subfolders
+    for (auto i = m_foldersIndex.crbegin(); i != m_foldersIndex.crend(); ++i)
+    {
+        (*i)->recalculateProgress();
+        (*i)->recalculateAvailability();
+    }
+}
+
+void TorrentContentModel::updateFoldersPriority()
+{
+    for (auto i = m_foldersIndex.crbegin(); i != m_foldersIndex.crend(); ++i)
+        (*i)->updatePriority(false);
+}
+
 void TorrentContentModel::selectAll()
 {
     for (int i = 0; i < m_rootItem->childCount(); ++i)
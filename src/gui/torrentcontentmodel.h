@@ -84,7 +84,11 @@ public slots:
     void selectNone();
 
 private:
+    void updateFoldersProgress();
+    void updateFoldersPriority();
+
     TorrentContentModelFolder *m_rootItem;
     QVector<TorrentContentModelFile *> m_filesIndex;
+    QVector<TorrentContentModelFolder *> m_foldersIndex; // parent folders go before their subfolders
     QFileIconProvider *m_fileIconProvider;
 };
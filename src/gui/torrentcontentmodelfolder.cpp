@@ -65,6 +65,7 @@ void TorrentContentModelFolder::deleteAllChildren()
     Q_ASSERT(isRootItem());
     qDeleteAll(m_childItems);
     m_childItems.clear();
+    m_childFolders.clear();
 }
 
 const QVector<TorrentContentModelItem *> &TorrentContentModelFolder::children() const
@@ -75,10 +76,13 @@ const QVector<TorrentContentModelItem *> &TorrentContentModelFolder::children()
 void TorrentContentModelFolder::appendChild(TorrentContentModelItem *item)
 {
     Q_ASSERT(item);
+    item->m_row = m_childItems.size();
     m_childItems.append(item);
     // Update own size
     if (item->itemType() == FileType)
         increaseSize(item->size());
+    else
+        m_childFolders.insert(item->name(), static_cast<TorrentContentModelFolder *>(item));
 }
 
 TorrentContentModelItem *TorrentContentModelFolder::child(int row) const
@@ -88,12 +92,7 @@ TorrentContentModelItem *TorrentContentModelFolder::child(int row) const
 
 TorrentContentModelFolder *TorrentContentModelFolder::childFolderWithName(const QString &name) const
 {
-    for (TorrentContentModelItem *child : asConst(m_childItems))
-    {
-        if ((child->itemType() == FolderType) && (child->name() == name))
-            return static_cast<TorrentContentModelFolder *>(child);
-    }
-    return nullptr;
+    return m_childFolders.value(name, nullptr);
 }
 
 int TorrentContentModelFolder::childCount() const
@@ -102,7 +101,7 @@ int TorrentContentModelFolder::childCount() const
 }
 
 // Only non-root folders use this function
-void TorrentContentModelFolder::updatePriority()
+void TorrentContentModelFolder::updatePriority(const bool updateParent)
 {
     if (isRootItem())
         return;
@@ -117,13 +116,13 @@ void TorrentContentModelFolder::updatePriority()
     {
         if (m_childItems.at(i)->priority() != prio)
         {
-            setPriority(BitTorrent::DownloadPriority::Mixed);
+            setPriority(BitTorrent::DownloadPriority::Mixed, updateParent);
             return;
         }
     }
     // All child items have the same priority
     // Update own if necessary
-    setPriority(prio);
+    setPriority(prio, updateParent);
 }
 
 void TorrentContentModelFolder::setPriority(BitTorrent::DownloadPriority newPriority, bool updateParent)
@@ -153,8 +152,6 @@ void TorrentContentModelFolder::recalculateProgress()
         if (child->priority() == BitTorrent::DownloadPriority::Ignored)
             continue;
 
-        if (child->itemType() == FolderType)
-            static_cast<TorrentContentModelFolder *>(child)->recalculateProgress();
         tProgress += child->progress() * child->size();
         tSize += child->size();
         tRemaining += child->remaining();
@@ -178,8 +175,6 @@ void TorrentContentModelFolder::recalculateAvailability()
         if (child->priority() == BitTorrent::DownloadPriority::Ignored)
             continue;
 
-        if (child->itemType() == FolderType)
-            static_cast<TorrentContentModelFolder*>(child)->recalculateAvailability();
         const qreal childAvailability = child->availability();
         if (childAvailability >= 0)
         { // -1 means "no data"
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <QHash>
+
 #include "torrentcontentmodelitem.h"
 
 namespace BitTorrent
@@ -49,9 +51,11 @@ public:
     ItemType itemType() const override;
 
     void increaseSize(qulonglong delta);
+    // These use current values of the children, so the subfolders
+    // must be recalculated before their parent
     void recalculateProgress();
     void recalculateAvailability();
-    void updatePriority();
+    void updatePriority(bool updateParent = true);
 
     void setPriority(BitTorrent::DownloadPriority newPriority, bool updateParent = true) override;
 
@@ -64,4 +68,5 @@ public:
 
 private:
     QVector<TorrentContentModelItem*> m_childItems;
+    QHash<QString, TorrentContentModelFolder *> m_childFolders;
 };
@@ -42,6 +42,7 @@ TorrentContentModelItem::TorrentContentModelItem(TorrentContentModelFolder *pare
     , m_priority(BitTorrent::DownloadPriority::Normal)
     , m_progress(0)
     , m_availability(-1.)
+    , m_row(0)
 {
 }
 
@@ -177,9 +178,7 @@ QVariant TorrentContentModelItem::underlyingData(const int column) const
 
 int TorrentContentModelItem::row() const
 {
-    if (m_parentItem)
-        return m_parentItem->children().indexOf(const_cast<TorrentContentModelItem *>(this));
-    return 0;
+    return m_row;
 }
 
 TorrentContentModelFolder *TorrentContentModelItem::parent() const
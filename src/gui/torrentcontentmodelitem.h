@@ -84,6 +84,8 @@ public:
     int row() const;
 
 protected:
+    friend class TorrentContentModelFolder;
+
     TorrentContentModelFolder *m_parentItem;
     // Root item members
     QVector<QString> m_itemData;
@@ -94,4 +96,5 @@ protected:
     BitTorrent::DownloadPriority m_priority;
     qreal m_progress;
     qreal m_availability;
+    int m_row; // position in the parent folder, is set when the item is appended
 };
@@ -39,6 +39,7 @@
 #include "base/bittorrent/torrentinfo.h"
 #include "base/global.h"
 #include "base/utils/fs.h"
+#include "base/utils/misc.h"
 #include "ui_torrentcreatordialog.h"
 #include "utils.h"
 
@@ -80,6 +81,7 @@ TorrentCreatorDialog::TorrentCreatorDialog(QWidget *parent, const QString &defau
     connect(m_creatorThread, &BitTorrent::TorrentCreatorThread::creationSuccess, this, &TorrentCreatorDialog::handleCreationSuccess);
     connect(m_creatorThread, &BitTorrent::TorrentCreatorThread::creationFailure, this, &TorrentCreatorDialog::handleCreationFailure);
     connect(m_creatorThread, &BitTorrent::TorrentCreatorThread::updateProgress, this, &TorrentCreatorDialog::updateProgressBar);
+    connect(m_creatorThread, &BitTorrent::TorrentCreatorThread::updateHashingProgress, this, &TorrentCreatorDialog::updateHashingSpeed);
 
     loadSettings();
     updateInputPath(defaultPath);
@@ -261,6 +263,16 @@ void TorrentCreatorDialog::handleCreationSuccess(const QString &path, const QStr
 void TorrentCreatorDialog::updateProgressBar(int progress)
 {
     m_ui->progressBar->setValue(progress);
+    if ((progress == 0) || (progress == 100))
+        m_ui->progressBar->setFormat(QLatin1String("%p%"));
+}
+
+void TorrentCreatorDialog::updateHashingSpeed(qint64 hashedBytes, qint64 totalBytes, qint64 bytesPerSecond)
+{
+    // "%p%" is the percentage placeholder of QProgressBar
+    m_ui->progressBar->setFormat(tr("%p% (%1 of %2, %3)", "e.g: 50% (1.5 GiB of 3 GiB, 900 MiB/s)")
+        .arg(Utils::Misc::friendlyUnit(hashedBytes), Utils::Misc::friendlyUnit(totalBytes)
+            , Utils::Misc::friendlyUnit(bytesPerSecond, true)));
 }
 
 void TorrentCreatorDialog::updatePiecesCount()
@@ -52,6 +52,7 @@ public:
 
 private slots:
     void updateProgressBar(int progress);
+    void updateHashingSpeed(qint64 hashedBytes, qint64 totalBytes, qint64 bytesPerSecond);
     void updatePiecesCount();
     void onCreateButtonClicked();
     void onAddFileButtonClicked();
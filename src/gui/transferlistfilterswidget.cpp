@@ -47,6 +47,7 @@
 #include "base/net/downloadmanager.h"
 #include "base/preferences.h"
 #include "base/torrentfilter.h"
+#include "base/torrentstatuscounters.h"
 #include "base/utils/fs.h"
 #include "base/utils/string.h"
 #include "categoryfilterwidget.h"
@@ -173,24 +174,8 @@ void BaseFilterWidget::toggleFilter(bool checked)
 StatusFilterWidget::StatusFilterWidget(QWidget *parent, TransferListWidget *transferList)
     : BaseFilterWidget(parent, transferList)
 {
-    connect(BitTorrent::Session::instance(), &BitTorrent::Session::torrentAdded
-            , this, &StatusFilterWidget::updateTorrentNumbers);
-
-    connect(BitTorrent::Session::instance(), &BitTorrent::Session::torrentsUpdated
+    connect(TorrentStatusCounters::instance(), &TorrentStatusCounters::changed
             , this, &StatusFilterWidget::updateTorrentNumbers);
-    connect(BitTorrent::Session::instance(), &BitTorrent::Session::torrentAboutToBeRemoved
-            , this, &StatusFilterWidget::updateTorrentNumbers);
-
-
-    connect(BitTorrent::Session::instance(), &BitTorrent::Session::xdownAdded
-        , this, &StatusFilterWidget::updateTorrentNumbers);
-    connect(BitTorrent::Session::instance(), &BitTorrent::Session::xdownUpdated
-        , this, &StatusFilterWidget::updateTorrentNumbers);
-    connect(BitTorrent::Session::instance(), &BitTorrent::Session::xdownAboutToBeRemoved
-        , this, &StatusFilterWidget::updateTorrentNumbers);
-
-    connect(BitTorrent::Session::instance(), &BitTorrent::Session::onUpdateTorrentNumbers
-        , this, &StatusFilterWidget::updateTorrentNumbers);
 
     // Add status filters
     auto *all = new QListWidgetItem(this);
@@ -238,6 +223,8 @@ StatusFilterWidget::StatusFilterWidget(QWidget *parent, TransferListWidget *tran
     const Preferences *const pref = Preferences::instance();
     setCurrentRow(pref->getTransSelFilter(), QItemSelectionModel::SelectCurrent);
     toggleFilter(pref->getStatusFilterState());
+
+    updateTorrentNumbers();
 }
 
 StatusFilterWidget::~StatusFilterWidget()
@@ -247,95 +234,23 @@ StatusFilterWidget::~StatusFilterWidget()
 
 void StatusFilterWidget::updateTorrentNumbers()
 {
-    ////////////////**************************////////////////
-    ////////////////***** ˢƵ *******////////////////
-    ////////////////**************************////////////////
-    qint64 curTick = QDateTime::currentMSecsSinceEpoch();
-    if (curTick - m_statUpdateTick < 800)
-    {
-        return;
-    }
-    m_statUpdateTick = curTick;
-
-#if 0
-    const QVector<BitTorrent::TorrentHandle *> torrents = BitTorrent::Session::instance()->torrents();
-    const QVector<BitTorrent::TorrentHandle *> xdowns = BitTorrent::Session::instance()->xdowns();
-    int iTotalValue = torrents.count() + xdowns.count();
-    for (const BitTorrent::TorrentHandle *torrent : torrents) {
-        if (torrent->isDownloading())
-            ++nbDownloading;
-        if (torrent->isUploading())
-            ++nbSeeding;
-        if (torrent->isCompleted())
-            ++nbCompleted;
-        if (torrent->isResumed())
-            ++nbResumed;
-        if (torrent->isPaused())
-            ++nbPaused;
-        if (torrent->isActive())
-            ++nbActive;
-        if (torrent->isInactive())
-            ++nbInactive;
-        if (torrent->state() ==  BitTorrent::TorrentState::StalledUploading)
-            ++nbStalledUploading;
-        if (torrent->state() ==  BitTorrent::TorrentState::StalledDownloading)
-            ++nbStalledDownloading;
-        if (torrent->isErrored())
-            ++nbErrored;
-    }
-
-    for (const BitTorrent::TorrentHandle *torrent : xdowns) {
-        if (torrent->isDownloading()) {
-            ++nbDownloading;
-            continue;
-        }
-        if (torrent->isCompleted()) {
-            ++nbCompleted;
-            continue;
-        }
-        if (torrent->isPaused()) {
-            ++nbPaused;
-            continue;
-        }
-        if (torrent->isErrored()) {
-            ++nbErrored;
-        }
-    }
-#endif
+    const TorrentStatusCounters::Snapshot stat = TorrentStatusCounters::instance()->snapshot();
 
-    StatusStatistics stat;
-    BitTorrent::Session::instance()->ShowStatusStatistics(stat);
-    int nbDownloading = stat.nbDownloading;
-    int nbSeeding = stat.nbSeeding;
-    int nbCompleted = stat.nbCompleted;
-    int nbResumed = stat.nbResumed;
-    int nbPaused = stat.nbPaused;
-    int nbActive = stat.nbActive;
-    int nbInactive = stat.nbInactive;
-    int nbStalled = 0;
-    int nbStalledUploading = stat.nbStalledUploading;
-    int nbStalledDownloading = stat.nbStalledDownloading;
-    int nbErrored = stat.nbErrored;
-    int iTotalValue = stat.nbTotalSize;
-    nbStalled = nbStalledUploading + nbStalledDownloading;
-    // ȫ
-    item(TorrentFilter::All)->setData(Qt::DisplayRole, tr("All (%1)").arg(iTotalValue));
-    // 
-    item(TorrentFilter::Downloading)->setData(Qt::DisplayRole, tr("Downloading (%1)").arg(nbDownloading));
+    item(TorrentFilter::All)->setData(Qt::DisplayRole, tr("All (%1)").arg(stat.count(TorrentFilter::All)));
+    item(TorrentFilter::Downloading)->setData(Qt::DisplayRole, tr("Downloading (%1)").arg(stat.count(TorrentFilter::Downloading)));
 #ifdef __ENABLE_ALL_STATUS__
-    item(TorrentFilter::Seeding)->setData(Qt::DisplayRole, tr("Seeding (%1)").arg(nbSeeding));
+    item(TorrentFilter::Seeding)->setData(Qt::DisplayRole, tr("Seeding (%1)").arg(stat.count(TorrentFilter::Seeding)));
 #endif
-    // 
-    item(TorrentFilter::Completed)->setData(Qt::DisplayRole, tr("Completed (%1)").arg(nbCompleted));
+    item(TorrentFilter::Completed)->setData(Qt::DisplayRole, tr("Completed (%1)").arg(stat.count(TorrentFilter::Completed)));
 #ifdef __ENABLE_ALL_STATUS__
-    item(TorrentFilter::Resumed)->setData(Qt::DisplayRole, tr("Resumed (%1)").arg(nbResumed));
-    item(TorrentFilter::Paused)->setData(Qt::DisplayRole, tr("Paused (%1)").arg(nbPaused));
-    item(TorrentFilter::Active)->setData(Qt::DisplayRole, tr("Active (%1)").arg(nbActive));
-    item(TorrentFilter::Inactive)->setData(Qt::DisplayRole, tr("Inactive (%1)").arg(nbInactive));
-    item(TorrentFilter::Stalled)->setData(Qt::DisplayRole, tr("Stalled (%1)").arg(nbStalled));
-    item(TorrentFilter::StalledUploading)->setData(Qt::DisplayRole, tr("Stalled Uploading (%1)").arg(nbStalledUploading));
-    item(TorrentFilter::StalledDownloading)->setData(Qt::DisplayRole, tr("Stalled Downloading (%1)").arg(nbStalledDownloading));
-    item(TorrentFilter::Errored)->setData(Qt::DisplayRole, tr("Errored (%1)").arg(nbErrored));
+    item(TorrentFilter::Resumed)->setData(Qt::DisplayRole, tr("Resumed (%1)").arg(stat.count(TorrentFilter::Resumed)));
+    item(TorrentFilter::Paused)->setData(Qt::DisplayRole, tr("Paused (%1)").arg(stat.count(TorrentFilter::Paused)));
+    item(TorrentFilter::Active)->setData(Qt::DisplayRole, tr("Active (%1)").arg(stat.count(TorrentFilter::Active)));
+    item(TorrentFilter::Inactive)->setData(Qt::DisplayRole, tr("Inactive (%1)").arg(stat.count(TorrentFilter::Inactive)));
+    item(TorrentFilter::Stalled)->setData(Qt::DisplayRole, tr("Stalled (%1)").arg(stat.count(TorrentFilter::Stalled)));
+    item(TorrentFilter::StalledUploading)->setData(Qt::DisplayRole, tr("Stalled Uploading (%1)").arg(stat.count(TorrentFilter::StalledUploading)));
+    item(TorrentFilter::StalledDownloading)->setData(Qt::DisplayRole, tr("Stalled Downloading (%1)").arg(stat.count(TorrentFilter::StalledDownloading)));
+    item(TorrentFilter::Errored)->setData(Qt::DisplayRole, tr("Errored (%1)").arg(stat.count(TorrentFilter::Errored)));
 #endif
 }
 
@@ -569,7 +484,7 @@ void TrackerFiltersList::downloadFavicon(const QString &url)
 {
     if (!m_downloadTrackerFavicon) return;
     Net::DownloadManager::instance()->download(
-                Net::DownloadRequest(url).saveToFile(true)
+                Net::DownloadRequest(url).saveToFile(true).useCache(true)
                 , this, &TrackerFiltersList::handleFavicoDownloadFinished);
 }
 
@@ -92,9 +92,6 @@ private:
     void applyFilter(int row) override;
     void handleNewTorrent(BitTorrent::TorrentHandle *const) override;
     void torrentAboutToBeDeleted(BitTorrent::TorrentHandle *const) override;
-
-    qint64 m_statUpdateTick = 0;
-
 };
 
 class TrackerFiltersList final : public BaseFilterWidget
@@ -34,6 +34,7 @@
 #include <QDebug>
 #include <QIcon>
 #include <QPalette>
+#include <QTimer>
 
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
@@ -149,7 +150,12 @@ TransferListModel::TransferListModel(QObject *parent)
     , m_stateThemeColors {torrentStateColorsFromUITheme()}
 {
     configure();
-    connect(Preferences::instance(), &Preferences::changed, this, &TransferListModel::configure);
+    connect(Preferences::instance(), &Preferences::changed, this, [this](const Preferences::Keys changedKeys)
+    {
+        if (changedKeys.testFlag(Preferences::Key::HideZeroValues)
+            || changedKeys.testFlag(Preferences::Key::HideZeroComboValues))
+            configure();
+    });
 
     // Load the torrents
     using namespace BitTorrent;
@@ -161,6 +167,7 @@ TransferListModel::TransferListModel(QObject *parent)
     for (TorrentHandle *const torrent : asConst(Session::instance()->xdowns())) {
         addXDown(torrent);
     }
+    flushPendingChanges();
 
     // Listen for torrent changes
     connect(Session::instance(), &Session::torrentLoaded, this, &TransferListModel::addTorrent);
@@ -615,12 +622,8 @@ void TransferListModel::addTorrent(BitTorrent::TorrentHandle *const torrent)
 {
     Q_ASSERT(!m_torrentMap.contains(torrent));
 
-    const int row = m_torrentList.size();
-
-    beginInsertRows({}, row, row);
-    m_torrentList << torrent;
-    m_torrentMap[torrent] = row;
-    endInsertRows();
+    m_pendingTorrents << torrent;
+    scheduleFlush();
 }
 
 
@@ -629,14 +632,7 @@ void TransferListModel::addTorrent(BitTorrent::TorrentHandle *const torrent)
 
 void TransferListModel::addXDown(BitTorrent::TorrentHandle *const xdownItem)
 {
-    Q_ASSERT(!m_torrentMap.contains(xdownItem));
-
-    const int row = m_torrentList.size();
-
-    beginInsertRows({}, row, row);
-    m_torrentList << xdownItem;
-    m_torrentMap[xdownItem] = row;
-    endInsertRows();
+    addTorrent(xdownItem);
 }
 
 Qt::ItemFlags TransferListModel::flags(const QModelIndex &index) const
@@ -657,39 +653,81 @@ BitTorrent::TorrentHandle *TransferListModel::torrentHandle(const QModelIndex &i
 void TransferListModel::handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent)
 {
     const int row = m_torrentMap.value(torrent, -1);
-    Q_ASSERT(row >= 0);
+    if (row < 0)
+    {
+        const bool isPending = m_pendingTorrents.removeOne(torrent);
+        Q_ASSERT(isPending);
+        Q_UNUSED(isPending);
+        return;
+    }
 
-    beginRemoveRows({}, row, row);
-    m_torrentList.removeAt(row);
+    m_torrentList[row] = nullptr;
     m_torrentMap.remove(torrent);
-    for (int &value : m_torrentMap) {
-        if (value > row)
-            --value;
-    }
-    endRemoveRows();
+    ++m_removedCount;
+    scheduleFlush();
 }
 
 ///////xxxxxxx///
 
 void TransferListModel::handleXDownAboutToBeRemoved(BitTorrent::TorrentHandle *const xdownItem)
 {
-    const int row = m_torrentMap.value(xdownItem, -1);
-    Q_ASSERT(row >= 0);
-
-    beginRemoveRows({}, row, row);
-    m_torrentList.removeAt(row);
-    m_torrentMap.remove(xdownItem);
-    for (int &value : m_torrentMap) {
-        if (value > row)
-            --value;
+    handleTorrentAboutToBeRemoved(xdownItem);
+}
+
+void TransferListModel::scheduleFlush()
+{
+    if (m_isFlushScheduled) return;
+
+    m_isFlushScheduled = true;
+    QTimer::singleShot(0, this, &TransferListModel::flushPendingChanges);
+}
+
+void TransferListModel::flushPendingChanges()
+{
+    m_isFlushScheduled = false;
+
+    if (m_removedCount > 0)
+    {
+        // drop the ranges of removed rows starting from the last one,
+        // so the rows that precede a range keep their numbers
+        for (int row = (m_torrentList.size() - 1); row >= 0; --row)
+        {
+            if (m_torrentList[row]) continue;
+
+            const int last = row;
+            while ((row > 0) && !m_torrentList[row - 1])
+                --row;
+
+            beginRemoveRows({}, row, last);
+            m_torrentList.erase((m_torrentList.begin() + row), (m_torrentList.begin() + last + 1));
+            endRemoveRows();
+        }
+        m_removedCount = 0;
+
+        for (int row = 0; row < m_torrentList.size(); ++row)
+            m_torrentMap[m_torrentList[row]] = row;
+    }
+
+    if (!m_pendingTorrents.isEmpty())
+    {
+        const int first = m_torrentList.size();
+
+        beginInsertRows({}, first, (first + m_pendingTorrents.size() - 1));
+        m_torrentList.reserve(first + m_pendingTorrents.size());
+        for (BitTorrent::TorrentHandle *const torrent : asConst(m_pendingTorrents))
+        {
+            m_torrentMap[torrent] = m_torrentList.size();
+            m_torrentList << torrent;
+        }
+        m_pendingTorrents.clear();
+        endInsertRows();
     }
-    endRemoveRows();
 }
 
 void TransferListModel::handleTorrentStatusUpdated(BitTorrent::TorrentHandle *const torrent)
 {
     const int row = m_torrentMap.value(torrent, -1);
-    Q_ASSERT(row >= 0);
+    if (row < 0) return;  // not inserted yet
 
     emit dataChanged(index(row, 0), index(row, columnCount() - 1));
 }
@@ -697,7 +735,7 @@ void TransferListModel::handleTorrentStatusUpdated(BitTorrent::TorrentHandle *co
 void TransferListModel::handleXDownStatusUpdated(BitTorrent::TorrentHandle *const xdownItem)
 {
     const int row = m_torrentMap.value(xdownItem, -1);
-    Q_ASSERT(row >= 0);
+    if (row < 0) return;  // not inserted yet
 
     emit dataChanged(index(row, 0), index(row, columnCount() - 1));
 }
@@ -711,7 +749,7 @@ void TransferListModel::handleTorrentsUpdated(const QVector<BitTorrent::TorrentH
         for (BitTorrent::TorrentHandle *const torrent : torrents)
         {
             const int row = m_torrentMap.value(torrent, -1);
-            Q_ASSERT(row >= 0);
+            if (row < 0) continue;  // not inserted yet
 
             emit dataChanged(index(row, 0), index(row, columns));
         }
@@ -725,12 +763,12 @@ void TransferListModel::handleTorrentsUpdated(const QVector<BitTorrent::TorrentH
 
 void TransferListModel::configure()
 {
-    const Preferences *pref = Preferences::instance();
+    const Preferences::Snapshot &pref = Preferences::instance()->snapshot();
 
     HideZeroValuesMode hideZeroValuesMode = HideZeroValuesMode::Never;
-    if (pref->getHideZeroValues())
+    if (pref.hideZeroValues)
     {
-        if (pref->getHideZeroComboValues() == 1)
+        if (pref.hideZeroComboValues == 1)
             hideZeroValuesMode = HideZeroValuesMode::Paused;
         else
             hideZeroValuesMode = HideZeroValuesMode::Always;
@@ -33,6 +33,7 @@
 #include <QColor>
 #include <QHash>
 #include <QList>
+#include <QVector>
 
 #include "base/bittorrent/torrenthandle.h"
 
@@ -126,8 +127,17 @@ private:
     QString displayValue(const BitTorrent::TorrentHandle *torrent, int column) const;
     QVariant internalValue(const BitTorrent::TorrentHandle *torrent, int column, bool alt = false) const;
 
+    void scheduleFlush();
+    void flushPendingChanges();
+
+    // Rows of removed torrents are set to null and dropped later together with the
+    // other rows removed at the same time, so that bulk removal doesn't renumber
+    // the rows for every single torrent. Added torrents are inserted in one batch too.
     QList<BitTorrent::TorrentHandle *> m_torrentList;  // maps row number to torrent handle
     QHash<BitTorrent::TorrentHandle *, int> m_torrentMap;  // maps torrent handle to row number
+    QVector<BitTorrent::TorrentHandle *> m_pendingTorrents;  // added but not inserted yet
+    int m_removedCount = 0;
+    bool m_isFlushScheduled = false;
     const QHash<BitTorrent::TorrentState, QString> m_statusStrings;
     // row text colors
     const QHash<BitTorrent::TorrentState, QColor> m_stateThemeColors;
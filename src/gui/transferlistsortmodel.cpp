@@ -112,9 +112,12 @@ bool TransferListSortModel::lessThan_impl(const QModelIndex &left, const QModelI
     const auto hashLessThan = [this, &left, &right]() -> bool
     {
         const TransferListModel *model = qobject_cast<TransferListModel *>(sourceModel());
-        const BitTorrent::InfoHash hashL = model->torrentHandle(left)->hash();
-        const BitTorrent::InfoHash hashR = model->torrentHandle(right)->hash();
-        return hashL < hashR;
+        const BitTorrent::TorrentHandle *torrentL = model->torrentHandle(left);
+        const BitTorrent::TorrentHandle *torrentR = model->torrentHandle(right);
+        // rows of removed torrents are kept until the model drops them
+        if (!torrentL || !torrentR)
+            return (torrentR != nullptr);
+        return torrentL->hash() < torrentR->hash();
     };
 
     const int sortColumn = left.column();
@@ -372,6 +372,8 @@ QVector<BitTorrent::TorrentHandle *> TransferListWidget::getSelectedTorrents(Bit
     torrents.reserve(selectedRows.size());
     for (const QModelIndex &index : selectedRows) {
         BitTorrent::TorrentHandle *pHandle = m_listModel->torrentHandle(mapToSource(index));
+        if (!pHandle) continue;  // the row is about to be removed
+
         if (BitTorrent::SelectTaskHandleType::Select_All_Handle == iValueType) {
             torrents << pHandle;
         }
@@ -394,7 +396,11 @@ QVector<BitTorrent::TorrentHandle *> TransferListWidget::getVisibleTorrents() co
     QVector<BitTorrent::TorrentHandle *> torrents;
     torrents.reserve(visibleTorrentsCount);
     for (int i = 0; i < visibleTorrentsCount; ++i)
-        torrents << m_listModel->torrentHandle(mapToSource(m_sortFilterModel->index(i, 0)));
+    {
+        BitTorrent::TorrentHandle *const torrent = m_listModel->torrentHandle(mapToSource(m_sortFilterModel->index(i, 0)));
+        if (torrent)
+            torrents << torrent;
+    }
     return torrents;
 }
 
@@ -984,8 +990,8 @@ void TransferListWidget::applyToSelectedTorrents(const std::function<void (BitTo
     for (const QModelIndex &index : asConst(selectionModel()->selectedRows()))
     {
         BitTorrent::TorrentHandle *const torrent = m_listModel->torrentHandle(mapToSource(index));
-        Q_ASSERT(torrent);
-        fn(torrent);
+        if (torrent)
+            fn(torrent);
     }
 }
 
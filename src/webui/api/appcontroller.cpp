@@ -45,6 +45,7 @@
 
 #include "base/bittorrent/session.h"
 #include "base/global.h"
+#include "base/net/downloadmanager.h"
 #include "base/net/portforwarder.h"
 #include "base/net/proxyconfigurationmanager.h"
 #include "base/preferences.h"
@@ -277,6 +278,8 @@ void AppController::preferencesAction()
     data["current_interface_address"] = BitTorrent::Session::instance()->networkInterfaceAddress();
     // Save resume data interval
     data["save_resume_data_interval"] = session->saveResumeDataInterval();
+    // Resume data journal
+    data["resume_data_journal"] = pref->isResumeDataJournalEnabled();
     // Recheck completed torrents
     data["recheck_completed_torrents"] = pref->recheckTorrentsOnCompletion();
     // Resolve peer countries
@@ -723,6 +726,9 @@ void AppController::setPreferencesAction()
     // Save resume data interval
     if (hasKey("save_resume_data_interval"))
         session->setSaveResumeDataInterval(it.value().toInt());
+    // Resume data journal
+    if (hasKey("resume_data_journal"))
+        pref->setResumeDataJournalEnabled(it.value().toBool());
     // Recheck completed torrents
     if (hasKey("recheck_completed_torrents"))
         pref->recheckTorrentsOnCompletion(it.value().toBool());
@@ -882,3 +888,15 @@ void AppController::networkInterfaceAddressListAction()
 
     setResult(addressList);
 }
+
+// Returns the statistics of the HTTP cache used for RSS feeds, icons etc.
+void AppController::httpCacheStatsAction()
+{
+    const Net::HttpCacheStatistics stats = Net::DownloadManager::instance()->cacheStatistics();
+    setResult(QJsonObject {
+        {"hits", stats.hits},
+        {"misses", stats.misses},
+        {"saved_bytes", stats.savedBytes},
+        {"entries", stats.entries}
+    });
+}
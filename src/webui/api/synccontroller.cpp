@@ -34,20 +34,19 @@
 #include <QMetaObject>
 #include <QThread>
 
-#include "base/bittorrent/infohash.h"
 #include "base/bittorrent/peeraddress.h"
 #include "base/bittorrent/peerinfo.h"
 #include "base/bittorrent/session.h"
 #include "base/bittorrent/torrenthandle.h"
-#include "base/bittorrent/trackerentry.h"
 #include "base/global.h"
 #include "base/net/geoipmanager.h"
 #include "base/preferences.h"
+#include "base/torrentstatuscounters.h"
 #include "base/utils/string.h"
 #include "apierror.h"
 #include "freediskspacechecker.h"
 #include "isessionmanager.h"
-#include "serialize/serialize_torrent.h"
+#include "syncrevisionlog.h"
 
 namespace
 {
@@ -56,6 +55,7 @@ namespace
     // Sync main data keys
     const char KEY_SYNC_MAINDATA_QUEUEING[] = "queueing";
     const char KEY_SYNC_MAINDATA_REFRESH_INTERVAL[] = "refresh_interval";
+    const char KEY_SYNC_MAINDATA_STATUS_COUNTS[] = "status_counts";
     const char KEY_SYNC_MAINDATA_USE_ALT_SPEED_LIMITS[] = "use_alt_speed_limits";
 
     // Sync torrent peers keys
@@ -160,6 +160,28 @@ namespace
         return map;
     }
 
+    QVariantMap getStatusCounts()
+    {
+        const TorrentStatusCounters::Snapshot stat = TorrentStatusCounters::instance()->snapshot();
+
+        QVariantMap map;
+        map[QLatin1String("all")] = stat.count(TorrentFilter::All);
+        map[QLatin1String("downloading")] = stat.count(TorrentFilter::Downloading);
+        map[QLatin1String("completed")] = stat.count(TorrentFilter::Completed);
+#ifdef __ENABLE_ALL_STATUS__
+        map[QLatin1String("seeding")] = stat.count(TorrentFilter::Seeding);
+        map[QLatin1String("resumed")] = stat.count(TorrentFilter::Resumed);
+        map[QLatin1String("paused")] = stat.count(TorrentFilter::Paused);
+        map[QLatin1String("active")] = stat.count(TorrentFilter::Active);
+        map[QLatin1String("inactive")] = stat.count(TorrentFilter::Inactive);
+        map[QLatin1String("stalled")] = stat.count(TorrentFilter::Stalled);
+        map[QLatin1String("stalled_uploading")] = stat.count(TorrentFilter::StalledUploading);
+        map[QLatin1String("stalled_downloading")] = stat.count(TorrentFilter::StalledDownloading);
+        map[QLatin1String("errored")] = stat.count(TorrentFilter::Errored);
+#endif
+        return map;
+    }
+
     // Compare two structures (prevData, data) and calculate difference (syncData).
     // Structures encoded as map.
     void processMap(const QVariantMap &prevData, const QVariantMap &data, QVariantMap &syncData)
@@ -369,6 +391,7 @@ namespace
 
 SyncController::SyncController(ISessionManager *sessionManager, QObject *parent)
     : APIController(sessionManager, parent)
+    , m_revisionLog {new SyncRevisionLog(this)}
 {
     m_freeDiskSpaceThread = new QThread(this);
     m_freeDiskSpaceChecker = new FreeDiskSpaceChecker();
@@ -448,101 +471,22 @@ SyncController::~SyncController()
 //  - "queueing": queue system usage flag
 //  - "refresh_interval": torrents table refresh interval
 //  - "free_space_on_disk": Free space on the default save path
+//  - "status_counts": number of tasks matching each status filter, by filter name
 // GET param:
-//   - rid (int): last response id
+//   - rid (int): last response id (revision of the sync data the client has)
 void SyncController::maindataAction()
 {
     const auto *session = BitTorrent::Session::instance();
 
-    QVariantMap data;
-
-    QVariantMap lastResponse = sessionManager()->session()->getData(QLatin1String("syncMainDataLastResponse")).toMap();
-    QVariantMap lastAcceptedResponse = sessionManager()->session()->getData(QLatin1String("syncMainDataLastAcceptedResponse")).toMap();
-
-    QVariantHash torrents;
-    QHash<QString, QStringList> trackers;
-    int iLimitSize = 4000;
-    for (const BitTorrent::TorrentHandle *torrent : asConst(session->torrents(iLimitSize)))
-    {
-        const BitTorrent::InfoHash torrentHash = torrent->hash();
-
-        QVariantMap map = serialize(*torrent);
-        map.remove(KEY_TORRENT_HASH);
-
-        // Calculated last activity time can differ from actual value by up to 10 seconds (this is a libtorrent issue).
-        // So we don't need unnecessary updates of last activity time in response.
-        const auto iterTorrents = lastResponse.find("torrents");
-        if (iterTorrents != lastResponse.end())
-        {
-            const QVariantHash lastResponseTorrents = iterTorrents->toHash();
-            const auto iterHash = lastResponseTorrents.find(torrentHash);
-
-            if (iterHash != lastResponseTorrents.end())
-            {
-                const QVariantMap torrentData = iterHash->toMap();
-                const auto iterLastActivity = torrentData.find(KEY_TORRENT_LAST_ACTIVITY_TIME);
-
-                if (iterLastActivity != torrentData.end())
-                {
-                    const int lastValue = iterLastActivity->toInt();
-                    if (qAbs(lastValue - map[KEY_TORRENT_LAST_ACTIVITY_TIME].toInt()) < 15)
-                        map[KEY_TORRENT_LAST_ACTIVITY_TIME] = lastValue;
-                }
-            }
-        }
-
-        for (const BitTorrent::TrackerEntry &tracker : asConst(torrent->trackers()))
-            trackers[tracker.url()] << torrentHash;
-
-        torrents[torrentHash] = map;
-    }
-    
-
-    for (const BitTorrent::TorrentHandle *torrent : asConst(session->xdowns())) {
-        QString strItemHash = torrent->getItemHash();
-
-        QVariantMap map = serialize(*torrent);
-        map.remove(KEY_TORRENT_HASH);
-
-        // Calculated last activity time can differ from actual value by up to 10 seconds (this is a libtorrent issue).
-        // So we don't need unnecessary updates of last activity time in response.
-        const auto iterTorrents = lastResponse.find("torrents");
-        if (iterTorrents != lastResponse.end()) {
-            const QVariantHash lastResponseTorrents = iterTorrents->toHash();
-            const auto iterUrl = lastResponseTorrents.find(strItemHash);
-
-            if (iterUrl != lastResponseTorrents.end()) {
-                const QVariantMap torrentData = iterUrl->toMap();
-                const auto iterLastActivity = torrentData.find(KEY_TORRENT_LAST_ACTIVITY_TIME);
-
-                if (iterLastActivity != torrentData.end()) {
-                    const int lastValue = iterLastActivity->toInt();
-                    if (qAbs(lastValue - map[KEY_TORRENT_LAST_ACTIVITY_TIME].toInt()) < 15)
-                        map[KEY_TORRENT_LAST_ACTIVITY_TIME] = lastValue;
-                }
-            }
-        }
-        torrents[strItemHash] = map;
-    }
-    data["torrents"] = torrents;
-
-
-    QVariantHash trackersHash;
-
-    data["trackers"] = trackersHash;
-
     QVariantMap serverState = getTransferInfo();
     serverState[KEY_TRANSFER_FREESPACEONDISK] = getFreeDiskSpace();
     serverState[KEY_SYNC_MAINDATA_QUEUEING] = session->isQueueingSystemEnabled();
     serverState[KEY_SYNC_MAINDATA_USE_ALT_SPEED_LIMITS] = session->isAltGlobalSpeedLimitEnabled();
     serverState[KEY_SYNC_MAINDATA_REFRESH_INTERVAL] = session->refreshInterval();
-    data["server_state"] = serverState;
+    serverState[KEY_SYNC_MAINDATA_STATUS_COUNTS] = getStatusCounts();
 
     const int acceptedResponseId {params()["rid"].toInt()};
-    setResult(QJsonObject::fromVariantMap(generateSyncData(acceptedResponseId, data, lastAcceptedResponse, lastResponse)));
-
-    sessionManager()->session()->setData(QLatin1String("syncMainDataLastResponse"), lastResponse);
-    sessionManager()->session()->setData(QLatin1String("syncMainDataLastAcceptedResponse"), lastAcceptedResponse);
+    setResult(QJsonObject::fromVariantMap(m_revisionLog->syncData(acceptedResponseId, serverState)));
 }
 
 // GET param:
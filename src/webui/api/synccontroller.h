@@ -37,6 +37,7 @@ struct ISessionManager;
 class QThread;
 
 class FreeDiskSpaceChecker;
+class SyncRevisionLog;
 
 class SyncController : public APIController
 {
@@ -58,6 +59,8 @@ private:
     qint64 getFreeDiskSpace();
     void invokeChecker() const;
 
+    SyncRevisionLog *m_revisionLog = nullptr;
+
     qint64 m_freeDiskSpace = 0;
     FreeDiskSpaceChecker *m_freeDiskSpaceChecker = nullptr;
     QThread *m_freeDiskSpaceThread = nullptr;
@@ -0,0 +1,181 @@
+#include "syncrevisionlog.h"
+
+#include "base/bittorrent/session.h"
+#include "base/bittorrent/torrenthandle.h"
+#include "base/global.h"
+#include "serialize/serialize_torrent.h"
+#include "torrentchangetracker.h"
+
+namespace
+{
+    // Removed items are remembered until there are too many of them,
+    // clients that are older than the forgotten ones get a full update
+    const int MAX_REMOVED_ITEMS = 10000;
+
+    const char KEY_FULL_UPDATE[] = "full_update";
+    const char KEY_RESPONSE_ID[] = "rid";
+    const char KEY_SERVER_STATE[] = "server_state";
+    const char KEY_TORRENTS[] = "torrents";
+    const char KEY_TORRENTS_REMOVED[] = "torrents_removed";
+    const char KEY_TRACKERS[] = "trackers";
+
+    QVariantMap changedFields(const QVariantMap &data, const QHash<QString, int> &fieldRevisions, const int acceptedRevision)
+    {
+        QVariantMap changes;
+        for (auto i = fieldRevisions.cbegin(); i != fieldRevisions.cend(); ++i)
+        {
+            if (i.value() > acceptedRevision)
+                changes[i.key()] = data.value(i.key());
+        }
+        return changes;
+    }
+}
+
+SyncRevisionLog::SyncRevisionLog(QObject *parent)
+    : QObject {parent}
+    , m_changeTracker {new TorrentChangeTracker(this)}
+{
+    using BitTorrent::Session;
+
+    for (BitTorrent::TorrentHandle *const torrent : asConst(Session::instance()->torrents()))
+        m_changeTracker->markDirty(torrent);
+    for (BitTorrent::TorrentHandle *const torrent : asConst(Session::instance()->xdowns()))
+        m_changeTracker->markDirty(torrent);
+
+    connect(m_changeTracker, &TorrentChangeTracker::torrentAboutToBeRemoved, this, &SyncRevisionLog::handleTorrentAboutToBeRemoved);
+}
+
+int SyncRevisionLog::revision() const
+{
+    return m_revision;
+}
+
+QVariantMap SyncRevisionLog::syncData(const int acceptedRevision, const QVariantMap &serverState)
+{
+    flush(serverState);
+
+    QVariantMap syncData;
+    QVariantHash torrents;
+
+    const bool fullUpdate = (acceptedRevision < m_oldestRevision) || (acceptedRevision > m_revision);
+    if (fullUpdate)
+    {
+        for (auto i = m_items.cbegin(); i != m_items.cend(); ++i)
+            torrents[i.key()] = i->data;
+
+        syncData[KEY_TORRENTS] = torrents;
+        syncData[KEY_TRACKERS] = QVariantHash {};
+        syncData[KEY_SERVER_STATE] = m_serverState.data;
+        syncData[KEY_FULL_UPDATE] = true;
+    }
+    else
+    {
+        for (auto i = m_items.cbegin(); i != m_items.cend(); ++i)
+        {
+            if (i->revision > acceptedRevision)
+                torrents[i.key()] = changedFields(i->data, i->fieldRevisions, acceptedRevision);
+        }
+        if (!torrents.isEmpty())
+            syncData[KEY_TORRENTS] = torrents;
+
+        QVariantList removedItems;
+        for (auto i = m_removals.crbegin(); (i != m_removals.crend()) && (i->revision > acceptedRevision); ++i)
+            removedItems << i->key;
+        if (!removedItems.isEmpty())
+            syncData[KEY_TORRENTS_REMOVED] = removedItems;
+
+        if (m_serverState.revision > acceptedRevision)
+            syncData[KEY_SERVER_STATE] = changedFields(m_serverState.data, m_serverState.fieldRevisions, acceptedRevision);
+    }
+
+    syncData[KEY_RESPONSE_ID] = m_revision;
+    return syncData;
+}
+
+void SyncRevisionLog::handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent)
+{
+    const QString key = TorrentChangeTracker::itemKey(torrent);
+    if (m_items.remove(key) == 0)
+        return;
+
+    ++m_revision;
+    m_removals.append({m_revision, key});
+    pruneRemovals();
+}
+
+bool SyncRevisionLog::updateItem(Item &item, const QVariantMap &data, const int revision)
+{
+    bool changed = false;
+    for (auto i = data.cbegin(); i != data.cend(); ++i)
+    {
+        const auto prevValue = item.data.constFind(i.key());
+        if (prevValue != item.data.cend())
+        {
+            if (*prevValue == i.value())
+                continue;
+
+            // Calculated last activity time can differ from actual value by up to 10 seconds (this is a libtorrent issue).
+            // So we don't need unnecessary updates of last activity time in response.
+            if ((i.key() == QLatin1String(KEY_TORRENT_LAST_ACTIVITY_TIME))
+                && (qAbs(prevValue->toLongLong() - i.value().toLongLong()) < 15))
+                continue;
+        }
+
+        item.data[i.key()] = i.value();
+        item.fieldRevisions[i.key()] = revision;
+        changed = true;
+    }
+
+    if (changed)
+        item.revision = revision;
+    return changed;
+}
+
+void SyncRevisionLog::flush(const QVariantMap &serverState)
+{
+    const int newRevision = m_revision + 1;
+    bool changed = updateItem(m_serverState, serverState, newRevision);
+
+    for (BitTorrent::TorrentHandle *const torrent : asConst(m_changeTracker->takeDirtyTorrents()))
+    {
+        const QString key = TorrentChangeTracker::itemKey(torrent);
+
+        QVariantMap data = serialize(*torrent);
+        data.remove(KEY_TORRENT_HASH);
+
+        const auto itemIter = m_items.find(key);
+        if (itemIter == m_items.end())
+        {
+            // the item could be removed and then added again,
+            // it must not be reported as removed after that
+            for (int i = m_removals.size() - 1; i >= 0; --i)
+            {
+                if (m_removals[i].key == key)
+                {
+                    m_removals.remove(i);
+                    break;
+                }
+            }
+
+            updateItem(m_items[key], data, newRevision);
+            changed = true;
+        }
+        else if (updateItem(*itemIter, data, newRevision))
+        {
+            changed = true;
+        }
+    }
+
+    if (changed)
+        m_revision = newRevision;
+}
+
+void SyncRevisionLog::pruneRemovals()
+{
+    if (m_removals.size() <= MAX_REMOVED_ITEMS)
+        return;
+
+    const int count = m_removals.size() - MAX_REMOVED_ITEMS;
+    m_oldestRevision = m_removals[count - 1].revision;
+    m_removals.remove(0, count);
+}
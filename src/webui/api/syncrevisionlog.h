@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+}
+
+class TorrentChangeTracker;
+
+// Keeps the last serialized state of every task together with the revision
+// at which each of its fields last changed. The log is shared by all WebUI/API
+// clients, so its size depends on the number of tasks only. Tasks are marked
+// dirty by session signals and serialized again only when a client asks for
+// main data, so unchanged tasks are never serialized twice.
+class SyncRevisionLog final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SyncRevisionLog)
+
+public:
+    explicit SyncRevisionLog(QObject *parent = nullptr);
+
+    int revision() const;
+
+    // Applies pending changes (and the given server state) to the log and returns
+    // the sync data a client that has seen `acceptedRevision` needs to catch up.
+    // Falls back to the full data if that revision is unknown or too old.
+    QVariantMap syncData(int acceptedRevision, const QVariantMap &serverState);
+
+private slots:
+    void handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent);
+
+private:
+    struct Item
+    {
+        QVariantMap data;
+        QHash<QString, int> fieldRevisions;
+        int revision = 0;
+    };
+
+    struct Removal
+    {
+        int revision;
+        QString key;
+    };
+
+    bool updateItem(Item &item, const QVariantMap &data, int revision);
+    void flush(const QVariantMap &serverState);
+    void pruneRemovals();
+
+    QHash<QString, Item> m_items;
+    Item m_serverState;
+    TorrentChangeTracker *m_changeTracker = nullptr;
+    QVector<Removal> m_removals;  // ordered by revision
+    int m_revision = 1;
+    int m_oldestRevision = 1;  // deltas can't be produced for clients older than this
+};
@@ -0,0 +1,64 @@
+#include "torrentchangetracker.h"
+
+#include <utility>
+
+#include "base/bittorrent/infohash.h"
+#include "base/bittorrent/session.h"
+#include "base/bittorrent/torrenthandle.h"
+
+TorrentChangeTracker::TorrentChangeTracker(QObject *parent)
+    : QObject {parent}
+{
+    using BitTorrent::Session;
+
+    connect(Session::instance(), &Session::torrentLoaded, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::torrentAboutToBeRemoved, this, &TorrentChangeTracker::handleTorrentAboutToBeRemoved);
+    connect(Session::instance(), &Session::torrentsUpdated, this, &TorrentChangeTracker::markDirtyList);
+    connect(Session::instance(), &Session::torrentFinished, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::torrentMetadataReceived, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::torrentResumed, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::torrentPaused, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::torrentFinishedChecking, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::torrentSavePathChanged, this, &TorrentChangeTracker::markDirty);
+#ifdef __ENABLE_CATEGORY__
+    connect(Session::instance(), &Session::torrentCategoryChanged, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::torrentTagAdded, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::torrentTagRemoved, this, &TorrentChangeTracker::markDirty);
+#endif
+
+    connect(Session::instance(), &Session::xdownAdded, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::xdownAboutToBeRemoved, this, &TorrentChangeTracker::handleTorrentAboutToBeRemoved);
+    connect(Session::instance(), &Session::xdownFinished, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::xdownResumed, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::xdownPaused, this, &TorrentChangeTracker::markDirty);
+    connect(Session::instance(), &Session::xdownUpdated, this, &TorrentChangeTracker::markDirty);
+}
+
+QString TorrentChangeTracker::itemKey(const BitTorrent::TorrentHandle *torrent)
+{
+    return (torrent->getHandleType() == BitTorrent::TaskHandleType::XDown_Handle)
+        ? torrent->getItemHash()
+        : QString {torrent->hash()};
+}
+
+QSet<BitTorrent::TorrentHandle *> TorrentChangeTracker::takeDirtyTorrents()
+{
+    return std::exchange(m_dirtyTorrents, {});
+}
+
+void TorrentChangeTracker::markDirty(BitTorrent::TorrentHandle *const torrent)
+{
+    m_dirtyTorrents.insert(torrent);
+}
+
+void TorrentChangeTracker::markDirtyList(const QVector<BitTorrent::TorrentHandle *> &torrents)
+{
+    for (BitTorrent::TorrentHandle *const torrent : torrents)
+        m_dirtyTorrents.insert(torrent);
+}
+
+void TorrentChangeTracker::handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent)
+{
+    m_dirtyTorrents.remove(torrent);
+    emit torrentAboutToBeRemoved(torrent);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+}
+
+// Collects the tasks that the session reported as changed since they were last taken,
+// so the WebUI/API caches can update them lazily. Every cache owns its own tracker.
+class TorrentChangeTracker final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TorrentChangeTracker)
+
+public:
+    explicit TorrentChangeTracker(QObject *parent = nullptr);
+
+    // Key of the task in the WebUI/API data
+    static QString itemKey(const BitTorrent::TorrentHandle *torrent);
+
+    // Returns the changed tasks and forgets them
+    QSet<BitTorrent::TorrentHandle *> takeDirtyTorrents();
+
+public slots:
+    void markDirty(BitTorrent::TorrentHandle *const torrent);
+    void markDirtyList(const QVector<BitTorrent::TorrentHandle *> &torrents);
+
+signals:
+    // The task is already forgotten by the tracker
+    void torrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent);
+
+private slots:
+    void handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent);
+
+private:
+    QSet<BitTorrent::TorrentHandle *> m_dirtyTorrents;
+};
@@ -0,0 +1,365 @@
+#include "torrentqueryengine.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QDateTime>
+
+#include "base/bittorrent/session.h"
+#include "base/bittorrent/torrenthandle.h"
+#include "base/global.h"
+#include "serialize/serialize_torrent.h"
+#include "torrentchangetracker.h"
+
+namespace
+{
+    // If the narrowest filter leaves less than 1/SELECTIVE_RATIO of all tasks
+    // it is cheaper to sort the matching tasks than to walk the whole sorted index
+    const int SELECTIVE_RATIO = 8;
+
+    const TorrentFilter::Type STATUS_FILTER_TYPES[] =
+    {
+        TorrentFilter::Downloading,
+#ifdef __ENABLE_ALL_STATUS__
+        TorrentFilter::Seeding,
+#endif
+        TorrentFilter::Completed,
+#ifdef __ENABLE_ALL_STATUS__
+        TorrentFilter::Resumed,
+        TorrentFilter::Paused,
+#endif
+        TorrentFilter::Active,
+        TorrentFilter::Inactive,
+#ifdef __ENABLE_ALL_STATUS__
+        TorrentFilter::Stalled,
+        TorrentFilter::StalledUploading,
+        TorrentFilter::StalledDownloading,
+        TorrentFilter::Errored
+#endif
+    };
+
+    quint32 filterBit(const TorrentFilter::Type type)
+    {
+        return (1u << static_cast<int>(type));
+    }
+
+    template <typename T>
+    QVector<T> slice(const QVector<T> &list, int offset, const int limit)
+    {
+        const int size = list.size();
+        // normalize offset
+        if (offset < 0)
+            offset = size + offset;
+        if ((offset >= size) || (offset < 0))
+            offset = 0;
+
+        if ((limit > 0) || (offset > 0))
+            return list.mid(offset, ((limit > 0) ? limit : -1));
+        return list;
+    }
+
+    template <typename T, typename Entry>
+    void updateSortedIndex(std::set<T> &index, const decltype(T::value) &oldValue, const decltype(T::value) &newValue
+        , const Entry &entry, BitTorrent::TorrentHandle *const torrent)
+    {
+        if (!(oldValue < newValue) && !(newValue < oldValue))
+            return;
+
+        index.erase(T {oldValue, entry.seq, torrent});
+        index.insert(T {newValue, entry.seq, torrent});
+    }
+}
+
+TorrentQueryEngine::TorrentQueryEngine(QObject *parent)
+    : QObject {parent}
+    , m_changeTracker {new TorrentChangeTracker(this)}
+{
+    using BitTorrent::Session;
+
+    for (const TorrentFilter::Type type : STATUS_FILTER_TYPES)
+        m_statusFilters.append(TorrentFilter {type});
+
+    // keep the session order: torrents first, then XDown tasks
+    for (BitTorrent::TorrentHandle *const torrent : asConst(Session::instance()->torrents()))
+        addTorrent(torrent);
+    for (BitTorrent::TorrentHandle *const torrent : asConst(Session::instance()->xdowns()))
+        addTorrent(torrent);
+
+    connect(m_changeTracker, &TorrentChangeTracker::torrentAboutToBeRemoved, this, &TorrentQueryEngine::handleTorrentAboutToBeRemoved);
+}
+
+bool TorrentQueryEngine::isIndexedColumn(const QString &column)
+{
+    return (columnByName(column) != Column::None);
+}
+
+TorrentQueryEngine::Column TorrentQueryEngine::columnByName(const QString &column)
+{
+    if (column == QLatin1String(KEY_TORRENT_NAME))
+        return Column::Name;
+    if (column == QLatin1String(KEY_TORRENT_SIZE))
+        return Column::Size;
+    if (column == QLatin1String(KEY_TORRENT_ADDED_ON))
+        return Column::AddedOn;
+    return Column::None;
+}
+
+QVector<BitTorrent::TorrentHandle *> TorrentQueryEngine::select(const TorrentQuery &query)
+{
+    flush();
+
+    const TorrentFilter::Type type = TorrentFilter {query.filter}.type();
+
+    // Collect the restrictions and pick the narrowest one as the candidate set
+    const QSet<BitTorrent::TorrentHandle *> *candidates = nullptr;
+    const auto narrow = [&candidates](const QSet<BitTorrent::TorrentHandle *> *restriction)
+    {
+        if (!candidates || (restriction->size() < candidates->size()))
+            candidates = restriction;
+    };
+
+    const bool byHash = !query.hashes.isEmpty();
+    QSet<BitTorrent::TorrentHandle *> hashMatches;
+    if (byHash)
+    {
+        for (const QString &hash : asConst(query.hashes))
+        {
+            BitTorrent::TorrentHandle *torrent = m_byKey.value(hash);
+            if (!torrent)
+                torrent = m_byKey.value(hash.toLower());
+            if (torrent)
+                hashMatches.insert(torrent);
+        }
+        narrow(&hashMatches);
+    }
+
+    const bool byStatus = (type != TorrentFilter::All);
+    const QSet<BitTorrent::TorrentHandle *> statusMatches = m_byStatus.value(type);
+    if (byStatus)
+        narrow(&statusMatches);
+
+#ifdef __ENABLE_CATEGORY__
+    const bool byCategory = !query.category.isNull();
+    QSet<BitTorrent::TorrentHandle *> categoryMatches;
+    if (byCategory)
+    {
+        // all tasks of a bucket share the same category, so any of them can answer for the others
+        for (const QSet<BitTorrent::TorrentHandle *> &bucket : asConst(m_byCategory))
+        {
+            if (!bucket.isEmpty() && (*bucket.cbegin())->belongsToCategory(query.category))
+                categoryMatches.unite(bucket);
+        }
+        narrow(&categoryMatches);
+    }
+#endif
+
+    const auto accept = [&](BitTorrent::TorrentHandle *const torrent) -> bool
+    {
+        if (byHash && (candidates != &hashMatches) && !hashMatches.contains(torrent))
+            return false;
+        if (byStatus && (candidates != &statusMatches) && !statusMatches.contains(torrent))
+            return false;
+#ifdef __ENABLE_CATEGORY__
+        if (byCategory && (candidates != &categoryMatches) && !categoryMatches.contains(torrent))
+            return false;
+#endif
+        return true;
+    };
+
+    const Column column = columnByName(query.sortColumn);
+    const bool sorted = (column != Column::None);
+    const bool reverse = sorted && query.reverse;
+    const int offset = (sorted || query.sortColumn.isEmpty()) ? query.offset : 0;
+    const int limit = (sorted || query.sortColumn.isEmpty()) ? query.limit : -1;
+
+    if (candidates && ((candidates->size() * SELECTIVE_RATIO) < m_entries.size()))
+    {
+        QVector<BitTorrent::TorrentHandle *> torrents;
+        torrents.reserve(candidates->size());
+        for (BitTorrent::TorrentHandle *const torrent : *candidates)
+        {
+            if (accept(torrent))
+                torrents.append(torrent);
+        }
+
+        switch (column)
+        {
+        case Column::Name:
+            return slice(sortTorrents(torrents, &Entry::name, reverse), offset, limit);
+        case Column::Size:
+            return slice(sortTorrents(torrents, &Entry::size, reverse), offset, limit);
+        case Column::AddedOn:
+            return slice(sortTorrents(torrents, &Entry::addedOn, reverse), offset, limit);
+        default:
+            return slice(sortTorrents(torrents, &Entry::seq, false), offset, limit);
+        }
+    }
+
+    const auto scan = [&accept, candidates, offset, limit](const auto begin, const auto end)
+    {
+        // stop as soon as the requested page is complete
+        const int stopAt = ((offset >= 0) && (limit > 0)) ? (offset + limit) : -1;
+
+        QVector<BitTorrent::TorrentHandle *> result;
+        for (auto it = begin; it != end; ++it)
+        {
+            if (candidates && !candidates->contains(it->torrent))
+                continue;
+            if (!accept(it->torrent))
+                continue;
+
+            result.append(it->torrent);
+            if (result.size() == stopAt)
+                break;
+        }
+        return slice(result, offset, limit);
+    };
+
+    switch (column)
+    {
+    case Column::Name:
+        return reverse ? scan(m_byName.crbegin(), m_byName.crend()) : scan(m_byName.cbegin(), m_byName.cend());
+    case Column::Size:
+        return reverse ? scan(m_bySize.crbegin(), m_bySize.crend()) : scan(m_bySize.cbegin(), m_bySize.cend());
+    case Column::AddedOn:
+        return reverse ? scan(m_byAddedOn.crbegin(), m_byAddedOn.crend()) : scan(m_byAddedOn.cbegin(), m_byAddedOn.cend());
+    default:
+        return scan(m_bySeq.cbegin(), m_bySeq.cend());
+    }
+}
+
+template <typename T>
+QVector<BitTorrent::TorrentHandle *> TorrentQueryEngine::sortTorrents(const QVector<BitTorrent::TorrentHandle *> &torrents
+    , T Entry::*member, const bool reverse) const
+{
+    std::vector<IndexNode<T>> nodes;
+    nodes.reserve(torrents.size());
+    for (BitTorrent::TorrentHandle *const torrent : torrents)
+    {
+        const Entry &entry = *m_entries.constFind(torrent);
+        nodes.push_back({entry.*member, entry.seq, torrent});
+    }
+
+    std::sort(nodes.begin(), nodes.end());
+    if (reverse)
+        std::reverse(nodes.begin(), nodes.end());
+
+    QVector<BitTorrent::TorrentHandle *> result;
+    result.reserve(torrents.size());
+    for (const IndexNode<T> &node : nodes)
+        result.append(node.torrent);
+    return result;
+}
+
+void TorrentQueryEngine::handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent)
+{
+    const auto entryIter = m_entries.find(torrent);
+    if (entryIter == m_entries.end())
+        return;
+
+    const Entry &entry = *entryIter;
+    m_byKey.remove(entry.key);
+    for (auto it = m_byStatus.begin(); it != m_byStatus.end(); ++it)
+        it->remove(torrent);
+#ifdef __ENABLE_CATEGORY__
+    m_byCategory[entry.category].remove(torrent);
+#endif
+    m_bySeq.erase(IndexNode<quint64> {entry.seq, entry.seq, torrent});
+    m_byName.erase(IndexNode<QString> {entry.name, entry.seq, torrent});
+    m_bySize.erase(IndexNode<qlonglong> {entry.size, entry.seq, torrent});
+    m_byAddedOn.erase(IndexNode<qint64> {entry.addedOn, entry.seq, torrent});
+
+    m_entries.erase(entryIter);
+}
+
+void TorrentQueryEngine::flush()
+{
+    for (BitTorrent::TorrentHandle *const torrent : asConst(m_changeTracker->takeDirtyTorrents()))
+    {
+        const auto entryIter = m_entries.find(torrent);
+        if (entryIter == m_entries.end())
+            addTorrent(torrent);
+        else
+            updateEntry(torrent, *entryIter);
+    }
+}
+
+void TorrentQueryEngine::addTorrent(BitTorrent::TorrentHandle *const torrent)
+{
+    Entry &entry = m_entries[torrent];
+    entry.seq = m_nextSeq++;
+    entry.key = TorrentChangeTracker::itemKey(torrent);
+    entry.name = torrent->name();
+    entry.size = torrent->wantedSize();
+    entry.addedOn = torrent->addedTime().toSecsSinceEpoch();
+    entry.filterMask = filterMask(torrent);
+#ifdef __ENABLE_CATEGORY__
+    entry.category = torrent->category();
+    m_byCategory[entry.category].insert(torrent);
+#endif
+
+    m_byKey[entry.key] = torrent;
+    for (const TorrentFilter::Type type : STATUS_FILTER_TYPES)
+    {
+        if (entry.filterMask & filterBit(type))
+            m_byStatus[type].insert(torrent);
+    }
+    m_bySeq.insert({entry.seq, entry.seq, torrent});
+    m_byName.insert({entry.name, entry.seq, torrent});
+    m_bySize.insert({entry.size, entry.seq, torrent});
+    m_byAddedOn.insert({entry.addedOn, entry.seq, torrent});
+}
+
+void TorrentQueryEngine::updateEntry(BitTorrent::TorrentHandle *const torrent, Entry &entry)
+{
+    const QString name = torrent->name();
+    updateSortedIndex(m_byName, entry.name, name, entry, torrent);
+    entry.name = name;
+
+    const qlonglong size = torrent->wantedSize();
+    updateSortedIndex(m_bySize, entry.size, size, entry, torrent);
+    entry.size = size;
+
+    const qint64 addedOn = torrent->addedTime().toSecsSinceEpoch();
+    updateSortedIndex(m_byAddedOn, entry.addedOn, addedOn, entry, torrent);
+    entry.addedOn = addedOn;
+
+    const quint32 mask = filterMask(torrent);
+    const quint32 changedBits = mask ^ entry.filterMask;
+    if (changedBits != 0)
+    {
+        for (const TorrentFilter::Type type : STATUS_FILTER_TYPES)
+        {
+            const quint32 bit = filterBit(type);
+            if (!(changedBits & bit))
+                continue;
+
+            if (mask & bit)
+                m_byStatus[type].insert(torrent);
+            else
+                m_byStatus[type].remove(torrent);
+        }
+        entry.filterMask = mask;
+    }
+
+#ifdef __ENABLE_CATEGORY__
+    const QString category = torrent->category();
+    if (category != entry.category)
+    {
+        m_byCategory[entry.category].remove(torrent);
+        m_byCategory[category].insert(torrent);
+        entry.category = category;
+    }
+#endif
+}
+
+quint32 TorrentQueryEngine::filterMask(const BitTorrent::TorrentHandle *torrent) const
+{
+    quint32 mask = 0;
+    for (const TorrentFilter &filter : m_statusFilters)
+    {
+        if (filter.match(torrent))
+            mask |= filterBit(filter.type());
+    }
+    return mask;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <set>
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "base/torrentfilter.h"
+
+namespace BitTorrent
+{
+    class TorrentHandle;
+}
+
+class TorrentChangeTracker;
+
+struct TorrentQuery
+{
+    QString filter;         // status filter name, see TorrentFilter::setTypeByName()
+    QString category;       // null string matches any category
+    QStringList hashes;     // empty list matches any task
+    QString sortColumn;     // serialized torrent key, empty string keeps the session order
+    bool reverse = false;
+    int offset = 0;         // negative value counts from the end
+    int limit = -1;         // non-positive value means unlimited
+};
+
+// Answers torrents/info queries without serializing the tasks that don't make it
+// into the requested page. Every task is indexed by the status filters it matches,
+// by category and by the typed values of the most used sort columns. Indexes are
+// updated lazily from the tasks that the session reported as changed.
+class TorrentQueryEngine final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TorrentQueryEngine)
+
+public:
+    explicit TorrentQueryEngine(QObject *parent = nullptr);
+
+    static bool isIndexedColumn(const QString &column);
+
+    // Filters, sorts by an indexed column (if any) and slices the result.
+    // If the sort column isn't indexed the matching tasks are returned in session order
+    // and offset/limit are not applied, so the caller has to sort and slice them itself.
+    QVector<BitTorrent::TorrentHandle *> select(const TorrentQuery &query);
+
+private slots:
+    void handleTorrentAboutToBeRemoved(BitTorrent::TorrentHandle *const torrent);
+
+private:
+    template <typename T>
+    struct IndexNode
+    {
+        T value;
+        quint64 seq;
+        BitTorrent::TorrentHandle *torrent;
+
+        bool operator<(const IndexNode &other) const
+        {
+            if (value < other.value) return true;
+            if (other.value < value) return false;
+            return seq < other.seq;
+        }
+    };
+
+    template <typename T>
+    using SortedIndex = std::set<IndexNode<T>>;
+
+    struct Entry
+    {
+        quint64 seq = 0;
+        QString key;
+        quint32 filterMask = 0;
+#ifdef __ENABLE_CATEGORY__
+        QString category;
+#endif
+        QString name;
+        qlonglong size = 0;
+        qint64 addedOn = 0;
+    };
+
+    enum class Column
+    {
+        None,
+        Name,
+        Size,
+        AddedOn
+    };
+
+    static Column columnByName(const QString &column);
+
+    void flush();
+    void addTorrent(BitTorrent::TorrentHandle *const torrent);
+    void updateEntry(BitTorrent::TorrentHandle *const torrent, Entry &entry);
+    quint32 filterMask(const BitTorrent::TorrentHandle *torrent) const;
+
+    template <typename T>
+    QVector<BitTorrent::TorrentHandle *> sortTorrents(const QVector<BitTorrent::TorrentHandle *> &torrents
+        , T Entry::*member, bool reverse) const;
+
+    QVector<TorrentFilter> m_statusFilters;
+
+    QHash<BitTorrent::TorrentHandle *, Entry> m_entries;
+    QHash<QString, BitTorrent::TorrentHandle *> m_byKey;
+    QHash<int, QSet<BitTorrent::TorrentHandle *>> m_byStatus;
+#ifdef __ENABLE_CATEGORY__
+    QHash<QString, QSet<BitTorrent::TorrentHandle *>> m_byCategory;
+#endif
+    SortedIndex<quint64> m_bySeq;
+    SortedIndex<QString> m_byName;
+    SortedIndex<qlonglong> m_bySize;
+    SortedIndex<qint64> m_byAddedOn;
+
+    TorrentChangeTracker *m_changeTracker = nullptr;
+    quint64 m_nextSeq = 0;
+};
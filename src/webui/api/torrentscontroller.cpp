@@ -48,6 +48,7 @@
 #include "base/bittorrent/torrenthandle.h"
 #include "base/bittorrent/torrentinfo.h"
 #include "base/bittorrent/trackerentry.h"
+#include "base/bittorrent/xdownhandleimpl.h"
 #include "base/global.h"
 #include "base/logger.h"
 #include "base/net/downloadmanager.h"
@@ -56,6 +57,7 @@
 #include "base/utils/string.h"
 #include "apierror.h"
 #include "serialize/serialize_torrent.h"
+#include "torrentqueryengine.h"
 
 // Tracker keys
 const char KEY_TRACKER_URL[] = "url";
@@ -104,6 +106,15 @@ const char KEY_PROP_COMPLETION_DATE[] = "completion_date";
 const char KEY_PROP_CREATION_DATE[] = "creation_date";
 const char KEY_PROP_SAVE_PATH[] = "save_path";
 const char KEY_PROP_COMMENT[] = "comment";
+const char KEY_PROP_DOWN_CONCURRENT[] = "down_concurrent";
+const char KEY_PROP_DOWN_CONCURRENT_ADAPTIVE[] = "down_concurrent_adaptive";
+const char KEY_PROP_DOWN_CONCURRENT_HISTORY[] = "down_concurrent_history";
+
+// Concurrency change keys
+const char KEY_CONCURRENCY_TIME[] = "time";
+const char KEY_CONCURRENCY_VALUE[] = "concurrency";
+const char KEY_CONCURRENCY_SPEED[] = "speed";
+const char KEY_CONCURRENCY_REASON[] = "reason";
 
 // File keys
 const char KEY_FILE_NAME[] = "name";
@@ -241,6 +252,12 @@ namespace
     }
 }
 
+TorrentsController::TorrentsController(ISessionManager *sessionManager, QObject *parent)
+    : APIController(sessionManager, parent)
+    , m_queryEngine {new TorrentQueryEngine(this)}
+{
+}
+
 // Returns all the torrents in JSON format.
 // The return value is a JSON-formatted list of dictionaries.
 // The dictionary keys are:
@@ -280,38 +297,33 @@ void TorrentsController::infoAction()
     int offset {params()["offset"].toInt()};
     const QStringList hashes {params()["hashes"].split('|', QString::SkipEmptyParts)};
 
-    InfoHashSet hashSet;
-    for (const QString &hash : hashes)
-        hashSet.insert(BitTorrent::InfoHash {hash});
-
-	////////////
-    TorrentFilter torrentFilter(filter, (hashSet.isEmpty() ? TorrentFilter::AnyHash : hashSet)
+    TorrentQuery query;
+    query.filter = filter;
 #ifdef __ENABLE_CATEGORY__
-        , category
+    query.category = category;
 #endif
-    	);
-	////////////
-
-    int iLimitSize = limit;
-    if (iLimitSize <= 0) {
-        iLimitSize = 4000;
-    }
-    else if (iLimitSize > 10000) {
-        iLimitSize = 10000;
-    }
-	QVariantList torrentList;
-    QVector<BitTorrent::TorrentHandle *> torrents = BitTorrent::Session::instance()->torrentsFilter(iLimitSize, filter, (hashSet.isEmpty() ? TorrentFilter::AnyHash : hashSet));
-    for (const BitTorrent::TorrentHandle *torrent : asConst(torrents))
+    query.hashes = hashes;
+    query.sortColumn = sortedColumn;
+    query.reverse = reverse;
+    query.offset = offset;
+    query.limit = limit;
+
+    // Indexed columns are filtered, sorted and sliced by the query engine,
+    // so only the requested page gets serialized
+    const QVector<BitTorrent::TorrentHandle *> torrents = m_queryEngine->select(query);
+    if (sortedColumn.isEmpty() || TorrentQueryEngine::isIndexedColumn(sortedColumn))
     {
-        torrentList.append(serialize(*torrent));
+        QJsonArray result;
+        for (const BitTorrent::TorrentHandle *torrent : torrents)
+            result.append(QJsonObject::fromVariantMap(serialize(*torrent)));
+        setResult(result);
+        return;
     }
 
-    QVector<BitTorrent::TorrentHandle *> xdowns = BitTorrent::Session::instance()->xdownsFilter(iLimitSize, filter, (hashSet.isEmpty() ? TorrentFilter::AnyHash : hashSet));
-    for (const BitTorrent::TorrentHandle *torrent : asConst(xdowns))
-    {
+    QVariantList torrentList;
+    torrentList.reserve(torrents.size());
+    for (const BitTorrent::TorrentHandle *torrent : torrents)
         torrentList.append(serialize(*torrent));
-    }
-
 
     if (torrentList.isEmpty())
     {
@@ -319,45 +331,43 @@ void TorrentsController::infoAction()
         return;
     }
 
-    if (!sortedColumn.isEmpty())
+    // Columns without an index are sorted by their serialized values
+    if (!torrentList[0].toMap().contains(sortedColumn))
+        throw APIError(APIErrorType::BadParams, tr("'sort' parameter is invalid"));
+
+    const auto lessThan = [](const QVariant &left, const QVariant &right) -> bool
     {
-        if (!torrentList[0].toMap().contains(sortedColumn))
-            throw APIError(APIErrorType::BadParams, tr("'sort' parameter is invalid"));
+        Q_ASSERT(left.type() == right.type());
 
-        const auto lessThan = [](const QVariant &left, const QVariant &right) -> bool
+        switch (static_cast<QMetaType::Type>(left.type()))
         {
-            Q_ASSERT(left.type() == right.type());
-
-            switch (static_cast<QMetaType::Type>(left.type()))
-            {
-            case QMetaType::Bool:
-                return left.value<bool>() < right.value<bool>();
-            case QMetaType::Double:
-                return left.value<double>() < right.value<double>();
-            case QMetaType::Float:
-                return left.value<float>() < right.value<float>();
-            case QMetaType::Int:
-                return left.value<int>() < right.value<int>();
-            case QMetaType::LongLong:
-                return left.value<qlonglong>() < right.value<qlonglong>();
-            case QMetaType::QString:
-                return left.value<QString>() < right.value<QString>();
-            default:
-                qWarning("Unhandled QVariant comparison, type: %d, name: %s", left.type()
-                    , QMetaType::typeName(left.type()));
-                break;
-            }
-            return false;
-        };
+        case QMetaType::Bool:
+            return left.value<bool>() < right.value<bool>();
+        case QMetaType::Double:
+            return left.value<double>() < right.value<double>();
+        case QMetaType::Float:
+            return left.value<float>() < right.value<float>();
+        case QMetaType::Int:
+            return left.value<int>() < right.value<int>();
+        case QMetaType::LongLong:
+            return left.value<qlonglong>() < right.value<qlonglong>();
+        case QMetaType::QString:
+            return left.value<QString>() < right.value<QString>();
+        default:
+            qWarning("Unhandled QVariant comparison, type: %d, name: %s", left.type()
+                , QMetaType::typeName(left.type()));
+            break;
+        }
+        return false;
+    };
 
-        std::sort(torrentList.begin(), torrentList.end()
-            , [reverse, &sortedColumn, &lessThan](const QVariant &torrent1, const QVariant &torrent2)
-        {
-            const QVariant value1 {torrent1.toMap().value(sortedColumn)};
-            const QVariant value2 {torrent2.toMap().value(sortedColumn)};
-            return reverse ? lessThan(value2, value1) : lessThan(value1, value2);
-        });
-    }
+    std::sort(torrentList.begin(), torrentList.end()
+        , [reverse, &sortedColumn, &lessThan](const QVariant &torrent1, const QVariant &torrent2)
+    {
+        const QVariant value1 {torrent1.toMap().value(sortedColumn)};
+        const QVariant value2 {torrent2.toMap().value(sortedColumn)};
+        return reverse ? lessThan(value2, value1) : lessThan(value1, value2);
+    });
 
     const int size = torrentList.size();
     // normalize offset
@@ -411,6 +421,9 @@ void TorrentsController::infoAction()
 //   - "creation_date": Torrent creation date
 //   - "save_path": Torrent save path
 //   - "comment": Torrent comment
+//   - "down_concurrent": Segment count of HTTP task
+//   - "down_concurrent_adaptive": Whether the segment count follows the measured throughput
+//   - "down_concurrent_history": Recent segment count changes of HTTP task
 void TorrentsController::propertiesAction()
 {
     requireParams({"hash"});
@@ -473,6 +486,25 @@ void TorrentsController::propertiesAction()
     dataDict[KEY_PROP_SAVE_PATH] = Utils::Fs::toNativePath(torrent->savePath());
     dataDict[KEY_PROP_COMMENT] = torrent->comment();
 
+    if (torrent->getHandleType() == BitTorrent::TaskHandleType::XDown_Handle)
+    {
+        const auto *xdown = static_cast<const BitTorrent::XDownHandleImpl *>(torrent);
+        dataDict[KEY_PROP_DOWN_CONCURRENT] = xdown->getDownConcurrent();
+        dataDict[KEY_PROP_DOWN_CONCURRENT_ADAPTIVE] = xdown->isDownConcurrentAdaptive();
+
+        QJsonArray history;
+        for (const BitTorrent::ConcurrencyChange &change : asConst(xdown->getDownConcurrentHistory()))
+        {
+            history << QJsonObject {
+                {KEY_CONCURRENCY_TIME, static_cast<double>(change.timestamp / 1000)},
+                {KEY_CONCURRENCY_VALUE, change.concurrency},
+                {KEY_CONCURRENCY_SPEED, change.speed},
+                {KEY_CONCURRENCY_REASON, static_cast<int>(change.reason)}
+            };
+        }
+        dataDict[KEY_PROP_DOWN_CONCURRENT_HISTORY] = history;
+    }
+
     setResult(dataDict);
 }
 
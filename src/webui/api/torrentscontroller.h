@@ -30,13 +30,15 @@
 
 #include "apicontroller.h"
 
+class TorrentQueryEngine;
+
 class TorrentsController : public APIController
 {
     Q_OBJECT
     Q_DISABLE_COPY(TorrentsController)
 
 public:
-    using APIController::APIController;
+    explicit TorrentsController(ISessionManager *sessionManager, QObject *parent = nullptr);
 
 private slots:
     void infoAction();
@@ -84,4 +86,7 @@ private slots:
     void toggleSequentialDownloadAction();
     void toggleFirstLastPiecePrioAction();
     void renameFileAction();
+
+private:
+    TorrentQueryEngine *m_queryEngine = nullptr;
 };
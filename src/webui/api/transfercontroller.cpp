@@ -28,12 +28,15 @@
 
 #include "transfercontroller.h"
 
+#include <QJsonArray>
 #include <QJsonObject>
 #include <QVector>
 
 #include "base/bittorrent/peeraddress.h"
 #include "base/bittorrent/peerinfo.h"
+#include "base/bittorrent/segmentconcurrency.h"
 #include "base/bittorrent/session.h"
+#include "base/bittorrent/speedhistory.h"
 #include "base/global.h"
 #include "apierror.h"
 
@@ -46,6 +49,22 @@ const char KEY_TRANSFER_UPRATELIMIT[] = "up_rate_limit";
 const char KEY_TRANSFER_DHT_NODES[] = "dht_nodes";
 const char KEY_TRANSFER_CONNECTION_STATUS[] = "connection_status";
 
+// Segment concurrency keys
+const char KEY_HOST_CONCURRENCY[] = "concurrency";
+const char KEY_HOST_SPEED[] = "speed";
+const char KEY_HOST_TIME[] = "time";
+
+// Speed history keys
+const char KEY_HISTORY_TASKS[] = "tasks";
+const char KEY_HISTORY_HOSTS[] = "hosts";
+const char KEY_HISTORY_INTERVAL[] = "interval";
+const char KEY_HISTORY_POINTS[] = "points";
+
+namespace
+{
+    const qint64 DEFAULT_HISTORY_PERIOD = 5 * 60;
+}
+
 // Returns the global transfer information in JSON format.
 // The return value is a JSON-formatted dictionary.
 // The dictionary keys are:
@@ -131,3 +150,73 @@ void TransferController::banPeersAction()
             BitTorrent::Session::instance()->banIP(addr.ip.toString());
     }
 }
+
+// Returns the segment counts remembered per host for HTTP tasks in JSON format.
+// The return value is a JSON-formatted dictionary keyed by host name.
+// The values are dictionaries with the following keys:
+//   - "concurrency": Best known segment count
+//   - "speed": Average speed measured with that count
+//   - "time": Time of the measurement
+void TransferController::segmentConcurrencyAction()
+{
+    const BitTorrent::SegmentConcurrencyController *controller = BitTorrent::SegmentConcurrencyController::instance();
+    if (!controller)
+        throw APIError(APIErrorType::Conflict);
+
+    QJsonObject result;
+    const QHash<QString, BitTorrent::SegmentConcurrencyController::HostRecord> hosts = controller->hosts();
+    for (auto it = hosts.cbegin(); it != hosts.cend(); ++it)
+    {
+        result[it.key()] = QJsonObject {
+            {KEY_HOST_CONCURRENCY, it->concurrency},
+            {KEY_HOST_SPEED, it->speed},
+            {KEY_HOST_TIME, static_cast<double>(it->timestamp / 1000)}
+        };
+    }
+
+    setResult(result);
+}
+
+// Returns the speed history of a task ("hash" param) or of a host HTTP tasks
+// download from ("host" param) for the last "period" seconds (5 minutes by default).
+// The return value is a JSON-formatted dictionary:
+//   - "interval": seconds between the points
+//   - "points": list of [time, download speed, upload speed], oldest first
+// Without "hash" and "host" the lists of the known tasks and hosts are returned
+// as "tasks" and "hosts".
+void TransferController::speedHistoryAction()
+{
+    const BitTorrent::SpeedHistory *speedHistory = BitTorrent::SpeedHistory::instance();
+    if (!speedHistory)
+        throw APIError(APIErrorType::Conflict);
+
+    const QString hash = params()["hash"];
+    const QString host = params()["host"];
+    if (hash.isEmpty() && host.isEmpty())
+    {
+        setResult(QJsonObject {
+            {KEY_HISTORY_TASKS, QJsonArray::fromStringList(speedHistory->keys(BitTorrent::SpeedHistory::SeriesType::Task))},
+            {KEY_HISTORY_HOSTS, QJsonArray::fromStringList(speedHistory->keys(BitTorrent::SpeedHistory::SeriesType::Host))}
+        });
+        return;
+    }
+
+    bool ok = true;
+    const QString periodParam = params()["period"];
+    const qint64 period = periodParam.isEmpty() ? DEFAULT_HISTORY_PERIOD : periodParam.toLongLong(&ok);
+    if (!ok || (period <= 0))
+        throw APIError(APIErrorType::BadParams);
+
+    const BitTorrent::SpeedHistory::Series series = hash.isEmpty()
+        ? speedHistory->series(BitTorrent::SpeedHistory::SeriesType::Host, host, period)
+        : speedHistory->series(BitTorrent::SpeedHistory::SeriesType::Task, hash, period);
+
+    QJsonArray points;
+    for (const BitTorrent::SpeedHistory::Point &point : asConst(series.points))
+        points.append(QJsonArray {static_cast<double>(point.time), static_cast<double>(point.download), static_cast<double>(point.upload)});
+
+    setResult(QJsonObject {
+        {KEY_HISTORY_INTERVAL, static_cast<double>(series.interval)},
+        {KEY_HISTORY_POINTS, points}
+    });
+}
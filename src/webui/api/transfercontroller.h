@@ -47,4 +47,6 @@ private slots:
     void setUploadLimitAction();
     void setDownloadLimitAction();
     void banPeersAction();
+    void segmentConcurrencyAction();
+    void speedHistoryAction();
 };
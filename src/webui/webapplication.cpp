@@ -30,8 +30,10 @@
 
 #include <algorithm>
 
+#include <QCryptographicHash>
 #include <QDateTime>
 #include <QDebug>
+#include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonDocument>
@@ -49,6 +51,7 @@
 #include "base/types.h"
 #include "base/utils/bytearray.h"
 #include "base/utils/fs.h"
+#include "base/utils/gzip.h"
 #include "base/utils/misc.h"
 #include "base/utils/random.h"
 #include "base/utils/string.h"
@@ -111,7 +114,32 @@ namespace
             return QLatin1String("private, max-age=43200");  // 12 hrs
         }
 
-        return QLatin1String("no-store");
+        // the files are validated by ETag
+        return QLatin1String("no-cache");
+    }
+
+    QStringRef opaqueTag(QStringRef eTag)
+    {
+        eTag = eTag.trimmed();
+        if (eTag.startsWith(QLatin1String("W/")))
+            eTag = eTag.mid(2);
+        return eTag;
+    }
+
+    // [rfc7232] 3.2. If-None-Match, uses the weak comparison
+    bool matchesETag(const QString &ifNoneMatch, const QString &eTag)
+    {
+        if (ifNoneMatch.trimmed() == QLatin1String("*"))
+            return true;
+
+        const QStringRef fileTag = opaqueTag(QStringRef(&eTag));
+        for (const QStringRef &tag : asConst(ifNoneMatch.splitRef(',', QString::SkipEmptyParts)))
+        {
+            if (opaqueTag(tag) == fileTag)
+                return true;
+        }
+
+        return false;
     }
 }
 
@@ -170,6 +198,16 @@ void WebApplication::sendWebUIFile()
                 + path
     };
 
+    if (!m_isAltUIUsed)
+    {
+        // all the built-in files are in the cache, the file system isn't touched
+        if (session() && !m_cachedFiles.contains(localPath) && !QFileInfo::exists(localPath))
+            localPath = m_rootFolder + PUBLIC_FOLDER + path;
+
+        sendFile(localPath);
+        return;
+    }
+
     QFileInfo fileInfo {localPath};
 
     if (!fileInfo.exists() && session())
@@ -179,66 +217,70 @@ void WebApplication::sendWebUIFile()
         fileInfo.setFile(localPath);
     }
 
-    if (m_isAltUIUsed)
-    {
 #ifdef Q_OS_UNIX
-        if (!Utils::Fs::isRegularFile(localPath))
-        {
-            status(500, "Internal Server Error");
-            print(tr("Unacceptable file type, only regular file is allowed."), Http::CONTENT_TYPE_TXT);
-            return;
-        }
+    if (!Utils::Fs::isRegularFile(localPath))
+    {
+        status(500, "Internal Server Error");
+        print(tr("Unacceptable file type, only regular file is allowed."), Http::CONTENT_TYPE_TXT);
+        return;
+    }
 #endif
 
-        while (fileInfo.filePath() != m_rootFolder)
-        {
-            if (fileInfo.isSymLink())
-                throw InternalServerErrorHTTPError(tr("Symlinks inside alternative UI folder are forbidden."));
+    while (fileInfo.filePath() != m_rootFolder)
+    {
+        if (fileInfo.isSymLink())
+            throw InternalServerErrorHTTPError(tr("Symlinks inside alternative UI folder are forbidden."));
 
-            fileInfo.setFile(fileInfo.path());
-        }
+        fileInfo.setFile(fileInfo.path());
     }
 
     sendFile(localPath);
 }
 
-void WebApplication::translateDocument(QString &data) const
+QString WebApplication::translateDocument(const QString &data) const
 {
-    const QRegularExpression regex("QBT_TR\\((([^\\)]|\\)(?!QBT_TR))+)\\)QBT_TR\\[CONTEXT=([a-zA-Z_][a-zA-Z0-9_]*)\\]");
+    // translatable strings and the variables are substituted in one pass over the document
+    const QRegularExpression regex(QLatin1String("QBT_TR\\((?<source>(?:[^\\)]|\\)(?!QBT_TR))+)\\)QBT_TR\\[CONTEXT=(?<context>[a-zA-Z_][a-zA-Z0-9_]*)\\]"
+        "|\\$\\{(?<variable>LANG|CACHEID)\\}"));
+    const QString lang = m_currentLocale.left(2);
+
+    QString result;
+    result.reserve(data.size());
 
-    int i = 0;
-    bool found = true;
-    while (i < data.size() && found)
+    int pos = 0;
+    QRegularExpressionMatchIterator iter = regex.globalMatch(data);
+    while (iter.hasNext())
     {
-        QRegularExpressionMatch regexMatch;
-        i = data.indexOf(regex, i, &regexMatch);
-        if (i >= 0)
-        {
-            const QString sourceText = regexMatch.captured(1);
-            const QString context = regexMatch.captured(3);
-
-            const QString loadedText = m_translationFileLoaded
-                ? m_translator.translate(context.toUtf8().constData(), sourceText.toUtf8().constData())
-                : QString();
-            // `loadedText` is empty when translation is not provided
-            // it should fallback to `sourceText`
-            QString translation = loadedText.isEmpty() ? sourceText : loadedText;
-
-            // Use HTML code for quotes to prevent issues with JS
-            translation.replace('\'', "&#39;");
-            translation.replace('\"', "&#34;");
-
-            data.replace(i, regexMatch.capturedLength(), translation);
-            i += translation.length();
-        }
-        else
+        const QRegularExpressionMatch regexMatch = iter.next();
+        result.append(data.midRef(pos, (regexMatch.capturedStart() - pos)));
+        pos = regexMatch.capturedEnd();
+
+        const QStringRef variable = regexMatch.capturedRef(QLatin1String("variable"));
+        if (!variable.isEmpty())
         {
-            found = false; // no more translatable strings
+            result.append((variable == QLatin1String("LANG")) ? lang : m_cacheID);
+            continue;
         }
 
-        data.replace(QLatin1String("${LANG}"), m_currentLocale.left(2));
-        data.replace(QLatin1String("${CACHEID}"), m_cacheID);
+        const QString sourceText = regexMatch.captured(QLatin1String("source"));
+        const QString context = regexMatch.captured(QLatin1String("context"));
+
+        const QString loadedText = m_translationFileLoaded
+            ? m_translator.translate(context.toUtf8().constData(), sourceText.toUtf8().constData())
+            : QString();
+        // `loadedText` is empty when translation is not provided
+        // it should fallback to `sourceText`
+        QString translation = loadedText.isEmpty() ? sourceText : loadedText;
+
+        // Use HTML code for quotes to prevent issues with JS
+        translation.replace('\'', "&#39;");
+        translation.replace('\"', "&#34;");
+
+        result.append(translation);
     }
+    result.append(data.midRef(pos));
+
+    return result;
 }
 
 WebSession *WebApplication::session()
@@ -321,11 +363,12 @@ void WebApplication::configure()
     const bool isAltUIUsed = pref->isAltWebUiEnabled();
     const QString rootFolder = Utils::Fs::expandPathAbs(
                 !isAltUIUsed ? WWW_FOLDER : pref->getWebUiRootFolder());
+    bool isFileCacheOutdated = false;
     if ((isAltUIUsed != m_isAltUIUsed) || (rootFolder != m_rootFolder))
     {
         m_isAltUIUsed = isAltUIUsed;
         m_rootFolder = rootFolder;
-        m_translatedFiles.clear();
+        isFileCacheOutdated = true;
         if (!m_isAltUIUsed)
             LogMsg(tr("Using built-in Web UI."));
         else
@@ -336,7 +379,7 @@ void WebApplication::configure()
     if (m_currentLocale != newLocale)
     {
         m_currentLocale = newLocale;
-        m_translatedFiles.clear();
+        isFileCacheOutdated = true;
 
         m_translationFileLoaded = m_translator.load(m_rootFolder + QLatin1String("/translations/webui_") + newLocale);
         if (m_translationFileLoaded)
@@ -350,6 +393,9 @@ void WebApplication::configure()
         }
     }
 
+    if (isFileCacheOutdated)
+        buildFileCache();
+
     m_isLocalAuthEnabled = pref->isWebUiLocalAuthEnabled();
     m_isAuthSubnetWhitelistEnabled = pref->isWebUiAuthSubnetWhitelistEnabled();
     m_authSubnetWhitelist = pref->getWebUiAuthSubnetWhitelist();
@@ -420,17 +466,60 @@ void WebApplication::declarePublicAPI(const QString &apiPath)
 
 void WebApplication::sendFile(const QString &path)
 {
-    const QDateTime lastModified {QFileInfo(path).lastModified()};
+    auto it = m_cachedFiles.constFind(path);
+    // the built-in files never change, the files of the alternative UI may be edited meanwhile
+    if ((it != m_cachedFiles.constEnd()) && !path.startsWith(QLatin1Char(':'))
+        && (QFileInfo(path).lastModified() > it->lastModified))
+    {
+        it = m_cachedFiles.constEnd();
+    }
+
+    if (it == m_cachedFiles.constEnd())
+        it = m_cachedFiles.insert(path, loadFile(path));
 
-    // find translated file in cache
-    const auto it = m_translatedFiles.constFind(path);
-    if ((it != m_translatedFiles.constEnd()) && (lastModified <= it->lastModified))
+    setHeader({Http::HEADER_CACHE_CONTROL, getCachingInterval(it->mimeType)});
+    setHeader({Http::HEADER_ETAG, it->eTag});
+    if (!it->gzipData.isEmpty())
+        setHeader({Http::HEADER_VARY, QLatin1String("accept-encoding")});
+
+    if (matchesETag(request().headers.value(Http::HEADER_IF_NONE_MATCH), it->eTag))
     {
-        print(it->data, it->mimeType);
-        setHeader({Http::HEADER_CACHE_CONTROL, getCachingInterval(it->mimeType)});
+        status(304, QLatin1String("Not Modified"));
         return;
     }
 
+    print(it->data, it->mimeType);
+    setPrecompressed(it->gzipData);
+}
+
+void WebApplication::buildFileCache()
+{
+    m_cachedFiles.clear();
+
+    // files of the alternative UI are loaded on demand
+    if (m_isAltUIUsed)
+        return;
+
+    for (const QString &folder : {PUBLIC_FOLDER, PRIVATE_FOLDER})
+    {
+        QDirIterator iter {(m_rootFolder + folder), QDir::Files, QDirIterator::Subdirectories};
+        while (iter.hasNext())
+        {
+            const QString path = iter.next();
+            try
+            {
+                m_cachedFiles.insert(path, loadFile(path));
+            }
+            catch (const HTTPError &)
+            {
+                // it will fail again when requested
+            }
+        }
+    }
+}
+
+WebApplication::CachedFile WebApplication::loadFile(const QString &path) const
+{
     QFile file {path};
     if (!file.open(QIODevice::ReadOnly))
     {
@@ -445,24 +534,35 @@ void WebApplication::sendFile(const QString &path)
                                            .arg(Utils::Misc::friendlyUnit(MAX_ALLOWED_FILESIZE)));
     }
 
-    QByteArray data {file.readAll()};
+    CachedFile cachedFile;
+    cachedFile.lastModified = QFileInfo(file).lastModified();
+    cachedFile.data = file.readAll();
     file.close();
 
-    const QMimeType mimeType {QMimeDatabase().mimeTypeForFileNameAndData(path, data)};
-    const bool isTranslatable {mimeType.inherits(QLatin1String("text/plain"))};
+    const QMimeType mimeType {QMimeDatabase().mimeTypeForFileNameAndData(path, cachedFile.data)};
+    cachedFile.mimeType = mimeType.name();
 
     // Translate the file
-    if (isTranslatable)
-    {
-        QString dataStr {data};
-        translateDocument(dataStr);
-        data = dataStr.toUtf8();
-
-        m_translatedFiles[path] = {data, mimeType.name(), lastModified}; // caching translated file
+    if (mimeType.inherits(QLatin1String("text/plain")))
+        cachedFile.data = translateDocument(QString::fromUtf8(cachedFile.data)).toUtf8();
+
+    // [rfc7232] 2.3.3. The plain and the gzip variants are sent with the same tag,
+    // so it is weak, a strong one would have to differ between content-codings
+    cachedFile.eTag = QLatin1String("W/\"")
+        + QString::fromLatin1(QCryptographicHash::hash(cachedFile.data, QCryptographicHash::Md5).toHex())
+        + QLatin1Char('"');
+
+    // compressed once here instead of for every client, very small files aren't worth it
+    if (cachedFile.data.size() > 1024)
+    {
+        bool ok = false;
+        const QByteArray gzipData = Utils::Gzip::compress(cachedFile.data, 9, &ok);
+        // "Content-Encoding: gzip\r\n" is 24 bytes long
+        if (ok && ((gzipData.size() + 24) < cachedFile.data.size()))
+            cachedFile.gzipData = gzipData;
     }
 
-    print(data, mimeType.name());
-    setHeader({Http::HEADER_CACHE_CONTROL, getCachingInterval(mimeType.name())});
+    return cachedFile;
 }
 
 Http::Response WebApplication::processRequest(const Http::Request &request, const Http::Environment &env)
@@ -96,6 +96,18 @@ public:
     const Http::Environment &env() const;
 
 private:
+    // Files of the UI are kept translated, along with their gzip variants.
+    // The built-in ones are loaded at once, the files of the alternative UI
+    // are loaded on demand and reloaded when they are modified.
+    struct CachedFile
+    {
+        QByteArray data;
+        QByteArray gzipData;    // empty if compression isn't worth it
+        QString mimeType;
+        QString eTag;
+        QDateTime lastModified;
+    };
+
     void doProcessRequest();
     void configure();
 
@@ -105,7 +117,9 @@ private:
     void sendFile(const QString &path);
     void sendWebUIFile();
 
-    void translateDocument(QString &data) const;
+    void buildFileCache();
+    CachedFile loadFile(const QString &path) const;
+    QString translateDocument(const QString &data) const;
 
     // Session management
     QString generateSid() const;
@@ -133,13 +147,7 @@ private:
     bool m_isAltUIUsed = false;
     QString m_rootFolder;
 
-    struct TranslatedFile
-    {
-        QByteArray data;
-        QString mimeType;
-        QDateTime lastModified;
-    };
-    QHash<QString, TranslatedFile> m_translatedFiles;
+    QHash<QString, CachedFile> m_cachedFiles;
     QString m_currentLocale;
     QTranslator m_translator;
     bool m_translationFileLoaded = false;
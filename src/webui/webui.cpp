@@ -86,6 +86,8 @@ void WebUI::configure()
                 m_httpServer->close();
         }
 
+        m_httpServer->setWorkerThreadCount(pref->getWebUiWorkerThreads());
+
         if (pref->isWebUiHttpsEnabled())
         {
             const auto readData = [](const QString &path) -> QByteArray
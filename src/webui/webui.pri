@@ -9,6 +9,9 @@ HEADERS += \
     $$PWD/api/rsscontroller.h \
     $$PWD/api/searchcontroller.h \
     $$PWD/api/synccontroller.h \
+    $$PWD/api/syncrevisionlog.h \
+    $$PWD/api/torrentchangetracker.h \
+    $$PWD/api/torrentqueryengine.h \
     $$PWD/api/torrentscontroller.h \
     $$PWD/api/transfercontroller.h \
     $$PWD/api/serialize/serialize_torrent.h \
@@ -25,6 +28,9 @@ SOURCES += \
     $$PWD/api/rsscontroller.cpp \
     $$PWD/api/searchcontroller.cpp \
     $$PWD/api/synccontroller.cpp \
+    $$PWD/api/syncrevisionlog.cpp \
+    $$PWD/api/torrentchangetracker.cpp \
+    $$PWD/api/torrentqueryengine.cpp \
     $$PWD/api/torrentscontroller.cpp \
     $$PWD/api/transfercontroller.cpp \
     $$PWD/api/serialize/serialize_torrent.cpp \